@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+"""Downloads a blob from the bulk transfer service of the Nordic Clicker and reports the throughput.
+
+Requires the `bleak` package. Interrupted transfers are resumed from the last received offset. The storage source
+is only sent over an encrypted link, so the clicker is paired first (Just Works) when it is downloaded; it is only
+available in development builds (CONFIG_APP_BT_DEBUG_ACCESS).
+
+With --runs, the blob is downloaded repeatedly and the minimum, median and maximum throughput are reported. The
+clicker logs the same figure as seen from its side when a transfer finishes (see src/services/bulk_svc.c). The
+ceiling of the link is about 170 kB/s: with 2M PHY, data length extension and connection event extension, each
+240-byte chunk takes a 266-byte encrypted LL PDU (1064 us), two inter-frame spaces and the empty ack of the central
+(1.41 ms in total), so the 16 kB storage partition takes about 0.1 s at best.
+
+Usage:
+    bulk_download.py <BLE address> {storage,stats,trace} [--output FILE] [--runs N]
+"""
+
+import argparse
+import asyncio
+import statistics
+import struct
+import time
+
+from bleak import BleakClient
+
+BULK_SVC_CONTROL_UUID = "456bdbf1-0ad5-401a-898f-d0505330d97a"
+BULK_SVC_DATA_UUID = "456bdbf2-0ad5-401a-898f-d0505330d97a"
+
+SOURCES = {"storage": 0, "stats": 1, "trace": 2}  # enum bulk_svc_source_t
+
+CMD_START = 0x01
+STATUS_FORMAT = "<BBII"  # struct status_t
+
+MAX_ATTEMPTS = 5
+
+
+async def download(address, source, pair):
+    data = bytearray()
+    done = asyncio.Event()
+
+    def on_notification(_, payload):
+        (offset,) = struct.unpack_from("<I", payload)
+        chunk = payload[4:]
+
+        # Chunks arrive in order; anything else is a leftover from an aborted attempt
+        if offset != len(data):
+            return
+
+        if chunk:
+            data.extend(chunk)
+        else:
+            done.set()
+
+    for attempt in range(MAX_ATTEMPTS):
+        try:
+            async with BleakClient(address) as client:
+                if pair:
+                    await client.pair()
+
+                print(f"Connected (MTU {client.mtu_size}), starting at offset {len(data)}")
+                await client.start_notify(BULK_SVC_DATA_UUID, on_notification)
+
+                start = time.monotonic()
+                start_len = len(data)
+                await client.write_gatt_char(
+                    BULK_SVC_CONTROL_UUID, struct.pack("<BBI", CMD_START, source, len(data)), response=True
+                )
+                await done.wait()
+                elapsed = time.monotonic() - start
+
+                size = len(data) - start_len
+                print(f"Received {size} bytes in {elapsed:.3f} s ({size / elapsed / 1000:.1f} kB/s)")
+                return bytes(data), size / elapsed
+        except Exception as e:
+            print(f"Attempt {attempt + 1} failed at offset {len(data)}: {e}")
+
+    raise RuntimeError("Download failed")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("address", help="BLE address of the clicker")
+    parser.add_argument("source", choices=SOURCES.keys(), help="blob to download")
+    parser.add_argument("--output", metavar="FILE", help="save the blob to a file")
+    parser.add_argument("--runs", type=int, default=1, help="number of downloads for the throughput statistics")
+    args = parser.parse_args()
+
+    pair = args.source == "storage"
+    results = [asyncio.run(download(args.address, SOURCES[args.source], pair)) for _ in range(args.runs)]
+    data = results[-1][0]
+
+    if args.runs > 1:
+        rates = [r[1] / 1000 for r in results]
+        print(f"{args.runs} runs: min {min(rates):.1f}, median {statistics.median(rates):.1f}, "
+              f"max {max(rates):.1f} kB/s")
+
+    if args.output:
+        with open(args.output, "wb") as f:
+            f.write(data)
+
+
+if __name__ == "__main__":
+    main()
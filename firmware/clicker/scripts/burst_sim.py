@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""Simulates a burst of simultaneous clicks (e.g. a vote) from many clickers sharing one receiver.
+
+Compares plain Gazell retransmissions with the slotting and backoff of src/radio.c and reports the time until all
+packets are delivered and the number of transmissions per click.
+
+The model is deliberately simple: all clickers have just woken up (so they are out of sync with the receiver) and
+all channels are equally good; the receiver visits each channel for 2 of every CHANNELS_NUM * 2 timeslots, and a
+timeslot in which the receiver listens on a channel is acked if exactly one clicker transmits on it and lost for all
+of them otherwise (no capture effect). Without slotting, all clickers start on the same channel. The constants match
+src/radio.c; the number of slots is what the receiver hints for the given number of clickers.
+
+Usage:
+    burst_sim.py [--devices N] [--runs N] [--seed N]
+"""
+
+import argparse
+import random
+import statistics
+
+TIMESLOT_US = 600
+CHANNELS_NUM = 8
+HOST_TIMESLOTS_PER_CHANNEL = 2
+SLOT_TIMESLOTS = CHANNELS_NUM * HOST_TIMESLOTS_PER_CHANNEL
+OUT_OF_SYNC_TIMESLOTS_PER_CHANNEL = CHANNELS_NUM * 2
+MAX_TX_ATTEMPTS_PER_TRY = OUT_OF_SYNC_TIMESLOTS_PER_CHANNEL
+MAX_TX_TRIES = 10
+BACKOFF_BASE_SLOTS = 2
+MAX_BACKOFF_EXP = 3
+MIN_NUM_SLOTS = 8
+MAX_NUM_SLOTS = 128
+GAZELL_MAX_TX_ATTEMPTS = 100
+
+
+def slot_of(device_id, num_slots):
+    """Same as get_slot_delay() in src/radio.c, in slots."""
+    return (((device_id * 2654435761) & 0xFFFFFFFF) * num_slots) >> 32
+
+
+def host_listens(t, phase, channel):
+    return (t + phase) % SLOT_TIMESLOTS // HOST_TIMESLOTS_PER_CHANNEL == channel
+
+
+def simulate(num_devices, slotted, rng):
+    """Returns (completion time in ms, transmissions, lost packets)."""
+    num_slots = min(max(2 << (num_devices - 1).bit_length(), MIN_NUM_SLOTS), MAX_NUM_SLOTS)
+    attempts_per_try = MAX_TX_ATTEMPTS_PER_TRY if slotted else GAZELL_MAX_TX_ATTEMPTS
+    max_tries = MAX_TX_TRIES if slotted else 1
+
+    # Per device: [timeslot of the next attempt, attempts left in this try, tries so far, channel]
+    devices = []
+    for _ in range(num_devices):
+        slot = slot_of(rng.getrandbits(32), num_slots)
+        if slotted:
+            devices.append([slot // CHANNELS_NUM * SLOT_TIMESLOTS, attempts_per_try, 1, slot % CHANNELS_NUM])
+        else:
+            devices.append([0, attempts_per_try, 1, 0])
+
+    phase = rng.randrange(SLOT_TIMESLOTS)
+    t = 0
+    done_at = 0
+    transmissions = 0
+    lost = 0
+    while devices:
+        sending = [d for d in devices if d[0] == t]
+        transmissions += len(sending)
+
+        for channel in range(CHANNELS_NUM):
+            on_channel = [d for d in sending if d[3] == channel]
+            if len(on_channel) == 1 and host_listens(t, phase, channel):
+                devices.remove(on_channel[0])
+                sending.remove(on_channel[0])
+                done_at = t + 1
+
+        for d in sending:
+            d[1] -= 1
+            if d[1] > 0:
+                d[0] = t + 1
+            elif d[2] < max_tries:
+                window = BACKOFF_BASE_SLOTS << min(d[2] - 1, MAX_BACKOFF_EXP)
+                d[0] = t + 1 + rng.randrange(window) * SLOT_TIMESLOTS
+                d[1] = attempts_per_try
+                d[2] += 1
+                d[3] = (d[3] + 1) % CHANNELS_NUM
+            else:
+                devices.remove(d)
+                lost += 1
+                done_at = t + 1
+
+        t += 1
+
+    return done_at * TIMESLOT_US / 1000, transmissions, lost
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--devices", type=int, default=60, help="number of clickers clicking at the same time")
+    parser.add_argument("--runs", type=int, default=200, help="number of bursts to simulate")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    print(f"{args.devices} clickers, {args.runs} bursts")
+    print(f"{'strategy':<10} {'median [ms]':>12} {'max [ms]':>9} {'tx/click':>9} {'lost/burst':>11}")
+    for name, slotted in (("gazell", False), ("slotted", True)):
+        rng = random.Random(args.seed)
+        results = [simulate(args.devices, slotted, rng) for _ in range(args.runs)]
+        times = [r[0] for r in results]
+        tx_per_click = sum(r[1] for r in results) / (args.runs * args.devices)
+        lost = sum(r[2] for r in results) / args.runs
+        print(f"{name:<10} {statistics.median(times):>12.1f} {max(times):>9.1f} {tx_per_click:>9.1f} {lost:>11.1f}")
+
+
+if __name__ == "__main__":
+    main()
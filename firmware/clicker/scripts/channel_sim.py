@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+"""Simulates the Gazell channel selection of the Nordic Clicker in the presence of an interferer.
+
+Compares the retry rate and the latency of the first packet after waking up (the clicker is out of sync with the
+receiver then) for three strategies:
+
+    fixed     the clicker always starts on the first channel of the table (Gazell's default behaviour)
+    learned   the clicker starts on one of the channels that score at least half as good as the best one, picked by
+              its slot (see select_slot() and update_score() in src/radio.c)
+    blacklist like learned, and the receiver also blacklists bad channels (see receiver-example/src/blacklist.c)
+
+A population of clickers that all start without channel scores (e.g. fresh batteries) takes turns sending; the
+receiver collects the reports of all of them. Blacklisted channels are given another chance after the timeout, with a
+clean record, like on the receiver. The "active" column is the average number of channels the receiver cycled
+through, "blacklisted" counts how often a channel was blacklisted.
+
+Modelled results (not measured on hardware): a learned clicker only tries a bad channel until its score drops below
+half of the best one, i.e. for about one click, so the receiver only gets the MIN_REPORTS reports it needs to judge a
+channel from a large population. With the defaults (30 clickers, Wi-Fi channel 1 at 80%), no channel is blacklisted
+and the blacklist strategy gives the same numbers as learned (6.60 retries per click, p50 4.2 ms); with 400 clickers
+clicking every 100 ms, the bad channels are blacklisted for part of the run (7.4 active channels on average) and the
+blacklist strategy needs 6.07 retries per click instead of 6.72 (p99 9.0 instead of 10.2 ms), since the receiver
+comes around to the channel of the clicker sooner. Use --onset to switch the interferer on after the clickers have
+learned their channels.
+
+The model is deliberately simple: the receiver dwells 2 timeslots on each of its active channels, the out-of-sync
+clicker sends once per timeslot and stays on a channel for OUT_OF_SYNC_TIMESLOTS_PER_CHANNEL timeslots (which covers
+a full cycle of the receiver whether or not it has blacklisted channels), and the interferer blocks each timeslot on
+the channels it covers with a fixed probability. The channel plan is read from ../common/channels.h.
+
+Usage:
+    channel_sim.py [--clicks N] [--clickers N] [--interval MS] [--interferer LOW-HIGH] [--duty PERCENT] [--seed N]
+"""
+
+import argparse
+import random
+import re
+from pathlib import Path
+
+CHANNELS_H = Path(__file__).resolve().parent.parent.parent / "common" / "channels.h"
+
+TIMESLOT_US = 600
+HOST_TIMESLOTS_PER_CHANNEL = 2
+MAX_TX_ATTEMPTS = 100
+
+NUM_SLOTS = 8  # DEFAULT_NUM_SLOTS in src/radio.c
+
+BLACKLIST_MIN_REPORTS = 32
+BLACKLIST_MAX_REPORTS = 4 * BLACKLIST_MIN_REPORTS
+BLACKLIST_PERCENT = 50  # CONFIG_APP_CHANNEL_BLACKLIST_PERCENT
+BLACKLIST_TIMEOUT_MS = 600 * 1000  # CONFIG_APP_CHANNEL_BLACKLIST_TIMEOUT_S
+
+
+def parse_channels_h(path):
+    """Returns the channel table and CHANNELS_MIN_ACTIVE from channels.h."""
+    text = path.read_text()
+    table = [int(c) for c in re.search(r"channels_table\[CHANNELS_NUM\] = \{(.*?)\}", text).group(1).split(",")]
+    min_active = int(re.search(r"#define CHANNELS_MIN_ACTIVE\s+(\d+)", text).group(1))
+    return table, min_active
+
+
+def update_score(score, ok):
+    return score + (255 - score + 3) // 4 if ok else score - (score + 3) // 4
+
+
+def select_start(scores, device_id):
+    """Returns the index the clicker starts on, like select_slot() in src/radio.c."""
+    slot = ((device_id * 2654435761) % 2**32 * NUM_SLOTS) >> 32
+    best = max(scores)
+    good = [i for i, score in enumerate(scores) if score >= best // 2]
+    return good[slot % len(good)]
+
+
+class Blacklist:
+    """Reports of the clickers per channel, like receiver-example/src/blacklist.c."""
+
+    def __init__(self, table, min_active):
+        self.table = table
+        self.min_active = min_active
+        self.reports = [[0, 0] for _ in table]  # [ok, failed] per channel
+        self.until_ms = [None] * len(table)  # Uptime until which a channel is blacklisted, None if it is active
+        self.num_blacklisted = 0  # Number of times a channel was blacklisted
+
+    def report(self, ok_idx, failed, now_ms):
+        for idx in range(len(self.table)):
+            if idx == ok_idx or idx in failed:
+                counts = self.reports[idx]
+                counts[idx != ok_idx] += 1
+                if sum(counts) >= BLACKLIST_MAX_REPORTS:
+                    counts[0] //= 2
+                    counts[1] //= 2
+
+        for idx, (ok, bad) in enumerate(self.reports):
+            total = ok + bad
+            is_bad = total >= BLACKLIST_MIN_REPORTS and bad * 100 >= total * BLACKLIST_PERCENT
+            if self.until_ms[idx] is not None and now_ms >= self.until_ms[idx]:
+                self.until_ms[idx] = None
+                self.reports[idx] = [0, 0]
+            elif self.until_ms[idx] is None and is_bad and len(self.active()) > self.min_active:
+                self.until_ms[idx] = now_ms + BLACKLIST_TIMEOUT_MS
+                self.num_blacklisted += 1
+
+    def active(self):
+        return [c for idx, c in enumerate(self.table) if self.until_ms[idx] is None]
+
+
+def send(table, active, start, blocked, rng):
+    """Sends a packet and returns (attempts, index it was acked on or None, failed indices)."""
+    out_of_sync_timeslots = len(table) * HOST_TIMESLOTS_PER_CHANNEL
+    host_phase = rng.randrange(len(active) * HOST_TIMESLOTS_PER_CHANNEL)
+    failed = set()
+
+    for attempt in range(MAX_TX_ATTEMPTS):
+        idx = (start + attempt // out_of_sync_timeslots) % len(table)
+        host_channel = active[(host_phase + attempt) // HOST_TIMESLOTS_PER_CHANNEL % len(active)]
+        if table[idx] == host_channel and not (table[idx] in blocked and rng.random() < blocked[table[idx]]):
+            return attempt + 1, idx, failed
+        if (attempt + 1) % out_of_sync_timeslots == 0:
+            failed.add(idx)
+
+    return MAX_TX_ATTEMPTS, None, failed | {idx}
+
+
+def simulate(strategy, table, min_active, blocked, onset, clicks, num_clickers, interval_ms, rng):
+    device_ids = [rng.getrandbits(32) for _ in range(num_clickers)]
+    scores = [[0] * len(table) for _ in range(num_clickers)]
+    blacklist = Blacklist(table, min_active)
+    latencies_ms = []
+    total_attempts = 0
+    lost = 0
+
+    active_sum = 0
+
+    for click in range(clicks):
+        clicker = rng.randrange(num_clickers)
+        blocked_now = blocked if click >= onset else {}
+        start = 0 if strategy == "fixed" else select_start(scores[clicker], device_ids[clicker])
+        active = blacklist.active() if strategy == "blacklist" else table
+        attempts, ok_idx, failed = send(table, active, start, blocked_now, rng)
+        active_sum += len(active)
+
+        total_attempts += attempts
+        latencies_ms.append(attempts * TIMESLOT_US / 1000)
+        lost += ok_idx is None
+
+        for idx in failed:
+            scores[clicker][idx] = update_score(scores[clicker][idx], False)
+        if ok_idx is not None:
+            scores[clicker][ok_idx] = update_score(scores[clicker][ok_idx], True)
+
+        if strategy == "blacklist":
+            blacklist.report(ok_idx, failed, click * interval_ms)
+
+    latencies_ms.sort()
+    return {
+        "retries": (total_attempts - clicks) / clicks,
+        "p50": latencies_ms[len(latencies_ms) // 2],
+        "p99": latencies_ms[int(len(latencies_ms) * 0.99)],
+        "lost": lost,
+        "active": active_sum / clicks,
+        "blacklisted": blacklist.num_blacklisted,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--clicks", type=int, default=10000, help="number of clicks to simulate")
+    parser.add_argument("--clickers", type=int, default=30, help="number of clickers taking turns")
+    parser.add_argument("--interval", type=int, default=1000, help="time between two clicks in ms")
+    parser.add_argument("--interferer", default="2-24", help="channels covered by the interferer (default: Wi-Fi 1)")
+    parser.add_argument("--duty", type=int, default=80, help="share of the timeslots the interferer blocks in %%")
+    parser.add_argument("--onset", type=int, default=0, help="number of clicks before the interferer switches on")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    table, min_active = parse_channels_h(CHANNELS_H)
+    low, high = (int(c) for c in args.interferer.split("-"))
+    blocked = {c: args.duty / 100 for c in table if low <= c <= high}
+
+    print(f"Channels: {table}, blocked: {sorted(blocked)} ({args.duty}% of the timeslots)")
+    print(f"{'strategy':<10} {'retries/click':>14} {'p50 [ms]':>9} {'p99 [ms]':>9} {'lost':>5} {'active':>7} "
+          f"{'blacklisted':>12}")
+    for strategy in ("fixed", "learned", "blacklist"):
+        rng = random.Random(args.seed)
+        r = simulate(strategy, table, min_active, blocked, args.onset, args.clicks, args.clickers, args.interval, rng)
+        print(f"{strategy:<10} {r['retries']:>14.2f} {r['p50']:>9.1f} {r['p99']:>9.1f} {r['lost']:>5} "
+              f"{r['active']:>7.1f} {r['blacklisted']:>12}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""Runs the click workloads of the Nordic Clicker on native_sim and checks the energy figures against a baseline.
+
+For each workload (see sim/sim_workload.c), the clicker is built for native_sim with overlay-energy.conf, run until
+it enters System OFF, and the charge per click and the projected CR2032 life are taken from the energy lines it
+prints (see src/energy.h). The script exits with status 1 if a workload got worse than the baseline by more than
+the threshold, i.e. if the charge per click rose or the projected life dropped by more than the given percentage.
+
+Without a baseline file (or with --update), the figures are written to the baseline file instead; commit it
+together with the change that explains the new figures.
+
+Usage:
+    energy_bench.py [--workloads NAME,...] [--threshold PERCENT] [--baseline FILE] [--update] [--no-build]
+"""
+
+import argparse
+import json
+import subprocess
+import sys
+from pathlib import Path
+
+APP_DIR = Path(__file__).resolve().parent.parent
+BUILD_DIR = APP_DIR / "build" / "energy"
+DEFAULT_BASELINE = Path(__file__).resolve().parent / "energy_baseline.json"
+WORKLOADS = ["presentation", "quiz", "idle"]
+RUN_TIMEOUT_S = 600
+
+
+def build(workload):
+    build_dir = BUILD_DIR / workload
+    subprocess.run(
+        [
+            "west", "build", "-b", "native_sim", "-s", str(APP_DIR), "-d", str(build_dir), "--",
+            "-DEXTRA_CONF_FILE=overlay-energy.conf", f"-DCONFIG_APP_SIM_WORKLOAD_{workload.upper()}=y",
+        ],
+        check=True,
+    )
+    return build_dir / "zephyr" / "zephyr.exe"
+
+
+def run(exe):
+    """Runs the workload until System OFF ends the executable and returns the parsed energy lines."""
+    out = subprocess.run([str(exe)], capture_output=True, text=True, timeout=RUN_TIMEOUT_S, check=False).stdout
+
+    states = {}
+    total = None
+    for line in out.splitlines():
+        fields = line.strip().split(",")
+        if fields[:2] == ["energy", "state"]:
+            states[fields[2]] = {"time_us": int(fields[3]), "uah": float(fields[4])}
+        elif fields[:2] == ["energy", "total"]:
+            total = {
+                "uptime_us": int(fields[2]),
+                "clicks": int(fields[3]),
+                "uah": float(fields[4]),
+                "uah_per_click": float(fields[5]),
+                "life_days": int(fields[6]),
+            }
+
+    if total is None:
+        sys.exit(f"{exe}: no energy summary in the output (did the device enter System OFF?)")
+
+    return {"states": states, **total}
+
+
+def regressions(name, result, baseline, threshold):
+    """Yields a message for each figure that got worse than the baseline by more than the threshold."""
+    limit = baseline["uah_per_click"] * (1 + threshold / 100)
+    if result["uah_per_click"] > limit:
+        yield f"{name}: {result['uah_per_click']:.3f} uAh per click, baseline {baseline['uah_per_click']:.3f} uAh"
+
+    limit = baseline["life_days"] * (1 - threshold / 100)
+    if result["life_days"] < limit:
+        yield f"{name}: {result['life_days']} days projected life, baseline {baseline['life_days']} days"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--workloads", default=",".join(WORKLOADS), help="comma-separated workloads to run")
+    parser.add_argument("--threshold", type=float, default=5.0, help="allowed regression in percent")
+    parser.add_argument("--baseline", type=Path, default=DEFAULT_BASELINE)
+    parser.add_argument("--update", action="store_true", help="write the figures to the baseline file")
+    parser.add_argument("--no-build", action="store_true", help="run the executables of a previous build")
+    args = parser.parse_args()
+
+    results = {}
+    for workload in args.workloads.split(","):
+        exe = BUILD_DIR / workload / "zephyr" / "zephyr.exe" if args.no_build else build(workload)
+        results[workload] = run(exe)
+
+    print(f"{'workload':<14} {'clicks':>7} {'uAh':>10} {'uAh/click':>10} {'life [days]':>12}")
+    for workload, r in results.items():
+        print(f"{workload:<14} {r['clicks']:>7} {r['uah']:>10.3f} {r['uah_per_click']:>10.3f} {r['life_days']:>12}")
+
+    if args.update or not args.baseline.exists():
+        baseline = json.loads(args.baseline.read_text()) if args.baseline.exists() else {}
+        baseline.update(results)
+        args.baseline.write_text(json.dumps(baseline, indent=4) + "\n")
+        print(f"Baseline written to {args.baseline}")
+        return 0
+
+    baseline = json.loads(args.baseline.read_text())
+    failures = []
+    for workload, r in results.items():
+        if workload in baseline:
+            failures += regressions(workload, r, baseline[workload], args.threshold)
+        else:
+            print(f"{workload}: not in the baseline, not checked")
+
+    for failure in failures:
+        print(f"REGRESSION {failure}")
+
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
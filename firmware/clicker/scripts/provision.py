@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+"""Provisions Nordic Clickers with a configuration and reports the throughput of the provisioning station.
+
+Scans for clickers, pairs with each one (the provisioning service needs an encrypted link), reads its device ID and
+nonce, writes the complete configuration in a single authenticated write and checks the stored configuration by
+comparing its CRC. Each device is only provisioned once per run. Requires the `bleak` package.
+
+Usage:
+    provision.py --key <hex> --config config.json [--count N]
+
+The configuration file contains the fields of struct config_t as hex strings, e.g.:
+    {"gazell_secret_key": "00112233445566778899aabbccddeeff", "gazell_pairing_addr": "e7e7e7e7e7",
+     "gazell_packet_valid_id": "abcdef", "gazell_system_addr": "c2c2c2c2c2", "gazell_host_id": "0102030405"}
+"""
+
+import argparse
+import asyncio
+import hashlib
+import hmac
+import json
+import struct
+import time
+import zlib
+
+from bleak import BleakClient, BleakScanner
+
+DEVICE_NAME = "Nordic Clicker"
+PROVISIONING_SVC_CONFIG_UUID = "456bdbf9-0ad5-401a-898f-d0505330d97a"
+
+CONFIG_FIELDS = [  # struct config_t
+    ("gazell_secret_key", 16),
+    ("gazell_pairing_addr", 5),
+    ("gazell_packet_valid_id", 3),
+    ("gazell_system_addr", 5),
+    ("gazell_host_id", 5),
+]
+
+STATUS_FORMAT = "<8s8sIb"  # struct provisioning_status_t
+
+
+def pack_config(config):
+    data = b""
+    for name, size in CONFIG_FIELDS:
+        value = bytes.fromhex(config[name])
+        if len(value) != size:
+            raise ValueError(f"{name} must be {size} bytes")
+        data += value
+    return data
+
+
+def mask_secret_key(key, device_id, nonce, config):
+    """Same as unmask_key() in src/provisioning.c; the key is never sent in the clear."""
+    pad = hmac.new(key, b"gazell-key" + device_id + nonce, hashlib.sha256).digest()[:16]
+    return bytes(a ^ b for a, b in zip(config[:16], pad)) + config[16:]
+
+
+def build_message(key, device_id, nonce, config):
+    body = struct.pack("<B", 0) + mask_secret_key(key, device_id, nonce, config)  # No flags are defined
+    body += struct.pack("<I", zlib.crc32(body))
+    mac = hmac.new(key, device_id + nonce + body, hashlib.sha256).digest()[:16]
+    return body + mac
+
+
+async def provision(address, key, config):
+    async with BleakClient(address) as client:
+        await client.pair()
+
+        # The nonce is only valid for one message, so it is read right before the write
+        status = await client.read_gatt_char(PROVISIONING_SVC_CONFIG_UUID)
+        device_id, nonce, _, _ = struct.unpack(STATUS_FORMAT, status)
+
+        # The write only succeeds once the configuration has been saved and verified by the device
+        await client.write_gatt_char(
+            PROVISIONING_SVC_CONFIG_UUID, build_message(key, device_id, nonce, config), response=True
+        )
+
+        status = await client.read_gatt_char(PROVISIONING_SVC_CONFIG_UUID)
+        _, _, config_crc, result = struct.unpack(STATUS_FORMAT, status)
+        if result != 0 or config_crc != zlib.crc32(config):
+            raise RuntimeError(f"verification failed (result {result})")
+
+        return device_id
+
+
+async def run(args):
+    key = bytes.fromhex(args.key)
+    with open(args.config) as f:
+        config = pack_config(json.load(f))
+
+    done = set()
+    start = time.monotonic()
+    while len(done) < args.count:
+        devices = await BleakScanner.discover(timeout=2.0)
+        for device in devices:
+            if device.name != DEVICE_NAME or device.address in done:
+                continue
+
+            t0 = time.monotonic()
+            try:
+                device_id = await provision(device.address, key, config)
+            except Exception as e:
+                print(f"{device.address}: FAILED ({e})")
+                continue
+
+            done.add(device.address)
+            print(f"{device.address}: provisioned device {device_id.hex()} in {time.monotonic() - t0:.2f} s")
+            if len(done) >= args.count:
+                break
+
+    elapsed = time.monotonic() - start
+    print(f"Provisioned {len(done)} devices in {elapsed:.1f} s ({elapsed / len(done):.2f} s per device)")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--key", required=True, help="provisioning key (CONFIG_APP_PROVISIONING_KEY)")
+    parser.add_argument("--config", required=True, help="JSON file with the configuration")
+    parser.add_argument("--count", type=int, default=1, help="number of devices to provision")
+    asyncio.run(run(parser.parse_args()))
+
+
+if __name__ == "__main__":
+    main()
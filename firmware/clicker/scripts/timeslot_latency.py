@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+"""Reports the latency that sharing the radio with BLE adds to clicks (see CONFIG_APP_RADIO_TIMESLOTS).
+
+Reads a trace saved with `trace_decode.py --download <address> --save trace.bin` or `bulk_download.py <address> trace
+--output trace.bin` and evaluates the RADIO_TIMESLOT events, i.e. the time from requesting a timeslot until it
+started. The high priority timeslots (clicks) are grouped by whether a BLE connection was up at the time; while it was,
+each wait is compared with the connection interval (from the BLE_CONN_PARAMS events), which is the target for the
+added latency.
+
+Usage:
+    timeslot_latency.py trace.bin
+"""
+
+import argparse
+import struct
+import sys
+from pathlib import Path
+
+from trace_decode import INFO_FORMAT, RECORD_FORMAT, TRACE_H, TRACE_MAGIC, parse_trace_h
+
+HIGH_PRIORITY = 1 << 31
+
+
+def find_event(events, name):
+    return next(key for key, value in events.items() if value == name)
+
+
+def collect(data, events):
+    """Returns the waits of the high priority timeslots in us as (wait, connection interval or None) tuples."""
+    info_size = struct.calcsize(INFO_FORMAT)
+    magic, _, _, _, _, record_size = struct.unpack_from(INFO_FORMAT, data)
+    if magic != TRACE_MAGIC:
+        sys.exit(f"Invalid trace magic: {magic:#010x}")
+
+    conn_params = find_event(events, "BLE_CONN_PARAMS")
+    disconnected = find_event(events, "BLE_DISCONNECTED")
+    timeslot = find_event(events, "RADIO_TIMESLOT")
+
+    waits = []
+    interval = None
+    last_boot = None
+    for offset in range(info_size, len(data) - record_size + 1, record_size):
+        _, boot, module, event, arg = struct.unpack_from(RECORD_FORMAT, data, offset)
+        if boot != last_boot:
+            interval = None
+            last_boot = boot
+
+        if (module, event) == conn_params:
+            interval = arg
+        elif (module, event) == disconnected:
+            interval = None
+        elif (module, event) == timeslot and arg & HIGH_PRIORITY:
+            waits.append((arg & ~HIGH_PRIORITY, interval))
+
+    return waits
+
+
+def summarize(name, waits, within=""):
+    if not waits:
+        return f"{name:<12} {0:>6}"
+
+    waits = sorted(waits)
+    p50 = waits[len(waits) // 2] / 1000
+    p99 = waits[int(len(waits) * 0.99)] / 1000
+    return f"{name:<12} {len(waits):>6} {p50:>9.2f} {p99:>9.2f} {waits[-1] / 1000:>9.2f} {within:>16}"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("file", help="saved trace")
+    args = parser.parse_args()
+
+    _, events = parse_trace_h(TRACE_H)
+    waits = collect(Path(args.file).read_bytes(), events)
+
+    idle = [wait for wait, interval in waits if interval is None]
+    connected = [wait for wait, interval in waits if interval is not None]
+    within = sum(wait <= interval for wait, interval in waits if interval is not None)
+
+    print(f"{'BLE':<12} {'slots':>6} {'p50 [ms]':>9} {'p99 [ms]':>9} {'max [ms]':>9} {'within interval':>16}")
+    print(summarize("advertising", idle))
+    print(summarize("connected", connected, f"{within}/{len(connected)}"))
+
+
+if __name__ == "__main__":
+    main()
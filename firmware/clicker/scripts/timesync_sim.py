@@ -0,0 +1,176 @@
+#!/usr/bin/env python3
+"""Simulates how well the receiver can rank presses of different clickers with and without the time sync.
+
+In every round, a number of clickers press within a short window (a vote). Their click packets reach the receiver
+after their slot delay, retries and backoffs (see src/radio.c), so the order of arrival says little about the order of
+the presses. With the time sync, each clicker follows its acked click packet with a sync packet that gives the time
+from each press to the ack, measured with its RTC; the receiver subtracts that from the time it received the click
+packet (see process_sync() in receiver-example/src/radio.c). The model:
+
+    - each RTC runs at 32768 Hz with a frequency error of up to --ppm and a random phase, and times are truncated to
+      whole cycles (the clicker's k_cycle_get_32(), the receiver's k_uptime_ticks())
+    - the ack reaches the clicker a fixed latency after the receiver took its time, plus the air time of the ack
+      payload and a little jitter; the payload is a slot hint, or a command for --commands percent of the acks.
+      The clicker takes the air time of the payload off its ack time (see on_tx_done() in src/radio.c); the
+      "uncompensated" results show what happens without that
+    - each try of a packet fails with probability --loss and is retried after the random backoff of the firmware; a
+      sync packet that gets lost leaves the receiver with the ages of the click packet (10 ms resolution)
+
+Reports the error of the press times (the common latency removed) and the share of pairs of presses, further apart
+than the target, that each method ranks correctly.
+
+The figures are modelled, not measured. With the defaults, the p99 error of the synced press times is 38 us with
+the compensation and 98 us without it (100% and 91% within 50 us). The ranking hardly changes (92.8% of the pairs
+either way; 100.0% and 99.9% with --loss 0), since only acks with a command are off and most misses come from presses
+whose sync packet got lost.
+
+Usage:
+    timesync_sim.py [--clickers N] [--rounds N] [--window-us US] [--loss PERCENT] [--commands PERCENT] [--ppm PPM]
+                    [--seed N]
+"""
+
+import argparse
+import random
+
+RTC_HZ = 32768
+CYCLE_US = 8 * 2 * 600  # Receiver cycle through all channels (see CYCLE_US in src/radio.c)
+TIMESLOT_US = 600
+NUM_SLOTS = 8
+MAX_TX_TRIES = 10
+BACKOFF_BASE_CYCLES = 2
+MAX_BACKOFF_EXP = 3
+EVENT_TIME_UNIT_US = 10000
+ACK_LATENCY_US = 240  # From the receiver's RX callback to the clicker's TX done callback, for an empty ack
+ACK_JITTER_US = 5
+AIR_US_PER_BYTE = 4  # 2 Mbps
+SLOT_HINT_LEN = 3  # struct packet_slot_hint_t
+COMMAND_LEN = 12 + 7 + 4  # Header, LED command and MIC
+TARGET_US = 100
+
+
+class Rtc:
+    def __init__(self, rng, ppm):
+        self.rate = 1 + rng.uniform(-ppm, ppm) / 1e6
+        self.phase = rng.uniform(0, 1e6)
+
+    def exact_us(self, t_us):
+        return t_us * self.rate + self.phase
+
+    def cycles(self, t_us):
+        return int(self.exact_us(t_us) * RTC_HZ / 1e6)
+
+    def us(self, t_us):
+        return self.cycles(t_us) * 1e6 / RTC_HZ
+
+
+def deliver(start_us, rng, loss):
+    """Returns the time the packet got through after start_us, or None if all tries failed."""
+    t_us = start_us
+    for tries in range(1, MAX_TX_TRIES + 1):
+        t_us += rng.randrange(1, 3) * TIMESLOT_US
+        if rng.random() >= loss:
+            return t_us
+
+        exp = min(tries - 1, MAX_BACKOFF_EXP)
+        t_us += rng.randrange(BACKOFF_BASE_CYCLES << exp) * CYCLE_US
+    return None
+
+
+def simulate_round(clickers, receiver, args, rng):
+    """Returns (press time, arrival time, estimate, uncompensated estimate, whether the sync packet got through) for
+    every delivered press of a round, all on the time base of the receiver (the press time without truncation)."""
+    loss = args.loss / 100
+    t0_us = rng.uniform(1e6, 1e9)
+    presses = []
+    for rtc in clickers:
+        press_us = t0_us + rng.uniform(0, args.window_us)
+        slot_us = rng.randrange(NUM_SLOTS) * CYCLE_US
+        ack_us = deliver(press_us + slot_us, rng, loss)
+        if ack_us is None:
+            continue
+
+        ack_len = COMMAND_LEN if rng.random() < args.commands / 100 else SLOT_HINT_LEN
+        air_us = ack_len * AIR_US_PER_BYTE
+        rx_us = receiver.us(ack_us - ACK_LATENCY_US - air_us + rng.uniform(0, ACK_JITTER_US))
+
+        # The clicker takes the air time of the payload off in whole RTC cycles (k_us_to_cyc_near32())
+        ack_cycles = rtc.cycles(ack_us)
+        compensated_cycles = ack_cycles - round(air_us * RTC_HZ / 1e6)
+        age_us = int((compensated_cycles - rtc.cycles(press_us)) * 1e6 / RTC_HZ)
+        uncompensated_age_us = int((ack_cycles - rtc.cycles(press_us)) * 1e6 / RTC_HZ)
+
+        # The ages of the click packet are rounded to the packet format's time unit
+        sync_ok = rng.random() >= loss
+        if sync_ok:
+            estimate_us = rx_us - age_us
+            uncompensated_us = rx_us - uncompensated_age_us
+        else:
+            estimate_us = rx_us - round(age_us / EVENT_TIME_UNIT_US) * EVENT_TIME_UNIT_US
+            uncompensated_us = estimate_us
+        presses.append((receiver.exact_us(press_us), rx_us, estimate_us, uncompensated_us, sync_ok))
+    return presses
+
+
+def ranked_pairs(presses, key):
+    """Returns (pairs further apart than TARGET_US, how many of them key ranks correctly)."""
+    total = 0
+    correct = 0
+    for i, a in enumerate(presses):
+        for b in presses[i + 1 :]:
+            if abs(a[0] - b[0]) <= TARGET_US:
+                continue
+            total += 1
+            correct += (a[0] < b[0]) == (key(a) < key(b))
+    return total, correct
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--clickers", type=int, default=32, help="number of clickers pressing in every round")
+    parser.add_argument("--rounds", type=int, default=500, help="number of rounds to simulate")
+    parser.add_argument("--window-us", type=float, default=1000, help="window the presses of a round fall into")
+    parser.add_argument("--loss", type=int, default=10, help="share of the tries that fail in %%")
+    parser.add_argument("--commands", type=int, default=10, help="share of the acks that carry a command in %%")
+    parser.add_argument("--ppm", type=float, default=40, help="maximum frequency error of the RTCs in ppm")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    clickers = [Rtc(rng, args.ppm) for _ in range(args.clickers)]
+    receiver = Rtc(rng, args.ppm)
+
+    errors = {"synced": [], "uncompensated": []}
+    num_presses = 0
+    pairs = {"arrival": [0, 0], "synced": [0, 0], "uncompensated": [0, 0]}
+    keys = {"arrival": lambda p: p[1], "synced": lambda p: p[2], "uncompensated": lambda p: p[3]}
+    for _ in range(args.rounds):
+        presses = simulate_round(clickers, receiver, args, rng)
+        for name, key in keys.items():
+            total, correct = ranked_pairs(presses, key)
+            pairs[name][0] += total
+            pairs[name][1] += correct
+        errors["synced"] += [p[2] - p[0] for p in presses if p[4]]
+        errors["uncompensated"] += [p[3] - p[0] for p in presses if p[4]]
+        num_presses += len(presses)
+
+    print(f"{args.clickers} clickers, {args.rounds} rounds, presses within {args.window_us:.0f} us, "
+          f"{args.loss}% tries lost, {args.commands}% acks with a command, RTCs within {args.ppm:.0f} ppm")
+    print(f"Synced presses: {len(errors['synced'])}/{num_presses} (the others fall back to the ages of the click "
+          f"packet)")
+    for name, errs in errors.items():
+        # The common latency shifts all press times alike, so it does not affect the ranking
+        offset = sorted(errs)[len(errs) // 2]
+        errs = sorted(abs(e - offset) for e in errs)
+        p50 = errs[len(errs) // 2]
+        p99 = errs[int(len(errs) * 0.99)]
+        within = sum(e <= TARGET_US / 2 for e in errs)
+        print(f"{name.capitalize()} press time error: p50 {p50:.1f} us, p99 {p99:.1f} us, max {errs[-1]:.1f} us, "
+              f"{100 * within / len(errs):.1f}% within {TARGET_US // 2} us")
+
+    print(f"{'ranking':<14} {'pairs > ' + str(TARGET_US) + ' us apart':>22} {'correct':>9}")
+    for name, (total, correct) in pairs.items():
+        print(f"{name:<14} {total:>22} {100 * correct / max(total, 1):>8.1f}%")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""Downloads and decodes the binary event trace of the Nordic Clicker.
+
+The trace is either downloaded over BLE (requires the `bleak` package) or read from a file that was previously saved
+with --save or downloaded with `bulk_download.py <address> trace --output <file>` (which is much faster). Module and
+event names are taken from src/trace.h, so this script does not need to be updated when new events are added.
+
+Usage:
+    trace_decode.py --download <BLE address> [--save trace.bin]
+    trace_decode.py trace.bin
+"""
+
+import argparse
+import asyncio
+import re
+import struct
+import sys
+from pathlib import Path
+
+TRACE_H = Path(__file__).resolve().parent.parent / "src" / "trace.h"
+
+TRACE_MAGIC = 0x54524331
+INFO_FORMAT = "<IIIIHH"  # struct trace_info_t
+RECORD_FORMAT = "<IHBBI"  # struct trace_record_t
+
+TRACE_SVC_INFO_UUID = "456bdbe1-0ad5-401a-898f-d0505330d97a"
+TRACE_SVC_RECORDS_UUID = "456bdbe2-0ad5-401a-898f-d0505330d97a"
+
+
+def parse_trace_h(path):
+    """Returns the module names ({id: name}) and event names ({(module id, event id): name}) from trace.h."""
+    text = path.read_text()
+
+    modules = {}
+    for name, value in re.findall(r"TRACE_MOD_(\w+)\s*=\s*(\d+)", text):
+        modules[int(value)] = name
+
+    module_ids = {name: value for value, name in modules.items()}
+    events = {}
+    events_enum = re.search(r"enum trace_event_t \{(.*?)\};", text, re.S).group(1)
+    module = None
+    for line in events_enum.splitlines():
+        section = re.match(r"\s*// TRACE_MOD_(\w+)", line)
+        if section:
+            module = module_ids[section.group(1)]
+            continue
+
+        event = re.match(r"\s*TRACE_EVT_(\w+)\s*=\s*(\d+)", line)
+        if event and module is not None:
+            events[(module, int(event.group(2)))] = event.group(1)
+
+    return modules, events
+
+
+async def download(address):
+    """Downloads the trace over BLE and returns it in the file format (header followed by all records)."""
+    from bleak import BleakClient
+
+    async with BleakClient(address) as client:
+        info = await client.read_gatt_char(TRACE_SVC_INFO_UUID)
+        _, _, head, _, capacity, record_size = struct.unpack(INFO_FORMAT, info)
+
+        records = b""
+        seq = max(0, head - capacity)
+        while seq < head:
+            await client.write_gatt_char(TRACE_SVC_RECORDS_UUID, struct.pack("<I", seq), response=True)
+            page = await client.read_gatt_char(TRACE_SVC_RECORDS_UUID)
+            (first_seq,) = struct.unpack_from("<I", page)
+            data = page[4:]
+            if not data:
+                break
+
+            records += data
+            seq = first_seq + len(data) // record_size
+
+        return bytes(info) + records
+
+
+def decode(data, modules, events):
+    info_size = struct.calcsize(INFO_FORMAT)
+    magic, boot, head, cycles_per_sec, capacity, record_size = struct.unpack_from(INFO_FORMAT, data)
+    if magic != TRACE_MAGIC:
+        sys.exit(f"Invalid trace magic: {magic:#010x}")
+
+    print(f"# boot={boot} head={head} capacity={capacity} cycles_per_sec={cycles_per_sec}")
+    print("boot,time_s,module,event,arg")
+
+    for offset in range(info_size, len(data) - record_size + 1, record_size):
+        timestamp, rec_boot, module, event, arg = struct.unpack_from(RECORD_FORMAT, data, offset)
+        module_name = modules.get(module, f"MOD_{module}")
+        event_name = events.get((module, event), f"EVT_{event}")
+        print(f"{rec_boot},{timestamp / cycles_per_sec:.6f},{module_name},{event_name},{arg:#x}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("file", nargs="?", help="previously saved trace to decode")
+    parser.add_argument("--download", metavar="ADDRESS", help="download the trace from the clicker over BLE")
+    parser.add_argument("--save", metavar="FILE", help="save the downloaded trace to a file")
+    args = parser.parse_args()
+
+    if args.download:
+        data = asyncio.run(download(args.download))
+        if args.save:
+            Path(args.save).write_bytes(data)
+    elif args.file:
+        data = Path(args.file).read_bytes()
+    else:
+        parser.error("either a file or --download is required")
+
+    modules, events = parse_trace_h(TRACE_H)
+    decode(data, modules, events)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+"""Compares the radio charge per delivered click with adaptive and with fixed (full) TX power.
+
+The radio has no model on native_sim, so energy_bench.py cannot show what CONFIG_APP_RADIO_TX_POWER_CONTROL saves;
+this script models the link instead. A clicker at a given distance from the receiver sends clicks one after another;
+the TX power control follows update_tx_power() in src/radio.c (same levels, currents, target RSSI and number of
+healthy packets), and the level is kept from click to click like in retained RAM.
+
+The model is deliberately simple:
+
+    - log-distance path loss (40 dB at 1 m, exponent --exponent) with independent Gaussian fading (--fading dB) per
+      attempt, the same for the packet and its ack
+    - a packet or ack arrives with a probability that rises from 0 to 1 around the sensitivity of the receiver and of
+      the clicker at 2 Mbps (logistic, 1 dB wide); the receiver acks at 0 dBm
+    - the clicker is out of sync after waking up, so each try takes up to MAX_TX_ATTEMPTS_PER_TRY attempts of which
+      only the 2 that hit the receiver's dwell on the channel can get through; a failed try is retried
+    - each attempt charges the ramp-up and the air time of a click packet with one event at the TX current of the
+      level, and the ack window at the RX current; the radio is off for the rest of the Gazell timeslot
+
+Charges are in nAh per delivered click and cover the radio only; the CPU and the feedback cost the same with both
+settings (see energy_bench.py for those). The figures are modelled, not measured. With the defaults, adaptive power
+saves 24% of the radio charge at 2 m (3.74 instead of 4.93 nAh per delivered click, at -20 dBm), 18% at 10 m and 2%
+at 20 m; from about 25 m on, the acks are too weak for stepping down and both settings are the same. The savings are
+limited by the ack windows of the attempts that miss the receiver's channel, which are charged at the RX current at
+any TX power.
+
+Usage:
+    txpower_sim.py [--distances M,...] [--clicks N] [--exponent N] [--fading DB] [--seed N]
+"""
+
+import argparse
+import math
+import random
+
+# From src/radio.c
+TX_POWER_LEVELS = [(0, 4800), (-4, 3800), (-8, 3300), (-12, 3000), (-16, 2800), (-20, 2700)]  # (dBm, uA)
+TX_POWER_TARGET_RSSI = -80
+TX_POWER_HEALTHY_PACKETS = 4
+MAX_TX_ATTEMPTS_PER_TRY = 16
+MAX_TX_TRIES = 10
+HOST_TIMESLOTS_PER_CHANNEL = 2
+
+# Radio (nRF52840 at 2 Mbps, DC/DC enabled, 3 V)
+RX_CURRENT_UA = 4600  # ENERGY_RADIO_RX in src/energy.c
+SENSITIVITY_DBM = -89
+PACKET_BYTES = 1 + 5 + 1 + 24 + 2  # Preamble, address, packet control, click packet with one event, CRC
+RAMP_UP_US = 140
+TX_US = RAMP_UP_US + PACKET_BYTES * 4
+ACK_RX_US = 40 + (1 + 5 + 1 + 3 + 2) * 4  # Turnaround and an ack with a slot hint
+ACK_TIMEOUT_US = 250  # RX window when no ack comes
+
+UA_US_PER_NAH = 3600000
+
+
+def path_loss_db(distance_m, exponent):
+    return 40 + 10 * exponent * math.log10(max(distance_m, 1))
+
+
+def arrives(rssi, rng):
+    return rng.random() < 1 / (1 + math.exp(-(rssi - SENSITIVITY_DBM)))
+
+
+class Clicker:
+    def __init__(self, adaptive):
+        self.adaptive = adaptive
+        self.level = 0
+        self.healthy = 0
+
+    def update(self, ok, ack_rssi):
+        """Same as update_tx_power() in src/radio.c."""
+        if not self.adaptive:
+            return
+        if not ok:
+            self.level = 0
+            self.healthy = 0
+        elif self.level + 1 < len(TX_POWER_LEVELS):
+            if ack_rssi + TX_POWER_LEVELS[self.level + 1][0] < TX_POWER_TARGET_RSSI:
+                self.healthy = 0
+            else:
+                self.healthy += 1
+                if self.healthy >= TX_POWER_HEALTHY_PACKETS:
+                    self.level += 1
+                    self.healthy = 0
+
+
+def send_try(clicker, loss_db, fading_db, rng):
+    """Returns (ok, ack RSSI, charge in uA*us) of one try."""
+    dbm, tx_ua = TX_POWER_LEVELS[clicker.level]
+    phase = rng.randrange(MAX_TX_ATTEMPTS_PER_TRY)
+    charge = 0
+
+    for attempt in range(MAX_TX_ATTEMPTS_PER_TRY):
+        charge += TX_US * tx_ua
+        fading = rng.gauss(0, fading_db)
+        on_channel = (phase + attempt) % MAX_TX_ATTEMPTS_PER_TRY < HOST_TIMESLOTS_PER_CHANNEL
+        ack_rssi = -loss_db + fading
+        if on_channel and arrives(dbm - loss_db + fading, rng) and arrives(ack_rssi, rng):
+            charge += ACK_RX_US * RX_CURRENT_UA
+            return True, round(ack_rssi), charge
+        charge += ACK_TIMEOUT_US * RX_CURRENT_UA
+
+    return False, None, charge
+
+
+def simulate(adaptive, distance_m, args, rng):
+    clicker = Clicker(adaptive)
+    loss_db = path_loss_db(distance_m, args.exponent)
+    charge = 0
+    delivered = 0
+    tries = 0
+    level_dbm = 0
+
+    for _ in range(args.clicks):
+        level_dbm += TX_POWER_LEVELS[clicker.level][0]
+        for _ in range(MAX_TX_TRIES):
+            ok, ack_rssi, try_charge = send_try(clicker, loss_db, args.fading, rng)
+            charge += try_charge
+            tries += 1
+            clicker.update(ok, ack_rssi)
+            if ok:
+                delivered += 1
+                break
+
+    return {
+        "nah": charge / UA_US_PER_NAH / max(delivered, 1),
+        "delivered": 100 * delivered / args.clicks,
+        "tries": tries / args.clicks,
+        "dbm": level_dbm / args.clicks,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--distances", default="2,5,10,20,30,40", help="distances to the receiver in m")
+    parser.add_argument("--clicks", type=int, default=5000, help="number of clicks per distance and setting")
+    parser.add_argument("--exponent", type=float, default=3.0, help="path loss exponent (2 is free space)")
+    parser.add_argument("--fading", type=float, default=4.0, help="standard deviation of the fading in dB")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    print(f"{'distance':>8} {'setting':<9} {'nAh/click':>10} {'saved':>6} {'delivered':>10} {'tries':>6} {'dBm':>6}")
+    for distance in (float(d) for d in args.distances.split(",")):
+        fixed = simulate(False, distance, args, random.Random(args.seed))
+        adaptive = simulate(True, distance, args, random.Random(args.seed))
+        saved = 100 * (1 - adaptive["nah"] / fixed["nah"])
+        for name, r in (("fixed", fixed), ("adaptive", adaptive)):
+            print(f"{distance:>7.0f}m {name:<9} {r['nah']:>10.3f} {saved if r is adaptive else 0:>5.1f}% "
+                  f"{r['delivered']:>9.1f}% {r['tries']:>6.2f} {r['dbm']:>6.1f}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,306 @@
+#define DT_DRV_COMPAT yohummus_lp5813_emul
+
+#include "lp5813_emul.h"
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/drivers/i2c_emul.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(app_lp5813_emul);
+
+// The 10-bit register space is split across four I2C addresses (two MSBs of the register address)
+#define NUM_ADDRS 4
+#define NUM_REGS  0x400
+
+// Registers (see leds.c for the full list)
+#define REG_CHIP_EN           0x000
+#define REG_CMD_UPDATE        0x010
+#define REG_CMD_START         0x011
+#define REG_CMD_STOP          0x012
+#define REG_CMD_PAUSE         0x013
+#define REG_CMD_CONTINUE      0x014
+#define REG_LED_EN_1          0x020
+#define REG_LED_EN_2          0x021
+#define REG_SW_RESET          0x023
+#define REG_BASE_ANIM_LED_0   0x080
+#define REG_SIZE_ANIM_LED     0x01A
+#define REG_TSD_CONFIG_STATUS 0x300
+
+// Command values
+#define CMD_SW_RESET 0x66
+#define CMD_UPDATE   0x55
+#define CMD_START    0xFF
+#define CMD_STOP     0xAA
+#define CMD_PAUSE    0x33
+#define CMD_CONTINUE 0xCC
+
+// For REG_TSD_CONFIG_STATUS
+#define CONFIG_ERR_STATUS 0x01
+
+// Offsets within the animation registers of an LED
+#define REG_OFF_ANIM_AUTO_PAUSE    0
+#define REG_OFF_ANIM_AUTO_PLAYBACK 1
+#define REG_OFF_ANIM_AEU1          2
+#define REG_SIZE_ANIM_AEU          8
+#define REG_OFF_AEU_PWM_1          0
+#define REG_OFF_AEU_T12            5
+#define REG_OFF_AEU_T34            6
+#define REG_OFF_AEU_PLAYBACK       7
+
+// Durations of the time fields in ms
+static const uint16_t durations_ms[] = {0,    90,   180,  360,  540,  800,  1070, 1520,
+                                        2060, 2500, 3040, 4020, 5010, 5990, 7060, 8050};
+
+struct lp5813_emul_cfg {
+    uint16_t addr;
+    struct gpio_dt_spec en_gpio;
+};
+
+struct lp5813_emul_data {
+    const struct lp5813_emul_cfg *cfg;
+    struct gpio_callback en_cb;  // Clears the registers when EN goes low
+    uint8_t regs[NUM_REGS];
+    uint16_t reg_ptr;         // Register address for the next read/write
+    bool anim_running;        // Set by REG_CMD_START, cleared by REG_CMD_STOP
+    int64_t anim_start_time;  // Uptime in ms when the animation was started
+    int64_t anim_pause_time;  // Uptime in ms when the animation was paused, 0 if not paused
+    struct lp5813_emul_stats_t stats;
+    struct i2c_emul extra_addrs[NUM_ADDRS - 1];  // Bus registrations for the 2nd to 4th I2C address
+};
+
+/*********************************************************************************************************************
+ * PRIVATE FUNCTIONS
+ *********************************************************************************************************************/
+static bool is_powered(const struct lp5813_emul_cfg *cfg) {
+    return gpio_emul_output_get(cfg->en_gpio.port, cfg->en_gpio.pin) == 1;
+}
+
+static void reset_regs(struct lp5813_emul_data *data) {
+    memset(data->regs, 0, sizeof(data->regs));
+    data->reg_ptr         = 0;
+    data->anim_running    = false;
+    data->anim_pause_time = 0;
+}
+
+static void on_en_changed(const struct device *port, struct gpio_callback *cb, gpio_port_pins_t pins) {
+    // Like the real chip, the emulator loses all registers while it is disabled, so the driver has to configure it
+    // again after every power-up (the emulated GPIO calls back on changes of output pins as well)
+    struct lp5813_emul_data *data = CONTAINER_OF(cb, struct lp5813_emul_data, en_cb);
+    if (!is_powered(data->cfg)) {
+        reset_regs(data);
+    }
+}
+
+static void execute_cmd(struct lp5813_emul_data *data, uint16_t reg, uint8_t value) {
+    if (reg == REG_SW_RESET && value == CMD_SW_RESET) {
+        reset_regs(data);
+    } else if (reg == REG_CMD_UPDATE && value == CMD_UPDATE) {
+        // The configuration is only accepted if the chip is enabled
+        data->stats.cmd_updates++;
+        if (data->regs[REG_CHIP_EN] & 0x01) {
+            data->regs[REG_TSD_CONFIG_STATUS] &= ~CONFIG_ERR_STATUS;
+        } else {
+            data->regs[REG_TSD_CONFIG_STATUS] |= CONFIG_ERR_STATUS;
+        }
+    } else if (reg == REG_CMD_START && value == CMD_START) {
+        data->stats.cmd_starts++;
+        data->anim_running    = true;
+        data->anim_start_time = k_uptime_get();
+        data->anim_pause_time = 0;
+    } else if (reg == REG_CMD_STOP && value == CMD_STOP) {
+        data->stats.cmd_stops++;
+        data->anim_running = false;
+    } else if (reg == REG_CMD_PAUSE && value == CMD_PAUSE && data->anim_running && !data->anim_pause_time) {
+        data->anim_pause_time = k_uptime_get();
+    } else if (reg == REG_CMD_CONTINUE && value == CMD_CONTINUE && data->anim_pause_time) {
+        data->anim_start_time += k_uptime_get() - data->anim_pause_time;
+        data->anim_pause_time = 0;
+    }
+}
+
+static void write_reg(struct lp5813_emul_data *data, uint16_t reg, uint8_t value) {
+    // Command registers are write-only and do not keep their value
+    if ((reg >= REG_CMD_UPDATE && reg <= REG_CMD_CONTINUE) || reg == REG_SW_RESET) {
+        execute_cmd(data, reg, value);
+        return;
+    }
+
+    // Status registers are read-only
+    if (reg >= REG_TSD_CONFIG_STATUS) {
+        return;
+    }
+
+    data->regs[reg] = value;
+}
+
+/*********************************************************************************************************************
+ * EMULATOR API
+ *********************************************************************************************************************/
+static int transfer(const struct emul *target, struct i2c_msg *msgs, int num_msgs, int addr) {
+    const struct lp5813_emul_cfg *cfg = target->cfg;
+    struct lp5813_emul_data *data     = target->data;
+
+    // The chip does not acknowledge anything while it is disabled
+    if (!is_powered(cfg)) {
+        return -EIO;
+    }
+
+    const uint16_t page = (uint16_t)(addr - cfg->addr) << 8;
+    data->stats.transfers++;
+
+    bool reg_ptr_set = false;
+    for (int i = 0; i < num_msgs; i++) {
+        struct i2c_msg *msg = &msgs[i];
+
+        if ((msg->flags & I2C_MSG_RW_MASK) == I2C_MSG_WRITE) {
+            data->stats.bytes_written += msg->len;
+
+            for (uint32_t j = 0; j < msg->len; j++) {
+                // The first byte written in a transfer is the lower byte of the register address
+                if (!reg_ptr_set) {
+                    data->reg_ptr = page | msg->buf[j];
+                    reg_ptr_set   = true;
+                } else {
+                    write_reg(data, data->reg_ptr, msg->buf[j]);
+                    data->reg_ptr = (data->reg_ptr + 1) % NUM_REGS;
+                }
+            }
+        } else {
+            data->stats.bytes_read += msg->len;
+
+            for (uint32_t j = 0; j < msg->len; j++) {
+                msg->buf[j]   = data->regs[data->reg_ptr];
+                data->reg_ptr = (data->reg_ptr + 1) % NUM_REGS;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static const struct i2c_emul_api bus_api = {
+    .transfer = transfer,
+};
+
+static int init_emul(const struct emul *target, const struct device *parent) {
+    const struct lp5813_emul_cfg *cfg = target->cfg;
+    struct lp5813_emul_data *data     = target->data;
+
+    data->cfg = cfg;
+    reset_regs(data);
+
+    gpio_init_callback(&data->en_cb, on_en_changed, BIT(cfg->en_gpio.pin));
+    int res = gpio_add_callback(cfg->en_gpio.port, &data->en_cb);
+    if (res) {
+        LOG_ERR("Failed to add the EN callback of the LP5813 emulator: %d", res);
+        return res;
+    }
+
+    // Register the emulator for the remaining three I2C addresses as well
+    for (int i = 0; i < ARRAY_SIZE(data->extra_addrs); i++) {
+        struct i2c_emul *extra = &data->extra_addrs[i];
+        extra->target          = target;
+        extra->api             = &bus_api;
+        extra->addr            = cfg->addr + 1 + i;
+
+        res = i2c_emul_register(parent, extra);
+        if (res) {
+            LOG_ERR("Failed to register LP5813 emulator at address %X: %d", extra->addr, res);
+            return res;
+        }
+    }
+
+    return 0;
+}
+
+/*********************************************************************************************************************
+ * PUBLIC FUNCTIONS
+ *********************************************************************************************************************/
+uint8_t lp5813_emul_get_reg(const struct emul *target, uint16_t reg) {
+    struct lp5813_emul_data *data = target->data;
+    return data->regs[reg % NUM_REGS];
+}
+
+int lp5813_emul_get_anim(const struct emul *target, int led, struct lp5813_emul_anim_t *anim) {
+    struct lp5813_emul_data *data = target->data;
+
+    if (led < 0 || led >= LP5813_EMUL_NUM_LEDS) {
+        return -EINVAL;
+    }
+
+    memset(anim, 0, sizeof(*anim));
+
+    uint16_t led_en = data->regs[REG_LED_EN_1] | (data->regs[REG_LED_EN_2] << 8);
+    anim->enabled   = (led_en & BIT(led)) != 0;
+
+    // Decode the animation engine registers
+    const uint8_t *regs = &data->regs[REG_BASE_ANIM_LED_0 + led * REG_SIZE_ANIM_LED];
+    uint8_t pause       = regs[REG_OFF_ANIM_AUTO_PAUSE];
+    uint8_t playback    = regs[REG_OFF_ANIM_AUTO_PLAYBACK];
+
+    anim->num_aeus = MIN(((playback >> 4) & 0x3) + 1, 3);
+    anim->reps     = (playback & 0x0F) == 0x0F ? -1 : (playback & 0x0F) + 1;
+
+    uint32_t pattern_ms = durations_ms[pause >> 4] + durations_ms[pause & 0x0F];
+    bool infinite       = anim->reps == -1;
+
+    for (int i = 0; i < anim->num_aeus; i++) {
+        const uint8_t *aeu = &regs[REG_OFF_ANIM_AEU1 + i * REG_SIZE_ANIM_AEU];
+
+        memcpy(anim->pwm[i], &aeu[REG_OFF_AEU_PWM_1], sizeof(anim->pwm[i]));
+        anim->t_ms[i][0]  = durations_ms[aeu[REG_OFF_AEU_T12] & 0x0F];
+        anim->t_ms[i][1]  = durations_ms[aeu[REG_OFF_AEU_T12] >> 4];
+        anim->t_ms[i][2]  = durations_ms[aeu[REG_OFF_AEU_T34] & 0x0F];
+        anim->t_ms[i][3]  = durations_ms[aeu[REG_OFF_AEU_T34] >> 4];
+        anim->aeu_reps[i] = (aeu[REG_OFF_AEU_PLAYBACK] & 0x3) == 0x3 ? -1 : (aeu[REG_OFF_AEU_PLAYBACK] & 0x3) + 1;
+
+        uint32_t aeu_ms = anim->t_ms[i][0] + anim->t_ms[i][1] + anim->t_ms[i][2] + anim->t_ms[i][3];
+        pattern_ms += aeu_ms * MAX(anim->aeu_reps[i], 1);
+        infinite |= anim->aeu_reps[i] == -1;
+    }
+
+    anim->duration_ms = infinite ? 0 : pattern_ms * anim->reps;
+
+    // Simulate the playback
+    if (data->anim_running) {
+        int64_t now      = data->anim_pause_time ? data->anim_pause_time : k_uptime_get();
+        anim->elapsed_ms = now - data->anim_start_time;
+        anim->running    = anim->enabled && (infinite || anim->elapsed_ms < anim->duration_ms);
+    }
+
+    return 0;
+}
+
+void lp5813_emul_get_stats(const struct emul *target, struct lp5813_emul_stats_t *stats) {
+    struct lp5813_emul_data *data = target->data;
+    *stats                        = data->stats;
+}
+
+void lp5813_emul_reset_stats(const struct emul *target) {
+    struct lp5813_emul_data *data = target->data;
+    memset(&data->stats, 0, sizeof(data->stats));
+}
+
+/*********************************************************************************************************************
+ * DEVICE DEFINITIONS
+ *********************************************************************************************************************/
+// The emulator needs a device for its devicetree node; it does not provide any driver API
+static int init_dev(const struct device *dev) {
+    return 0;
+}
+
+#define LP5813_EMUL_DEFINE(n)                                                                          \
+    static struct lp5813_emul_data lp5813_emul_data_##n;                                               \
+    static const struct lp5813_emul_cfg lp5813_emul_cfg_##n = {                                        \
+        .addr    = DT_INST_REG_ADDR(n),                                                                \
+        .en_gpio = GPIO_DT_SPEC_INST_GET(n, enable_gpios),                                             \
+    };                                                                                                 \
+    EMUL_DT_INST_DEFINE(n, init_emul, &lp5813_emul_data_##n, &lp5813_emul_cfg_##n, &bus_api, NULL);    \
+    DEVICE_DT_INST_DEFINE(n, init_dev, NULL, NULL, NULL, POST_KERNEL, CONFIG_I2C_INIT_PRIORITY, NULL);
+
+DT_INST_FOREACH_STATUS_OKAY(LP5813_EMUL_DEFINE)
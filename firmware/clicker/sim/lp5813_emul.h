@@ -0,0 +1,70 @@
+#ifndef LP5813_EMUL_H
+#define LP5813_EMUL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/drivers/emul.h>
+
+// Number of LEDs (channels) of the chip; indices follow the register order (0, 1, 2, 3, A0, A1, A2, B0, ..., D2)
+#define LP5813_EMUL_NUM_LEDS 16
+
+// Bus traffic since the last call to lp5813_emul_reset_stats()
+struct lp5813_emul_stats_t {
+    uint32_t transfers;      // Number of I2C transfers (i.e. START ... STOP sequences)
+    uint32_t bytes_written;  // Number of bytes written, including register addresses
+    uint32_t bytes_read;     // Number of bytes read
+    uint32_t cmd_updates;    // Number of REG_CMD_UPDATE commands
+    uint32_t cmd_starts;     // Number of REG_CMD_START commands
+    uint32_t cmd_stops;      // Number of REG_CMD_STOP commands
+};
+
+// Decoded animation of a single LED, as programmed in the animation engine registers
+struct lp5813_emul_anim_t {
+    bool enabled;             // LED is enabled in LED_EN_1/LED_EN_2
+    bool running;             // Animation was started and has not finished yet
+    int num_aeus;             // Number of active AEUs (1..3)
+    uint8_t pwm[3][5];        // PWM_1..PWM_5 of each AEU
+    uint16_t t_ms[3][4];      // T1..T4 of each AEU in ms
+    int aeu_reps[3];          // Playback times of each AEU; -1 = infinite
+    int reps;                 // Playback times of the whole animation; -1 = infinite
+    uint32_t duration_ms;     // Total duration of the animation; 0 if it runs infinitely
+    int64_t elapsed_ms;       // Time since the animation was started
+};
+
+/**
+ * @brief Gets the current value of a register.
+ *
+ * @param target The LP5813 emulator.
+ * @param reg The register address (0x000 .. 0x3FF).
+ * @retval Value of the register.
+ */
+uint8_t lp5813_emul_get_reg(const struct emul *target, uint16_t reg);
+
+/**
+ * @brief Gets the decoded animation of an LED.
+ *
+ * @param target The LP5813 emulator.
+ * @param led Index of the LED (0 .. LP5813_EMUL_NUM_LEDS - 1).
+ * @param anim Pointer to the structure to fill.
+ *
+ * @retval 0 If successful.
+ * @retval -EINVAL If the LED index is invalid.
+ */
+int lp5813_emul_get_anim(const struct emul *target, int led, struct lp5813_emul_anim_t *anim);
+
+/**
+ * @brief Gets the bus traffic since the last reset of the statistics.
+ *
+ * @param target The LP5813 emulator.
+ * @param stats Pointer to the structure to fill.
+ */
+void lp5813_emul_get_stats(const struct emul *target, struct lp5813_emul_stats_t *stats);
+
+/**
+ * @brief Resets the bus traffic statistics.
+ *
+ * @param target The LP5813 emulator.
+ */
+void lp5813_emul_reset_stats(const struct emul *target);
+
+#endif  // LP5813_EMUL_H
@@ -0,0 +1,92 @@
+#define DT_DRV_COMPAT yohummus_pwm_capture_emul
+
+#include "pwm_capture_emul.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/pm/device.h>
+
+// Cycles are nanoseconds, so pwm_set() passes its arguments through unchanged
+#define CYCLES_PER_SEC NSEC_PER_SEC
+
+struct pwm_capture_emul_data {
+    struct pwm_capture_emul_channel_t channels[PWM_CAPTURE_EMUL_NUM_CHANNELS];
+    uint32_t set_count;
+    struct k_spinlock lock;
+};
+
+/*********************************************************************************************************************
+ * DRIVER API
+ *********************************************************************************************************************/
+static int set_cycles(const struct device *dev, uint32_t channel, uint32_t period_cycles, uint32_t pulse_cycles,
+                      pwm_flags_t flags) {
+    struct pwm_capture_emul_data *data = dev->data;
+
+    if (channel >= PWM_CAPTURE_EMUL_NUM_CHANNELS) {
+        return -EINVAL;
+    }
+
+    k_spinlock_key_t key              = k_spin_lock(&data->lock);
+    data->channels[channel].period_ns = period_cycles;
+    data->channels[channel].pulse_ns  = pulse_cycles;
+    data->channels[channel].flags     = flags;
+    data->set_count++;
+    k_spin_unlock(&data->lock, key);
+
+    return 0;
+}
+
+static int get_cycles_per_sec(const struct device *dev, uint32_t channel, uint64_t *cycles) {
+    if (channel >= PWM_CAPTURE_EMUL_NUM_CHANNELS) {
+        return -EINVAL;
+    }
+
+    *cycles = CYCLES_PER_SEC;
+    return 0;
+}
+
+static const struct pwm_driver_api api = {
+    .set_cycles         = set_cycles,
+    .get_cycles_per_sec = get_cycles_per_sec,
+};
+
+static int pm_action(const struct device *dev, enum pm_device_action action) {
+    // Nothing to do; the emulator only needs to support PM so that runtime PM can be tracked on native_sim
+    return 0;
+}
+
+static int init(const struct device *dev) {
+    return pm_device_driver_init(dev, pm_action);
+}
+
+/*********************************************************************************************************************
+ * PUBLIC FUNCTIONS
+ *********************************************************************************************************************/
+int pwm_capture_emul_get_channel(const struct device *dev, uint32_t channel, struct pwm_capture_emul_channel_t *state) {
+    struct pwm_capture_emul_data *data = dev->data;
+
+    if (channel >= PWM_CAPTURE_EMUL_NUM_CHANNELS) {
+        return -EINVAL;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+    *state               = data->channels[channel];
+    k_spin_unlock(&data->lock, key);
+
+    return 0;
+}
+
+uint32_t pwm_capture_emul_get_set_count(const struct device *dev) {
+    struct pwm_capture_emul_data *data = dev->data;
+    return data->set_count;
+}
+
+/*********************************************************************************************************************
+ * DEVICE DEFINITIONS
+ *********************************************************************************************************************/
+#define PWM_CAPTURE_EMUL_DEFINE(n)                                                                          \
+    static struct pwm_capture_emul_data pwm_capture_emul_data_##n;                                          \
+    PM_DEVICE_DT_INST_DEFINE(n, pm_action);                                                                 \
+    DEVICE_DT_INST_DEFINE(n, init, PM_DEVICE_DT_INST_GET(n), &pwm_capture_emul_data_##n, NULL, POST_KERNEL, \
+                          CONFIG_PWM_INIT_PRIORITY, &api);
+
+DT_INST_FOREACH_STATUS_OKAY(PWM_CAPTURE_EMUL_DEFINE)
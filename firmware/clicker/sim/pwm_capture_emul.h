@@ -0,0 +1,37 @@
+#ifndef PWM_CAPTURE_EMUL_H
+#define PWM_CAPTURE_EMUL_H
+
+#include <stdint.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/pwm.h>
+
+// Number of channels of the emulated PWM controller (same as the nRF52840 PWM peripheral)
+#define PWM_CAPTURE_EMUL_NUM_CHANNELS 4
+
+struct pwm_capture_emul_channel_t {
+    uint32_t period_ns;
+    uint32_t pulse_ns;
+    pwm_flags_t flags;
+};
+
+/**
+ * @brief Gets the current configuration of a channel of the emulated PWM controller.
+ *
+ * @param dev The emulated PWM controller.
+ * @param channel The channel to get the configuration of.
+ * @param state Pointer to the structure to fill.
+ *
+ * @retval 0 If successful.
+ * @retval -EINVAL If the channel is invalid.
+ */
+int pwm_capture_emul_get_channel(const struct device *dev, uint32_t channel, struct pwm_capture_emul_channel_t *state);
+
+/**
+ * @brief Gets the number of pwm_set() calls on the emulated PWM controller since startup.
+ *
+ * @param dev The emulated PWM controller.
+ * @retval >=0 Number of pwm_set() calls.
+ */
+uint32_t pwm_capture_emul_get_set_count(const struct device *dev);
+
+#endif  // PWM_CAPTURE_EMUL_H
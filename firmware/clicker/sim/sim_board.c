@@ -0,0 +1,69 @@
+#include "sim_board.h"
+
+#include <zephyr/drivers/adc.h>
+#include <zephyr/drivers/adc/adc_emul.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(app_sim_board);
+
+// Initial state of the simulated board
+#define INITIAL_BATTERY_MV 3000
+
+// Emulated devices
+static const struct gpio_dt_spec buttons[] = {
+    GPIO_DT_SPEC_GET(DT_NODELABEL(button_1), gpios),  // BUTTONS_BTN_1
+    GPIO_DT_SPEC_GET(DT_NODELABEL(button_2), gpios),  // BUTTONS_BTN_2
+    GPIO_DT_SPEC_GET(DT_NODELABEL(button_3), gpios),  // BUTTONS_BTN_3
+    GPIO_DT_SPEC_GET(DT_NODELABEL(button_4), gpios),  // BUTTONS_BTN_4
+    GPIO_DT_SPEC_GET(DT_NODELABEL(button_5), gpios),  // BUTTONS_BTN_5
+    GPIO_DT_SPEC_GET(DT_NODELABEL(button_6), gpios),  // BUTTONS_BTN_SHIFT
+};
+
+static const struct adc_dt_spec adc = ADC_DT_SPEC_GET(DT_PATH(zephyr_user));
+
+/*********************************************************************************************************************
+ * STARTUP HOOKS
+ *********************************************************************************************************************/
+static int init_sim_board() {
+    // The emulated GPIOs only accept input values for pins configured as inputs; the pull-ups are not emulated,
+    // so we release all (active-low) buttons explicitly
+    for (int i = 0; i < ARRAY_SIZE(buttons); i++) {
+        int res = gpio_pin_configure_dt(&buttons[i], GPIO_INPUT);
+        if (res == 0) {
+            res = sim_board_set_button((enum buttons_button_t)i, false);
+        }
+
+        if (res != 0) {
+            LOG_ERR("Failed to initialize simulated button %d: %d", i + 1, res);
+        }
+    }
+
+    int res = sim_board_set_battery_mv(INITIAL_BATTERY_MV);
+    if (res != 0) {
+        LOG_ERR("Failed to initialize simulated battery voltage: %d", res);
+    }
+
+    return 0;
+}
+
+SYS_INIT(init_sim_board, POST_KERNEL, 99);
+
+/*********************************************************************************************************************
+ * PUBLIC FUNCTIONS
+ *********************************************************************************************************************/
+int sim_board_set_button(enum buttons_button_t button, bool pressed) {
+    if (button >= ARRAY_SIZE(buttons)) {
+        return -EINVAL;
+    }
+
+    // The buttons are active-low
+    const struct gpio_dt_spec *spec = &buttons[button];
+    return gpio_emul_input_set(spec->port, spec->pin, pressed ? 0 : 1);
+}
+
+int sim_board_set_battery_mv(int mv) {
+    return adc_emul_const_value_set(adc.dev, adc.channel_id, (uint32_t)mv);
+}
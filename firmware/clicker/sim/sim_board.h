@@ -0,0 +1,29 @@
+#ifndef SIM_BOARD_H
+#define SIM_BOARD_H
+
+#include <stdbool.h>
+
+#include "../src/buttons.h"
+
+/**
+ * @brief Presses or releases a button on the simulated board.
+ *
+ * @param button The button to press or release.
+ * @param pressed True to press the button, false to release it.
+ *
+ * @retval 0 If successful.
+ * @retval <0 Error code if setting the GPIO input failed.
+ */
+int sim_board_set_button(enum buttons_button_t button, bool pressed);
+
+/**
+ * @brief Sets the battery voltage seen by the ADC of the simulated board.
+ *
+ * @param mv The battery voltage in mV.
+ *
+ * @retval 0 If successful.
+ * @retval <0 Error code if setting the ADC input failed.
+ */
+int sim_board_set_battery_mv(int mv);
+
+#endif  // SIM_BOARD_H
@@ -0,0 +1,80 @@
+#include "sim_board.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(app_sim_workload);
+
+#if !defined(CONFIG_APP_SIM_WORKLOAD_NONE)
+
+// Thread configuration
+#define THREAD_STACK_SIZE 1024
+#define THREAD_PRIORITY   10
+
+// Macros for readability
+#define CLICK(delay_ms_, button_, press_ms_, reps_) \
+    {.delay_ms = (delay_ms_), .button = (button_), .press_ms = (press_ms_), .reps = (reps_)}
+#define SHORT_PRESS 150
+#define LONG_PRESS  2500
+
+// A (repeated) click within a workload
+struct click_t {
+    uint32_t delay_ms;  // Time between the release of the previous click and the press of this one
+    enum buttons_button_t button;
+    uint16_t press_ms;  // Time the button is held down
+    uint16_t reps;      // Number of times this click is repeated
+};
+
+// Workloads; once a workload has finished, the device enters System OFF after CONFIG_APP_IDLE_TIMEOUT_S seconds,
+// which prints the profiling and energy results
+#if defined(CONFIG_APP_SIM_WORKLOAD_PRESENTATION)
+static const struct click_t workload[] = {
+    CLICK(30000, BUTTONS_BTN_2, SHORT_PRESS, 110),  // Next slide
+    CLICK(30000, BUTTONS_BTN_1, SHORT_PRESS, 5),    // Previous slide
+    CLICK(30000, BUTTONS_BTN_2, SHORT_PRESS, 5),    // Next slide
+};
+#elif defined(CONFIG_APP_SIM_WORKLOAD_QUIZ)
+static const struct click_t workload[] = {
+    CLICK(1000, BUTTONS_BTN_3, SHORT_PRESS, 1),      // Answer
+    CLICK(200, BUTTONS_BTN_3, SHORT_PRESS, 3),       // Changed the mind a few times
+    CLICK(5000, BUTTONS_BTN_SHIFT, SHORT_PRESS, 2),  // Shift combination
+    CLICK(100, BUTTONS_BTN_5, SHORT_PRESS, 1),       //
+    CLICK(3000, BUTTONS_BTN_1, LONG_PRESS, 1),       // Long press
+    CLICK(500, BUTTONS_BTN_2, SHORT_PRESS, 20),      // Fast answers
+};
+#elif defined(CONFIG_APP_SIM_WORKLOAD_IDLE)
+// The pauses stay just below the idle timeout, so that the device sleeps in System ON for most of the workload
+// instead of ending it by entering System OFF
+#define IDLE_PAUSE_MS (MAX(CONFIG_APP_IDLE_TIMEOUT_S - 10, 1) * 1000)
+static const struct click_t workload[] = {
+    CLICK(1000, BUTTONS_BTN_1, SHORT_PRESS, 1),              // Picked up from the desk
+    CLICK(IDLE_PAUSE_MS, BUTTONS_BTN_2, SHORT_PRESS, 6),     // Occasional clicks
+    CLICK(IDLE_PAUSE_MS / 2, BUTTONS_BTN_3, LONG_PRESS, 1),  // Long press
+    CLICK(IDLE_PAUSE_MS, BUTTONS_BTN_2, SHORT_PRESS, 4),     // Occasional clicks
+};
+#endif
+
+/*********************************************************************************************************************
+ * THREADS
+ *********************************************************************************************************************/
+static void sim_workload_thread_fn() {
+    LOG_INF("Replaying workload with %d steps", ARRAY_SIZE(workload));
+
+    for (int i = 0; i < ARRAY_SIZE(workload); i++) {
+        const struct click_t *click = &workload[i];
+
+        for (int rep = 0; rep < click->reps; rep++) {
+            k_msleep(click->delay_ms);
+            sim_board_set_button(click->button, true);
+            k_msleep(click->press_ms);
+            sim_board_set_button(click->button, false);
+        }
+    }
+
+    LOG_INF("Workload finished; waiting for System OFF");
+}
+
+K_THREAD_DEFINE(sim_workload_thread_id, THREAD_STACK_SIZE, sim_workload_thread_fn, NULL, NULL, NULL, THREAD_PRIORITY,
+                0, 0);
+
+#endif  // !CONFIG_APP_SIM_WORKLOAD_NONE
@@ -1,13 +1,16 @@
+#include "energy.h"
+#include "retained.h"
+#include "stats.h"
+#include "trace.h"
+#include "workq.h"
+
 #include <zephyr/drivers/adc.h>
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/pm/device_runtime.h>
 
 LOG_MODULE_REGISTER(app_battery);
 
-// Thread configuration
-#define THREAD_STACK_SIZE 1024
-#define THREAD_PRIORITY   10
-
 // Timing configuration
 #define SAMPLE_INTERVAL       K_SECONDS(1)
 #define SAMPLE_AVERAGE_COUNT  4
@@ -16,9 +19,12 @@ LOG_MODULE_REGISTER(app_battery);
 // ADC device
 static const struct adc_dt_spec adc = ADC_DT_SPEC_GET(DT_PATH(zephyr_user));
 
-// Semaphores and global state
+// Global state
 static atomic_t avg_adc_reading;  // 0 initially until first read, -1 in case of an error
 
+static int16_t samples[SAMPLE_AVERAGE_COUNT];  // Only accessed from the work queue
+static int sample_idx = 0;
+
 /*********************************************************************************************************************
  * PRIVATE FUNCTIONS
  *********************************************************************************************************************/
@@ -51,71 +57,105 @@ static bool read_adc(int16_t *val) {
     seq.buffer_size  = sizeof(*val);
     seq.oversampling = OVERSAMPLING_EXPONENT;
 
+    // The SAADC is only resumed for the duration of the conversion
+    res = pm_device_runtime_get(adc.dev);
+    if (res) {
+        LOG_ERR("Failed to resume ADC device: %d", res);
+        return false;
+    }
+
+    stats_add(STATS_ADC_READS, 1);
+    energy_state_begin(ENERGY_ADC_ON);
     res = adc_read_dt(&adc, &seq);
+    energy_state_end(ENERGY_ADC_ON);
+    pm_device_runtime_put(adc.dev);
     if (res) {
         LOG_ERR("Failed to read ADC: %d", res);
         return false;
     }
 
+    trace(TRACE_MOD_BATTERY, TRACE_EVT_BATTERY_SAMPLE, (uint16_t)*val);
     return true;
 }
 
 /*********************************************************************************************************************
- * THREADS
+ * WORK HANDLERS
  *********************************************************************************************************************/
-static void battery_thread_fn() {
-    if (!init_adc()) {
+static void sample_work_fn(struct k_work *work) {
+    // Read the ADC into the next sample slot
+    if (!read_adc(&samples[sample_idx])) {
+        atomic_set(&avg_adc_reading, -1);
+        LOG_ERR("Failed to read ADC; battery module disabled");
         return;
     }
 
-    // Create a buffer for the samples
-    int16_t samples[SAMPLE_AVERAGE_COUNT];
-    int sample_idx = 0;
-
-    // First reading; set all samples to the same first reading
-    int16_t sample;
-    if (!read_adc(&sample)) goto error;
-    atomic_set(&avg_adc_reading, (int32_t)sample);
+    sample_idx = (sample_idx + 1) % SAMPLE_AVERAGE_COUNT;
 
+    // Update the average ADC reading
+    int32_t sum = 0;
     for (int i = 0; i < SAMPLE_AVERAGE_COUNT; ++i) {
-        samples[i] = sample;
+        sum += samples[i];
     }
 
-    LOG_INF("Battery module initialized OK; waiting for commands");
+    int16_t avg = (int16_t)(sum / SAMPLE_AVERAGE_COUNT);
+    atomic_set(&avg_adc_reading, avg);
 
-    // Main loop, periodically reading the battery voltage
-    while (true) {
-        k_sleep(SAMPLE_INTERVAL);
+    // The checksum of the retained state is only updated if the average actually changed
+    if (retained.battery_avg_adc != avg) {
+        retained.battery_avg_adc = avg;
+        retained_update();
+    }
 
-        // Read the ADC into the next sample slot
-        if (!read_adc(&samples[sample_idx])) goto error;
-        sample_idx = (sample_idx + 1) % SAMPLE_AVERAGE_COUNT;
+    // Schedule the next reading
+    k_work_schedule_for_queue(&workq, k_work_delayable_from_work(work), SAMPLE_INTERVAL);
+}
 
-        // Update the average ADC reading
-        int32_t sum = 0;
-        for (int i = 0; i < SAMPLE_AVERAGE_COUNT; ++i) {
-            sum += samples[i];
-        }
+K_WORK_DELAYABLE_DEFINE(battery_sample_work, sample_work_fn);
 
-        atomic_set(&avg_adc_reading, sum / SAMPLE_AVERAGE_COUNT);
+/*********************************************************************************************************************
+ * STARTUP HOOKS
+ *********************************************************************************************************************/
+static int init_battery() {
+    if (!init_adc()) {
+        atomic_set(&avg_adc_reading, -1);
+        return 0;
+    }
+
+    // First reading; set all samples to the same first reading, which is the average from the previous wake cycle
+    // if available (this avoids the first conversion right after a wake-up)
+    int16_t sample = retained.battery_avg_adc;
+    if (sample <= 0 && !read_adc(&sample)) {
+        atomic_set(&avg_adc_reading, -1);
+        LOG_ERR("Failed to read ADC; battery module disabled");
+        return 0;
+    }
+
+    atomic_set(&avg_adc_reading, (int32_t)sample);
+
+    for (int i = 0; i < SAMPLE_AVERAGE_COUNT; ++i) {
+        samples[i] = sample;
     }
 
-error:
-    atomic_set(&avg_adc_reading, -1);
-    LOG_ERR("Failed to read ADC; battery module disabled");
+    // Periodically read the battery voltage
+    k_work_schedule_for_queue(&workq, &battery_sample_work, SAMPLE_INTERVAL);
+
+    LOG_INF("Battery module initialized OK");
+
+    return 0;
 }
 
-K_THREAD_DEFINE(battery_thread_id, THREAD_STACK_SIZE, battery_thread_fn, NULL, NULL, NULL, THREAD_PRIORITY, 0, 0);
+SYS_INIT(init_battery, APPLICATION, 0);
 
 /*********************************************************************************************************************
  * PUBLIC FUNCTIONS
  *********************************************************************************************************************/
 int battery_get_voltage_mv() {
-    // Get the reading from the battery thread, if it is 0, we are still initializing
+    // Get the reading from the battery module; 0 means that the first reading has not been taken yet
     int32_t raw = atomic_get(&avg_adc_reading);
-    while (raw == 0) {
-        k_sleep(K_MSEC(1));
-        raw = atomic_get(&avg_adc_reading);
+    if (raw == 0) {
+        return -EAGAIN;
+    } else if (raw < 0) {
+        return -EIO;
     }
 
     // Convert the ADC reading to millivolts
@@ -123,7 +163,7 @@ int battery_get_voltage_mv() {
     int res    = adc_raw_to_millivolts_dt(&adc, &mv);
     if (res) {
         LOG_ERR("Failed to convert ADC raw value to millivolts: %d", res);
-        return false;
+        return res;
     }
 
     return (int)mv;
@@ -4,8 +4,11 @@
 /**
  * @brief Gets the latest measurement of the battery voltage.
  *
+ * Never blocks; the voltage is the average of the samples that the battery module takes in the background.
+ *
  * @retval >0 Battery voltage in mV.
- * @retval -1 In case of an error.
+ * @retval -EAGAIN If the first sample has not been taken yet.
+ * @retval <0 Other error code if the battery voltage could not be measured.
  */
 int battery_get_voltage_mv();
 
@@ -1,9 +1,12 @@
 #include "bluetooth.h"
 #include "battery.h"
+#include "idle.h"
+#include "trace.h"
 #include "services/battery_svc.h"
 #include "services/config_svc.h"
 
 #include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
 #include <zephyr/bluetooth/gatt.h>
 #include <zephyr/bluetooth/hci.h>
 #include <zephyr/bluetooth/uuid.h>
@@ -25,12 +28,46 @@ static const struct bt_data sd[] = {
     BT_DATA(BT_DATA_NAME_COMPLETE, CONFIG_BT_DEVICE_NAME, (sizeof(CONFIG_BT_DEVICE_NAME) - 1)),
 };
 
+// Unit of the connection interval
+#define CONN_INTERVAL_UNIT_US 1250
+
 // Semaphores
 K_SEM_DEFINE(bluetooth_ready, 1, 1);
 
+// Link parameters requested on every connection to speed up bulk transfers (see services/bulk_svc.c)
+static struct bt_gatt_exchange_params mtu_exchange_params;
+
 /*********************************************************************************************************************
  * PRIVATE FUNCTIONS
  *********************************************************************************************************************/
+static void on_mtu_exchanged(struct bt_conn *conn, uint8_t err, struct bt_gatt_exchange_params *params) {
+    if (err) {
+        LOG_WRN("MTU exchange failed with error %d", err);
+        return;
+    }
+
+    LOG_INF("MTU exchanged: %d bytes", bt_gatt_get_mtu(conn));
+}
+
+static void request_fast_link(struct bt_conn *conn) {
+    // Each request is answered asynchronously; if the central does not support a feature, we keep the defaults
+    int err = bt_conn_le_phy_update(conn, BT_CONN_LE_PHY_PARAM_2M);
+    if (err) {
+        LOG_WRN("bt_conn_le_phy_update() returned %d", err);
+    }
+
+    err = bt_conn_le_data_len_update(conn, BT_LE_DATA_LEN_PARAM_MAX);
+    if (err) {
+        LOG_WRN("bt_conn_le_data_len_update() returned %d", err);
+    }
+
+    mtu_exchange_params.func = on_mtu_exchanged;
+    err                      = bt_gatt_exchange_mtu(conn, &mtu_exchange_params);
+    if (err) {
+        LOG_WRN("bt_gatt_exchange_mtu() returned %d", err);
+    }
+}
+
 static void on_bluetooth_ready(int err) {
     if (err) {
         LOG_ERR("on_bluetooth_ready() called with error %d", err);
@@ -39,6 +76,53 @@ static void on_bluetooth_ready(int err) {
     k_sem_give(&bluetooth_ready);
 }
 
+static void on_connected(struct bt_conn *conn, uint8_t err) {
+    trace(TRACE_MOD_BLE, TRACE_EVT_BLE_CONNECTED, err);
+    if (err) {
+        LOG_ERR("Connection failed with error %d", err);
+        return;
+    }
+
+    // Stay awake while a central is connected
+    LOG_INF("Connected");
+    idle_set_busy(IDLE_SRC_BLE, true);
+    request_fast_link(conn);
+
+    // The connection interval bounds the latency that BLE adds to clicks (see src/timeslot.c)
+    struct bt_conn_info info;
+    if (bt_conn_get_info(conn, &info) == 0) {
+        trace(TRACE_MOD_BLE, TRACE_EVT_BLE_CONN_PARAMS, info.le.interval * CONN_INTERVAL_UNIT_US);
+    }
+}
+
+static void on_disconnected(struct bt_conn *conn, uint8_t reason) {
+    LOG_INF("Disconnected (reason %d)", reason);
+    trace(TRACE_MOD_BLE, TRACE_EVT_BLE_DISCONNECTED, reason);
+    idle_set_busy(IDLE_SRC_BLE, false);
+}
+
+static void on_le_param_updated(struct bt_conn *conn, uint16_t interval, uint16_t latency, uint16_t timeout) {
+    LOG_INF("Connection parameters updated: interval %u us, latency %u, timeout %u ms",
+            interval * CONN_INTERVAL_UNIT_US, latency, timeout * 10);
+    trace(TRACE_MOD_BLE, TRACE_EVT_BLE_CONN_PARAMS, interval * CONN_INTERVAL_UNIT_US);
+}
+
+static void on_phy_updated(struct bt_conn *conn, struct bt_conn_le_phy_info *param) {
+    LOG_INF("PHY updated: TX %d, RX %d", param->tx_phy, param->rx_phy);
+}
+
+static void on_data_len_updated(struct bt_conn *conn, struct bt_conn_le_data_len_info *info) {
+    LOG_INF("Data length updated: TX %d bytes, RX %d bytes", info->tx_max_len, info->rx_max_len);
+}
+
+BT_CONN_CB_DEFINE(conn_callbacks) = {
+    .connected           = on_connected,
+    .disconnected        = on_disconnected,
+    .le_param_updated    = on_le_param_updated,
+    .le_phy_updated      = on_phy_updated,
+    .le_data_len_updated = on_data_len_updated,
+};
+
 /*********************************************************************************************************************
  * PUBLIC FUNCTIONS
  *********************************************************************************************************************/
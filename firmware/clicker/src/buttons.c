@@ -1,9 +1,17 @@
 #include "buttons.h"
+#include "energy.h"
+#include "idle.h"
+#include "profiling.h"
+#include "stats.h"
+#include "trace.h"
 
-#include <hal/nrf_gpio.h>
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/logging/log.h>
 
+#if defined(CONFIG_SOC_FAMILY_NORDIC_NRF)
+#include <hal/nrf_gpio.h>
+#endif
+
 LOG_MODULE_REGISTER(app_buttons);
 
 // Thread configuration
@@ -15,10 +23,10 @@ LOG_MODULE_REGISTER(app_buttons);
 #define LONG_PRESS_THRESHOLD_ON_WAKEUP K_MSEC(1500)
 
 // GPIO devices
-#define BUTTON_DEF(node_label)                                                \
-    (struct button_t) {                                                       \
-        .spec = GPIO_DT_SPEC_GET(DT_NODELABEL(node_label), gpios),            \
-        .port = DT_PROP(DT_GPIO_CTLR(DT_NODELABEL(node_label), gpios), port), \
+#define BUTTON_DEF(node_label)                                                      \
+    (struct button_t) {                                                             \
+        .spec = GPIO_DT_SPEC_GET(DT_NODELABEL(node_label), gpios),                  \
+        .port = DT_PROP_OR(DT_GPIO_CTLR(DT_NODELABEL(node_label), gpios), port, 0), \
     }
 
 struct button_t {
@@ -43,10 +51,15 @@ struct buttons_fifo_item_t {
 };
 
 K_FIFO_DEFINE(buttons_fifo);
+static atomic_t buttons_fifo_depth;  // Number of items in the FIFO (for the statistics only)
 
 // Sempahore for the ISR to signal the thread to check for button presses/releases
 K_SEM_DEFINE(buttons_sem, 0, 1);
 
+// Hardware cycles of the last button interrupt; presses are timed in the ISR so that the time does not depend on
+// when the thread gets to run (which matters for the time sync, see radio.c)
+static atomic_t last_edge_cycles;
+
 // Status of the LATCH registers at startup to check which button triggered exit from System OFF
 static uint32_t gpio_latch_at_startup[2] = {0};
 
@@ -54,7 +67,14 @@ static uint32_t gpio_latch_at_startup[2] = {0};
  * STARTUP HOOKS
  *********************************************************************************************************************/
 static int detect_wakup_latch() {
-    nrf_gpio_latches_read(0, ARRAY_SIZE(gpio_latch_at_startup), gpio_latch_at_startup);
+#if defined(CONFIG_SOC_FAMILY_NORDIC_NRF)
+    // Clear the latches as well so that they only reflect the wake-up source of the next System OFF cycle
+    nrf_gpio_latches_read_and_clear(0, ARRAY_SIZE(gpio_latch_at_startup), gpio_latch_at_startup);
+#elif defined(CONFIG_APP_SIM_WAKEUP_BUTTON) && CONFIG_APP_SIM_WAKEUP_BUTTON > 0
+    // The simulated board has no latches; pretend that the configured button woke us up
+    const struct button_t *btn       = &buttons[CONFIG_APP_SIM_WAKEUP_BUTTON - 1];
+    gpio_latch_at_startup[btn->port] = BIT(btn->spec.pin);
+#endif
     return 0;
 }
 
@@ -65,6 +85,7 @@ SYS_INIT(detect_wakup_latch, PRE_KERNEL_1, 0);
  *********************************************************************************************************************/
 static void button_pressed(const struct device *port, struct gpio_callback *cb, gpio_port_pins_t pins) {
     // Signal the thread to check for button presses/releases
+    atomic_set(&last_edge_cycles, k_cycle_get_32());
     k_sem_give(&buttons_sem);
 }
 
@@ -129,6 +150,8 @@ static void buttons_thread_fn() {
     const struct button_t *pressed_button = NULL;
     k_timepoint_t long_press_exp_time     = sys_timepoint_calc(K_FOREVER);
     int preceding_short_shift_presses     = 0;
+    uint32_t press_cycles                 = 0;  // A press that woke us up counts from the start of the clock
+    uint32_t press_uptime_ms              = 0;
 
     LOG_INF("Buttons module initialized OK; waiting for button presses");
 
@@ -138,6 +161,7 @@ static void buttons_thread_fn() {
         if (gpio_latch_at_startup[btn->port] & BIT(btn->spec.pin)) {
             long_press_exp_time = sys_timepoint_calc(LONG_PRESS_THRESHOLD_ON_WAKEUP);
             pressed_button      = btn;
+            idle_set_busy(IDLE_SRC_BUTTONS, true);
             LOG_INF("Button %d was pressed at startup", i + 1);
             break;
         }
@@ -151,15 +175,26 @@ static void buttons_thread_fn() {
     while (true) {
         // If, until now, no button has been pressed, we check if any button is pressed now
         if (pressed_button == NULL) {
+            PROFILING_BEGIN(PROFILING_BUTTON_SCAN);
+
             for (int i = 0; i < ARRAY_SIZE(buttons); i++) {
                 const struct button_t *btn = &buttons[i];
 
                 if (is_button_pressed(btn)) {
                     long_press_exp_time = sys_timepoint_calc(LONG_PRESS_THRESHOLD);
                     pressed_button      = btn;
+                    press_cycles        = atomic_get(&last_edge_cycles);
+                    press_uptime_ms     = k_uptime_get_32() - k_cyc_to_ms_floor32(k_cycle_get_32() - press_cycles);
                     break;
                 }
             }
+
+            PROFILING_END(PROFILING_BUTTON_SCAN);
+
+            if (pressed_button) {
+                idle_set_busy(IDLE_SRC_BUTTONS, true);
+                trace(TRACE_MOD_BUTTONS, TRACE_EVT_BUTTON_PRESSED, ARRAY_INDEX(buttons, pressed_button));
+            }
         }
 
         // Otherwise, if, until now, a button has been pressed, we check if that button has now been released,
@@ -175,9 +210,16 @@ static void buttons_thread_fn() {
                 item->event.button               = (enum buttons_button_t)(ARRAY_INDEX(buttons, pressed_button));
                 item->event.is_long_press        = is_long_press;
                 item->event.preceding_short_shift_presses = preceding_short_shift_presses;
+                item->event.uptime_ms                     = press_uptime_ms;
+                item->event.press_cycles                  = press_cycles;
                 LOG_INF("New button event: button=%d, long=%d, pssp=%d", item->event.button + 1,
                         item->event.is_long_press, item->event.preceding_short_shift_presses);
                 k_fifo_put(&buttons_fifo, item);
+                stats_set_queue_depth(STATS_QUEUE_BUTTONS, atomic_inc(&buttons_fifo_depth) + 1);
+                energy_count_click();
+                trace(TRACE_MOD_BUTTONS, TRACE_EVT_BUTTON_EVENT,
+                      item->event.button | (item->event.is_long_press << 8) |
+                          (item->event.preceding_short_shift_presses << 16));
 
                 // Update the state
                 if (pressed_button == &buttons[BUTTONS_BTN_SHIFT] && !is_long_press) {
@@ -188,6 +230,7 @@ static void buttons_thread_fn() {
 
                 pressed_button      = NULL;
                 long_press_exp_time = sys_timepoint_calc(K_FOREVER);
+                idle_set_busy(IDLE_SRC_BUTTONS, false);
             }
         }
 
@@ -207,7 +250,21 @@ int buttons_get_event(struct buttons_event_t *event, k_timeout_t timeout) {
         return -ETIMEDOUT;
     }
 
+    stats_set_queue_depth(STATS_QUEUE_BUTTONS, atomic_dec(&buttons_fifo_depth) - 1);
     *event = item->event;
     k_free(item);
     return 0;
-}
\ No newline at end of file
+}
+
+int buttons_arm_wakeup() {
+    for (int i = 0; i < ARRAY_SIZE(buttons); i++) {
+        // A level interrupt sets up the SENSE mechanism of the pin, which is what wakes the device from System OFF
+        int res = gpio_pin_interrupt_configure_dt(&buttons[i].spec, GPIO_INT_LEVEL_ACTIVE);
+        if (res != 0) {
+            LOG_ERR("Failed to configure wake-up for button %d: %d", i + 1, res);
+            return res;
+        }
+    }
+
+    return 0;
+}
@@ -17,6 +17,8 @@ struct buttons_event_t {
     enum buttons_button_t button;
     bool is_long_press;
     int preceding_short_shift_presses;
+    uint32_t uptime_ms;     // Time of the press (k_uptime_get_32())
+    uint32_t press_cycles;  // Time of the press in hardware cycles (k_cycle_get_32()), taken in the interrupt
 };
 
 /**
@@ -31,4 +33,15 @@ struct buttons_event_t {
  */
 int buttons_get_event(struct buttons_event_t *event, k_timeout_t timeout);
 
+/**
+ * @brief Arms all buttons to wake the device from System OFF.
+ *
+ * After calling this function, no more button events will be generated; it is meant to be called right before
+ * entering System OFF.
+ *
+ * @retval 0 If successful.
+ * @retval <0 Error code if configuring the wake-up failed.
+ */
+int buttons_arm_wakeup();
+
 #endif  // BUTTONS_H
@@ -1,4 +1,7 @@
 #include "config.h"
+#include "profiling.h"
+#include "retained.h"
+#include "trace.h"
 
 #include <zephyr/drivers/flash.h>
 #include <zephyr/fs/nvs.h>
@@ -12,6 +15,7 @@ LOG_MODULE_REGISTER(app_config);
 #define NVS_PARTITION_DEVICE FIXED_PARTITION_DEVICE(NVS_PARTITION)
 #define NVS_PARTITION_OFFSET FIXED_PARTITION_OFFSET(NVS_PARTITION)
 #define NVS_FS_ENTRY_ID      1
+#define NVS_COUNTER_ENTRY_ID 2
 
 // Global state
 static bool is_initialized = false;
@@ -52,11 +56,41 @@ static int init_nvs() {
     return 0;
 }
 
+static int write_config(const struct config_t *config) {
+    // Initialize the NVS if necessary
+    int res = init_nvs();
+    if (res) return res;
+
+    // Save the configuration to NVS
+    res = nvs_write(&fs, NVS_FS_ENTRY_ID, config, sizeof(*config));
+    if (res > 0) {
+        LOG_INF("Configuration saved to NVS (%d bytes)", res);
+    } else if (res == 0) {
+        LOG_INF("Configuration already up-to-date, nothing written");
+    } else {
+        LOG_ERR("Failed to write configuration to NVS: %d", res);
+        return res;
+    }
+
+    retained.config       = *config;
+    retained.config_valid = true;
+    retained_update();
+
+    return 0;
+}
+
 /*********************************************************************************************************************
  * PUBLIC FUNCTIONS
  *********************************************************************************************************************/
 
 int config_load(struct config_t *config) {
+    // Use the copy in retained RAM if we have one (saves mounting the NVS and reading the flash after a wake-up)
+    if (retained.config_valid) {
+        *config = retained.config;
+        trace(TRACE_MOD_CONFIG, TRACE_EVT_CONFIG_LOAD, 0);
+        return 0;
+    }
+
     // Initialize the NVS if necessary
     int res = init_nvs();
     if (res) return res;
@@ -73,24 +107,69 @@ int config_load(struct config_t *config) {
         return res;
     }
 
+    retained.config       = *config;
+    retained.config_valid = true;
+    retained_update();
+    trace(TRACE_MOD_CONFIG, TRACE_EVT_CONFIG_LOAD, 1);
+
     return 0;
 }
 
 int config_save(const struct config_t *config) {
+    PROFILING_BEGIN(PROFILING_CONFIG_SAVE);
+    int res = write_config(config);
+    PROFILING_END(PROFILING_CONFIG_SAVE);
+    trace(TRACE_MOD_CONFIG, TRACE_EVT_CONFIG_SAVE, res);
+
+    return res;
+}
+
+int config_verify(const struct config_t *config) {
     // Initialize the NVS if necessary
     int res = init_nvs();
     if (res) return res;
 
-    // Save the configuration to NVS
-    res = nvs_write(&fs, NVS_FS_ENTRY_ID, config, sizeof(*config));
-    if (res > 0) {
-        LOG_INF("Configuration saved to NVS (%d bytes)", res);
-    } else if (res == 0) {
-        LOG_INF("Configuration already up-to-date, nothing written");
-    } else {
-        LOG_ERR("Failed to write configuration to NVS: %d", res);
+    struct config_t stored;
+    res = nvs_read(&fs, NVS_FS_ENTRY_ID, &stored, sizeof(stored));
+    if (res != sizeof(stored)) {
+        LOG_ERR("Failed to read back configuration from NVS: %d", res);
+        return res < 0 ? res : -EIO;
+    }
+
+    if (memcmp(&stored, config, sizeof(stored)) != 0) {
+        LOG_ERR("Configuration in NVS does not match the written one");
+        return -EIO;
+    }
+
+    return 0;
+}
+
+int config_load_radio_counter(uint32_t *counter) {
+    // Initialize the NVS if necessary
+    int res = init_nvs();
+    if (res) return res;
+
+    res = nvs_read(&fs, NVS_COUNTER_ENTRY_ID, counter, sizeof(*counter));
+    if (res == -ENOENT) {
+        *counter = 0;
+    } else if (res != sizeof(*counter)) {
+        LOG_ERR("Failed to read radio counter from NVS: %d", res);
+        return res < 0 ? res : -EIO;
+    }
+
+    return 0;
+}
+
+int config_save_radio_counter(uint32_t counter) {
+    // Initialize the NVS if necessary
+    int res = init_nvs();
+    if (res) return res;
+
+    res = nvs_write(&fs, NVS_COUNTER_ENTRY_ID, &counter, sizeof(counter));
+    if (res < 0) {
+        LOG_ERR("Failed to write radio counter to NVS: %d", res);
         return res;
     }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -31,4 +31,37 @@ int config_load(struct config_t* config);
  */
 int config_save(const struct config_t* config);
 
+/**
+ * @brief Verify that the configuration in persistent storage matches the given one.
+ *
+ * In contrast to config_load(), this always reads back from flash (and not from the copy in retained RAM).
+ *
+ * @param config Pointer to the expected configuration.
+ *
+ * @retval 0 If the stored configuration matches.
+ * @retval -EIO If the stored configuration differs.
+ * @retval <0 Other error code if reading the configuration failed.
+ */
+int config_verify(const struct config_t* config);
+
+/**
+ * @brief Load the persistent radio packet counter.
+ *
+ * @param counter Filled with the stored counter, or 0 if none has been stored yet.
+ *
+ * @retval 0 If successful.
+ * @retval <0 Error code if loading the counter failed.
+ */
+int config_load_radio_counter(uint32_t* counter);
+
+/**
+ * @brief Save the persistent radio packet counter.
+ *
+ * @param counter The counter to store.
+ *
+ * @retval 0 If successful.
+ * @retval <0 Error code if saving the counter failed.
+ */
+int config_save_radio_counter(uint32_t counter);
+
 #endif  // CONFIG_H
@@ -0,0 +1,184 @@
+#include "energy.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+
+// Typical currents in uA at 3 V (nRF52840 product specification with DC/DC enabled, LP5813 and speaker estimated
+// for the LED currents and drive levels used by the LEDs and speaker modules)
+#define CURRENT_CPU_ACTIVE_UA 3300  // CPU running from flash at 64 MHz
+#define CURRENT_SLEEP_UA      3     // System ON, all peripherals idle, RTC running, full RAM retention
+#define CURRENT_SYSTEM_OFF_UA 1     // System OFF with the retained RAM section powered (rounded up from 0.6 uA)
+
+static const uint32_t state_currents_ua[] = {
+    [ENERGY_LEDS_ON]  = 6000,  // LP5813 boost converter and one RGB LED at MAX_LED_CURRENT_FRACTION
+    [ENERGY_PWM_ON]   = 3000,  // PWM peripheral, HFCLK and speaker
+    [ENERGY_ADC_ON]   = 1000,  // SAADC with EasyDMA
+    [ENERGY_RADIO_TX] = 4800,  // Radio TX at 0 dBm (changed with the TX power, see radio.c)
+    [ENERGY_RADIO_RX] = 4600,  // Radio RX at 1 Mbps / 2 Mbps
+};
+
+static const char *const state_names[] = {
+    [ENERGY_LEDS_ON]  = "leds_on",
+    [ENERGY_PWM_ON]   = "pwm_on",
+    [ENERGY_ADC_ON]   = "adc_on",
+    [ENERGY_RADIO_TX] = "radio_tx",
+    [ENERGY_RADIO_RX] = "radio_rx",
+};
+
+BUILD_ASSERT(ARRAY_SIZE(state_currents_ua) == ENERGY_NUM_STATES);
+BUILD_ASSERT(ARRAY_SIZE(state_names) == ENERGY_NUM_STATES);
+
+// Battery capacity for the life projection
+#define CR2032_CAPACITY_NAH (220ULL * 1000 * 1000)
+
+// Conversion from time in us and current in uA to charge in nAh
+#define UA_US_PER_NAH 3600000ULL
+
+// Charges are accumulated in nAh and printed in uAh with three decimals
+#define UAH_FMT       "%llu.%03llu"
+#define UAH_ARGS(nah) (nah) / 1000, (nah) % 1000
+
+// Time spent in a single power state
+struct state_time_t {
+    int depth;                // Number of nested energy_state_begin() calls
+    int64_t start_ticks;      // Uptime in ticks when the state was entered (or its current changed)
+    int64_t total_ticks;      // Total time spent in the state
+    uint32_t current_ua;      // Current drawn in the state, 0 for the default from state_currents_ua
+    uint64_t total_ua_ticks;  // Integral of the current over the time spent in the state
+};
+
+// Global state
+static struct state_time_t states[ENERGY_NUM_STATES];
+static uint32_t clicks    = 0;
+static uint32_t delivered = 0;
+
+static struct k_spinlock lock;
+
+/*********************************************************************************************************************
+ * PRIVATE FUNCTIONS
+ *********************************************************************************************************************/
+static uint64_t to_nah(uint64_t time_us, uint32_t current_ua) {
+    return time_us * current_ua / UA_US_PER_NAH;
+}
+
+static uint32_t get_current_ua(enum energy_state_t state) {
+    return states[state].current_ua ? states[state].current_ua : state_currents_ua[state];
+}
+
+static void close_interval(enum energy_state_t state, int64_t now_ticks) {
+    int64_t ticks = now_ticks - states[state].start_ticks;
+
+    states[state].total_ticks += ticks;
+    states[state].total_ua_ticks += ticks * get_current_ua(state);
+    states[state].start_ticks = now_ticks;
+}
+
+static uint64_t get_cpu_active_us() {
+    k_thread_runtime_stats_t stats;
+    if (k_thread_runtime_stats_all_get(&stats) != 0) {
+        return 0;
+    }
+
+    // total_cycles excludes the time spent in the idle thread
+    return k_cyc_to_us_floor64(stats.total_cycles);
+}
+
+/*********************************************************************************************************************
+ * PUBLIC FUNCTIONS
+ *********************************************************************************************************************/
+void energy_state_begin(enum energy_state_t state) {
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    if (states[state].depth++ == 0) {
+        states[state].start_ticks = k_uptime_ticks();
+    }
+
+    k_spin_unlock(&lock, key);
+}
+
+void energy_state_end(enum energy_state_t state) {
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    if (states[state].depth > 0 && --states[state].depth == 0) {
+        close_interval(state, k_uptime_ticks());
+    }
+
+    k_spin_unlock(&lock, key);
+}
+
+void energy_set_current(enum energy_state_t state, uint32_t current_ua) {
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    if (states[state].depth > 0) {
+        close_interval(state, k_uptime_ticks());
+    }
+
+    states[state].current_ua = current_ua;
+
+    k_spin_unlock(&lock, key);
+}
+
+void energy_count_click() {
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    clicks++;
+    k_spin_unlock(&lock, key);
+}
+
+void energy_count_delivered(uint32_t num_clicks) {
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    delivered += num_clicks;
+    k_spin_unlock(&lock, key);
+}
+
+void energy_dump() {
+    // Take a snapshot of the state times, including the states that are currently active
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    int64_t now_ticks = k_uptime_ticks();
+    uint64_t state_us[ENERGY_NUM_STATES];
+    uint64_t state_nah[ENERGY_NUM_STATES];
+    for (int i = 0; i < ENERGY_NUM_STATES; i++) {
+        int64_t ticks     = states[i].total_ticks;
+        uint64_t ua_ticks = states[i].total_ua_ticks;
+        if (states[i].depth > 0) {
+            ticks += now_ticks - states[i].start_ticks;
+            ua_ticks += (now_ticks - states[i].start_ticks) * get_current_ua(i);
+        }
+
+        state_us[i]  = k_ticks_to_us_floor64(ticks);
+        state_nah[i] = k_ticks_to_us_floor64(ua_ticks) / UA_US_PER_NAH;
+    }
+
+    uint32_t num_clicks    = clicks;
+    uint32_t num_delivered = delivered;
+
+    k_spin_unlock(&lock, key);
+
+    // CPU active and sleeping (everything else) are derived from the thread runtime statistics
+    uint64_t uptime_us     = k_ticks_to_us_floor64(now_ticks);
+    uint64_t cpu_active_us = MIN(get_cpu_active_us(), uptime_us);
+    uint64_t sleep_us      = uptime_us - cpu_active_us;
+
+    uint64_t cpu_active_nah = to_nah(cpu_active_us, CURRENT_CPU_ACTIVE_UA);
+    uint64_t sleep_nah      = to_nah(sleep_us, CURRENT_SLEEP_UA);
+    uint64_t total_nah      = cpu_active_nah + sleep_nah;
+
+    printk("energy,state,cpu_active,%llu," UAH_FMT "\n", cpu_active_us, UAH_ARGS(cpu_active_nah));
+    printk("energy,state,sleep,%llu," UAH_FMT "\n", sleep_us, UAH_ARGS(sleep_nah));
+
+    for (int i = 0; i < ENERGY_NUM_STATES; i++) {
+        total_nah += state_nah[i];
+        printk("energy,state,%s,%llu," UAH_FMT "\n", state_names[i], state_us[i], UAH_ARGS(state_nah[i]));
+    }
+
+    // Project the battery life, assuming that the device spends the rest of the day in System OFF
+    uint64_t nah_per_click  = total_nah / MAX(num_clicks, 1);
+    uint64_t system_off_nah = to_nah(24ULL * 3600 * USEC_PER_SEC, CURRENT_SYSTEM_OFF_UA);
+    uint64_t nah_per_day    = nah_per_click * CONFIG_APP_ENERGY_CLICKS_PER_DAY + system_off_nah;
+    uint64_t life_days      = CR2032_CAPACITY_NAH / MAX(nah_per_day, 1);
+
+    uint64_t nah_per_delivered = total_nah / MAX(num_delivered, 1);
+
+    printk("energy,total,%llu,%u," UAH_FMT "," UAH_FMT ",%llu,%u," UAH_FMT "\n", uptime_us, num_clicks,
+           UAH_ARGS(total_nah), UAH_ARGS(nah_per_click), life_days, num_delivered, UAH_ARGS(nah_per_delivered));
+}
@@ -0,0 +1,85 @@
+#ifndef ENERGY_H
+#define ENERGY_H
+
+enum energy_state_t {
+    ENERGY_LEDS_ON,   // LP5813 enabled
+    ENERGY_PWM_ON,    // PWM running and speaker driven
+    ENERGY_ADC_ON,    // SAADC conversion in progress
+    ENERGY_RADIO_TX,  // Radio transmitting
+    ENERGY_RADIO_RX,  // Radio receiving (e.g. waiting for an ack)
+    ENERGY_NUM_STATES,
+};
+
+#if defined(CONFIG_APP_ENERGY_MODEL)
+
+/**
+ * @brief Marks the start of a power state.
+ *
+ * @param state The power state that was entered.
+ */
+void energy_state_begin(enum energy_state_t state);
+
+/**
+ * @brief Marks the end of a power state.
+ *
+ * @param state The power state that was left.
+ */
+void energy_state_end(enum energy_state_t state);
+
+/**
+ * @brief Changes the current drawn in a power state (e.g. when the TX power changes).
+ *
+ * Time already spent in the state is accounted with the previous current.
+ *
+ * @param state The power state.
+ * @param current_ua The current in uA.
+ */
+void energy_set_current(enum energy_state_t state, uint32_t current_ua);
+
+/**
+ * @brief Counts a click (i.e. a button event) for the per-click figures.
+ */
+void energy_count_click();
+
+/**
+ * @brief Counts clicks that were delivered to the receiver for the per-delivered-click figures.
+ *
+ * @param num_clicks Number of clicks (a click packet may carry several).
+ */
+void energy_count_delivered(uint32_t num_clicks);
+
+/**
+ * @brief Prints the time spent in each power state and the resulting charge estimates.
+ *
+ * The output consists of one line per state and a summary line, in the following format (charges in uAh with three
+ * decimals):
+ *
+ *   energy,state,<name>,<time in us>,<charge>
+ *   energy,total,<uptime in us>,<clicks>,<charge>,<charge per click>,<projected CR2032 life in days>,
+ *                <delivered clicks>,<charge per delivered click>
+ */
+void energy_dump();
+
+#else
+
+static inline void energy_state_begin(enum energy_state_t state) {
+}
+
+static inline void energy_state_end(enum energy_state_t state) {
+}
+
+static inline void energy_set_current(enum energy_state_t state, uint32_t current_ua) {
+}
+
+static inline void energy_count_click() {
+}
+
+static inline void energy_count_delivered(uint32_t num_clicks) {
+}
+
+static inline void energy_dump() {
+}
+
+#endif  // CONFIG_APP_ENERGY_MODEL
+
+#endif  // ENERGY_H
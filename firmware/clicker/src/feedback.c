@@ -0,0 +1,202 @@
+#include "feedback.h"
+#include "leds.h"
+#include "notes.h"
+#include "speaker.h"
+#include "workq.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(app_feedback);
+
+// Maximum number of play commands waiting to be executed
+#define CMD_QUEUE_SIZE 4
+
+// Macros for defining the steps of a script; LED steps take no time, tone steps last for the given length
+#define STEP_LEDS(led_, pattern_, r_, g_, b_, reps_)                                                  \
+    {                                                                                                 \
+        .type = STEP_TYPE_LEDS, .length = 0,                                                          \
+        .leds = {.led = (led_), .pattern = (pattern_), .color = {(r_), (g_), (b_)}, .reps = (reps_)}, \
+    }
+#define STEP_TONE(note_, length_) {.type = STEP_TYPE_TONE, .length = (length_), .tone = (note_)}
+#define STEP_WAIT_LEDS            {.type = STEP_TYPE_WAIT_LEDS}
+#define STEP_END                  {.type = STEP_TYPE_END}
+
+// A single step within a script
+enum step_type_t {
+    STEP_TYPE_END,
+    STEP_TYPE_LEDS,
+    STEP_TYPE_TONE,
+    STEP_TYPE_WAIT_LEDS,  // Silences the speaker until the pattern of the last LED step (with finite reps) has finished
+};
+
+struct script_step_t {
+    uint8_t type;
+    uint16_t length;  // Time until the next step in ms
+    union {
+        struct {
+            uint8_t led;
+            uint8_t pattern;
+            struct leds_color_t color;
+            int8_t reps;
+        } leds;
+        uint16_t tone;
+    };
+};
+
+// Scripts; the LEDs and the speaker are switched off at the end of each script
+static const struct script_step_t script_success[] = {
+    STEP_LEDS(LEDS_D2, LEDS_BREATHE, 0, 100, 0, 1),
+    STEP_TONE(C6, EIGTH),
+    STEP_TONE(E6, EIGTH),
+    STEP_TONE(G6, QUARTER),
+    STEP_WAIT_LEDS,
+    STEP_END,
+};
+
+static const struct script_step_t script_error[] = {
+    STEP_LEDS(LEDS_D2, LEDS_FLASH, 100, 0, 0, 2),
+    STEP_TONE(E5, QUARTER),
+    STEP_TONE(REST, EIGTH),
+    STEP_TONE(C5, HALF),
+    STEP_WAIT_LEDS,
+    STEP_END,
+};
+
+static const struct script_step_t script_low_battery[] = {
+    STEP_LEDS(LEDS_D1, LEDS_FLASH, 100, 60, 0, 3),
+    STEP_TONE(C6, QUARTER),
+    STEP_TONE(REST, 100),
+    STEP_TONE(G5, QUARTER),
+    STEP_TONE(REST, 100),
+    STEP_TONE(C5, HALF),
+    STEP_WAIT_LEDS,
+    STEP_END,
+};
+
+static const struct script_step_t *const scripts[] = {
+    [FEEDBACK_SUCCESS]     = script_success,
+    [FEEDBACK_ERROR]       = script_error,
+    [FEEDBACK_LOW_BATTERY] = script_low_battery,
+};
+
+// Message queue for passing play commands to the work queue
+struct play_cmd_t {
+    const struct script_step_t *script;  // NULL = stop current script
+    feedback_finished_cb_t cb;
+};
+
+K_MSGQ_DEFINE(feedback_play_cmd_msgq, sizeof(struct play_cmd_t), CMD_QUEUE_SIZE, 4);
+
+// Global state (only accessed from the work queue)
+static const struct script_step_t *next_step = NULL;
+static feedback_finished_cb_t finished_cb    = NULL;
+static k_timepoint_t leds_finish_time;  // When the pattern of the last LED step finishes
+
+/*********************************************************************************************************************
+ * WORK HANDLERS
+ *********************************************************************************************************************/
+static void step_work_fn(struct k_work *work);
+static void cmd_work_fn(struct k_work *work);
+
+K_WORK_DELAYABLE_DEFINE(feedback_step_work, step_work_fn);
+K_WORK_DEFINE(feedback_cmd_work, cmd_work_fn);
+
+static void stop_script(bool aborted) {
+    k_work_cancel_delayable(&feedback_step_work);
+    next_step = NULL;
+
+    leds_play_now(LEDS_D1, LEDS_SOLID, LEDS_RGB(0, 0, 0), 0);
+    speaker_tone_now(0);
+
+    if (finished_cb) {
+        feedback_finished_cb_t cb = finished_cb;
+        finished_cb               = NULL;
+        cb(aborted);
+    }
+}
+
+static void step_work_fn(struct k_work *work) {
+    // Execute all steps that are due now, i.e. up to and including the next step that takes time
+    while (next_step) {
+        const struct script_step_t *step = next_step++;
+
+        switch (step->type) {
+            case STEP_TYPE_LEDS:
+                // A pattern that repeats indefinitely (reps -1) is not waited for
+                leds_play_now(step->leds.led, step->leds.pattern, step->leds.color, step->leds.reps);
+                leds_finish_time = sys_timepoint_calc(K_MSEC(MAX(step->leds.reps, 0) * LEDS_PATTERN_PERIOD_MS));
+                break;
+
+            case STEP_TYPE_TONE:
+                speaker_tone_now(step->tone);
+                break;
+
+            case STEP_TYPE_WAIT_LEDS:
+                speaker_tone_now(REST);
+                k_work_reschedule_for_queue(&workq, &feedback_step_work, sys_timepoint_timeout(leds_finish_time));
+                return;
+
+            default:
+                stop_script(false);
+                return;
+        }
+
+        if (step->length > 0) {
+            k_work_reschedule_for_queue(&workq, &feedback_step_work, K_MSEC(step->length));
+            return;
+        }
+    }
+}
+
+static void cmd_work_fn(struct k_work *work) {
+    struct play_cmd_t cmd;
+
+    // Execute all commands that have been queued since the last run
+    while (k_msgq_get(&feedback_play_cmd_msgq, &cmd, K_NO_WAIT) == 0) {
+        // Stop the script currently playing (or switch everything off for a stop-command)
+        stop_script(next_step != NULL);
+
+        if (cmd.script) {
+            next_step   = cmd.script;
+            finished_cb = cmd.cb;
+            step_work_fn(NULL);
+        }
+    }
+}
+
+/*********************************************************************************************************************
+ * PRIVATE FUNCTIONS
+ *********************************************************************************************************************/
+static int put_play_cmd(const struct script_step_t *script, feedback_finished_cb_t cb) {
+    struct play_cmd_t cmd = {
+        .script = script,
+        .cb     = cb,
+    };
+
+    int res = k_msgq_put(&feedback_play_cmd_msgq, &cmd, K_NO_WAIT);
+    if (res) {
+        LOG_ERR("Command queue is full");
+        return -ENOMEM;
+    }
+
+    k_work_submit_to_queue(&workq, &feedback_cmd_work);
+
+    return 0;
+}
+
+/*********************************************************************************************************************
+ * PUBLIC FUNCTIONS
+ *********************************************************************************************************************/
+int feedback_play(enum feedback_script_t script, feedback_finished_cb_t cb) {
+    if (script >= ARRAY_SIZE(scripts)) {
+        LOG_ERR("Invalid feedback script: %d", script);
+        return -EINVAL;
+    }
+
+    return put_play_cmd(scripts[script], cb);
+}
+
+int feedback_off() {
+    return put_play_cmd(NULL, NULL);
+}
@@ -0,0 +1,38 @@
+#ifndef FEEDBACK_H
+#define FEEDBACK_H
+
+#include <stdbool.h>
+
+enum feedback_script_t {
+    FEEDBACK_SUCCESS,
+    FEEDBACK_ERROR,
+    FEEDBACK_LOW_BATTERY,
+};
+
+typedef void (*feedback_finished_cb_t)(bool aborted);
+
+/**
+ * @brief Play a feedback script on the LEDs and the speaker.
+ *
+ * A script is a timeline of LED patterns and speaker tones that are executed by a single scheduler, so the LEDs and
+ * the speaker stay in sync. Playing a script takes over both the LEDs and the speaker, i.e. patterns and melodies
+ * started with leds_play() and speaker_play() are aborted. If a script is currently still playing, it will be aborted
+ * and its finished callback will be called before playing the new script.
+ *
+ * @param script The script to play.
+ * @param cb The callback to call when the script has finished playing. Can be set to NULL.
+ *
+ * @retval 0 If successful.
+ * @retval <0 Error code if playing the script failed.
+ */
+int feedback_play(enum feedback_script_t script, feedback_finished_cb_t cb);
+
+/**
+ * @brief Stops the script currently playing, if there is any, and switches the LEDs and the speaker off.
+ *
+ * @retval 0 If successful.
+ * @retval <0 Error code if stopping the script failed.
+ */
+int feedback_off();
+
+#endif  // FEEDBACK_H
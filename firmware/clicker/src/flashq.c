@@ -0,0 +1,27 @@
+#include "flashq.h"
+
+#include <zephyr/init.h>
+
+// Thread configuration; the priority is lower than the one of the shared work queue, so that flash writes and erases
+// only run while nothing else is to be done
+#define THREAD_STACK_SIZE 1536
+#define THREAD_PRIORITY   10
+
+// Work queue and its stack
+K_THREAD_STACK_DEFINE(flashq_stack, THREAD_STACK_SIZE);
+
+struct k_work_q flashq;
+
+/*********************************************************************************************************************
+ * STARTUP HOOKS
+ *********************************************************************************************************************/
+static int start_flashq() {
+    const struct k_work_queue_config cfg = {
+        .name = "app_flashq",
+    };
+
+    k_work_queue_start(&flashq, flashq_stack, K_THREAD_STACK_SIZEOF(flashq_stack), THREAD_PRIORITY, &cfg);
+    return 0;
+}
+
+SYS_INIT(start_flashq, POST_KERNEL, 0);
@@ -0,0 +1,15 @@
+#ifndef FLASHQ_H
+#define FLASHQ_H
+
+#include <zephyr/kernel.h>
+
+/**
+ * @brief Work queue for the flash writes and erases of the journal and the packet counter.
+ *
+ * Runs at a lower priority than the shared work queue (see workq.h), so a sector erase (up to 85 ms on the nRF52840)
+ * never holds up the feedback or the radio. The modules hand their flash work over to this queue and keep the state
+ * that the work shares with the shared work queue under their own locks.
+ */
+extern struct k_work_q flashq;
+
+#endif  // FLASHQ_H
@@ -0,0 +1,123 @@
+#include "idle.h"
+#include "buttons.h"
+#include "energy.h"
+#include "profiling.h"
+#include "retained.h"
+#include "trace.h"
+#include "workq.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/pm/device.h>
+#include <zephyr/sys/poweroff.h>
+
+LOG_MODULE_REGISTER(app_idle);
+
+// Timing configuration
+#define IDLE_TIMEOUT K_SECONDS(CONFIG_APP_IDLE_TIMEOUT_S)
+
+// Peripherals that must be suspended (by runtime PM) whenever all modules are idle
+static const struct device *const peripherals[] = {
+    DEVICE_DT_GET(DT_NODELABEL(i2c0)),
+    DEVICE_DT_GET(DT_NODELABEL(pwm0)),
+    DEVICE_DT_GET(DT_IO_CHANNELS_CTLR(DT_PATH(zephyr_user))),
+};
+
+// Global state
+static atomic_t busy_sources;           // Bitmask of enum idle_source_t
+static atomic_t is_poweroff_requested;  // idle_poweroff() was called
+
+/*********************************************************************************************************************
+ * PRIVATE FUNCTIONS
+ *********************************************************************************************************************/
+static bool check_peripherals_suspended() {
+    bool ok = true;
+
+    for (int i = 0; i < ARRAY_SIZE(peripherals); i++) {
+        enum pm_device_state state;
+        int res = pm_device_state_get(peripherals[i], &state);
+
+        // Devices without PM support (-ENOSYS) manage their power on their own
+        if (res == 0 && state != PM_DEVICE_STATE_SUSPENDED) {
+            LOG_WRN("Peripheral %s is still %s while idle", peripherals[i]->name, pm_device_state_str(state));
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+/*********************************************************************************************************************
+ * WORK HANDLERS
+ *********************************************************************************************************************/
+static void poweroff_work_fn(struct k_work *work) {
+    // Some module became busy again since the work was scheduled
+    bool is_requested = atomic_get(&is_poweroff_requested);
+    if (atomic_get(&busy_sources) != 0 && !is_requested) {
+        return;
+    }
+
+    if (is_requested) {
+        LOG_INF("System OFF requested; entering System OFF");
+    } else {
+        LOG_INF("No activity for %d s; entering System OFF", CONFIG_APP_IDLE_TIMEOUT_S);
+    }
+
+    // Print the profiling and energy results of this wake cycle (if enabled)
+    profiling_dump();
+    energy_dump();
+
+    // A peripheral that is still resumed at this point indicates a missing pm_device_runtime_put() somewhere
+    if (!check_peripherals_suspended()) {
+        LOG_ERR("Not all peripherals are suspended; check the runtime PM usage of the modules");
+    }
+
+    // Make sure that a button press wakes us up again
+    int res = buttons_arm_wakeup();
+    if (res) {
+        LOG_ERR("Failed to arm buttons for wake-up (%d); staying on", res);
+        trace(TRACE_MOD_SYSTEM, TRACE_EVT_ERROR, res);
+        return;
+    }
+
+    trace(TRACE_MOD_SYSTEM, TRACE_EVT_POWEROFF, 0);
+    retained_update();
+    sys_poweroff();
+}
+
+K_WORK_DELAYABLE_DEFINE(poweroff_work, poweroff_work_fn);
+
+/*********************************************************************************************************************
+ * STARTUP HOOKS
+ *********************************************************************************************************************/
+static int start_idle_timer() {
+    k_work_schedule_for_queue(&workq, &poweroff_work, IDLE_TIMEOUT);
+    return 0;
+}
+
+SYS_INIT(start_idle_timer, APPLICATION, 0);
+
+/*********************************************************************************************************************
+ * PUBLIC FUNCTIONS
+ *********************************************************************************************************************/
+void idle_set_busy(enum idle_source_t src, bool busy) {
+    if (busy) {
+        atomic_set_bit(&busy_sources, src);
+    } else {
+        atomic_clear_bit(&busy_sources, src);
+    }
+
+    idle_kick();
+}
+
+void idle_kick() {
+    // Activity does not postpone a requested System OFF
+    if (!atomic_get(&is_poweroff_requested)) {
+        k_work_reschedule_for_queue(&workq, &poweroff_work, IDLE_TIMEOUT);
+    }
+}
+
+void idle_poweroff() {
+    atomic_set(&is_poweroff_requested, true);
+    k_work_reschedule_for_queue(&workq, &poweroff_work, K_NO_WAIT);
+}
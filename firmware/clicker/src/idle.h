@@ -0,0 +1,37 @@
+#ifndef IDLE_H
+#define IDLE_H
+
+#include <stdbool.h>
+
+enum idle_source_t {
+    IDLE_SRC_BUTTONS,
+    IDLE_SRC_LEDS,
+    IDLE_SRC_SPEAKER,
+    IDLE_SRC_BLE,
+    IDLE_SRC_RADIO,
+};
+
+/**
+ * @brief Marks a module as busy or idle.
+ *
+ * The device never enters System OFF while any module is busy. Once all modules are idle, the device enters System
+ * OFF after CONFIG_APP_IDLE_TIMEOUT_S seconds unless new activity is reported in the meantime.
+ *
+ * @param src The module reporting its state.
+ * @param busy True if the module is busy, false if it is idle.
+ */
+void idle_set_busy(enum idle_source_t src, bool busy);
+
+/**
+ * @brief Reports a short activity, restarting the inactivity period.
+ */
+void idle_kick();
+
+/**
+ * @brief Enters System OFF as soon as possible, even if modules are still busy.
+ *
+ * Used when the receiver sends the clicker to sleep. Packets that have not been sent yet are lost.
+ */
+void idle_poweroff();
+
+#endif  // IDLE_H
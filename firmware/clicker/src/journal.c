@@ -0,0 +1,368 @@
+#include "journal.h"
+#include "flashq.h"
+#include "retained.h"
+#include "trace.h"
+
+#include <string.h>
+#include <zephyr/fs/fcb.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/storage/flash_map.h>
+
+LOG_MODULE_REGISTER(app_journal);
+
+// Journal partition: a flash circular buffer (FCB) whose entries each hold the records of one flush of the staging
+// buffer, oldest first. A sector is erased once all of its events have been delivered, or when the partition is full
+// and the space is needed for newer events.
+#define JOURNAL_PARTITION    journal_partition
+#define JOURNAL_PARTITION_ID FIXED_PARTITION_ID(JOURNAL_PARTITION)
+#define JOURNAL_MAGIC        0x4c4e524a  // "JRNL"
+#define JOURNAL_MAX_SECTORS  8
+
+// Largest gap between two events of a batch that the delta times of the packet format can express
+#define MAX_BATCH_GAP_MS (PACKET_EVENT_MAX_DELTA * PACKET_EVENT_TIME_UNIT_MS)
+
+// Collects the events of a batch
+struct batch_builder_t {
+    struct journal_batch_t *batch;
+    uint32_t uptimes_ms[PACKET_MAX_REPLAY_EVENTS];
+};
+
+// Global state. The partition is only accessed with fcb_lock held: by the flash work queue while writing and erasing,
+// and by journal_get_batch() on the work queue, which does not wait for the lock. The journal state in retained RAM is
+// changed by both work queues under state_lock; since the flash work holds fcb_lock throughout, journal_get_batch()
+// sees the records either staged or in flash, never in both places or neither.
+static struct fcb fcb;
+static struct flash_sector sectors[JOURNAL_MAX_SECTORS];
+static bool is_mounted = false;
+static journal_ready_cb_t ready_cb;
+static struct journal_record_t flush_buf[JOURNAL_FLUSH_SIZE];  // Records being written (only accessed by the flush)
+
+K_MUTEX_DEFINE(fcb_lock);
+K_MUTEX_DEFINE(state_lock);
+
+static void flush_work_fn(struct k_work *work);
+static void erase_work_fn(struct k_work *work);
+
+K_WORK_DEFINE(journal_flush_work, flush_work_fn);
+K_WORK_DEFINE(journal_erase_work, erase_work_fn);
+
+/*********************************************************************************************************************
+ * PRIVATE FUNCTIONS
+ *********************************************************************************************************************/
+static int mount() {
+    if (is_mounted) return 0;
+
+    uint32_t sector_cnt = ARRAY_SIZE(sectors);
+    int res             = flash_area_get_sectors(JOURNAL_PARTITION_ID, &sector_cnt, sectors);
+    if (res) {
+        LOG_ERR("Failed to get the journal sectors: %d", res);
+        return res;
+    }
+
+    fcb.f_magic      = JOURNAL_MAGIC;
+    fcb.f_sectors    = sectors;
+    fcb.f_sector_cnt = sector_cnt;
+
+    res = fcb_init(JOURNAL_PARTITION_ID, &fcb);
+    if (res) {
+        LOG_ERR("Failed to mount the journal: %d", res);
+        return res;
+    }
+
+    is_mounted = true;
+    return 0;
+}
+
+static int for_each_record(bool (*fn)(const struct journal_record_t *record, void *arg), void *arg) {
+    // The records in flash are older than the staged ones
+    if (retained.journal_in_flash) {
+        int res = mount();
+        if (res) return res;
+
+        struct fcb_entry loc = {0};
+        while (fcb_getnext(&fcb, &loc) == 0) {
+            for (uint32_t offset = 0; offset + sizeof(struct journal_record_t) <= loc.fe_data_len;
+                 offset += sizeof(struct journal_record_t)) {
+                struct journal_record_t record;
+                res = flash_area_read(fcb.fap, FCB_ENTRY_FA_DATA_OFF(loc) + offset, &record, sizeof(record));
+                if (res) return res;
+
+                if (!fn(&record, arg)) return 0;
+            }
+        }
+    }
+
+    for (int i = 0; i < retained.journal_num_staged; i++) {
+        if (!fn(&retained.journal_staged[i], arg)) return 0;
+    }
+
+    return 0;
+}
+
+static bool add_to_batch(const struct journal_record_t *record, void *arg) {
+    struct batch_builder_t *builder = arg;
+    struct journal_batch_t *batch   = builder->batch;
+    if (record->id < retained.journal_replay_id) {
+        return true;
+    }
+
+    // Only events of the current wake cycle have a known age
+    bool is_current = record->id >= retained.journal_wake_id;
+    if (batch->num_events == 0) {
+        batch->first_id = record->id;
+    } else {
+        bool was_current  = batch->first_id >= retained.journal_wake_id;
+        uint32_t gap_ms   = record->uptime_ms - builder->uptimes_ms[batch->num_events - 1];
+        bool is_adjacent  = record->id == batch->first_id + batch->num_events && is_current == was_current;
+        bool is_gap_short = !is_current || gap_ms <= MAX_BATCH_GAP_MS;
+        if (!is_adjacent || !is_gap_short) {
+            return false;
+        }
+    }
+
+    packet_decode_events(record->event, sizeof(record->event), &batch->events[batch->num_events]);
+    builder->uptimes_ms[batch->num_events++] = record->uptime_ms;
+    return batch->num_events < PACKET_MAX_REPLAY_EVENTS;
+}
+
+static int check_delivered(struct fcb_entry_ctx *ctx, void *arg) {
+    // The last record of an entry has the highest ID
+    bool *is_delivered = arg;
+    struct journal_record_t record;
+    uint32_t offset = FCB_ENTRY_FA_DATA_OFF(ctx->loc) + ctx->loc.fe_data_len - sizeof(record);
+    int res         = flash_area_read(ctx->fap, offset, &record, sizeof(record));
+    if (res || record.id >= retained.journal_replay_id) {
+        *is_delivered = false;
+        return 1;
+    }
+
+    return 0;
+}
+
+static int erase_delivered_sectors() {
+    if (!retained.journal_in_flash) {
+        return 0;
+    }
+
+    int res = mount();
+    if (res) return res;
+
+    for (int i = 0; i < fcb.f_sector_cnt && !fcb_is_empty(&fcb); i++) {
+        bool is_delivered = true;
+        res               = fcb_walk(&fcb, fcb.f_oldest, check_delivered, &is_delivered);
+        if (res < 0) return res;
+
+        if (!is_delivered) {
+            return 0;
+        }
+
+        res = fcb_rotate(&fcb);
+        if (res) return res;
+    }
+
+    k_mutex_lock(&state_lock, K_FOREVER);
+    retained.journal_in_flash = !fcb_is_empty(&fcb);
+    retained_update();
+    k_mutex_unlock(&state_lock);
+
+    return 0;
+}
+
+static int append(const struct journal_record_t *records, int num_records) {
+    int res = mount();
+    if (res) return res;
+
+    struct fcb_entry loc;
+    uint16_t len = num_records * sizeof(struct journal_record_t);
+    res          = fcb_append(&fcb, len, &loc);
+    if (res == -ENOSPC) {
+        // Make room for the newer events; the receiver copes with the gap in the journal IDs
+        LOG_WRN("Journal full, dropping the oldest sector");
+        trace(TRACE_MOD_RADIO, TRACE_EVT_RADIO_JOURNAL_DROP, 0);
+        res = fcb_rotate(&fcb);
+        if (res) return res;
+
+        res = fcb_append(&fcb, len, &loc);
+    }
+    if (res) return res;
+
+    res = flash_area_write(fcb.fap, FCB_ENTRY_FA_DATA_OFF(loc), records, len);
+    if (res) return res;
+
+    return fcb_append_finish(&fcb, &loc);
+}
+
+static void remove_staged(uint32_t end_id) {
+    // The staged records are ordered by ID
+    int num_removed = 0;
+    while (num_removed < retained.journal_num_staged && retained.journal_staged[num_removed].id < end_id) {
+        num_removed++;
+    }
+
+    retained.journal_num_staged -= num_removed;
+    memmove(retained.journal_staged, &retained.journal_staged[num_removed],
+            retained.journal_num_staged * sizeof(struct journal_record_t));
+}
+
+/*********************************************************************************************************************
+ * WORK HANDLERS (on the flash work queue)
+ *********************************************************************************************************************/
+static void flush_work_fn(struct k_work *work) {
+    k_mutex_lock(&fcb_lock, K_FOREVER);
+
+    // The staged records stay where they are while they are written, so that new ones can be staged and delivered ones
+    // removed in the meantime; afterwards, the written ones are removed by their IDs
+    k_mutex_lock(&state_lock, K_FOREVER);
+    int num_records = MIN(retained.journal_num_staged, JOURNAL_FLUSH_SIZE);
+    memcpy(flush_buf, retained.journal_staged, num_records * sizeof(struct journal_record_t));
+    k_mutex_unlock(&state_lock);
+
+    int res = num_records > 0 ? append(flush_buf, num_records) : 0;
+    trace(TRACE_MOD_RADIO, TRACE_EVT_RADIO_JOURNAL_FLUSH, res ? res : num_records);
+
+    // On failure, the records stay staged and the next journal_add() tries again
+    bool is_flush_due = false;
+    if (res) {
+        LOG_ERR("Failed to write the journal: %d", res);
+    } else if (num_records > 0) {
+        k_mutex_lock(&state_lock, K_FOREVER);
+        remove_staged(flush_buf[num_records - 1].id + 1);
+        retained.journal_in_flash = true;
+        retained_update();
+        is_flush_due = retained.journal_num_staged >= JOURNAL_FLUSH_SIZE;
+        k_mutex_unlock(&state_lock);
+    }
+
+    k_mutex_unlock(&fcb_lock);
+
+    if (is_flush_due) {
+        k_work_submit_to_queue(&flashq, &journal_flush_work);
+    }
+
+    if (ready_cb) ready_cb();
+}
+
+static void erase_work_fn(struct k_work *work) {
+    k_mutex_lock(&fcb_lock, K_FOREVER);
+    int res = erase_delivered_sectors();
+    k_mutex_unlock(&fcb_lock);
+
+    if (res) {
+        LOG_WRN("Failed to erase delivered journal sectors: %d", res);
+    }
+
+    if (ready_cb) ready_cb();
+}
+
+/*********************************************************************************************************************
+ * PUBLIC FUNCTIONS
+ *********************************************************************************************************************/
+int journal_init(uint32_t next_counter, journal_ready_cb_t cb) {
+    // Journal IDs increase by one per event, so the receiver can drop replayed events that it has seen already by
+    // their ID. If the retained state is lost, the IDs continue at the next packet counter times PACKET_MAX_EVENTS:
+    // every journaled event was sent in a click packet with a counter of its own (with at most PACKET_MAX_EVENTS
+    // events per packet), and counters are never reused (see radio.c), so all IDs handed out before are lower.
+    k_mutex_lock(&state_lock, K_FOREVER);
+    if (!retained_is_valid()) {
+        retained.journal_next_id   = next_counter * PACKET_MAX_EVENTS;
+        retained.journal_replay_id = 0;
+        retained.journal_in_flash  = true;  // Unknown, so we have to look
+    }
+
+    retained.journal_wake_id = retained.journal_next_id;
+    retained_update();
+    k_mutex_unlock(&state_lock);
+
+    ready_cb = cb;
+    return 0;
+}
+
+int journal_add(const struct buttons_event_t *event) {
+    struct packet_event_t packet_event = {
+        .button        = event->button,
+        .is_long_press = event->is_long_press,
+        .shift_presses = MIN(event->preceding_short_shift_presses, UINT8_MAX),
+    };
+
+    k_mutex_lock(&state_lock, K_FOREVER);
+
+    // Only happens if the flash work is far behind or writing keeps failing
+    if (retained.journal_num_staged == JOURNAL_STAGING_SIZE) {
+        k_mutex_unlock(&state_lock);
+        LOG_ERR("Journal staging buffer full, dropping event");
+        return -ENOMEM;
+    }
+
+    struct journal_record_t *record = &retained.journal_staged[retained.journal_num_staged++];
+    record->id                      = retained.journal_next_id++;
+    record->uptime_ms               = event->uptime_ms;
+    packet_encode_events(&packet_event, 1, record->event);
+    retained_update();
+
+    // Flash is only written once enough records are staged
+    bool is_flush_due = retained.journal_num_staged >= JOURNAL_FLUSH_SIZE;
+    k_mutex_unlock(&state_lock);
+
+    if (is_flush_due) {
+        k_work_submit_to_queue(&flashq, &journal_flush_work);
+    }
+
+    return 0;
+}
+
+bool journal_has_events() {
+    return retained.journal_num_staged > 0 || retained.journal_in_flash;
+}
+
+int journal_get_batch(struct journal_batch_t *batch) {
+    struct batch_builder_t builder = {.batch = batch};
+    batch->num_events              = 0;
+
+    // The shared work queue does not wait for flash writes and erases
+    if (k_mutex_lock(&fcb_lock, K_NO_WAIT) != 0) {
+        return -EBUSY;
+    }
+
+    int res = for_each_record(add_to_batch, &builder);
+    k_mutex_unlock(&fcb_lock);
+    if (res) return res;
+
+    // Once everything has been delivered, the partition need not be mounted again
+    if (batch->num_events == 0) {
+        if (retained.journal_in_flash) {
+            k_work_submit_to_queue(&flashq, &journal_erase_work);
+        }
+
+        return 0;
+    }
+
+    // The ages are sent relative to the newest event
+    if (batch->first_id < retained.journal_wake_id) {
+        batch->age_ms = PACKET_AGE_UNKNOWN;
+        for (int i = 0; i < batch->num_events; i++) {
+            batch->events[i].age_ms = 0;
+        }
+    } else {
+        uint32_t newest_ms = builder.uptimes_ms[batch->num_events - 1];
+        batch->age_ms      = k_uptime_get_32() - newest_ms;
+        for (int i = 0; i < batch->num_events; i++) {
+            batch->events[i].age_ms = newest_ms - builder.uptimes_ms[i];
+        }
+    }
+
+    return 0;
+}
+
+void journal_ack(const struct journal_batch_t *batch) {
+    k_mutex_lock(&state_lock, K_FOREVER);
+    retained.journal_replay_id = batch->first_id + batch->num_events;
+    remove_staged(retained.journal_replay_id);
+    retained_update();
+    bool is_in_flash = retained.journal_in_flash;
+    k_mutex_unlock(&state_lock);
+
+    if (is_in_flash) {
+        k_work_submit_to_queue(&flashq, &journal_erase_work);
+    }
+}
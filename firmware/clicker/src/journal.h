@@ -0,0 +1,122 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "buttons.h"
+#include "packet.h"
+
+// Number of staged records that are written to flash as one entry, so outages with fewer undelivered events cause no
+// flash writes at all. The staging buffer in retained RAM has room for the events of two more click packets, which
+// come in while the entry is being written in the background.
+#define JOURNAL_FLUSH_SIZE   16
+#define JOURNAL_STAGING_SIZE (JOURNAL_FLUSH_SIZE + 2 * PACKET_MAX_EVENTS)
+
+// A journaled event
+struct journal_record_t {
+    uint32_t id;                       // Journal ID (see journal.c)
+    uint32_t uptime_ms;                // Time of the event (k_uptime_get_32())
+    uint8_t event[PACKET_EVENT_SIZE];  // The event, encoded with packet_encode_events()
+} __packed;
+
+// Events to replay in one packet
+struct journal_batch_t {
+    uint32_t first_id;   // Journal ID of the first (oldest) event; the IDs of the others follow consecutively
+    uint32_t age_ms;     // Time since the newest event, or PACKET_AGE_UNKNOWN if it is from an earlier wake cycle
+    uint8_t num_events;  // Number of events (0 if there is nothing to replay)
+    struct packet_event_t events[PACKET_MAX_REPLAY_EVENTS];  // Ages relative to the newest event
+};
+
+// Called on the flash work queue (see flashq.h) when the journal has finished writing to or erasing the flash
+typedef void (*journal_ready_cb_t)();
+
+#if defined(CONFIG_APP_JOURNAL)
+
+/**
+ * @brief Starts a new wake cycle of the journal.
+ *
+ * The journal partition is only mounted once it is needed, so wake cycles without undelivered events do not touch
+ * the flash. Must be called after the packet counter has been initialized (see radio.c). The other functions must be
+ * called from the work queue (see workq.h); the flash writes and erases run on the flash work queue.
+ *
+ * @param next_counter Counter of the next packet; seeds the journal IDs if the retained state was lost.
+ * @param ready_cb Called when the flash is free again, e.g. to retry journal_get_batch() after -EBUSY.
+ *
+ * @retval 0 If successful.
+ */
+int journal_init(uint32_t next_counter, journal_ready_cb_t ready_cb);
+
+/**
+ * @brief Adds an event whose click packet was not acked to the journal.
+ *
+ * The event is staged in retained RAM; once JOURNAL_FLUSH_SIZE events are staged, they are appended to the journal
+ * partition on the flash work queue. If the partition is full, the oldest sector is erased, and the events in it are
+ * lost.
+ *
+ * @param event The button event.
+ *
+ * @retval 0 If successful.
+ * @retval -ENOMEM If the staging buffer is full because the staged events could not be written to flash; the event
+ *                 is lost.
+ */
+int journal_add(const struct buttons_event_t *event);
+
+/**
+ * @brief Checks whether the journal may hold events that have not been delivered yet.
+ *
+ * @retval true If journal_get_batch() may return events.
+ * @retval false If there is nothing to replay.
+ */
+bool journal_has_events();
+
+/**
+ * @brief Gets the oldest events that have not been delivered yet.
+ *
+ * A batch ends early at gaps in the journal IDs, at the start of the current wake cycle and at gaps between events
+ * that the delta times of the packet format cannot express; the next batch continues there.
+ *
+ * @param batch Filled with the events.
+ *
+ * @retval 0 If successful (batch->num_events is 0 if there is nothing to replay).
+ * @retval -EBUSY If the flash is being written or erased; the ready callback is called when it is done.
+ * @retval <0 Other error code if reading the journal failed.
+ */
+int journal_get_batch(struct journal_batch_t *batch);
+
+/**
+ * @brief Marks the events of a batch as delivered.
+ *
+ * Delivered events are removed from the staging buffer, and sectors of the journal partition that only contain
+ * delivered events are erased on the flash work queue.
+ *
+ * @param batch The batch that was acked.
+ */
+void journal_ack(const struct journal_batch_t *batch);
+
+#else
+
+static inline int journal_init(uint32_t next_counter, journal_ready_cb_t ready_cb) {
+    return 0;
+}
+
+static inline int journal_add(const struct buttons_event_t *event) {
+    return -ENOTSUP;
+}
+
+static inline bool journal_has_events() {
+    return false;
+}
+
+static inline int journal_get_batch(struct journal_batch_t *batch) {
+    batch->num_events = 0;
+    return 0;
+}
+
+static inline void journal_ack(const struct journal_batch_t *batch) {
+}
+
+#endif  // CONFIG_APP_JOURNAL
+
+#endif  // JOURNAL_H
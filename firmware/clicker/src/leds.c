@@ -1,15 +1,21 @@
 #include "leds.h"
+#include "energy.h"
+#include "idle.h"
+#include "profiling.h"
+#include "stats.h"
+#include "trace.h"
+#include "workq.h"
 
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/drivers/i2c.h>
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/pm/device_runtime.h>
 
 LOG_MODULE_REGISTER(app_leds);
 
-// Thread configuration
-#define THREAD_STACK_SIZE 1024
-#define THREAD_PRIORITY   5
+// Maximum number of play commands waiting to be executed
+#define CMD_QUEUE_SIZE 4
 
 // Maximum LED current as a fraction (0 .. 255) of the GLOBAL_MAX_CURRENT_*
 #define MAX_LED_CURRENT_FRACTION 0x2F
@@ -314,9 +320,8 @@ LOG_MODULE_REGISTER(app_leds);
 static const struct device *i2c_dev      = DEVICE_DT_GET(DT_NODELABEL(i2c0));
 static const struct gpio_dt_spec en_gpio = GPIO_DT_SPEC_GET(DT_NODELABEL(lp5813_en), gpios);
 
-// FIFO for communicating with the LEDs thread
+// Message queue for passing play commands to the work queue
 struct play_cmd_t {
-    void *fifo_reserved;
     enum leds_led_t led;
     enum leds_pattern_t pattern;
     struct leds_color_t color;
@@ -324,10 +329,16 @@ struct play_cmd_t {
     leds_finished_cb_t cb;
 };
 
-K_FIFO_DEFINE(leds_play_cmd_fifo);
+K_MSGQ_DEFINE(leds_play_cmd_msgq, sizeof(struct play_cmd_t), CMD_QUEUE_SIZE, 4);
 
-// Global state
-static bool led_driver_enabled = false;
+// Time for the boost converter of the LED driver to stabilize after enabling it (datasheet says around 1 ms)
+#define BOOST_SETTLE_TIME K_MSEC(1)
+
+// Global state (only accessed from the work queue, except for is_initialized)
+static bool is_initialized            = false;
+static bool led_driver_enabled        = false;
+static leds_finished_cb_t finished_cb = NULL;
+static struct play_cmd_t pending_cmd;  // Pattern to start once the boost converter has stabilized
 
 /*********************************************************************************************************************
  * PRIVATE FUNCTIONS
@@ -366,9 +377,13 @@ static int lp5813_write_reg(uint16_t reg, uint8_t value) {
         return -EINVAL;
     }
 
+    stats_add(STATS_LP5813_WRITES, 1);
+    stats_add(STATS_LP5813_BYTES, 1);
+
     int res = i2c_reg_write_byte(i2c_dev, (I2C_ADDR << 2) | (reg >> 8), reg & 0xFF, value);
     if (res < 0) {
         LOG_ERR("Failed to write to LP5813 register %X", (int)reg);
+        stats_add(STATS_I2C_ERRORS, 1);
     }
 
     return res;
@@ -380,9 +395,13 @@ static int lp5813_write_multiple(uint16_t start_reg, const uint8_t *values, uint
         return -EINVAL;
     }
 
+    stats_add(STATS_LP5813_WRITES, 1);
+    stats_add(STATS_LP5813_BYTES, num_values);
+
     int res = i2c_burst_write(i2c_dev, (I2C_ADDR << 2) | (start_reg >> 8), start_reg & 0xFF, values, num_values);
     if (res < 0) {
         LOG_ERR("Failed to write to LP5813 registers starting from %X", (int)start_reg);
+        stats_add(STATS_I2C_ERRORS, 1);
     }
 
     return res;
@@ -394,9 +413,12 @@ static int lp5813_read_reg(uint16_t reg, uint8_t *value) {
         return -EINVAL;
     }
 
+    stats_add(STATS_LP5813_READS, 1);
+
     int res = i2c_reg_read_byte(i2c_dev, (I2C_ADDR << 2) | (reg >> 8), reg & 0xFF, value);
     if (res < 0) {
         LOG_ERR("Failed to read from LP5813 register %X", (int)reg);
+        stats_add(STATS_I2C_ERRORS, 1);
     }
 
     return res;
@@ -437,19 +459,34 @@ static int lp5813_send_cmd(uint16_t cmd_reg) {
     return lp5813_write_reg(cmd_reg, value);
 }
 
-static bool enabled_led_driver() {
-    // Set the EN pin to enable/disable the LED driver
-    int res = gpio_pin_set_dt(&en_gpio, 1);
+static bool enable_led_driver() {
+    // Resume the I2C peripheral (and switch its pins to the default state) while the LED driver is enabled
+    int res = pm_device_runtime_get(i2c_dev);
+    if (res != 0) {
+        LOG_ERR("Failed to resume I2C device: %d", res);
+        return false;
+    }
+
+    // Set the EN pin to enable/disable the LED driver; the boost converter needs BOOST_SETTLE_TIME to stabilize
+    // before the driver can be configured (see configure_led_driver())
+    res = gpio_pin_set_dt(&en_gpio, 1);
     if (res != 0) {
         LOG_ERR("Failed to set EN signal to 1: %d", res);
+        pm_device_runtime_put(i2c_dev);
         return false;
     }
 
-    // Wait around 1 ms for the boost converter to stabilize (datasheet says to wait around 1 ms)
-    k_msleep(1);
+    led_driver_enabled = true;
+    idle_set_busy(IDLE_SRC_LEDS, true);
+    energy_state_begin(ENERGY_LEDS_ON);
+    trace(TRACE_MOD_LEDS, TRACE_EVT_LEDS_ENABLED, 0);
 
+    return true;
+}
+
+static bool configure_led_driver() {
     // Initialize the LED driver; RGB leds have a max fwd voltage of 3.6V @ 20mA
-    res = lp5813_write_reg(REG_CHIP_EN, 0x01);
+    int res = lp5813_write_reg(REG_CHIP_EN, 0x01);
     if (res != 0) goto error;
 
     res = lp5813_write_reg(REG_DEV_CONFIG_0, BOOST_VOUT_3V6 | GLOBAL_MAX_CURRENT_25MA5);
@@ -503,15 +540,11 @@ static bool enabled_led_driver() {
     res = lp5813_write_reg(REG_AUTO_DC_D2_B, MAX_LED_CURRENT_FRACTION);
     if (res < 0) goto error;
 
-    led_driver_enabled = true;
-
     return true;
 
-    // In case of an error, we pull the enable pin low to disable the LED driver
+    // In case of an error, the caller disables the LED driver again
 error:
-    gpio_pin_set_dt(&en_gpio, 0);
-    led_driver_enabled = false;
-    LOG_ERR("Failed to enable the LED driver");
+    LOG_ERR("Failed to configure the LED driver");
     return false;
 }
 
@@ -522,7 +555,15 @@ static bool disable_led_driver() {
         return false;
     }
 
+    res = pm_device_runtime_put(i2c_dev);
+    if (res != 0) {
+        LOG_ERR("Failed to suspend I2C device: %d", res);
+    }
+
     led_driver_enabled = false;
+    idle_set_busy(IDLE_SRC_LEDS, false);
+    energy_state_end(ENERGY_LEDS_ON);
+    trace(TRACE_MOD_LEDS, TRACE_EVT_LEDS_DISABLED, 0);
 
     return true;
 }
@@ -566,13 +607,13 @@ static bool start_animation(enum leds_led_t led, enum leds_pattern_t pattern, st
         case LEDS_FLASH:
             dur_on       = DUR_540_MS;
             dur_off      = DUR_540_MS;
-            *finish_time = sys_timepoint_calc(K_MSEC(reps * (540 + 540)));
+            *finish_time = sys_timepoint_calc(K_MSEC(reps * LEDS_PATTERN_PERIOD_MS));
             break;
 
         case LEDS_BREATHE:
             dur_fade_in  = DUR_540_MS;
             dur_fade_out = DUR_540_MS;
-            *finish_time = sys_timepoint_calc(K_MSEC(reps * (540 + 540)));
+            *finish_time = sys_timepoint_calc(K_MSEC(reps * LEDS_PATTERN_PERIOD_MS));
             break;
 
         default:
@@ -624,83 +665,142 @@ error:
 }
 
 /*********************************************************************************************************************
- * THREADS
+ * WORK HANDLERS
  *********************************************************************************************************************/
-static void leds_thread_fn() {
-    if (!init_gpio_and_i2c()) {
+static void finished_work_fn(struct k_work *work);
+static void settled_work_fn(struct k_work *work);
+static void cmd_work_fn(struct k_work *work);
+
+K_WORK_DELAYABLE_DEFINE(leds_finished_work, finished_work_fn);
+K_WORK_DELAYABLE_DEFINE(leds_settled_work, settled_work_fn);
+K_WORK_DEFINE(leds_cmd_work, cmd_work_fn);
+
+static void stop_pattern(bool aborted) {
+    k_work_cancel_delayable(&leds_finished_work);
+    k_work_cancel_delayable(&leds_settled_work);
+
+    // Disable the LED driver (LED driver will go into low-power mode)
+    if (led_driver_enabled) {
+        disable_led_driver();
+    }
+
+    // Call the finished callback with the aborted flag set appropriately
+    if (finished_cb) {
+        leds_finished_cb_t cb = finished_cb;
+        finished_cb           = NULL;
+        cb(aborted);
+    }
+}
+
+static void finished_work_fn(struct k_work *work) {
+    stop_pattern(false);
+}
+
+static void settled_work_fn(struct k_work *work) {
+    // The boost converter has stabilized, so we can configure the LED driver and start the animation
+    struct play_cmd_t *cmd = &pending_cmd;
+    k_timepoint_t finish_time;
+    bool ok = configure_led_driver();
+
+    PROFILING_BEGIN(PROFILING_START_ANIMATION);
+    ok = ok && start_animation(cmd->led, cmd->pattern, cmd->color, cmd->reps, &finish_time);
+    PROFILING_END(PROFILING_START_ANIMATION);
+
+    // If we successfully started the animation, we schedule the finish (unless the animation runs forever), otherwise
+    // we call the callback with aborted=true (more information will be in the logs)
+    if (!ok) {
+        stop_pattern(true);
         return;
     }
 
-    LOG_INF("LEDs module initialized OK; waiting for commands");
+    k_timeout_t timeout = sys_timepoint_timeout(finish_time);
+    if (!K_TIMEOUT_EQ(timeout, K_FOREVER)) {
+        k_work_reschedule_for_queue(&workq, &leds_finished_work, timeout);
+    }
+}
+
+static bool start_pattern(enum leds_led_t led, enum leds_pattern_t pattern, struct leds_color_t color, int reps,
+                          leds_finished_cb_t cb) {
+    stop_pattern(true);
 
-    k_timepoint_t finish_time      = sys_timepoint_calc(K_FOREVER);
-    leds_finished_cb_t finished_cb = NULL;
-
-    // Main loop, executing commands and updating the LED driver
-    while (true) {
-        // Wait for a new play command or until the finish time has been reached
-        k_timeout_t timeout    = sys_timepoint_timeout(finish_time);
-        struct play_cmd_t *cmd = k_fifo_get(&leds_play_cmd_fifo, timeout);
-
-        // Disable the LED driver (LED driver will go into low-power mode)
-        if (led_driver_enabled) {
-            disable_led_driver();
-        }
-
-        // Call the finished callback with the aborted flag set appropriately
-        if (finished_cb) {
-            bool aborted = !sys_timepoint_expired(finish_time);
-            finished_cb(aborted);
-            finished_cb = NULL;
-        }
-
-        // If we didn't receive a command, wait for the next one
-        if (!cmd) {
-            finish_time = sys_timepoint_calc(K_FOREVER);
-            continue;
-        }
-
-        // If the command is not a stop-command, enabled the LED driver and start the animation
-        bool ok = true;
-        if (cmd->reps != 0) {
-            ok = enabled_led_driver() && start_animation(cmd->led, cmd->pattern, cmd->color, cmd->reps, &finish_time);
-        }
-
-        // If we successfully started the animation, we save the finished callback, otherwise
-        // we call the callback with aborted=true (more information will be in the logs)
-        if (ok) {
-            finished_cb = cmd->cb;
-        } else if (cmd->cb) {
-            finish_time = sys_timepoint_calc(K_FOREVER);
-            cmd->cb(true);
-        }
-
-        // Free the command (it was allocated leds_play())
-        k_free(cmd);
+    // A stop-command is finished as soon as the LED driver is shut down
+    if (reps == 0) {
+        if (cb) cb(false);
+        return true;
     }
+
+    // Enable the LED driver; the animation is started by settled_work_fn() once the boost converter has stabilized,
+    // so that the work queue is not blocked in the meantime
+    trace(TRACE_MOD_LEDS, TRACE_EVT_LEDS_PATTERN_START, led | (pattern << 8) | (reps << 16));
+    if (!enable_led_driver()) {
+        if (cb) cb(true);
+        return false;
+    }
+
+    pending_cmd = (struct play_cmd_t){
+        .led     = led,
+        .pattern = pattern,
+        .color   = color,
+        .reps    = reps,
+    };
+
+    finished_cb = cb;
+    k_work_reschedule_for_queue(&workq, &leds_settled_work, BOOST_SETTLE_TIME);
+
+    return true;
 }
 
-K_THREAD_DEFINE(leds_thread_id, THREAD_STACK_SIZE, leds_thread_fn, NULL, NULL, NULL, THREAD_PRIORITY, 0, 0);
+static void cmd_work_fn(struct k_work *work) {
+    struct play_cmd_t cmd;
+
+    // Execute all commands that have been queued since the last run
+    while (k_msgq_get(&leds_play_cmd_msgq, &cmd, K_NO_WAIT) == 0) {
+        stats_set_queue_depth(STATS_QUEUE_LEDS, k_msgq_num_used_get(&leds_play_cmd_msgq));
+        start_pattern(cmd.led, cmd.pattern, cmd.color, cmd.reps, cmd.cb);
+    }
+}
+
+/*********************************************************************************************************************
+ * STARTUP HOOKS
+ *********************************************************************************************************************/
+static int init_leds() {
+    if (!init_gpio_and_i2c()) {
+        return 0;
+    }
+
+    is_initialized = true;
+    LOG_INF("LEDs module initialized OK; waiting for commands");
+
+    return 0;
+}
+
+SYS_INIT(init_leds, APPLICATION, 0);
 
 /*********************************************************************************************************************
  * PUBLIC FUNCTIONS
  *********************************************************************************************************************/
 int leds_play(enum leds_led_t led, enum leds_pattern_t pattern, struct leds_color_t color, int reps,
               leds_finished_cb_t cb) {
-    struct play_cmd_t *cmd = k_malloc(sizeof(struct play_cmd_t));
-    if (!cmd) {
-        LOG_ERR("Unable to allocate FIFO data item from heap");
-        return -ENOMEM;
+    if (!is_initialized) {
+        return -ENODEV;
     }
 
-    cmd->fifo_reserved = NULL;
-    cmd->led           = led;
-    cmd->pattern       = pattern;
-    cmd->color         = color;
-    cmd->reps          = reps;
-    cmd->cb            = cb;
+    struct play_cmd_t cmd = {
+        .led     = led,
+        .pattern = pattern,
+        .color   = color,
+        .reps    = reps,
+        .cb      = cb,
+    };
+
+    int res = k_msgq_put(&leds_play_cmd_msgq, &cmd, K_NO_WAIT);
+    if (res) {
+        LOG_ERR("Command queue is full");
+        return -ENOMEM;
+    }
 
-    k_fifo_put(&leds_play_cmd_fifo, cmd);
+    stats_set_queue_depth(STATS_QUEUE_LEDS, k_msgq_num_used_get(&leds_play_cmd_msgq));
+    k_work_submit_to_queue(&workq, &leds_cmd_work);
 
     return 0;
 }
@@ -708,3 +808,13 @@ int leds_play(enum leds_led_t led, enum leds_pattern_t pattern, struct leds_colo
 int leds_off() {
     return leds_play(LEDS_D1, LEDS_SOLID, LEDS_RGB(0, 0, 0), 0, NULL);
 }
+
+int leds_play_now(enum leds_led_t led, enum leds_pattern_t pattern, struct leds_color_t color, int reps) {
+    __ASSERT(k_current_get() == k_work_queue_thread_get(&workq), "Must be called from the work queue");
+
+    if (!is_initialized) {
+        return -ENODEV;
+    }
+
+    return start_pattern(led, pattern, color, reps, NULL) ? 0 : -EIO;
+}
@@ -23,6 +23,9 @@ struct leds_color_t {
     uint8_t b;
 };
 
+// Length of one repetition of the LEDS_FLASH and LEDS_BREATHE patterns in ms (two phases of 540 ms each)
+#define LEDS_PATTERN_PERIOD_MS 1080
+
 typedef void (*leds_finished_cb_t)(bool aborted);
 
 /**
@@ -54,4 +57,21 @@ int leds_play(enum leds_led_t led, enum leds_pattern_t pattern, struct leds_colo
  */
 int leds_off();
 
+/**
+ * @brief Play a pattern on an LED immediately, without a finished callback.
+ *
+ * Same as leds_play(), but the pattern is started synchronously instead of going through the command queue (the
+ * animation itself starts about 1 ms later, once the boost converter of the LED driver has stabilized). This is meant
+ * for modules that orchestrate the LEDs from the shared work queue (see workq.h) and must only be called from there.
+ *
+ * @param led The LED to play the pattern on.
+ * @param pattern The pattern to play.
+ * @param color The color of the pattern.
+ * @param reps The number of times to repeat the pattern. Set to -1 to repeat indefinitely and 0 to switch LEDs off.
+ *
+ * @retval 0 If successful.
+ * @retval <0 Error code if playing the pattern failed.
+ */
+int leds_play_now(enum leds_led_t led, enum leds_pattern_t pattern, struct leds_color_t color, int reps);
+
 #endif  // LEDS_H
@@ -8,13 +8,25 @@
 #include "buttons.h"
 #include "config.h"
 #include "leds.h"
+#include "radio.h"
+#include "retained.h"
 #include "speaker.h"
+#include "trace.h"
 
 LOG_MODULE_REGISTER(app_main);
 
 int main(void) {
+    LOG_INF("Starting up (retained state %s)", retained_is_valid() ? "restored" : "reset");
+    trace(TRACE_MOD_SYSTEM, TRACE_EVT_BOOT, retained_is_valid());
+
     bool ok = true;
-    ok &= bluetooth_init() == 0;
+    if (IS_ENABLED(CONFIG_BT)) {
+        ok &= bluetooth_init() == 0;
+    }
+
+    if (IS_ENABLED(CONFIG_GAZELL)) {
+        ok &= radio_init() == 0;
+    }
 
     if (!ok) {
         LOG_ERR("Initialization failed.");
@@ -23,29 +35,20 @@ int main(void) {
 
     LOG_INF("Starting main loop...");
 
-    int i = 0;
+    // Wait for button events; the idle module puts the device into System OFF once nothing happens anymore
     while (1) {
-        // k_msleep(1000);
-        LOG_INF("Still alive %d", i);
-        ++i;
-
-        // leds_play(LEDS_D2, LEDS_BREATHE, LEDS_RGB(100, 100, 0), 2, on_leds_finished);
-        // speaker_play(SPEAKER_MELODY_ERROR, on_speaker_finished);
-        // k_msleep(10000);
-
-        k_msleep(1000);
-        // int mv = battery_get_voltage_mv();
-        // LOG_ERR("Battery voltage: %d mV", mv);
-
-        // struct buttons_event_t event;
-        // if (buttons_get_event(&event, K_SECONDS(1)) == 0) {
-        //     LOG_INF("Button: %d, long: %d, shift: %d", event.button + 1, event.is_long_press,
-        //             event.preceding_short_shift_presses);
-
-        //     if (event.button == BUTTONS_BTN_3) {
-        //         sys_poweroff();
-        //     }
-        // }
+        struct buttons_event_t event;
+        if (buttons_get_event(&event, K_FOREVER) == 0) {
+            LOG_INF("Button: %d, long: %d, shift: %d", event.button + 1, event.is_long_press,
+                    event.preceding_short_shift_presses);
+
+            // A long press of the shift button starts pairing with a receiver instead of being sent
+            if (IS_ENABLED(CONFIG_GAZELL) && event.button == BUTTONS_BTN_SHIFT && event.is_long_press) {
+                radio_pair();
+            } else if (IS_ENABLED(CONFIG_GAZELL)) {
+                radio_send_event(&event);
+            }
+        }
     }
 
     return 0;
@@ -0,0 +1,78 @@
+#ifndef NOTES_H
+#define NOTES_H
+
+// Notes in Hz
+enum note_t {
+    REST = 0,
+    C4   = 262,
+    Db4  = 277,
+    D4   = 294,
+    Eb4  = 311,
+    E4   = 330,
+    F4   = 349,
+    Gb4  = 370,
+    G4   = 392,
+    Ab4  = 415,
+    A4   = 440,
+    Bb4  = 466,
+    B4   = 494,
+    C5   = 523,
+    Db5  = 554,
+    D5   = 587,
+    Eb5  = 622,
+    E5   = 659,
+    F5   = 698,
+    Gb5  = 740,
+    G5   = 784,
+    Ab5  = 831,
+    A5   = 880,
+    Bb5  = 932,
+    B5   = 988,
+    C6   = 1046,
+    Db6  = 1109,
+    D6   = 1175,
+    Eb6  = 1245,
+    E6   = 1319,
+    F6   = 1397,
+    Gb6  = 1480,
+    G6   = 1568,
+    Ab6  = 1661,
+    A6   = 1760,
+    Bb6  = 1865,
+    B6   = 1976,
+    C7   = 2093,
+    Db7  = 2217,
+    D7   = 2349,
+    Eb7  = 2489,
+    E7   = 2637,
+    F7   = 2794,
+    Gb7  = 2960,
+    G7   = 3136,
+    Ab7  = 3322,
+    A7   = 3520,
+    Bb7  = 3729,
+    B7   = 3951,
+    C8   = 4186,
+    Db8  = 4435,
+    D8   = 4699,
+    Eb8  = 4978,
+    E8   = 5274,
+    F8   = 5588,
+    Gb8  = 5920,
+    G8   = 6272,
+    Ab8  = 6645,
+    A8   = 7040,
+    Bb8  = 7459,
+    B8   = 7902,
+};
+
+// Note lengths in ms
+enum note_length_t {
+    SIXTEENTH = 38,
+    EIGTH     = 75,
+    QUARTER   = 150,
+    HALF      = 300,
+    WHOLE     = 600,
+};
+
+#endif  // NOTES_H
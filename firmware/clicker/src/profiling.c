@@ -0,0 +1,70 @@
+#include "profiling.h"
+
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+
+// Statistics of a single code section
+struct point_stats_t {
+    uint32_t count;
+    uint64_t total_cycles;
+    uint64_t min_cycles;
+    uint64_t max_cycles;
+};
+
+// Names of the code sections as printed by profiling_dump(); must not change, since tools parse them
+static const char *const point_names[] = {
+    [PROFILING_START_ANIMATION]       = "start_animation",
+    [PROFILING_SET_SPEAKER_FREQUENCY] = "set_speaker_frequency",
+    [PROFILING_BUTTON_SCAN]           = "button_scan",
+    [PROFILING_CONFIG_SAVE]           = "config_save",
+    [PROFILING_PACKET_SEAL]           = "packet_seal",
+    [PROFILING_RADIO_SEND]            = "radio_send",
+};
+
+BUILD_ASSERT(ARRAY_SIZE(point_names) == PROFILING_NUM_POINTS);
+
+// Global state
+static struct point_stats_t stats[PROFILING_NUM_POINTS];
+
+static struct k_spinlock lock;
+
+/*********************************************************************************************************************
+ * STARTUP HOOKS
+ *********************************************************************************************************************/
+static int init_profiling() {
+    timing_init();
+    timing_start();
+    return 0;
+}
+
+SYS_INIT(init_profiling, APPLICATION, 0);
+
+/*********************************************************************************************************************
+ * PUBLIC FUNCTIONS
+ *********************************************************************************************************************/
+void profiling_record(enum profiling_point_t point, timing_t start, timing_t end) {
+    uint64_t cycles = timing_cycles_get(&start, &end);
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    struct point_stats_t *s = &stats[point];
+    if (s->count == 0 || cycles < s->min_cycles) s->min_cycles = cycles;
+    if (cycles > s->max_cycles) s->max_cycles = cycles;
+    s->total_cycles += cycles;
+    s->count++;
+
+    k_spin_unlock(&lock, key);
+}
+
+void profiling_dump() {
+    for (int i = 0; i < PROFILING_NUM_POINTS; i++) {
+        k_spinlock_key_t key   = k_spin_lock(&lock);
+        struct point_stats_t s = stats[i];
+        k_spin_unlock(&lock, key);
+
+        uint64_t avg_cycles = s.count ? s.total_cycles / s.count : 0;
+        printk("prof,%s,%u,%llu,%llu,%llu,%llu,%llu\n", point_names[i], s.count, s.min_cycles, s.max_cycles,
+               timing_cycles_to_ns(s.min_cycles), timing_cycles_to_ns(avg_cycles), timing_cycles_to_ns(s.max_cycles));
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef PROFILING_H
+#define PROFILING_H
+
+enum profiling_point_t {
+    PROFILING_START_ANIMATION,
+    PROFILING_SET_SPEAKER_FREQUENCY,
+    PROFILING_BUTTON_SCAN,
+    PROFILING_CONFIG_SAVE,
+    PROFILING_PACKET_SEAL,
+    PROFILING_RADIO_SEND,
+    PROFILING_NUM_POINTS,
+};
+
+#if defined(CONFIG_APP_PROFILING)
+
+#include <zephyr/timing/timing.h>
+
+// Macros for measuring a code section; they compile to nothing if CONFIG_APP_PROFILING is disabled
+#define PROFILING_BEGIN(point) timing_t profiling_start_##point = timing_counter_get()
+#define PROFILING_END(point)   profiling_record(point, profiling_start_##point, timing_counter_get())
+
+/**
+ * @brief Records a measurement; use the PROFILING_BEGIN() and PROFILING_END() macros instead of calling this directly.
+ *
+ * @param point The measured code section.
+ * @param start Timing counter at the start of the code section.
+ * @param end Timing counter at the end of the code section.
+ */
+void profiling_record(enum profiling_point_t point, timing_t start, timing_t end);
+
+/**
+ * @brief Prints the statistics of all measured code sections.
+ *
+ * Each code section is printed on its own line in the following format (times in ns):
+ *
+ *   prof,<name>,<count>,<min cycles>,<max cycles>,<min time>,<avg time>,<max time>
+ */
+void profiling_dump();
+
+#else
+
+#define PROFILING_BEGIN(point)
+#define PROFILING_END(point)
+
+static inline void profiling_dump() {
+}
+
+#endif  // CONFIG_APP_PROFILING
+
+#endif  // PROFILING_H
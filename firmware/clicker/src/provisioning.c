@@ -0,0 +1,194 @@
+#include "provisioning.h"
+#include "config.h"
+
+#include <psa/crypto.h>
+#include <string.h>
+#include <zephyr/drivers/hwinfo.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/util.h>
+
+LOG_MODULE_REGISTER(app_provisioning);
+
+BUILD_ASSERT(sizeof(struct provisioning_msg_t) == 55, "Provisioning message layout is part of the protocol");
+BUILD_ASSERT(sizeof(CONFIG_APP_PROVISIONING_KEY) == 1 || sizeof(CONFIG_APP_PROVISIONING_KEY) == 65,
+             "CONFIG_APP_PROVISIONING_KEY must be empty or 32 bytes in hex");
+
+// MAC configuration
+#define MAC_ALG  PSA_ALG_TRUNCATED_MAC(PSA_ALG_HMAC(PSA_ALG_SHA_256), 16)
+#define KEY_SIZE 32
+
+// Global state (only accessed from the BT RX thread)
+static uint8_t device_id[8];
+static uint8_t nonce[8];
+static bool is_nonce_valid = false;  // A nonce has been handed out and not been used by a provisioning attempt yet
+static int8_t last_result  = -ENODATA;
+
+/*********************************************************************************************************************
+ * PRIVATE FUNCTIONS
+ *********************************************************************************************************************/
+static void read_device_id() {
+    ssize_t len = hwinfo_get_device_id(device_id, sizeof(device_id));
+    if (len < 0) {
+        LOG_ERR("Failed to read the device ID: %d", (int)len);
+        memset(device_id, 0, sizeof(device_id));
+    }
+}
+
+static void draw_nonce() {
+    psa_status_t status = psa_crypto_init();
+    if (status == PSA_SUCCESS) {
+        status = psa_generate_random(nonce, sizeof(nonce));
+    }
+
+    // Without a nonce, no message can be authenticated
+    is_nonce_valid = status == PSA_SUCCESS;
+    if (!is_nonce_valid) {
+        LOG_ERR("Failed to draw a nonce: %d", status);
+        memset(nonce, 0, sizeof(nonce));
+    }
+}
+
+static int unmask_key(psa_key_id_t key_id, struct config_t *config) {
+    // The pad depends on the device ID and the nonce, so the same key is masked differently in every message
+    static const char label[] = "gazell-key";
+    uint8_t input[sizeof(label) - 1 + sizeof(device_id) + sizeof(nonce)];
+    memcpy(input, label, sizeof(label) - 1);
+    memcpy(input + sizeof(label) - 1, device_id, sizeof(device_id));
+    memcpy(input + sizeof(label) - 1 + sizeof(device_id), nonce, sizeof(nonce));
+
+    uint8_t pad[sizeof(config->gazell_secret_key)];
+    size_t pad_len;
+    psa_status_t status = psa_mac_compute(key_id, MAC_ALG, input, sizeof(input), pad, sizeof(pad), &pad_len);
+    if (status != PSA_SUCCESS || pad_len != sizeof(pad)) {
+        LOG_ERR("psa_mac_compute() returned %d", status);
+        return -EIO;
+    }
+
+    for (size_t i = 0; i < sizeof(pad); i++) {
+        config->gazell_secret_key[i] ^= pad[i];
+    }
+    memset(pad, 0, sizeof(pad));
+
+    return 0;
+}
+
+static int open_message(const struct provisioning_msg_t *msg, struct config_t *config) {
+    if (!is_nonce_valid) {
+        LOG_ERR("No nonce has been read");
+        return -EACCES;
+    }
+
+    uint8_t key[KEY_SIZE];
+    if (hex2bin(CONFIG_APP_PROVISIONING_KEY, strlen(CONFIG_APP_PROVISIONING_KEY), key, sizeof(key)) != KEY_SIZE) {
+        LOG_ERR("No provisioning key configured");
+        return -EACCES;
+    }
+
+    psa_status_t status = psa_crypto_init();
+    if (status != PSA_SUCCESS) {
+        LOG_ERR("psa_crypto_init() returned %d", status);
+        return -EIO;
+    }
+
+    psa_key_attributes_t attr = PSA_KEY_ATTRIBUTES_INIT;
+    psa_set_key_usage_flags(&attr, PSA_KEY_USAGE_SIGN_MESSAGE | PSA_KEY_USAGE_VERIFY_MESSAGE);
+    psa_set_key_algorithm(&attr, MAC_ALG);
+    psa_set_key_type(&attr, PSA_KEY_TYPE_HMAC);
+
+    psa_key_id_t key_id;
+    status = psa_import_key(&attr, key, sizeof(key), &key_id);
+    memset(key, 0, sizeof(key));
+    if (status != PSA_SUCCESS) {
+        LOG_ERR("psa_import_key() returned %d", status);
+        return -EIO;
+    }
+
+    // The MAC covers the device ID and the nonce, so a message captured from one device can neither be used on another
+    // one nor be replayed later
+    uint8_t input[sizeof(device_id) + sizeof(nonce) + offsetof(struct provisioning_msg_t, mac)];
+    memcpy(input, device_id, sizeof(device_id));
+    memcpy(input + sizeof(device_id), nonce, sizeof(nonce));
+    memcpy(input + sizeof(device_id) + sizeof(nonce), msg, offsetof(struct provisioning_msg_t, mac));
+
+    int res = 0;
+    status  = psa_mac_verify(key_id, MAC_ALG, input, sizeof(input), msg->mac, sizeof(msg->mac));
+    if (status != PSA_SUCCESS) {
+        res = -EACCES;
+    } else {
+        *config = msg->config;
+        res     = unmask_key(key_id, config);
+    }
+
+    psa_destroy_key(key_id);
+    return res;
+}
+
+static int apply(const void *data, size_t len, struct config_t *config) {
+    const struct provisioning_msg_t *msg = data;
+
+    if (len != sizeof(*msg)) {
+        LOG_ERR("Invalid provisioning message length: %d != %d", len, sizeof(*msg));
+        return -EINVAL;
+    }
+
+    if (msg->crc != crc32_ieee(data, offsetof(struct provisioning_msg_t, crc))) {
+        LOG_ERR("Invalid provisioning message CRC");
+        return -EINVAL;
+    }
+
+    // All clickers of a system pair on the one address their receiver listens on, so the pairing address is part of
+    // the configuration rather than derived per device; no flags are defined yet
+    if (msg->flags != 0) {
+        LOG_ERR("Invalid provisioning message flags: 0x%02x", msg->flags);
+        return -EINVAL;
+    }
+
+    // Every authentication attempt uses up the nonce
+    int res        = open_message(msg, config);
+    is_nonce_valid = false;
+    if (res) {
+        LOG_ERR("Provisioning message failed authentication");
+        return res;
+    }
+
+    // Commit with a single write and verify by reading back from flash
+    res = config_save(config);
+    if (res) return res;
+
+    return config_verify(config);
+}
+
+/*********************************************************************************************************************
+ * PUBLIC FUNCTIONS
+ *********************************************************************************************************************/
+int provisioning_apply(const void *msg, size_t len, struct config_t *config) {
+    read_device_id();
+
+    int res     = apply(msg, len, config);
+    last_result = (int8_t)res;
+
+    if (res == 0) {
+        LOG_INF("Device provisioned");
+    }
+
+    return res;
+}
+
+void provisioning_get_status(struct provisioning_status_t *status) {
+    read_device_id();
+
+    if (!is_nonce_valid) {
+        draw_nonce();
+    }
+
+    struct config_t config;
+    if (config_load(&config) != 0) {
+        memset(&config, 0, sizeof(config));
+    }
+
+    memcpy(status->device_id, device_id, sizeof(device_id));
+    memcpy(status->nonce, nonce, sizeof(nonce));
+    status->config_crc  = crc32_ieee((const uint8_t *)&config, sizeof(config));
+    status->last_result = last_result;
+}
@@ -0,0 +1,56 @@
+#ifndef PROVISIONING_H
+#define PROVISIONING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/toolchain.h>
+
+#include "config.h"
+
+// Provisioning message as written by the provisioning station (little-endian, 55 bytes). The Gazell key is XORed with
+// HMAC-SHA256("gazell-key", device ID, nonce) under the provisioning key, truncated to 16 bytes, so that it stays
+// secret even if the link was paired with Just Works; the CRC and the MAC cover the masked key.
+struct provisioning_msg_t {
+    uint8_t flags;           // Reserved, must be 0
+    struct config_t config;  // The complete configuration, with the Gazell key masked (see above)
+    uint32_t crc;            // CRC-32 (IEEE) over flags and config
+    uint8_t mac[16];         // HMAC-SHA256 over device ID, nonce, flags, config and crc, truncated to 16 bytes
+} __packed;
+
+// Provisioning status as read by the provisioning station (little-endian, 21 bytes)
+struct provisioning_status_t {
+    uint8_t device_id[8];  // Hardware device ID; part of the MAC so that a message only works for one device
+    uint8_t nonce[8];      // Random nonce for the next message; part of the MAC so that a message only works once
+    uint32_t config_crc;   // CRC-32 (IEEE) over the configuration that is currently stored
+    int8_t last_result;    // Result of the last provisioning attempt (0 or a negative error code)
+} __packed;
+
+/**
+ * @brief Authenticates a provisioning message and commits the contained configuration.
+ *
+ * The message is checked (length, CRC and MAC), the Gazell key is unmasked, the configuration is saved with a single
+ * call to config_save() and then read back from flash to verify it. The MAC must cover the nonce of the last
+ * provisioning_get_status() call; every attempt uses up the nonce, so a recorded message cannot be replayed to roll
+ * the configuration back.
+ *
+ * @param msg The provisioning message.
+ * @param len Length of the message in bytes.
+ * @param config Filled with the committed configuration.
+ *
+ * @retval 0 If successful.
+ * @retval -EINVAL If the message length, flags or CRC are wrong.
+ * @retval -EACCES If the MAC is wrong, no nonce has been read or no provisioning key is configured.
+ * @retval <0 Other error code if saving or verifying the configuration failed.
+ */
+int provisioning_apply(const void *msg, size_t len, struct config_t *config);
+
+/**
+ * @brief Returns the provisioning status.
+ *
+ * Draws a new nonce if the previous one has been used up by a provisioning attempt.
+ *
+ * @param status Pointer to the status structure to fill.
+ */
+void provisioning_get_status(struct provisioning_status_t *status);
+
+#endif  // PROVISIONING_H
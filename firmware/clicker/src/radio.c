@@ -0,0 +1,1281 @@
+#include "radio.h"
+#include "channels.h"
+#include "config.h"
+#include "energy.h"
+#include "feedback.h"
+#include "flashq.h"
+#include "idle.h"
+#include "journal.h"
+#include "leds.h"
+#include "packet.h"
+#include "profiling.h"
+#include "retained.h"
+#include "speaker.h"
+#include "timeslot.h"
+#include "trace.h"
+#include "workq.h"
+
+#include <gzll_glue.h>
+#include <nrf_gzll.h>
+#include <zephyr/drivers/hwinfo.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/random/random.h>
+#include <zephyr/sys/byteorder.h>
+
+#if defined(CONFIG_BT)
+#include "services/config_svc.h"
+#endif
+
+LOG_MODULE_REGISTER(app_radio);
+
+// Gazell configuration
+#define PAIRING_PIPE    0  // Uses the pairing address as base address 0
+#define DATA_PIPE       1  // Uses the system address (base address 1 and prefix)
+#define AIR_US_PER_BYTE 4  // At Gazell's default data rate of 2 Mbps
+
+// After waking up, the clicker is out of sync with the receiver; it must then stay on a channel until the receiver
+// has cycled through all of its channels (Gazell's default of 2 timeslots per channel), so that a failure really
+// means that the channel is bad
+#define TIMESLOT_US                       600  // Gazell's default timeslot period
+#define CYCLE_US                          (CHANNELS_NUM * 2 * TIMESLOT_US)
+#define OUT_OF_SYNC_TIMESLOTS_PER_CHANNEL (CHANNELS_NUM * 2)
+
+// Contention: when many clickers send at the same time (e.g. in a vote), Gazell's retransmissions in every timeslot
+// keep colliding. Each clicker therefore gets a slot derived from its device ID, which selects one of the good
+// channels and a delay in receiver cycles. Data packets are sent one at a time and Gazell only gets one receiver cycle
+// worth of attempts per try; if they all fail, the packet is retried on the next channel after a random backoff of
+// up to BACKOFF_BASE_CYCLES << (tries - 1) receiver cycles. See scripts/burst_sim.py for the choice of the numbers.
+#define MAX_TX_ATTEMPTS_PER_TRY OUT_OF_SYNC_TIMESLOTS_PER_CHANNEL
+#define MAX_TX_TRIES            10
+#define MAX_SYNC_TX_TRIES       2  // The receiver only holds the click back for a short time (50 ms by default)
+#define DEFAULT_NUM_SLOTS       8  // Used until the receiver has sent a slot hint
+#define MAX_NUM_SLOTS           128
+#define BACKOFF_BASE_CYCLES     2
+#define MAX_BACKOFF_EXP         3
+#define TX_QUEUE_SIZE           8  // Button events waiting to be sent
+
+// Journal replay: the journal is replayed once the receiver acks a packet again. Without new clicks, replay packets
+// with few tries probe the link instead, on startup or after a failed packet and then at growing intervals. Probes
+// count as activity, so there are only MAX_REPLAY_PROBES per wake cycle, which lets the clicker enter System OFF if the
+// receiver stays away.
+#define MAX_PROBE_TX_TRIES      2
+#define MAX_REPLAY_PROBES       5  // Spread over 155 s at most, well within the default idle timeout
+#define REPLAY_PROBE_INTERVAL_S 5  // Doubled after each probe
+
+// TX power control: the receiver sends its acks at 0 dBm, so the ack RSSI minus our own attenuation estimates how
+// strong our packets arrive at the receiver. After TX_POWER_HEALTHY_PACKETS packets in a row that would still arrive
+// above TX_POWER_TARGET_RSSI at the next lower level, we step down one level; as soon as a try fails, we go back to
+// full power.
+#define TX_POWER_TARGET_RSSI     -80
+#define TX_POWER_HEALTHY_PACKETS 4
+
+// Pairing: after the request has been acked, the receiver needs some time to prepare the response, which we fetch
+// with the ack payload of a later packet
+#define PAIRING_FETCH_INTERVAL K_MSEC(20)
+#define PAIRING_FETCH_ATTEMPTS 25
+#define GAZELL_DISABLE_TIMEOUT K_MSEC(100)
+
+// The packet counter is persisted in NVS in blocks of this size: the NVS holds the end of the current block, so a
+// flash write is only needed once per block; after losing the retained state, the counter continues at the end of
+// the block, which may skip some values but never reuses one
+#define COUNTER_BLOCK_SIZE 1024
+
+BUILD_ASSERT(CHANNELS_NUM <= PACKET_LINK_NO_CHANNEL, "Channel indices are reported in 4 bits (see packet.h)");
+
+// TX power levels from full power down, with the typical TX current of the nRF52840 (DC/DC enabled, 3 V) for the
+// energy model
+struct tx_power_level_t {
+    nrf_gzll_tx_power_t power;
+    int8_t dbm;
+    uint16_t current_ua;
+};
+
+static const struct tx_power_level_t tx_power_levels[] = {
+    {NRF_GZLL_TX_POWER_0_DBM, 0, 4800},     {NRF_GZLL_TX_POWER_N4_DBM, -4, 3800},
+    {NRF_GZLL_TX_POWER_N8_DBM, -8, 3300},   {NRF_GZLL_TX_POWER_N12_DBM, -12, 3000},
+    {NRF_GZLL_TX_POWER_N16_DBM, -16, 2800}, {NRF_GZLL_TX_POWER_N20_DBM, -20, 2700},
+};
+
+// Queue for button events (from radio_send_event() to the work queue); the events that are queued when a packet is
+// sealed all go out in that packet, so a burst of clicks costs one packet instead of one per click
+K_MSGQ_DEFINE(radio_tx_msgq, sizeof(struct buttons_event_t), TX_QUEUE_SIZE, 4);
+
+// Kinds of data packets
+enum tx_kind_t {
+    TX_KIND_CLICK,         // New events from radio_tx_msgq
+    TX_KIND_REPLAY,        // Events from the journal
+    TX_KIND_SYNC,          // Press times of the last acked click packet
+    TX_KIND_PAIR_REQUEST,  // Pairing request (on the pairing pipe)
+    TX_KIND_PAIR_FETCH,    // Fetches the pairing response with its ack (on the pairing pipe)
+};
+
+// Data packet; sealed right before its first try, so that the ages of the events are accurate. Events of click
+// packets that are not acked go to the journal, which is replayed in replay packets once the receiver acks again.
+struct tx_packet_t {
+    uint8_t data[PACKET_MAX_SIZE];
+    uint8_t len;
+    uint8_t tries;
+    enum tx_kind_t kind;
+    uint32_t counter;
+    uint8_t num_events;                                // Events of a click packet
+    struct buttons_event_t events[PACKET_MAX_EVENTS];  // Events of a click packet
+    struct journal_batch_t batch;                      // Events of a replay packet
+    bool is_probe;                                     // A replay packet that probes the link
+};
+
+// Time sync: if the receiver asks for it in its slot hints, every acked click packet is followed by a sync packet
+// with the press times of its events relative to the ack (see packet.h). The ack is taken as the instant the receiver
+// got the click packet; without the air time of the ack payload (see on_tx_done()), both are off by the same air time
+// and interrupt latency for every clicker, so the receiver can rank presses of different clickers with the resolution
+// of the RTC (30.5 us).
+struct sync_packet_t {
+    bool is_pending;  // Waiting to be sent
+    uint8_t num_events;
+    struct packet_sync_t body;
+};
+
+// Global state
+static uint8_t packet_valid_id[3];
+static uint32_t device_id;
+static atomic_t packets_in_flight;
+static uint8_t channel_offset;  // Index of the first entry of the rotated channel table in channels_table
+static uint8_t channel_idx;     // Index of the current channel in the rotated channel table
+static bool is_warm_start;      // Channel scores were available in retained RAM at startup
+static bool first_packet_done;  // The first packet since startup was acked
+static k_timeout_t slot_delay;  // Delay of data packets according to our slot
+
+static K_SEM_DEFINE(disabled_sem, 0, 1);
+
+// Ack payload of the last packet sent on the pairing pipe; written from the radio interrupt before submitting the work
+static uint8_t pairing_ack[NRF_GZLL_CONST_MAX_PAYLOAD_LENGTH];
+static uint32_t pairing_ack_len;
+
+// Result of the last try of the current packet; written from the radio interrupt before submitting the work
+static atomic_t tx_ok;
+static uint32_t tx_ack_cycles;  // Hardware cycles when the ack came in
+
+// Command received in an ack payload; written from the radio interrupt before submitting the work, which clears
+// is_command_pending once it has opened the packet
+static atomic_t is_command_pending;
+static uint8_t command_buf[PACKET_MAX_SIZE];
+static uint32_t command_len;
+
+// A replay or probe waits for the journal to finish its flash work; cleared by on_journal_ready() on the flash work
+// queue
+static atomic_t is_journal_awaited;
+
+// Global state (only accessed from the work queue)
+static struct tx_packet_t tx_packet;      // Data packet currently being sent
+static struct sync_packet_t sync_packet;  // Sync packet for the last acked click packet
+static bool tx_busy;
+static bool is_link_up;         // The last data packet was acked
+static bool is_reload_pending;  // The configuration changed while a packet was being sent
+static bool is_pair_pending;    // radio_pair() was called; pairing starts once the current packet is done
+static bool is_probe_pending;   // A replay probe is due; it starts once the current packet is done
+static uint8_t num_probes;      // Replay probes sent in this wake cycle
+
+static uint32_t pair_request_counter;  // Counter of the acked pairing request, which the response must answer
+static uint8_t pair_fetches;           // Number of fetch packets sent for the current pairing request
+static struct packet_pair_response_t pair_response;
+
+static void tx_next_work_fn(struct k_work *work);
+static void tx_send_work_fn(struct k_work *work);
+static void tx_done_work_fn(struct k_work *work);
+static void command_work_fn(struct k_work *work);
+static void reload_work_fn(struct k_work *work);
+static void pair_work_fn(struct k_work *work);
+static void probe_work_fn(struct k_work *work);
+static void counter_work_fn(struct k_work *work);
+
+K_WORK_DEFINE(radio_tx_next_work, tx_next_work_fn);
+K_WORK_DELAYABLE_DEFINE(radio_tx_send_work, tx_send_work_fn);
+K_WORK_DEFINE(radio_tx_done_work, tx_done_work_fn);
+K_WORK_DEFINE(radio_command_work, command_work_fn);
+K_WORK_DEFINE(radio_reload_work, reload_work_fn);
+K_WORK_DEFINE(radio_pair_work, pair_work_fn);
+K_WORK_DELAYABLE_DEFINE(radio_probe_work, probe_work_fn);
+K_WORK_DEFINE(radio_counter_work, counter_work_fn);  // On the flash work queue
+
+K_MUTEX_DEFINE(counter_lock);  // Serializes the reservations of counter blocks in NVS
+
+/*********************************************************************************************************************
+ * PRIVATE FUNCTIONS
+ *********************************************************************************************************************/
+static int reserve_counters(uint32_t limit) {
+    k_mutex_lock(&counter_lock, K_FOREVER);
+
+    // The block is only used once the NVS holds its end
+    int res = 0;
+    if (limit > retained.radio_seq_limit) {
+        res = config_save_radio_counter(limit);
+        if (res == 0) {
+            retained.radio_seq_limit = limit;
+            retained_update();
+        }
+    }
+
+    k_mutex_unlock(&counter_lock);
+    return res;
+}
+
+static int init_counter() {
+    if (retained_is_valid() && retained.radio_seq < retained.radio_seq_limit) {
+        return 0;
+    }
+
+    // The retained state is gone, so we continue at the end of the block reserved in NVS
+    uint32_t limit;
+    int res = config_load_radio_counter(&limit);
+    if (res) return res;
+
+    // Commands are bound to the counter of one of our packets (see packet.h), so the ones sealed before (all below the
+    // limit) cannot be replayed after the retained state is lost either. The limit itself is skipped rather than used
+    // for a packet: no command is ever sealed with it, so the receiver cannot take it for the confirmation of a command
+    // it sealed before; it sees that we have moved past its command and seals it again instead
+    if (!retained_is_valid()) {
+        retained.radio_last_command = limit;
+        retained.radio_seq          = limit + 1;
+    } else {
+        retained.radio_seq = limit;
+    }
+
+    retained.radio_seq_limit = limit;
+    retained_update();
+
+    // Reserved right away (we are not on the work queue yet), so that the first packet need not wait for it
+    return reserve_counters(retained.radio_seq + COUNTER_BLOCK_SIZE);
+}
+
+static int next_counter(uint32_t *counter) {
+    // The next block is reserved on the flash work queue once half of the current one has been used; only if that
+    // has not finished (or failed) by the end of the block, we have to wait for the NVS write here
+    if (retained.radio_seq >= retained.radio_seq_limit) {
+        LOG_WRN("Packet counter block used up before the next one was reserved");
+        int res = reserve_counters(retained.radio_seq + COUNTER_BLOCK_SIZE);
+        if (res) return res;
+    } else if (retained.radio_seq_limit - retained.radio_seq <= COUNTER_BLOCK_SIZE / 2) {
+        k_work_submit_to_queue(&flashq, &radio_counter_work);
+    }
+
+    *counter = retained.radio_seq++;
+    retained_update();
+
+    return 0;
+}
+
+static void update_score(uint8_t idx, bool ok) {
+    // Exponential moving average: a success moves the score a quarter of the way up to UINT8_MAX, a failure a quarter
+    // of the way down to 0
+    uint8_t *score = &retained.radio_channel_score[idx];
+    *score         = ok ? *score + (UINT8_MAX - *score + 3) / 4 : *score - (*score + 3) / 4;
+}
+
+static void update_channel_scores(bool ok, uint32_t num_channel_switches) {
+    // Gazell moves on to the next entry of the channel table with every channel switch, so the packet failed on all
+    // channels from the current one up to (excluding) the one it ended on
+    uint8_t failed = 0;
+    for (uint32_t i = 0; i < num_channel_switches + !ok; i++) {
+        uint8_t idx = (channel_offset + channel_idx + i) % CHANNELS_NUM;
+        failed |= BIT(idx);
+        update_score(idx, false);
+    }
+
+    channel_idx = (channel_idx + num_channel_switches) % CHANNELS_NUM;
+
+    uint8_t ok_idx = (channel_offset + channel_idx) % CHANNELS_NUM;
+    if (ok) {
+        update_score(ok_idx, true);
+    }
+
+    // Reported to the receiver with the next click packet: the channel of the last try and the channels that failed
+    // in all tries of all packets since the last click packet was sealed
+    retained.radio_ok_channel = ok ? ok_idx : CHANNELS_NONE;
+    retained.radio_failed_channels |= failed;
+    retained_update();
+}
+
+static void count_retries(uint32_t num_tx_attempts) {
+    // Reported to the receiver with the next click packet, like the failed channels; the receiver cannot count them
+    // itself, since Gazell drops the duplicates of packets whose ack got lost
+    uint32_t num_retries       = retained.radio_num_retries + num_tx_attempts - 1;
+    retained.radio_num_retries = MIN(num_retries, PACKET_LINK_MAX_RETRIES);
+    retained_update();
+}
+
+static void apply_tx_power() {
+    const struct tx_power_level_t *level = &tx_power_levels[retained.radio_tx_power_level];
+    nrf_gzll_set_tx_power(level->power);
+    energy_set_current(ENERGY_RADIO_TX, level->current_ua);
+}
+
+static void update_tx_power(bool ok, int16_t ack_rssi) {
+    if (!IS_ENABLED(CONFIG_APP_RADIO_TX_POWER_CONTROL)) {
+        return;
+    }
+
+    uint8_t level = retained.radio_tx_power_level;
+    if (!ok) {
+        level                           = 0;
+        retained.radio_tx_power_healthy = 0;
+    } else if (level + 1 < ARRAY_SIZE(tx_power_levels)) {
+        // Estimated RSSI of our packets at the receiver if we were transmitting at the next lower level
+        int next_rssi = ack_rssi + tx_power_levels[level + 1].dbm;
+        if (next_rssi < TX_POWER_TARGET_RSSI) {
+            retained.radio_tx_power_healthy = 0;
+        } else if (++retained.radio_tx_power_healthy >= TX_POWER_HEALTHY_PACKETS) {
+            level++;
+            retained.radio_tx_power_healthy = 0;
+        }
+    }
+
+    if (level != retained.radio_tx_power_level) {
+        retained.radio_tx_power_level = level;
+        apply_tx_power();
+        trace(TRACE_MOD_RADIO, TRACE_EVT_RADIO_TX_POWER,
+              (uint16_t)tx_power_levels[level].dbm | ((uint32_t)(uint16_t)ack_rssi << 16));
+    }
+
+    retained_update();
+}
+
+static void begin_tx() {
+    // We stay awake until Gazell reports the result; the radio itself is only charged while a packet is in the Gazell
+    // TX FIFO (see add_packet() and on_tx_done()), not while it waits for its slot or a backoff
+    idle_set_busy(IDLE_SRC_RADIO, true);
+    atomic_inc(&packets_in_flight);
+}
+
+static void end_tx() {
+    if (atomic_dec(&packets_in_flight) == 1) {
+        idle_set_busy(IDLE_SRC_RADIO, false);
+    }
+}
+
+static void on_ack_payload(const uint8_t *payload, uint32_t len) {
+    const struct packet_slot_hint_t *hint = (const struct packet_slot_hint_t *)payload;
+    if (len == sizeof(*hint) && hint->type == PACKET_TYPE_SLOT_HINT && hint->num_slots > 0) {
+        retained.radio_num_slots = MIN(hint->num_slots, MAX_NUM_SLOTS);
+        retained.radio_time_sync = IS_ENABLED(CONFIG_APP_RADIO_TIME_SYNC) && (hint->flags & PACKET_SLOT_HINT_TIME_SYNC);
+        retained_update();
+        return;
+    }
+
+    // Commands are broadcast to all clickers until the addressed one confirms them, so we only decrypt new commands
+    // for us (in the work queue)
+    const struct packet_header_t *header = (const struct packet_header_t *)payload;
+    if (len > sizeof(*header) && len <= sizeof(command_buf) && header->type == PACKET_TYPE_COMMAND &&
+        header->device_id == device_id && header->counter > retained.radio_last_command &&
+        atomic_cas(&is_command_pending, false, true)) {
+        memcpy(command_buf, payload, len);
+        command_len = len;
+        k_work_submit_to_queue(&workq, &radio_command_work);
+    }
+}
+
+static void on_journal_ready() {
+    // Called on the flash work queue; a replay or probe that found the journal busy starts now
+    if (atomic_cas(&is_journal_awaited, true, false)) {
+        k_work_submit_to_queue(&workq, &radio_tx_next_work);
+    }
+}
+
+static void on_first_packet() {
+    uint32_t ms = k_uptime_get_32();
+    LOG_INF("First packet acked %u ms after startup (%s)", ms, is_warm_start ? "warm" : "cold");
+    trace(TRACE_MOD_RADIO, TRACE_EVT_RADIO_FIRST_PACKET, ms | ((uint32_t)is_warm_start << 31));
+}
+
+static void on_tx_done(uint32_t pipe, bool ok, nrf_gzll_device_tx_info_t tx_info) {
+    // Taken first, so that the time sync does not depend on the work below
+    uint32_t ack_cycles = k_cycle_get_32();
+
+    energy_state_end(ENERGY_RADIO_TX);
+    timeslot_tx_done();
+    trace(TRACE_MOD_RADIO, ok ? TRACE_EVT_RADIO_TX_OK : TRACE_EVT_RADIO_TX_FAILED,
+          tx_info.num_tx_attempts | (tx_info.num_channel_switches << 16));
+
+    // A packet that never got a timeslot (see timeslot_send()) says nothing about the channels or the TX power
+    if (tx_info.num_tx_attempts > 0) {
+        update_channel_scores(ok, tx_info.num_channel_switches);
+        update_tx_power(ok, tx_info.rssi);
+        count_retries(tx_info.num_tx_attempts);
+    }
+
+    if (ok && !first_packet_done) {
+        first_packet_done = true;
+        on_first_packet();
+    }
+
+    // Always fetch ack payloads so that the RX FIFO does not fill up; the pairing response is opened in the work queue
+    if (pipe == PAIRING_PIPE) {
+        pairing_ack_len = 0;
+        if (tx_info.payload_received_in_ack) {
+            pairing_ack_len = sizeof(pairing_ack);
+            nrf_gzll_fetch_packet_from_rx_fifo(pipe, pairing_ack, &pairing_ack_len);
+        }
+    } else if (tx_info.payload_received_in_ack) {
+        uint8_t payload[NRF_GZLL_CONST_MAX_PAYLOAD_LENGTH];
+        uint32_t len = sizeof(payload);
+        if (nrf_gzll_fetch_packet_from_rx_fifo(pipe, payload, &len)) {
+            on_ack_payload(payload, len);
+
+            // The receiver takes its time when it gets the packet, we take ours at the end of the ack, which comes
+            // later the longer the payload is (e.g. 80 us more for a command than for a slot hint); without the air
+            // time of the payload, the offset between the two is the same for every ack
+            ack_cycles -= k_us_to_cyc_near32(len * AIR_US_PER_BYTE);
+        }
+    }
+
+    tx_ack_cycles = ack_cycles;
+    atomic_set(&tx_ok, ok);
+    k_work_submit_to_queue(&workq, &radio_tx_done_work);
+}
+
+static int seal_packet(enum packet_type_t type, const void *body, size_t body_len, uint8_t *buf, uint32_t *counter) {
+    struct packet_header_t header = {
+        .type      = type,
+        .device_id = device_id,
+    };
+    memcpy(header.valid_id, packet_valid_id, sizeof(header.valid_id));
+
+    int res = next_counter(&header.counter);
+    if (res) return res;
+
+    PROFILING_BEGIN(PROFILING_PACKET_SEAL);
+    int len = packet_seal(&header, body, body_len, buf);
+    PROFILING_END(PROFILING_PACKET_SEAL);
+
+    if (len < 0) {
+        LOG_ERR("Failed to seal packet: %d", len);
+        return len;
+    }
+
+    *counter = header.counter;
+    return len;
+}
+
+static bool add_packet(uint32_t pipe, const uint8_t *data, uint32_t len, bool is_urgent) {
+    // With timeslots, the packet is added to the Gazell TX FIFO (and the radio charged) in the timeslot
+    if (IS_ENABLED(CONFIG_APP_RADIO_TIMESLOTS)) {
+        return timeslot_send(pipe, data, len, is_urgent) == 0;
+    }
+
+    if (!nrf_gzll_add_packet_to_tx_fifo(pipe, data, len)) {
+        return false;
+    }
+
+    // Gazell transmits until on_tx_done(); the acks are received in between at about the same current
+    energy_state_begin(ENERGY_RADIO_TX);
+    return true;
+}
+
+static k_timeout_t get_backoff_delay(uint32_t tries) {
+    uint32_t window = BACKOFF_BASE_CYCLES << MIN(tries - 1, MAX_BACKOFF_EXP);
+    uint32_t cycles = sys_rand32_get() % window;
+    trace(TRACE_MOD_RADIO, TRACE_EVT_RADIO_BACKOFF, cycles);
+    return K_USEC(cycles * CYCLE_US);
+}
+
+static int set_channel_table(uint8_t offset) {
+    // Rotating the table (instead of e.g. sorting it by score) keeps the channels in the order of channels_table, the
+    // same order the receiver cycles through them. The receiver leaves out its blacklisted channels, though, so the
+    // tables only match while it has none: otherwise Gazell's guess of the receiver's channel in sync mode is off, the
+    // clicker falls out of sync and stays on each channel for a full cycle of the receiver (which the out-of-sync
+    // setting covers for any number of active channels); our tries on a blacklisted channel always fail.
+    uint8_t table[CHANNELS_NUM];
+    for (int i = 0; i < CHANNELS_NUM; i++) {
+        table[i] = channels_table[(offset + i) % CHANNELS_NUM];
+    }
+
+    channel_offset = offset;
+    channel_idx    = 0;
+
+    // With timeslots, Gazell belongs to the timeslot callback, which applies the table at the start of a timeslot
+    if (IS_ENABLED(CONFIG_APP_RADIO_TIMESLOTS)) {
+        return timeslot_set_channel_table(table, CHANNELS_NUM);
+    }
+
+    return nrf_gzll_set_channel_table(table, CHANNELS_NUM) ? 0 : -EIO;
+}
+
+static uint8_t select_slot() {
+    // The clickers are spread over the slots evenly (Fibonacci hashing of the device ID) ...
+    uint32_t num_slots = retained.radio_num_slots ? retained.radio_num_slots : DEFAULT_NUM_SLOTS;
+    uint32_t hash      = device_id * 2654435761u;
+    uint32_t slot      = ((uint64_t)hash * num_slots) >> 32;
+
+    // ... and each slot maps to one of the channels that score at least half as good as the best one (all channels
+    // if nothing is known yet) and a delay in receiver cycles
+    uint8_t best = 0;
+    for (int i = 0; i < CHANNELS_NUM; i++) {
+        best = MAX(best, retained.radio_channel_score[i]);
+    }
+
+    uint8_t good[CHANNELS_NUM];
+    int num_good = 0;
+    for (int i = 0; i < CHANNELS_NUM; i++) {
+        if (retained.radio_channel_score[i] >= best / 2) {
+            good[num_good++] = i;
+        }
+    }
+
+    slot_delay = K_USEC(slot / num_good * CYCLE_US);
+    return good[slot % num_good];
+}
+
+static int enable_gazell() {
+    // With timeslots, Gazell is only enabled during the timeslots
+    if (IS_ENABLED(CONFIG_APP_RADIO_TIMESLOTS)) {
+        return 0;
+    }
+
+    return nrf_gzll_enable() ? 0 : -EIO;
+}
+
+static int disable_gazell() {
+    // With timeslots, Gazell is disabled at the end of each timeslot, and changes are applied by the timeslot callback
+    if (IS_ENABLED(CONFIG_APP_RADIO_TIMESLOTS) || !nrf_gzll_is_enabled()) {
+        return 0;
+    }
+
+    k_sem_reset(&disabled_sem);
+    nrf_gzll_disable();
+    return k_sem_take(&disabled_sem, GAZELL_DISABLE_TIMEOUT) == 0 ? 0 : -ETIMEDOUT;
+}
+
+static int move_to_next_channel() {
+    uint8_t offset = (channel_offset + channel_idx + 1) % CHANNELS_NUM;
+
+    int res = disable_gazell();
+    if (res) return res;
+
+    res = set_channel_table(offset);
+    if (res) return res;
+
+    return enable_gazell();
+}
+
+static int set_addresses(const struct config_t *config) {
+    // Each address consists of a base address (4 bytes) and the prefix of the respective pipe
+    if (IS_ENABLED(CONFIG_APP_RADIO_TIMESLOTS)) {
+        int res = timeslot_set_address(PAIRING_PIPE, config->gazell_pairing_addr);
+        if (res) return res;
+
+        return timeslot_set_address(DATA_PIPE, config->gazell_system_addr);
+    }
+
+    // Addresses can only be changed while Gazell is disabled
+    int res = disable_gazell();
+    if (res) return res;
+
+    bool ok = nrf_gzll_set_base_address_0(sys_get_le32(config->gazell_pairing_addr));
+    ok      = ok && nrf_gzll_set_address_prefix_byte(PAIRING_PIPE, config->gazell_pairing_addr[4]);
+    ok      = ok && nrf_gzll_set_base_address_1(sys_get_le32(config->gazell_system_addr));
+    ok      = ok && nrf_gzll_set_address_prefix_byte(DATA_PIPE, config->gazell_system_addr[4]);
+    if (!ok) {
+        return -EIO;
+    }
+
+    return enable_gazell();
+}
+
+static int reload_config() {
+    is_reload_pending = false;
+
+    struct config_t config;
+    int res = config_load(&config);
+    if (res) return res;
+
+    res = packet_set_key(config.gazell_secret_key);
+    if (res) return res;
+
+    memcpy(packet_valid_id, config.gazell_packet_valid_id, sizeof(packet_valid_id));
+    return set_addresses(&config);
+}
+
+static int open_pairing_response(struct packet_pair_response_t *response) {
+    if (pairing_ack_len == 0) {
+        return -ENOENT;
+    }
+
+    // The response must be addressed to us and answer our request; anything else is a leftover of another clicker's
+    // pairing attempt
+    struct packet_header_t header;
+    uint8_t body[PACKET_MAX_BODY_LEN];
+    int len = packet_open(pairing_ack, pairing_ack_len, &header, body);
+    if (len != sizeof(*response) || header.type != PACKET_TYPE_PAIR_RESPONSE || header.device_id != device_id ||
+        header.counter != pair_request_counter) {
+        LOG_WRN("Ignoring invalid pairing response (%d)", len);
+        return -EBADMSG;
+    }
+
+    memcpy(response, body, sizeof(*response));
+    return 0;
+}
+
+static int store_pairing(const struct packet_pair_response_t *response) {
+    // Store the pairing info and switch to the new system address
+    struct config_t config;
+    int res = config_load(&config);
+    if (res) return res;
+
+    memcpy(config.gazell_system_addr, response->system_addr, sizeof(config.gazell_system_addr));
+    memcpy(config.gazell_host_id, response->host_id, sizeof(config.gazell_host_id));
+    res = config_save(&config);
+    if (res) return res;
+
+    // The channel scores and the TX power level belong to the previous receiver
+    memset(retained.radio_channel_score, 0, sizeof(retained.radio_channel_score));
+    retained.radio_tx_power_level   = 0;
+    retained.radio_tx_power_healthy = 0;
+    retained.radio_time_sync        = false;
+    retained_update();
+    apply_tx_power();
+
+    res = set_addresses(&config);
+    if (res) return res;
+
+#if defined(CONFIG_BT)
+    config_svc_reload();
+#endif
+
+    LOG_INF("Paired with host %02x%02x%02x%02x%02x", config.gazell_host_id[0], config.gazell_host_id[1],
+            config.gazell_host_id[2], config.gazell_host_id[3], config.gazell_host_id[4]);
+    return 0;
+}
+
+static bool is_paired(const struct config_t *config) {
+    static const uint8_t unset[sizeof(config->gazell_system_addr)] = {0};
+    return memcmp(config->gazell_system_addr, unset, sizeof(unset)) != 0;
+}
+
+static int set_host_id(const uint8_t host_id[5]) {
+    struct config_t config;
+    int res = config_load(&config);
+    if (res) return res;
+
+    memcpy(config.gazell_host_id, host_id, sizeof(config.gazell_host_id));
+    res = config_save(&config);
+    if (res) return res;
+
+#if defined(CONFIG_BT)
+    config_svc_reload();
+#endif
+
+    return 0;
+}
+
+static int apply_command(const struct packet_command_t *command, size_t len) {
+    const size_t args_len = len - offsetof(struct packet_command_t, leds);
+
+    switch (command->command) {
+        case PACKET_COMMAND_LEDS: {
+            const struct packet_command_leds_t *leds = &command->leds;
+            if (args_len < sizeof(*leds) || leds->led > LEDS_D2 || leds->pattern > LEDS_BREATHE) {
+                return -EINVAL;
+            }
+
+            return leds_play(leds->led, leds->pattern, LEDS_RGB(leds->r, leds->g, leds->b), leds->reps, NULL);
+        }
+
+        case PACKET_COMMAND_MELODY:
+            if (args_len < sizeof(command->melody) || command->melody > SPEAKER_MELODY_LOW_BATTERY) {
+                return -EINVAL;
+            }
+
+            return speaker_play(command->melody, NULL);
+
+        case PACKET_COMMAND_HOST_ID:
+            if (args_len < sizeof(command->host_id)) {
+                return -EINVAL;
+            }
+
+            return set_host_id(command->host_id);
+
+        case PACKET_COMMAND_SLEEP:
+            idle_poweroff();
+            return 0;
+
+        default:
+            return -ENOTSUP;
+    }
+}
+
+/*********************************************************************************************************************
+ * WORK HANDLERS
+ *********************************************************************************************************************/
+static int build_click_packet() {
+    // Events that came in while waiting for our slot go out in the same packet
+    while (tx_packet.num_events < PACKET_MAX_EVENTS &&
+           k_msgq_get(&radio_tx_msgq, &tx_packet.events[tx_packet.num_events], K_NO_WAIT) == 0) {
+        tx_packet.num_events++;
+    }
+
+    uint32_t now = k_uptime_get_32();
+    struct packet_event_t events[PACKET_MAX_EVENTS];
+    for (int i = 0; i < tx_packet.num_events; i++) {
+        const struct buttons_event_t *event = &tx_packet.events[i];
+        events[i].button                    = event->button;
+        events[i].is_long_press             = event->is_long_press;
+        events[i].shift_presses             = MIN(event->preceding_short_shift_presses, UINT8_MAX);
+        events[i].age_ms                    = now - event->uptime_ms;
+    }
+
+    uint8_t ok_channel = retained.radio_ok_channel;
+    if (ok_channel == CHANNELS_NONE) {
+        ok_channel = PACKET_LINK_NO_CHANNEL;
+    }
+
+    struct packet_click_t click = {
+        .link            = ok_channel | retained.radio_num_retries << PACKET_LINK_RETRIES_SHIFT,
+        .failed_channels = retained.radio_failed_channels,
+        .last_command    = retained.radio_last_command,
+    };
+
+    int events_len = packet_encode_events(events, tx_packet.num_events, click.events);
+    if (events_len < 0) return events_len;
+
+    size_t body_len = offsetof(struct packet_click_t, events) + events_len;
+    int len         = seal_packet(PACKET_TYPE_CLICK, &click, body_len, tx_packet.data, &tx_packet.counter);
+    if (len < 0) return len;
+
+    // The failed channels and the retries have been reported; the tries of this packet start new counts
+    retained.radio_failed_channels = 0;
+    retained.radio_num_retries     = 0;
+    retained_update();
+
+    tx_packet.len = len;
+    return 0;
+}
+
+static int build_replay_packet() {
+    // The batch is fetched again for up-to-date ages
+    struct journal_batch_t *batch = &tx_packet.batch;
+    int res                       = journal_get_batch(batch);
+    if (res) return res;
+
+    if (batch->num_events == 0) {
+        return -ENOENT;
+    }
+
+    struct packet_replay_t replay = {
+        .first_id = batch->first_id,
+        .age_ms   = batch->age_ms,
+    };
+
+    int events_len = packet_encode_events(batch->events, batch->num_events, replay.events);
+    if (events_len < 0) return events_len;
+
+    size_t body_len = offsetof(struct packet_replay_t, events) + events_len;
+    int len         = seal_packet(PACKET_TYPE_REPLAY, &replay, body_len, tx_packet.data, &tx_packet.counter);
+    if (len < 0) return len;
+
+    tx_packet.len = len;
+    return 0;
+}
+
+static int build_sync_packet() {
+    size_t body_len = offsetof(struct packet_sync_t, press_ages_us) + sync_packet.num_events * sizeof(uint32_t);
+    int len         = seal_packet(PACKET_TYPE_SYNC, &sync_packet.body, body_len, tx_packet.data, &tx_packet.counter);
+    if (len < 0) return len;
+
+    tx_packet.len = len;
+    return 0;
+}
+
+static int build_pairing_packet() {
+    bool is_request = tx_packet.kind == TX_KIND_PAIR_REQUEST;
+    int len = seal_packet(is_request ? PACKET_TYPE_PAIR_REQUEST : PACKET_TYPE_PAIR_FETCH, NULL, 0, tx_packet.data,
+                          &tx_packet.counter);
+    if (len < 0) return len;
+
+    tx_packet.len = len;
+    return 0;
+}
+
+static void prepare_sync_packet() {
+    // The events beyond PACKET_MAX_SYNC_EVENTS are ranked with the ages of the click packet only
+    sync_packet.is_pending   = true;
+    sync_packet.num_events   = MIN(tx_packet.num_events, PACKET_MAX_SYNC_EVENTS);
+    sync_packet.body.counter = tx_packet.counter;
+    for (int i = 0; i < sync_packet.num_events; i++) {
+        sync_packet.body.press_ages_us[i] = k_cyc_to_us_floor32(tx_ack_cycles - tx_packet.events[i].press_cycles);
+    }
+
+    // Keeps us awake until the sync packet is done
+    begin_tx();
+}
+
+static int build_packet() {
+    switch (tx_packet.kind) {
+        case TX_KIND_CLICK:
+            return build_click_packet();
+
+        case TX_KIND_REPLAY:
+            return build_replay_packet();
+
+        case TX_KIND_SYNC:
+            return build_sync_packet();
+
+        case TX_KIND_PAIR_REQUEST:
+        case TX_KIND_PAIR_FETCH:
+            return build_pairing_packet();
+    }
+
+    return -EINVAL;
+}
+
+static void finish_click_packet(bool ok) {
+    if (ok) {
+        energy_count_delivered(tx_packet.num_events);
+        if (retained.radio_time_sync) {
+            prepare_sync_packet();
+        }
+    } else {
+        LOG_WRN("Packet %u with %u events not acked after %u tries", tx_packet.counter, tx_packet.num_events,
+                tx_packet.tries);
+
+        // The events are kept until the receiver is reachable again (journal_add() logs failures)
+        for (int i = 0; i < tx_packet.num_events; i++) {
+            journal_add(&tx_packet.events[i]);
+        }
+    }
+
+    // Every queued event has been accounted for by begin_tx()
+    for (int i = 0; i < tx_packet.num_events; i++) {
+        end_tx();
+    }
+}
+
+static void finish_replay_packet(bool ok) {
+    const struct journal_batch_t *batch = &tx_packet.batch;
+    if (ok) {
+        energy_count_delivered(batch->num_events);
+        journal_ack(batch);
+    } else {
+        LOG_WRN("Replay of journal events %u-%u not acked, pausing the replay", batch->first_id,
+                batch->first_id + batch->num_events - 1);
+    }
+
+    end_tx();
+}
+
+static void finish_sync_packet(bool ok) {
+    // The receiver falls back to the ages of the click packet, so a lost sync packet is not sent again
+    if (!ok) {
+        LOG_WRN("Sync packet for packet %u not acked", sync_packet.body.counter);
+    }
+
+    end_tx();
+}
+
+static void finish_pairing(bool ok) {
+    int res = ok ? store_pairing(&pair_response) : -ETIMEDOUT;
+    trace(TRACE_MOD_RADIO, TRACE_EVT_RADIO_PAIRED, res);
+    if (res) {
+        LOG_ERR("Pairing failed: %d", res);
+        feedback_play(FEEDBACK_ERROR, NULL);
+    } else {
+        feedback_play(FEEDBACK_SUCCESS, NULL);
+    }
+
+    // Taken by radio_pair()
+    end_tx();
+}
+
+static bool is_pairing() {
+    return tx_packet.kind == TX_KIND_PAIR_REQUEST || tx_packet.kind == TX_KIND_PAIR_FETCH;
+}
+
+static void finish_tx(bool ok) {
+    // Only data packets tell whether the receiver is reachable on the system address
+    if (!is_pairing()) {
+        is_link_up = ok;
+    }
+
+    switch (tx_packet.kind) {
+        case TX_KIND_CLICK:
+            finish_click_packet(ok);
+            break;
+
+        case TX_KIND_REPLAY:
+            finish_replay_packet(ok);
+            break;
+
+        case TX_KIND_SYNC:
+            finish_sync_packet(ok);
+            break;
+
+        case TX_KIND_PAIR_REQUEST:
+        case TX_KIND_PAIR_FETCH:
+            finish_pairing(ok);
+            break;
+    }
+
+    // Until the receiver acks again, the link is probed with the journal (see probe_work_fn())
+    if (is_link_up) {
+        num_probes = 0;
+    } else if (journal_has_events() && num_probes < MAX_REPLAY_PROBES) {
+        k_work_schedule_for_queue(&workq, &radio_probe_work, K_SECONDS(REPLAY_PROBE_INTERVAL_S << num_probes));
+    }
+
+    tx_busy = false;
+    if (is_reload_pending) {
+        reload_work_fn(NULL);
+    }
+
+    tx_next_work_fn(NULL);
+}
+
+static void tx_next_work_fn(struct k_work *work) {
+    if (tx_busy) {
+        return;
+    }
+
+    // A sync packet goes out right away, while the receiver still holds the click packet back for it; then new events
+    // go first, and the journal is replayed while the receiver is reachable and nothing else is queued
+    if (sync_packet.is_pending) {
+        sync_packet.is_pending = false;
+        tx_busy                = true;
+        tx_packet.kind         = TX_KIND_SYNC;
+        tx_packet.tries        = 0;
+        tx_packet.num_events   = 0;
+        k_work_schedule_for_queue(&workq, &radio_tx_send_work, K_NO_WAIT);
+        return;
+    }
+
+    // Pairing keeps the link busy until the response has been fetched, so that no data packet gets in between
+    if (is_pair_pending) {
+        LOG_INF("Pairing...");
+        is_pair_pending      = false;
+        tx_busy              = true;
+        tx_packet.kind       = TX_KIND_PAIR_REQUEST;
+        tx_packet.tries      = 0;
+        tx_packet.num_events = 0;
+        k_work_schedule_for_queue(&workq, &radio_tx_send_work, K_NO_WAIT);
+        return;
+    }
+
+    // A click packet probes the link as well as a replay packet does
+    bool has_events = k_msgq_num_used_get(&radio_tx_msgq) > 0;
+    bool is_probe   = !is_link_up && is_probe_pending;
+    int batch_res   = -ENOENT;
+    if (!has_events && (is_link_up || is_probe) && journal_has_events()) {
+        atomic_set(&is_journal_awaited, true);
+        batch_res = journal_get_batch(&tx_packet.batch);
+        atomic_set(&is_journal_awaited, batch_res == -EBUSY);
+    }
+
+    // While the journal is busy with the flash, the replay (and the probe) waits for on_journal_ready()
+    bool is_replay = batch_res == 0 && tx_packet.batch.num_events > 0;
+    if (batch_res != -EBUSY) {
+        is_probe_pending = false;
+    }
+
+    if (!has_events && !is_replay) {
+        return;
+    }
+
+    // The events of click packets are taken from the queue when the packet is sealed; a replay keeps us awake like
+    // queued events do
+    if (is_replay) {
+        begin_tx();
+    }
+
+    tx_busy              = true;
+    tx_packet.kind       = is_replay ? TX_KIND_REPLAY : TX_KIND_CLICK;
+    tx_packet.is_probe   = is_replay && is_probe;
+    tx_packet.tries      = 0;
+    tx_packet.num_events = 0;
+    k_work_schedule_for_queue(&workq, &radio_tx_send_work, slot_delay);
+}
+
+static void tx_send_work_fn(struct k_work *work) {
+    if (tx_packet.tries == 0) {
+        PROFILING_BEGIN(PROFILING_RADIO_SEND);
+        int res = build_packet();
+        PROFILING_END(PROFILING_RADIO_SEND);
+
+        if (res) {
+            LOG_ERR("Failed to build packet: %d", res);
+            finish_tx(false);
+            return;
+        }
+    }
+
+    // Pairing does not preempt BLE activity, clicks do
+    uint32_t pipe = is_pairing() ? PAIRING_PIPE : DATA_PIPE;
+    tx_packet.tries++;
+    if (!add_packet(pipe, tx_packet.data, tx_packet.len, !is_pairing())) {
+        LOG_ERR("Failed to queue packet: error %d", nrf_gzll_get_error_code());
+        finish_tx(false);
+        return;
+    }
+
+    trace(TRACE_MOD_RADIO, TRACE_EVT_RADIO_TX_QUEUED, tx_packet.counter);
+}
+
+static void pairing_tx_done(bool ok) {
+    // Like data packets, the next try goes out on the next channel, but without backoff, since we do not expect other
+    // clickers to pair at the same time
+    if (!ok) {
+        int res = move_to_next_channel();
+        if (res) {
+            LOG_WRN("Failed to switch channels: %d", res);
+        }
+    }
+
+    if (tx_packet.kind == TX_KIND_PAIR_REQUEST) {
+        if (ok) {
+            pair_request_counter = tx_packet.counter;
+            pair_fetches         = 0;
+            tx_packet.kind       = TX_KIND_PAIR_FETCH;
+            tx_packet.tries      = 0;
+            k_work_schedule_for_queue(&workq, &radio_tx_send_work, PAIRING_FETCH_INTERVAL);
+        } else if (tx_packet.tries < MAX_TX_TRIES) {
+            k_work_schedule_for_queue(&workq, &radio_tx_send_work, K_NO_WAIT);
+        } else {
+            finish_tx(false);
+        }
+
+        return;
+    }
+
+    // Each fetch is a new packet, until the receiver has the response ready
+    if (ok && open_pairing_response(&pair_response) == 0) {
+        finish_tx(true);
+    } else if (++pair_fetches >= PAIRING_FETCH_ATTEMPTS) {
+        finish_tx(false);
+    } else {
+        tx_packet.tries = 0;
+        k_work_schedule_for_queue(&workq, &radio_tx_send_work, PAIRING_FETCH_INTERVAL);
+    }
+}
+
+static void tx_done_work_fn(struct k_work *work) {
+    bool ok = atomic_get(&tx_ok);
+    if (is_pairing()) {
+        pairing_tx_done(ok);
+        return;
+    }
+
+    uint8_t max_tries = tx_packet.kind == TX_KIND_SYNC ? MAX_SYNC_TX_TRIES
+                        : tx_packet.is_probe            ? MAX_PROBE_TX_TRIES
+                                                        : MAX_TX_TRIES;
+    if (!ok && tx_packet.tries < max_tries) {
+        // The channel may be jammed, so we also try the next one
+        int res = move_to_next_channel();
+        if (res) {
+            LOG_WRN("Failed to switch channels: %d", res);
+        }
+
+        k_work_schedule_for_queue(&workq, &radio_tx_send_work, get_backoff_delay(tx_packet.tries));
+        return;
+    }
+
+    finish_tx(ok);
+}
+
+static void command_work_fn(struct k_work *work) {
+    struct packet_header_t header;
+    uint8_t body[PACKET_MAX_BODY_LEN];
+    int len = packet_open(command_buf, command_len, &header, body);
+    atomic_set(&is_command_pending, false);
+
+    if (len < (int)sizeof(uint8_t) || memcmp(header.valid_id, packet_valid_id, sizeof(packet_valid_id)) != 0) {
+        LOG_WRN("Ignoring invalid command (%d)", len);
+        return;
+    }
+
+    // The same command may come in with several acks until our next click confirms it
+    if (header.counter <= retained.radio_last_command) {
+        return;
+    }
+
+    // A command counts as applied even if it fails, so that the receiver does not keep sending it
+    retained.radio_last_command = header.counter;
+    retained_update();
+
+    const struct packet_command_t *command = (const struct packet_command_t *)body;
+    int res                                = apply_command(command, len);
+    trace(TRACE_MOD_RADIO, TRACE_EVT_RADIO_COMMAND, command->command | ((uint32_t)(uint16_t)res << 16));
+    if (res) {
+        LOG_WRN("Command %u failed: %d", command->command, res);
+    } else {
+        LOG_INF("Command %u applied", command->command);
+    }
+}
+
+static void reload_work_fn(struct k_work *work) {
+    // The packet being sent was sealed with the old key, so it is finished with the old addresses as well
+    if (tx_busy) {
+        is_reload_pending = true;
+        return;
+    }
+
+    int res = reload_config();
+    if (res) {
+        LOG_ERR("Failed to reload the configuration: %d", res);
+    } else {
+        LOG_INF("Configuration reloaded");
+    }
+}
+
+static void pair_work_fn(struct k_work *work) {
+    // Pressing the pairing button again while pairing is running has no effect
+    if (is_pair_pending || (tx_busy && is_pairing())) {
+        end_tx();
+        return;
+    }
+
+    is_pair_pending = true;
+    tx_next_work_fn(NULL);
+}
+
+static void counter_work_fn(struct k_work *work) {
+    // Reservations are only due once half of the block has been used (see next_counter())
+    uint32_t limit = retained.radio_seq_limit;
+    if (limit - retained.radio_seq > COUNTER_BLOCK_SIZE / 2) {
+        return;
+    }
+
+    int res = reserve_counters(limit + COUNTER_BLOCK_SIZE);
+    if (res) {
+        LOG_WRN("Failed to reserve the next packet counter block: %d", res);
+    }
+}
+
+static void probe_work_fn(struct k_work *work) {
+    // If the probe is acked, the link is up and the rest of the journal follows; otherwise finish_tx() schedules the
+    // next probe
+    if (is_link_up || !journal_has_events()) {
+        return;
+    }
+
+    num_probes++;
+    is_probe_pending = true;
+    tx_next_work_fn(NULL);
+}
+
+/*********************************************************************************************************************
+ * GAZELL CALLBACKS (called from the radio interrupt; a failed try also from timeslot.c)
+ *********************************************************************************************************************/
+void nrf_gzll_device_tx_success(uint32_t pipe, nrf_gzll_device_tx_info_t tx_info) {
+    on_tx_done(pipe, true, tx_info);
+}
+
+void nrf_gzll_device_tx_failed(uint32_t pipe, nrf_gzll_device_tx_info_t tx_info) {
+    on_tx_done(pipe, false, tx_info);
+}
+
+void nrf_gzll_host_rx_data_ready(uint32_t pipe, nrf_gzll_host_rx_info_t rx_info) {
+}
+
+void nrf_gzll_disabled() {
+    k_sem_give(&disabled_sem);
+}
+
+/*********************************************************************************************************************
+ * PUBLIC FUNCTIONS
+ *********************************************************************************************************************/
+int radio_init() {
+    struct config_t config;
+    int res = config_load(&config);
+    if (res) return res;
+
+    res = init_counter();
+    if (res) {
+        LOG_ERR("Failed to initialize the packet counter: %d", res);
+        return res;
+    }
+
+    res = journal_init(retained.radio_seq, on_journal_ready);
+    if (res) return res;
+
+    res = packet_set_key(config.gazell_secret_key);
+    if (res) {
+        LOG_ERR("Failed to set the packet key: %d", res);
+        return res;
+    }
+
+    memcpy(packet_valid_id, config.gazell_packet_valid_id, sizeof(packet_valid_id));
+
+    uint8_t id[8] = {0};
+    hwinfo_get_device_id(id, sizeof(id));
+    device_id = sys_get_le32(id);
+
+    // Initialize Gazell
+    if (!gzll_glue_init()) {
+        LOG_ERR("gzll_glue_init() failed");
+        return -EIO;
+    }
+
+    is_warm_start = false;
+    for (int i = 0; i < CHANNELS_NUM; i++) {
+        is_warm_start |= retained.radio_channel_score[i] > 0;
+    }
+
+    if (!retained_is_valid()) {
+        retained.radio_ok_channel = CHANNELS_NONE;
+    }
+
+    bool is_tx_power_valid = retained.radio_tx_power_level < ARRAY_SIZE(tx_power_levels);
+    if (!IS_ENABLED(CONFIG_APP_RADIO_TX_POWER_CONTROL) || !is_tx_power_valid) {
+        retained.radio_tx_power_level = 0;
+    }
+
+    retained_update();
+
+    res = timeslot_init();
+    if (res) return res;
+
+    bool ok = nrf_gzll_init(NRF_GZLL_MODE_DEVICE);
+    ok      = ok && nrf_gzll_set_max_tx_attempts(MAX_TX_ATTEMPTS_PER_TRY);
+    ok      = ok && nrf_gzll_set_timeslots_per_channel_when_device_out_of_sync(OUT_OF_SYNC_TIMESLOTS_PER_CHANNEL);
+    ok      = ok && set_channel_table(select_slot()) == 0;
+    ok      = ok && set_addresses(&config) == 0;
+    if (!ok) {
+        LOG_ERR("Failed to initialize Gazell: error %d", nrf_gzll_get_error_code());
+        return -EIO;
+    }
+
+    apply_tx_power();
+
+    LOG_INF("Radio initialized OK (device ID %08x, next packet %u, channel %u)", device_id, retained.radio_seq,
+            channels_table[channel_offset]);
+
+    // Without a system address there is nobody to talk to, so try to pair right away; otherwise events that were
+    // not delivered in the previous wake cycles are sent even if there is no new click
+    if (!is_paired(&config)) {
+        LOG_INF("Not paired yet");
+        radio_pair();
+    } else if (journal_has_events()) {
+        k_work_schedule_for_queue(&workq, &radio_probe_work, K_NO_WAIT);
+    }
+
+    return 0;
+}
+
+void radio_pair() {
+    // Keeps us awake until pairing has finished (see finish_pairing())
+    begin_tx();
+    k_work_submit_to_queue(&workq, &radio_pair_work);
+}
+
+void radio_reload_config() {
+    k_work_submit_to_queue(&workq, &radio_reload_work);
+}
+
+int radio_send_event(const struct buttons_event_t *event) {
+    // The work queue batches the events into packets and sends them one after another
+    begin_tx();
+    if (k_msgq_put(&radio_tx_msgq, event, K_NO_WAIT) != 0) {
+        LOG_ERR("TX queue is full");
+        end_tx();
+        return -ENOMEM;
+    }
+
+    k_work_submit_to_queue(&workq, &radio_tx_next_work);
+    return 0;
+}
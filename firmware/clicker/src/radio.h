@@ -0,0 +1,58 @@
+#ifndef RADIO_H
+#define RADIO_H
+
+#include "buttons.h"
+
+/**
+ * @brief Initializes the Gazell link to the receiver.
+ *
+ * Loads the configuration (key, addresses and packet validation ID) and the packet counter and enables Gazell in
+ * device mode. If no system address is configured yet, pairing is started right away (see radio_pair()).
+ *
+ * The receiver can piggyback commands for this clicker on its acks (LED patterns, melodies, a new host ID, or going
+ * to sleep, see packet.h); they are applied in the work queue as they come in.
+ *
+ * @retval 0 If successful.
+ * @retval <0 Error code if initialization failed.
+ */
+int radio_init();
+
+/**
+ * @brief Starts pairing with a receiver over the air.
+ *
+ * Sends a pairing request on the pairing address and fetches the response (the system address and host ID of the
+ * receiver) with the ack payload of a following packet. Both are encrypted with the secret key, so only clickers and
+ * receivers of the same system can pair. On success, the pairing info is stored with config_save() and used right
+ * away. The result is signalled to the user with the LEDs and the speaker.
+ *
+ * Pairing runs in the work queue and keeps the link busy until it has finished, so it never competes with data
+ * packets for the radio; events that come in meanwhile are sent afterwards (with the new system address). Returns
+ * right away; calling it again while pairing is running has no effect.
+ */
+void radio_pair();
+
+/**
+ * @brief Applies a changed configuration (key, packet validation ID and addresses) to the link.
+ *
+ * Must be called whenever the configuration was changed outside of this module (e.g. over BLE or by provisioning).
+ * The configuration is reloaded in the work queue; a packet that is being sent is finished with the previous one.
+ */
+void radio_reload_config();
+
+/**
+ * @brief Sends a button event to the receiver.
+ *
+ * The event is queued for transmission. Packets are sent one after another, each in the slot of this clicker, and
+ * carry all events that were queued when they are sealed (up to PACKET_MAX_EVENTS); packets that are not acknowledged
+ * are retried a few times after a random backoff. The events of packets that are still not acknowledged then are kept
+ * in the journal (see journal.h) and replayed once the receiver acknowledges packets again. If the receiver asks for
+ * time sync, each acknowledged packet is followed by a sync packet with the exact press times (see packet.h).
+ *
+ * @param event The button event to send.
+ *
+ * @retval 0 If the event was queued.
+ * @retval -ENOMEM If the TX queue is full.
+ */
+int radio_send_event(const struct buttons_event_t *event);
+
+#endif  // RADIO_H
@@ -0,0 +1,57 @@
+#include "retained.h"
+
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/crc.h>
+
+#if defined(CONFIG_SOC_FAMILY_NORDIC_NRF)
+#include <helpers/nrfx_ram_ctrl.h>
+#endif
+
+// Retained state; placed in a section that is not cleared on startup
+__noinit struct retained_t retained;
+
+// Global state
+static bool is_valid = false;
+
+static struct k_spinlock lock;
+
+/*********************************************************************************************************************
+ * PRIVATE FUNCTIONS
+ *********************************************************************************************************************/
+static uint32_t calc_crc() {
+    return crc32_ieee((const uint8_t *)&retained, offsetof(struct retained_t, crc));
+}
+
+/*********************************************************************************************************************
+ * STARTUP HOOKS
+ *********************************************************************************************************************/
+static int validate_retained_state() {
+    is_valid = (retained.crc == calc_crc());
+    if (!is_valid) {
+        memset(&retained, 0, sizeof(retained));
+        retained_update();
+    }
+
+#if defined(CONFIG_SOC_FAMILY_NORDIC_NRF)
+    // Keep the RAM section containing the retained state powered in System OFF
+    nrfx_ram_ctrl_retention_enable_set(&retained, sizeof(retained), true);
+#endif
+
+    return 0;
+}
+
+SYS_INIT(validate_retained_state, PRE_KERNEL_1, 0);
+
+/*********************************************************************************************************************
+ * PUBLIC FUNCTIONS
+ *********************************************************************************************************************/
+bool retained_is_valid() {
+    return is_valid;
+}
+
+void retained_update() {
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    retained.crc         = calc_crc();
+    k_spin_unlock(&lock, key);
+}
@@ -0,0 +1,64 @@
+#ifndef RETAINED_H
+#define RETAINED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "channels.h"
+#include "config.h"
+#include "journal.h"
+
+// State that is kept in RAM across System OFF and soft resets
+struct retained_t {
+    // Radio state
+    uint32_t radio_seq;                         // Sequence number (packet counter) of the next packet to transmit
+    uint32_t radio_seq_limit;                   // Sequence numbers up to this one are reserved in NVS (see radio.c)
+    uint32_t radio_last_command;                // Counter of the last command applied (see radio.c)
+    uint8_t radio_channel_score[CHANNELS_NUM];  // Success score of each channel, 0 if unknown (see radio.c)
+    uint8_t radio_ok_channel;                   // Channel index the last packet was acked on, or CHANNELS_NONE
+    uint8_t radio_failed_channels;              // Bitmask of the channel indices tries failed on since the last click
+    uint8_t radio_num_retries;                  // Retransmissions of all packets since the last click (saturating)
+    uint8_t radio_num_slots;                    // Number of transmission slots hinted by the receiver, 0 if unknown
+    uint8_t radio_tx_power_level;               // TX power level (see radio.c), 0 for full power
+    uint8_t radio_tx_power_healthy;             // Number of healthy packets in a row at the current TX power level
+    bool radio_time_sync;                       // The receiver asks for sync packets (see radio.c)
+
+    // Journal state (see journal.c)
+    uint32_t journal_next_id;    // Journal ID of the next event
+    uint32_t journal_wake_id;    // Journal ID of the first event of the current wake cycle
+    uint32_t journal_replay_id;  // Journal ID of the oldest event that has not been delivered
+    bool journal_in_flash;       // The journal partition may hold events that have not been delivered
+    uint8_t journal_num_staged;  // Number of records in the staging buffer
+    struct journal_record_t journal_staged[JOURNAL_STAGING_SIZE];
+
+    // Last average ADC reading of the battery module, 0 if unknown
+    int16_t battery_avg_adc;
+
+    // Copy of the configuration in NVS (includes the pairing info), only valid if config_valid is true
+    bool config_valid;
+    struct config_t config;
+
+    // Checksum over the fields above; must be the last member
+    uint32_t crc;
+};
+
+extern struct retained_t retained;
+
+/**
+ * @brief Checks whether the retained state survived the last reset.
+ *
+ * The retained state is validated (and reset if invalid) during startup, so this only reports the result.
+ *
+ * @retval true If the retained state was restored from the previous wake cycle.
+ * @retval false If the retained state was reset (e.g. after a power-on reset).
+ */
+bool retained_is_valid();
+
+/**
+ * @brief Updates the checksum of the retained state.
+ *
+ * Must be called after modifying the retained state, otherwise the changes are lost on the next reset.
+ */
+void retained_update();
+
+#endif  // RETAINED_H
@@ -1,50 +1,51 @@
 #include "battery_svc.h"
 #include "../battery.h"
+#include "../workq.h"
 
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 
 LOG_MODULE_REGISTER(app_battery_svc);
 
-// Thread configuration
-#define THREAD_STACK_SIZE 1024
-#define THREAD_PRIORITY   10
-#define UPDATE_INTERVAL   K_SECONDS(30)
-
-// Semaphores
-K_SEM_DEFINE(battery_svc_thread_enable, 1, 1);
+// Timing configuration
+#define UPDATE_INTERVAL K_SECONDS(30)
+#define RETRY_INTERVAL  K_SECONDS(1)  // If the battery module has no reading yet
 
 /*********************************************************************************************************************
- * THREADS
+ * WORK HANDLERS
  *********************************************************************************************************************/
-static void bas_thread_fn() {
-    // Wait for the signal to start the thread
-    k_sem_take(&battery_svc_thread_enable, K_FOREVER);
-    LOG_INF("Battery service thread initialized OK");
+static void bas_work_fn(struct k_work *work) {
+    // Measure the state of charge and update the battery service; the battery module samples on the same work queue,
+    // so we must not wait for its first reading here
+    int mv = battery_get_voltage_mv();
+    if (mv == -EAGAIN) {
+        k_work_schedule_for_queue(&workq, k_work_delayable_from_work(work), RETRY_INTERVAL);
+        return;
+    } else if (mv < 0) {
+        LOG_ERR("battery_get_voltage_mv() returned %d", mv);
+        k_work_schedule_for_queue(&workq, k_work_delayable_from_work(work), UPDATE_INTERVAL);
+        return;
+    }
 
-    // Main loop, measuring the state of charge and updating the battery service
-    while (true) {
-        int mv  = battery_get_voltage_mv();
-        int soc = battery_get_soc_percent(mv);
+    int soc = battery_get_soc_percent(mv);
 
-        int res = bt_bas_set_battery_level((uint8_t)soc);
-        if (res) {
-            LOG_ERR("bt_bas_set_battery_level() returned %d", res);
-        }
+    int res = bt_bas_set_battery_level((uint8_t)soc);
+    if (res) {
+        LOG_ERR("bt_bas_set_battery_level() returned %d", res);
+    }
 
-        LOG_INF("Battery voltage: %d mV, SOC: %d%%", mv, soc);
+    LOG_INF("Battery voltage: %d mV, SOC: %d%%", mv, soc);
 
-        k_sleep(UPDATE_INTERVAL);
-    }
+    k_work_schedule_for_queue(&workq, k_work_delayable_from_work(work), UPDATE_INTERVAL);
 }
 
-K_THREAD_DEFINE(battery_svc_thread_id, THREAD_STACK_SIZE, bas_thread_fn, NULL, NULL, NULL, THREAD_PRIORITY, 0, 0);
+K_WORK_DELAYABLE_DEFINE(battery_svc_work, bas_work_fn);
 
 /*********************************************************************************************************************
  * PUBLIC FUNCTIONS
  *********************************************************************************************************************/
 
 void battery_svc_init() {
-    // Start the battery service thread
-    k_sem_give(&battery_svc_thread_enable);
+    // Start the periodic battery service updates
+    k_work_schedule_for_queue(&workq, &battery_svc_work, K_NO_WAIT);
 }
@@ -0,0 +1,373 @@
+#include "bulk_svc.h"
+#include "../config.h"
+#include "../stats.h"
+#include "../trace.h"
+
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/drivers/flash.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/storage/flash_map.h>
+#include <zephyr/sys/byteorder.h>
+
+LOG_MODULE_REGISTER(app_bulk_svc);
+
+// UUIDs
+#define BT_UUID_BULK_SVC_CONTROL_VAL \
+    BT_UUID_128_ENCODE(0x456bdbf1, 0x0ad5, 0x401a, 0x898f, 0xd0505330d97a)  // Start/stop commands and status
+
+#define BT_UUID_BULK_SVC_DATA_VAL \
+    BT_UUID_128_ENCODE(0x456bdbf2, 0x0ad5, 0x401a, 0x898f, 0xd0505330d97a)  // Notifications with the blob data
+
+#define BT_UUID_BULK_SVC         BT_UUID_DECLARE_128(BT_UUID_BULK_SVC_VAL)
+#define BT_UUID_BULK_SVC_CONTROL BT_UUID_DECLARE_128(BT_UUID_BULK_SVC_CONTROL_VAL)
+#define BT_UUID_BULK_SVC_DATA    BT_UUID_DECLARE_128(BT_UUID_BULK_SVC_DATA_VAL)
+
+// Control commands (first byte written to the control characteristic)
+#define CMD_START 0x01  // Followed by the source (uint8) and the offset to start from (uint32)
+#define CMD_STOP  0x02  // No parameters
+
+// Transfer configuration; the number of notifications in flight must not exceed CONFIG_BT_BUF_ACL_TX_COUNT
+#define MAX_IN_FLIGHT  4
+#define RETRY_DELAY    K_MSEC(10)  // When other notifications have taken all buffers
+#define MAX_CHUNK_SIZE (CONFIG_BT_L2CAP_TX_MTU - 3 - sizeof(uint32_t))  // Minus ATT header and offset field
+#define NVS_PARTITION  storage_partition
+
+// A blob that can be downloaded
+struct source_t {
+    uint32_t (*begin)();  // Prepares the blob for a transfer and returns its size
+    int (*read)(uint32_t offset, uint8_t *buf, uint32_t len);
+    bool needs_encryption;  // Only sent over an encrypted link (the central pairs when the start command is rejected)
+};
+
+// Status of the transfer as returned by reading the control characteristic (little-endian, 10 bytes)
+struct status_t {
+    uint8_t source;   // enum bulk_svc_source_t
+    uint8_t active;   // 1 while data is being sent
+    uint32_t size;    // Size of the blob in bytes
+    uint32_t offset;  // Offset of the next chunk to send
+} __packed;
+
+// Service declaration (see below)
+extern const struct bt_gatt_service_static bulk_svc;
+
+#define DATA_ATTR (&bulk_svc.attrs[4])
+
+// Global state; the transfer state is accessed from the BT RX thread and the system work queue
+static struct bt_conn *transfer_conn;  // Connection the transfer is running on; NULL if there is none
+static struct status_t status;
+static atomic_t in_flight;  // Number of notifications that have not been sent yet
+static int64_t start_ms;    // Uptime when the transfer was (re)started, for the throughput in the log
+
+K_MUTEX_DEFINE(transfer_lock);
+
+// Sending runs on the system work queue rather than on the application's one: the BT host never waits for buffers
+// there (allocations from it fail with -ENOMEM instead), so the LEDs, speaker and radio are never held up by a transfer
+static void send_work_fn(struct k_work *work);
+K_WORK_DELAYABLE_DEFINE(bulk_send_work, send_work_fn);
+
+/*********************************************************************************************************************
+ * SOURCES
+ *********************************************************************************************************************/
+#if defined(CONFIG_APP_BT_DEBUG_ACCESS)
+// The raw storage partition also holds copies of older Gazell keys, so it is only served by development builds
+#define KEY_SIZE sizeof(((struct config_t *)0)->gazell_secret_key)
+
+static uint8_t storage_key[KEY_SIZE];  // Current Gazell key, blanked out of the blob; all zero if there is none
+
+static uint32_t storage_begin() {
+    struct config_t config;
+    config_load(&config);
+    memcpy(storage_key, config.gazell_secret_key, KEY_SIZE);
+
+    return FIXED_PARTITION_SIZE(NVS_PARTITION);
+}
+
+static int storage_read(uint32_t offset, uint8_t *buf, uint32_t len) {
+    // The chunk is read with KEY_SIZE - 1 bytes of margin on each side, so that copies of the key that cross the chunk
+    // boundaries are found as well; older copies of a key that has since been replaced are not blanked out
+    static uint8_t window[MAX_CHUNK_SIZE + 2 * (KEY_SIZE - 1)];
+
+    uint32_t start = offset > KEY_SIZE - 1 ? offset - (KEY_SIZE - 1) : 0;
+    uint32_t end   = MIN(offset + len + KEY_SIZE - 1, FIXED_PARTITION_SIZE(NVS_PARTITION));
+
+    int res = flash_read(FIXED_PARTITION_DEVICE(NVS_PARTITION), FIXED_PARTITION_OFFSET(NVS_PARTITION) + start, window,
+                         end - start);
+    if (res) return res;
+
+    memcpy(buf, window + (offset - start), len);
+
+    static const uint8_t no_key[KEY_SIZE];
+    if (!memcmp(storage_key, no_key, KEY_SIZE)) {
+        return 0;
+    }
+
+    for (uint32_t i = start; i + KEY_SIZE <= end; i++) {
+        if (memcmp(window + (i - start), storage_key, KEY_SIZE)) {
+            continue;
+        }
+
+        uint32_t from = MAX(i, offset);
+        uint32_t to   = MIN(i + KEY_SIZE, offset + len);
+        if (from < to) {
+            memset(buf + (from - offset), 0, to - from);
+        }
+    }
+
+    return 0;
+}
+#endif  // CONFIG_APP_BT_DEBUG_ACCESS
+
+#if defined(CONFIG_APP_STATS)
+static struct stats_snapshot_t stats_snapshot;
+
+static uint32_t stats_begin() {
+    stats_get_snapshot(&stats_snapshot);
+    return sizeof(stats_snapshot);
+}
+
+static int stats_read(uint32_t offset, uint8_t *buf, uint32_t len) {
+    memcpy(buf, (const uint8_t *)&stats_snapshot + offset, len);
+    return 0;
+}
+#endif  // CONFIG_APP_STATS
+
+#if defined(CONFIG_APP_TRACE)
+// The trace blob is the ring header followed by all records from the oldest to the newest one, i.e. the format that
+// scripts/trace_decode.py reads; records are copied at the time they are sent, so the ring keeps recording
+static struct trace_info_t trace_info;
+static uint32_t trace_first_seq;
+
+static uint32_t trace_begin() {
+    trace_get_info(&trace_info);
+    trace_first_seq = trace_info.head > trace_info.capacity ? trace_info.head - trace_info.capacity : 0;
+    return sizeof(trace_info) + (trace_info.head - trace_first_seq) * sizeof(struct trace_record_t);
+}
+
+static int trace_read_blob(uint32_t offset, uint8_t *buf, uint32_t len) {
+    while (len > 0) {
+        uint32_t n;
+
+        if (offset < sizeof(trace_info)) {
+            n = MIN(len, sizeof(trace_info) - offset);
+            memcpy(buf, (const uint8_t *)&trace_info + offset, n);
+        } else {
+            // Records that have been overwritten since the transfer started are replaced by newer ones
+            uint32_t rec_offset = offset - sizeof(trace_info);
+            uint32_t seq        = trace_first_seq + rec_offset / sizeof(struct trace_record_t);
+            uint32_t first_seq;
+            struct trace_record_t record = {0};
+            trace_read(seq, &record, 1, &first_seq);
+
+            n = MIN(len, sizeof(record) - rec_offset % sizeof(record));
+            memcpy(buf, (const uint8_t *)&record + rec_offset % sizeof(record), n);
+        }
+
+        offset += n;
+        buf += n;
+        len -= n;
+    }
+
+    return 0;
+}
+#endif  // CONFIG_APP_TRACE
+
+static const struct source_t sources[] = {
+#if defined(CONFIG_APP_BT_DEBUG_ACCESS)
+    [BULK_SVC_SRC_STORAGE] = {storage_begin, storage_read, true},
+#endif
+#if defined(CONFIG_APP_STATS)
+    [BULK_SVC_SRC_STATS] = {stats_begin, stats_read, false},
+#endif
+#if defined(CONFIG_APP_TRACE)
+    [BULK_SVC_SRC_TRACE] = {trace_begin, trace_read_blob, false},
+#endif
+};
+
+/*********************************************************************************************************************
+ * PRIVATE FUNCTIONS
+ *********************************************************************************************************************/
+static void stop_transfer() {
+    status.active = 0;
+
+    if (transfer_conn) {
+        bt_conn_unref(transfer_conn);
+        transfer_conn = NULL;
+    }
+}
+
+static void on_notification_sent(struct bt_conn *conn, void *user_data) {
+    // Free the slot and continue sending
+    atomic_dec(&in_flight);
+    k_work_reschedule(&bulk_send_work, K_NO_WAIT);
+}
+
+/*********************************************************************************************************************
+ * WORK HANDLERS
+ *********************************************************************************************************************/
+static void send_work_fn(struct k_work *work) {
+    static uint8_t buf[sizeof(uint32_t) + MAX_CHUNK_SIZE];
+
+    k_mutex_lock(&transfer_lock, K_FOREVER);
+
+    // Send as many chunks as there are free slots; the work is resubmitted whenever a notification has been sent
+    while (status.active && atomic_get(&in_flight) < MAX_IN_FLIGHT) {
+        uint32_t chunk_size = MIN(bt_gatt_get_mtu(transfer_conn) - 3 - sizeof(uint32_t), MAX_CHUNK_SIZE);
+        chunk_size          = MIN(chunk_size, status.size - status.offset);
+
+        // Each notification starts with the offset of the data; an empty chunk at the end marks the end of the blob
+        sys_put_le32(status.offset, buf);
+        int res = sources[status.source].read(status.offset, buf + sizeof(uint32_t), chunk_size);
+        if (res) {
+            LOG_ERR("Failed to read source %d at offset %u: %d", status.source, status.offset, res);
+            stop_transfer();
+            break;
+        }
+
+        struct bt_gatt_notify_params params = {
+            .attr = DATA_ATTR,
+            .data = buf,
+            .len  = sizeof(uint32_t) + chunk_size,
+            .func = on_notification_sent,
+        };
+
+        atomic_inc(&in_flight);
+        res = bt_gatt_notify_cb(transfer_conn, &params);
+        if (res == -ENOMEM) {
+            // Out of buffers; try again once a pending notification has been sent, or after a while if none of ours is
+            atomic_dec(&in_flight);
+            if (atomic_get(&in_flight) == 0) {
+                k_work_schedule(&bulk_send_work, RETRY_DELAY);
+            }
+
+            break;
+        } else if (res) {
+            atomic_dec(&in_flight);
+            LOG_ERR("bt_gatt_notify_cb() returned %d", res);
+            stop_transfer();
+            break;
+        }
+
+        if (chunk_size == 0) {
+            int64_t elapsed_ms = MAX(k_uptime_get() - start_ms, 1);
+            LOG_INF("Transfer of source %d finished (%u bytes, %lld ms, %lld B/s)", status.source, status.size,
+                    elapsed_ms, status.size * 1000LL / elapsed_ms);
+            stop_transfer();
+            break;
+        }
+
+        status.offset += chunk_size;
+    }
+
+    k_mutex_unlock(&transfer_lock);
+}
+
+/*********************************************************************************************************************
+ * SERVICE CALLBACKS
+ *********************************************************************************************************************/
+static ssize_t read_control_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, void *buf, uint16_t len,
+                               uint16_t offset) {
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, &status, sizeof(status));
+}
+
+static ssize_t write_control_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, const void *buf, uint16_t len,
+                                uint16_t offset, uint8_t flags) {
+    const uint8_t *data = buf;
+
+    if (offset != 0) {
+        LOG_ERR("Invalid offset for write: %d != 0", offset);
+        return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+    }
+
+    if (len == 1 && data[0] == CMD_STOP) {
+        k_mutex_lock(&transfer_lock, K_FOREVER);
+        stop_transfer();
+        k_mutex_unlock(&transfer_lock);
+        return len;
+    }
+
+    if (len != 6 || data[0] != CMD_START) {
+        LOG_ERR("Invalid command (length %d)", len);
+        return BT_GATT_ERR(BT_ATT_ERR_VALUE_NOT_ALLOWED);
+    }
+
+    uint8_t source        = data[1];
+    uint32_t start_offset = sys_get_le32(&data[2]);
+    if (source >= ARRAY_SIZE(sources) || !sources[source].begin) {
+        LOG_ERR("Invalid source: %d", source);
+        return BT_GATT_ERR(BT_ATT_ERR_VALUE_NOT_ALLOWED);
+    }
+
+    if (sources[source].needs_encryption && bt_conn_get_security(conn) < BT_SECURITY_L2) {
+        LOG_WRN("Source %d requested over an unencrypted link", source);
+        return BT_GATT_ERR(BT_ATT_ERR_INSUFFICIENT_ENCRYPTION);
+    }
+
+    if (!bt_gatt_is_subscribed(conn, DATA_ATTR, BT_GATT_CCC_NOTIFY)) {
+        LOG_ERR("Transfer started without subscribing to notifications");
+        return BT_GATT_ERR(BT_ATT_ERR_CCC_IMPROPER_CONF);
+    }
+
+    // (Re)start the transfer; a transfer can be resumed by starting at the offset of the last received chunk
+    k_mutex_lock(&transfer_lock, K_FOREVER);
+    stop_transfer();
+    status.source = source;
+    status.size   = sources[source].begin();
+    status.offset = MIN(start_offset, status.size);
+    status.active = 1;
+    transfer_conn = bt_conn_ref(conn);
+    start_ms      = k_uptime_get();
+    k_mutex_unlock(&transfer_lock);
+
+    LOG_INF("Starting transfer of source %d at offset %u (%u bytes)", source, status.offset, status.size);
+    k_work_reschedule(&bulk_send_work, K_NO_WAIT);
+
+    return len;
+}
+
+static void data_ccc_changed_cb(const struct bt_gatt_attr *attr, uint16_t value) {
+    LOG_INF("Notifications %s", value == BT_GATT_CCC_NOTIFY ? "enabled" : "disabled");
+}
+
+/*********************************************************************************************************************
+ * SERVICE DECLARATION
+ *********************************************************************************************************************/
+BT_GATT_SERVICE_DEFINE(                         // Service declaration
+    bulk_svc,                                   // Service name
+    BT_GATT_PRIMARY_SERVICE(BT_UUID_BULK_SVC),  // Service UUID
+
+    // Control characteristic
+    BT_GATT_CHARACTERISTIC(BT_UUID_BULK_SVC_CONTROL,                // UUID
+                           BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,  // Attribute properties
+                           BT_GATT_PERM_READ | BT_GATT_PERM_WRITE,  // Attribute access permissions
+                           read_control_cb,                         // Attribute read callback
+                           write_control_cb,                        // Attribute write callback
+                           NULL),                                   // Attribute user data
+
+    // Data characteristic (the value attribute is DATA_ATTR)
+    BT_GATT_CHARACTERISTIC(BT_UUID_BULK_SVC_DATA,  // UUID
+                           BT_GATT_CHRC_NOTIFY,    // Attribute properties
+                           BT_GATT_PERM_NONE,      // Attribute access permissions
+                           NULL,                   // Attribute read callback
+                           NULL,                   // Attribute write callback
+                           NULL),                  // Attribute user data
+    BT_GATT_CCC(data_ccc_changed_cb, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+);
+
+/*********************************************************************************************************************
+ * CONNECTION CALLBACKS
+ *********************************************************************************************************************/
+static void on_disconnected(struct bt_conn *conn, uint8_t reason) {
+    k_mutex_lock(&transfer_lock, K_FOREVER);
+
+    if (conn == transfer_conn) {
+        LOG_INF("Transfer aborted at offset %u by disconnect", status.offset);
+        stop_transfer();
+    }
+
+    k_mutex_unlock(&transfer_lock);
+}
+
+BT_CONN_CB_DEFINE(bulk_svc_conn_callbacks) = {
+    .disconnected = on_disconnected,
+};
@@ -0,0 +1,19 @@
+#ifndef BULK_SVC_H
+#define BULK_SVC_H
+
+#include <zephyr/bluetooth/uuid.h>
+
+// UUIDs
+#define BT_UUID_BULK_SVC_VAL BT_UUID_128_ENCODE(0x456bdbf0, 0x0ad5, 0x401a, 0x898f, 0xd0505330d97a)
+
+// Blobs that can be downloaded; the numeric values are part of the protocol and must not change
+enum bulk_svc_source_t {
+    BULK_SVC_SRC_STORAGE = 0,  // NVS storage partition without the current Gazell key (only with
+                               // CONFIG_APP_BT_DEBUG_ACCESS, over an encrypted link)
+    BULK_SVC_SRC_STATS   = 1,  // struct stats_snapshot_t (only with CONFIG_APP_STATS)
+    BULK_SVC_SRC_TRACE   = 2,  // Trace ring header and records (only with CONFIG_APP_TRACE)
+};
+
+// The service is registered statically; it needs no initialization
+
+#endif  // BULK_SVC_H
@@ -1,5 +1,6 @@
 #include "config_svc.h"
 #include "../config.h"
+#include "../radio.h"
 
 #include <zephyr/bluetooth/gatt.h>
 #include <zephyr/logging/log.h>
@@ -40,9 +41,8 @@ static ssize_t read_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, vo
     const uint8_t *data = attr->user_data;
     uint16_t data_len   = 0;
 
-    if (data == config.gazell_secret_key)
-        data_len = sizeof(config.gazell_secret_key);
-    else if (data == config.gazell_pairing_addr)
+    // The secret key is write-only
+    if (data == config.gazell_pairing_addr)
         data_len = sizeof(config.gazell_pairing_addr);
     else if (data == config.gazell_packet_valid_id)
         data_len = sizeof(config.gazell_packet_valid_id);
@@ -70,6 +70,13 @@ static ssize_t write_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, c
     else if (data == config.gazell_host_id)
         data_len = sizeof(config.gazell_host_id);
 
+    // Just Works pairing gives anyone in range an encrypted link, so release builds only take the key through the
+    // provisioning service
+    if (data == config.gazell_secret_key && !IS_ENABLED(CONFIG_APP_BT_DEBUG_ACCESS)) {
+        LOG_ERR("Writing the key requires CONFIG_APP_BT_DEBUG_ACCESS");
+        return BT_GATT_ERR(BT_ATT_ERR_WRITE_NOT_PERMITTED);
+    }
+
     if (len != data_len) {
         LOG_ERR("Invalid length for write: %d != %d", len, data_len);
         return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
@@ -83,6 +90,11 @@ static ssize_t write_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, c
     memcpy(data, buf, len);
     config_save(&config);
 
+    // The link uses the new key and addresses right away
+    if (IS_ENABLED(CONFIG_GAZELL)) {
+        radio_reload_config();
+    }
+
     return len;
 }
 
@@ -93,45 +105,45 @@ BT_GATT_SERVICE_DEFINE(                           // Service declaration
     config_svc,                                   // Service name
     BT_GATT_PRIMARY_SERVICE(BT_UUID_CONFIG_SVC),  // Service UUID
 
-    // Secret key characteristic
-    BT_GATT_CHARACTERISTIC(BT_UUID_CONFIG_SVC_GAZELL_SECRET_KEY,    // UUID
-                           BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,  // Attribute properties
-                           BT_GATT_PERM_READ | BT_GATT_PERM_WRITE,  // Attribute access permissions
-                           read_cb,                                 // Attribute read callback
-                           write_cb,                                // Attribute write callback
-                           config.gazell_secret_key),               // Attribute user data
+    // Secret key characteristic (write-only, only over an encrypted link and only with CONFIG_APP_BT_DEBUG_ACCESS)
+    BT_GATT_CHARACTERISTIC(BT_UUID_CONFIG_SVC_GAZELL_SECRET_KEY,  // UUID
+                           BT_GATT_CHRC_WRITE,                    // Attribute properties
+                           BT_GATT_PERM_WRITE_ENCRYPT,            // Attribute access permissions
+                           NULL,                                  // Attribute read callback
+                           write_cb,                              // Attribute write callback
+                           config.gazell_secret_key),             // Attribute user data
 
     // Pairing address characteristic
-    BT_GATT_CHARACTERISTIC(BT_UUID_CONFIG_SVC_GAZELL_PAIRING_ADDR,  // UUID
-                           BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,  // Attribute properties
-                           BT_GATT_PERM_READ | BT_GATT_PERM_WRITE,  // Attribute access permissions
-                           read_cb,                                 // Attribute read callback
-                           write_cb,                                // Attribute write callback
-                           config.gazell_pairing_addr),             // Attribute user data
+    BT_GATT_CHARACTERISTIC(BT_UUID_CONFIG_SVC_GAZELL_PAIRING_ADDR,          // UUID
+                           BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,          // Attribute properties
+                           BT_GATT_PERM_READ | BT_GATT_PERM_WRITE_ENCRYPT,  // Attribute access permissions
+                           read_cb,                                         // Attribute read callback
+                           write_cb,                                        // Attribute write callback
+                           config.gazell_pairing_addr),                     // Attribute user data
 
     // Packet validation ID characteristic
-    BT_GATT_CHARACTERISTIC(BT_UUID_CONFIG_SVC_GAZELL_PACKET_VALID_ID,  // UUID
-                           BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,     // Attribute properties
-                           BT_GATT_PERM_READ | BT_GATT_PERM_WRITE,     // Attribute access permissions
-                           read_cb,                                    // Attribute read callback
-                           write_cb,                                   // Attribute write callback
-                           config.gazell_packet_valid_id),             // Attribute user data
+    BT_GATT_CHARACTERISTIC(BT_UUID_CONFIG_SVC_GAZELL_PACKET_VALID_ID,       // UUID
+                           BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,          // Attribute properties
+                           BT_GATT_PERM_READ | BT_GATT_PERM_WRITE_ENCRYPT,  // Attribute access permissions
+                           read_cb,                                         // Attribute read callback
+                           write_cb,                                        // Attribute write callback
+                           config.gazell_packet_valid_id),                  // Attribute user data
 
     // System address characteristic
-    BT_GATT_CHARACTERISTIC(BT_UUID_CONFIG_SVC_GAZELL_SYSTEM_ADDR,   // UUID
-                           BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,  // Attribute properties
-                           BT_GATT_PERM_READ | BT_GATT_PERM_WRITE,  // Attribute access permissions
-                           read_cb,                                 // Attribute read callback
-                           write_cb,                                // Attribute write callback
-                           config.gazell_system_addr),              // Attribute user data
+    BT_GATT_CHARACTERISTIC(BT_UUID_CONFIG_SVC_GAZELL_SYSTEM_ADDR,           // UUID
+                           BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,          // Attribute properties
+                           BT_GATT_PERM_READ | BT_GATT_PERM_WRITE_ENCRYPT,  // Attribute access permissions
+                           read_cb,                                         // Attribute read callback
+                           write_cb,                                        // Attribute write callback
+                           config.gazell_system_addr),                      // Attribute user data
 
     // Host ID characteristic
-    BT_GATT_CHARACTERISTIC(BT_UUID_CONFIG_SVC_GAZELL_HOST_ID,       // UUID
-                           BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,  // Attribute properties
-                           BT_GATT_PERM_READ | BT_GATT_PERM_WRITE,  // Attribute access permissions
-                           read_cb,                                 // Attribute read callback
-                           write_cb,                                // Attribute write callback
-                           config.gazell_host_id),                  // Attribute user data
+    BT_GATT_CHARACTERISTIC(BT_UUID_CONFIG_SVC_GAZELL_HOST_ID,               // UUID
+                           BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,          // Attribute properties
+                           BT_GATT_PERM_READ | BT_GATT_PERM_WRITE_ENCRYPT,  // Attribute access permissions
+                           read_cb,                                         // Attribute read callback
+                           write_cb,                                        // Attribute write callback
+                           config.gazell_host_id),                          // Attribute user data
 );
 
 /*********************************************************************************************************************
@@ -141,3 +153,7 @@ BT_GATT_SERVICE_DEFINE(                           // Service declaration
 void config_svc_init() {
     config_load(&config);
 }
+
+void config_svc_reload() {
+    config_load(&config);
+}
@@ -14,4 +14,9 @@
  */
 void config_svc_init();
 
+/**
+ * @brief Reloads the configuration after it has been changed outside of the config service (e.g. by provisioning).
+ */
+void config_svc_reload();
+
 #endif  // CONFIG_SVC_H
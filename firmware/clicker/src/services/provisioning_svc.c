@@ -0,0 +1,76 @@
+#include "provisioning_svc.h"
+#include "../provisioning.h"
+#include "../radio.h"
+#include "config_svc.h"
+
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(app_provisioning_svc);
+
+// UUIDs
+#define BT_UUID_PROVISIONING_SVC_CONFIG_VAL \
+    BT_UUID_128_ENCODE(0x456bdbf9, 0x0ad5, 0x401a, 0x898f, 0xd0505330d97a)  // Provisioning message/status
+
+#define BT_UUID_PROVISIONING_SVC        BT_UUID_DECLARE_128(BT_UUID_PROVISIONING_SVC_VAL)
+#define BT_UUID_PROVISIONING_SVC_CONFIG BT_UUID_DECLARE_128(BT_UUID_PROVISIONING_SVC_CONFIG_VAL)
+
+/*********************************************************************************************************************
+ * SERVICE CALLBACKS
+ *********************************************************************************************************************/
+static ssize_t read_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, void *buf, uint16_t len,
+                       uint16_t offset) {
+    struct provisioning_status_t status;
+    provisioning_get_status(&status);
+
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, &status, sizeof(status));
+}
+
+static ssize_t write_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, const void *buf, uint16_t len,
+                        uint16_t offset, uint8_t flags) {
+    // The message must arrive in a single write (i.e. the provisioning station has to exchange the MTU first)
+    if (offset != 0) {
+        LOG_ERR("Invalid offset for write: %d != 0", offset);
+        return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+    }
+
+    struct config_t config;
+    int res = provisioning_apply(buf, len, &config);
+    config_svc_reload();
+
+    // The write response tells the provisioning station whether the device was provisioned, which saves a read
+    switch (res) {
+        case 0:
+            if (IS_ENABLED(CONFIG_GAZELL)) {
+                radio_reload_config();
+            }
+
+            return len;
+
+        case -EINVAL:
+            return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+
+        case -EACCES:
+            return BT_GATT_ERR(BT_ATT_ERR_AUTHENTICATION);
+
+        default:
+            return BT_GATT_ERR(BT_ATT_ERR_UNLIKELY);
+    }
+}
+
+/*********************************************************************************************************************
+ * SERVICE DECLARATION
+ *********************************************************************************************************************/
+BT_GATT_SERVICE_DEFINE(                                 // Service declaration
+    provisioning_svc,                                   // Service name
+    BT_GATT_PRIMARY_SERVICE(BT_UUID_PROVISIONING_SVC),  // Service UUID
+
+    // Config characteristic; write a struct provisioning_msg_t, read a struct provisioning_status_t (both only over an
+    // encrypted link, since the message carries the Gazell key)
+    BT_GATT_CHARACTERISTIC(BT_UUID_PROVISIONING_SVC_CONFIG,                         // UUID
+                           BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,                  // Attribute properties
+                           BT_GATT_PERM_READ_ENCRYPT | BT_GATT_PERM_WRITE_ENCRYPT,  // Attribute access permissions
+                           read_cb,                                                 // Attribute read callback
+                           write_cb,                                                // Attribute write callback
+                           NULL),                                                   // Attribute user data
+);
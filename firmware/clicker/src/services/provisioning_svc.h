@@ -0,0 +1,11 @@
+#ifndef PROVISIONING_SVC_H
+#define PROVISIONING_SVC_H
+
+#include <zephyr/bluetooth/uuid.h>
+
+// UUIDs
+#define BT_UUID_PROVISIONING_SVC_VAL BT_UUID_128_ENCODE(0x456bdbf8, 0x0ad5, 0x401a, 0x898f, 0xd0505330d97a)
+
+// The service is registered statically; it needs no initialization
+
+#endif  // PROVISIONING_SVC_H
@@ -0,0 +1,55 @@
+#include "stats_svc.h"
+#include "../stats.h"
+
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(app_stats_svc);
+
+// UUIDs
+#define BT_UUID_STATS_SVC_SNAPSHOT_VAL \
+    BT_UUID_128_ENCODE(0x456bdbe9, 0x0ad5, 0x401a, 0x898f, 0xd0505330d97a)  // struct stats_snapshot_t (288 bytes)
+
+#define BT_UUID_STATS_SVC          BT_UUID_DECLARE_128(BT_UUID_STATS_SVC_VAL)
+#define BT_UUID_STATS_SVC_SNAPSHOT BT_UUID_DECLARE_128(BT_UUID_STATS_SVC_SNAPSHOT_VAL)
+
+// Global state; the snapshot is taken when the characteristic is read at offset 0, so that long reads (which may span
+// several ATT requests) return consistent values
+static struct stats_snapshot_t snapshot;
+
+/*********************************************************************************************************************
+ * SERVICE CALLBACKS
+ *********************************************************************************************************************/
+static ssize_t read_snapshot_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, void *buf, uint16_t len,
+                                uint16_t offset) {
+    if (offset == 0) {
+        stats_get_snapshot(&snapshot);
+    }
+
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, &snapshot, sizeof(snapshot));
+}
+
+static ssize_t write_snapshot_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, const void *buf,
+                                 uint16_t len, uint16_t offset, uint8_t flags) {
+    // Writing anything resets the counters and queue maxima
+    stats_reset();
+    LOG_INF("Statistics reset");
+
+    return len;
+}
+
+/*********************************************************************************************************************
+ * SERVICE DECLARATION
+ *********************************************************************************************************************/
+BT_GATT_SERVICE_DEFINE(                          // Service declaration
+    stats_svc,                                   // Service name
+    BT_GATT_PRIMARY_SERVICE(BT_UUID_STATS_SVC),  // Service UUID
+
+    // Snapshot characteristic
+    BT_GATT_CHARACTERISTIC(BT_UUID_STATS_SVC_SNAPSHOT,              // UUID
+                           BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,  // Attribute properties
+                           BT_GATT_PERM_READ | BT_GATT_PERM_WRITE,  // Attribute access permissions
+                           read_snapshot_cb,                        // Attribute read callback
+                           write_snapshot_cb,                       // Attribute write callback
+                           NULL),                                   // Attribute user data
+);
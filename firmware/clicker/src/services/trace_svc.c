@@ -0,0 +1,95 @@
+#include "trace_svc.h"
+#include "../trace.h"
+
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+
+LOG_MODULE_REGISTER(app_trace_svc);
+
+// UUIDs
+#define BT_UUID_TRACE_SVC_INFO_VAL \
+    BT_UUID_128_ENCODE(0x456bdbe1, 0x0ad5, 0x401a, 0x898f, 0xd0505330d97a)  // Header of the trace ring (20 bytes)
+
+#define BT_UUID_TRACE_SVC_RECORDS_VAL \
+    BT_UUID_128_ENCODE(0x456bdbe2, 0x0ad5, 0x401a, 0x898f, 0xd0505330d97a)  // Page of trace records (up to 508 bytes)
+
+#define BT_UUID_TRACE_SVC         BT_UUID_DECLARE_128(BT_UUID_TRACE_SVC_VAL)
+#define BT_UUID_TRACE_SVC_INFO    BT_UUID_DECLARE_128(BT_UUID_TRACE_SVC_INFO_VAL)
+#define BT_UUID_TRACE_SVC_RECORDS BT_UUID_DECLARE_128(BT_UUID_TRACE_SVC_RECORDS_VAL)
+
+// A page of records as returned by the records characteristic; the page is built when the characteristic is read
+// at offset 0, so that long reads (which may span several ATT requests) return a consistent snapshot
+#define RECORDS_PER_PAGE ((BT_ATT_MAX_ATTRIBUTE_LEN - sizeof(uint32_t)) / sizeof(struct trace_record_t))
+
+struct records_page_t {
+    uint32_t first_seq;  // Sequence number of the first record in the page
+    struct trace_record_t records[RECORDS_PER_PAGE];
+};
+
+// Global state
+static uint32_t next_seq;  // Sequence number of the first record of the next page; set by the central
+static struct records_page_t page;
+static uint16_t page_len;
+
+/*********************************************************************************************************************
+ * SERVICE CALLBACKS
+ *********************************************************************************************************************/
+static ssize_t read_info_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, void *buf, uint16_t len,
+                            uint16_t offset) {
+    struct trace_info_t info;
+    trace_get_info(&info);
+
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, &info, sizeof(info));
+}
+
+static ssize_t read_records_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, void *buf, uint16_t len,
+                               uint16_t offset) {
+    if (offset == 0) {
+        int count = trace_read(next_seq, page.records, RECORDS_PER_PAGE, &page.first_seq);
+        page_len  = sizeof(page.first_seq) + count * sizeof(struct trace_record_t);
+    }
+
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, &page, page_len);
+}
+
+static ssize_t write_records_cb(struct bt_conn *conn, const struct bt_gatt_attr *attr, const void *buf, uint16_t len,
+                                uint16_t offset, uint8_t flags) {
+    if (len != sizeof(next_seq)) {
+        LOG_ERR("Invalid length for write: %d != %d", len, sizeof(next_seq));
+        return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+    }
+
+    if (offset != 0) {
+        LOG_ERR("Invalid offset for write: %d != 0", offset);
+        return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+    }
+
+    next_seq = sys_get_le32(buf);
+
+    return len;
+}
+
+/*********************************************************************************************************************
+ * SERVICE DECLARATION
+ *********************************************************************************************************************/
+BT_GATT_SERVICE_DEFINE(                          // Service declaration
+    trace_svc,                                   // Service name
+    BT_GATT_PRIMARY_SERVICE(BT_UUID_TRACE_SVC),  // Service UUID
+
+    // Info characteristic
+    BT_GATT_CHARACTERISTIC(BT_UUID_TRACE_SVC_INFO,  // UUID
+                           BT_GATT_CHRC_READ,       // Attribute properties
+                           BT_GATT_PERM_READ,       // Attribute access permissions
+                           read_info_cb,            // Attribute read callback
+                           NULL,                    // Attribute write callback
+                           NULL),                   // Attribute user data
+
+    // Records characteristic; write the sequence number of the first record to read (uint32), then read the page
+    BT_GATT_CHARACTERISTIC(BT_UUID_TRACE_SVC_RECORDS,               // UUID
+                           BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,  // Attribute properties
+                           BT_GATT_PERM_READ | BT_GATT_PERM_WRITE,  // Attribute access permissions
+                           read_records_cb,                         // Attribute read callback
+                           write_records_cb,                        // Attribute write callback
+                           NULL),                                   // Attribute user data
+);
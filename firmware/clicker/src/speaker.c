@@ -1,92 +1,25 @@
 #include "speaker.h"
+#include "energy.h"
+#include "idle.h"
+#include "notes.h"
+#include "profiling.h"
+#include "stats.h"
+#include "trace.h"
+#include "workq.h"
 
 #include <zephyr/drivers/pwm.h>
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/pm/device_runtime.h>
 
 LOG_MODULE_REGISTER(app_speaker);
 
-// Thread configuration
-#define THREAD_STACK_SIZE 1024
-#define THREAD_PRIORITY   4
+// Maximum number of play commands waiting to be executed
+#define CMD_QUEUE_SIZE 4
 
 // Macros for readability
 #define MELODY_END {.note = 0, .length = 0}
 
-// Notes in Hz
-enum note_t {
-    REST = 0,
-    C4   = 262,
-    Db4  = 277,
-    D4   = 294,
-    Eb4  = 311,
-    E4   = 330,
-    F4   = 349,
-    Gb4  = 370,
-    G4   = 392,
-    Ab4  = 415,
-    A4   = 440,
-    Bb4  = 466,
-    B4   = 494,
-    C5   = 523,
-    Db5  = 554,
-    D5   = 587,
-    Eb5  = 622,
-    E5   = 659,
-    F5   = 698,
-    Gb5  = 740,
-    G5   = 784,
-    Ab5  = 831,
-    A5   = 880,
-    Bb5  = 932,
-    B5   = 988,
-    C6   = 1046,
-    Db6  = 1109,
-    D6   = 1175,
-    Eb6  = 1245,
-    E6   = 1319,
-    F6   = 1397,
-    Gb6  = 1480,
-    G6   = 1568,
-    Ab6  = 1661,
-    A6   = 1760,
-    Bb6  = 1865,
-    B6   = 1976,
-    C7   = 2093,
-    Db7  = 2217,
-    D7   = 2349,
-    Eb7  = 2489,
-    E7   = 2637,
-    F7   = 2794,
-    Gb7  = 2960,
-    G7   = 3136,
-    Ab7  = 3322,
-    A7   = 3520,
-    Bb7  = 3729,
-    B7   = 3951,
-    C8   = 4186,
-    Db8  = 4435,
-    D8   = 4699,
-    Eb8  = 4978,
-    E8   = 5274,
-    F8   = 5588,
-    Gb8  = 5920,
-    G8   = 6272,
-    Ab8  = 6645,
-    A8   = 7040,
-    Bb8  = 7459,
-    B8   = 7902,
-};
-
-// Note lengths in ms
-enum note_length_t {
-    SIXTEENTH = 38,
-    EIGTH     = 75,
-    QUARTER   = 150,
-    HALF      = 300,
-    WHOLE     = 600,
-};
-
 // A note and its lengths within a melody
 struct melody_note_t {
     uint16_t note;
@@ -96,14 +29,19 @@ struct melody_note_t {
 // PWM device connected to the speaker
 static const struct device *pwm = DEVICE_DT_GET(DT_NODELABEL(pwm0));
 
-// FIFO for communicating with the speaker thread
+// Message queue for passing play commands to the work queue
 struct play_cmd_t {
-    void *fifo_reserved;
     const struct melody_note_t *melody;
     speaker_finished_cb_t cb;
 };
 
-K_FIFO_DEFINE(speaker_play_cmd_fifo);
+K_MSGQ_DEFINE(speaker_play_cmd_msgq, sizeof(struct play_cmd_t), CMD_QUEUE_SIZE, 4);
+
+// Global state (only accessed from the work queue, except for is_initialized)
+static bool is_initialized                   = false;
+static bool pwm_resumed                      = false;
+static const struct melody_note_t *next_note = NULL;
+static speaker_finished_cb_t finished_cb     = NULL;
 
 /*********************************************************************************************************************
  * PRIVATE FUNCTIONS
@@ -199,6 +137,9 @@ static const struct melody_note_t *get_melody(enum speaker_melody_t melody) {
 }
 
 static bool set_speaker_frequency(uint32_t frequency) {
+    PROFILING_BEGIN(PROFILING_SET_SPEAKER_FREQUENCY);
+    stats_add(STATS_PWM_SETS, 1);
+
     // Calculate the period and pulse length from the given frequency
     uint32_t period;
     uint32_t pulse;
@@ -227,100 +168,139 @@ static bool set_speaker_frequency(uint32_t frequency) {
     res = pwm_set(pwm, 1, period, pulse, PWM_POLARITY_INVERTED);
     if (res < 0) goto error;
 
+    PROFILING_END(PROFILING_SET_SPEAKER_FREQUENCY);
     return true;
 
 error:
+    PROFILING_END(PROFILING_SET_SPEAKER_FREQUENCY);
     LOG_ERR("Failed to set PWM parameters: %d", res);
     return false;
 }
 
-static int put_play_cmd(const struct melody_note_t *melody, speaker_finished_cb_t cb) {
-    struct play_cmd_t *cmd = k_malloc(sizeof(struct play_cmd_t));
-    if (!cmd) {
-        LOG_ERR("Unable to allocate FIFO data item from heap");
-        return -ENOMEM;
+/*********************************************************************************************************************
+ * WORK HANDLERS
+ *********************************************************************************************************************/
+static void note_work_fn(struct k_work *work);
+static void cmd_work_fn(struct k_work *work);
+
+K_WORK_DELAYABLE_DEFINE(speaker_note_work, note_work_fn);
+K_WORK_DEFINE(speaker_cmd_work, cmd_work_fn);
+
+static void stop_melody(bool aborted) {
+    // Also called to silence a plain tone, which is not traced
+    if (next_note) {
+        trace(TRACE_MOD_SPEAKER, TRACE_EVT_SPEAKER_MELODY_STOP, aborted);
     }
 
-    cmd->fifo_reserved = NULL;
-    cmd->melody        = melody;
-    cmd->cb            = cb;
+    k_work_cancel_delayable(&speaker_note_work);
+    next_note = NULL;
 
-    k_fifo_put(&speaker_play_cmd_fifo, cmd);
+    // Silence the speaker and suspend the PWM peripheral
+    if (pwm_resumed) {
+        set_speaker_frequency(0);
+        pm_device_runtime_put(pwm);
+        pwm_resumed = false;
+        idle_set_busy(IDLE_SRC_SPEAKER, false);
+        energy_state_end(ENERGY_PWM_ON);
+    }
 
-    return 0;
+    if (finished_cb) {
+        speaker_finished_cb_t cb = finished_cb;
+        finished_cb              = NULL;
+        cb(aborted);
+    }
 }
 
-/*********************************************************************************************************************
- * THREADS
- *********************************************************************************************************************/
-static void speaker_thread_fn() {
-    if (!device_is_ready(pwm)) {
-        LOG_ERR("PWM device is not ready");
+static void note_work_fn(struct k_work *work) {
+    // Melody is finished
+    if (!next_note || (next_note->note == 0 && next_note->length == 0)) {
+        stop_melody(false);
         return;
     }
 
-    LOG_INF("Speaker module initialized OK; waiting for commands");
+    // Play the next note and schedule the one after
+    set_speaker_frequency(next_note->note);
+    k_work_reschedule_for_queue(&workq, &speaker_note_work, K_MSEC(next_note->length));
+    next_note++;
+}
 
-    const struct melody_note_t *next_note = NULL;
-    k_timepoint_t next_note_time          = sys_timepoint_calc(K_FOREVER);
-    speaker_finished_cb_t finished_cb     = NULL;
-
-    // Main loop, executing commands and playing melodies
-    while (true) {
-        // Wait for a new play command or until the next note time has been reached
-        k_timeout_t timeout    = sys_timepoint_timeout(next_note_time);
-        struct play_cmd_t *cmd = k_fifo_get(&speaker_play_cmd_fifo, timeout);
-
-        // Play the next note in the melody if it's time or stop the melody if it's finished
-        if (sys_timepoint_expired(next_note_time)) {
-            // Play the next note
-            if (next_note && (next_note->note != 0 || next_note->length != 0)) {
-                set_speaker_frequency(next_note->note);
-                next_note_time = sys_timepoint_calc(K_MSEC(next_note->length));
-                next_note++;
-            }
-            // Melody is finished
-            else {
-                set_speaker_frequency(0);
-                next_note      = NULL;
-                next_note_time = sys_timepoint_calc(K_FOREVER);
-
-                if (finished_cb) {
-                    finished_cb(false);
-                    finished_cb = NULL;
-                }
-            }
+static void cmd_work_fn(struct k_work *work) {
+    struct play_cmd_t cmd;
+
+    // Execute all commands that have been queued since the last run
+    while (k_msgq_get(&speaker_play_cmd_msgq, &cmd, K_NO_WAIT) == 0) {
+        stats_set_queue_depth(STATS_QUEUE_SPEAKER, k_msgq_num_used_get(&speaker_play_cmd_msgq));
+
+        // If a melody is currently playing, stop it and call the finished callback
+        if (next_note) {
+            stop_melody(true);
         }
 
-        // If we didn't receive a command, wait for the next one
-        if (!cmd) {
+        // Stop-command
+        if (!cmd.melody) {
             continue;
         }
 
-        // If a melody is currently playing, call the finished callback
-        if (next_note) {
-            next_note      = NULL;
-            next_note_time = sys_timepoint_calc(K_NO_WAIT);
-
-            if (finished_cb) {
-                finished_cb(true);
-                finished_cb = NULL;
+        // Start playing the new melody (the PWM peripheral is only resumed while a melody or tone is playing; a tone of
+        // speaker_tone_now() has resumed it already and hands it over to the melody)
+        if (!pwm_resumed) {
+            if (pm_device_runtime_get(pwm) != 0) {
+                LOG_ERR("Failed to resume PWM device");
+                if (cmd.cb) cmd.cb(true);
+                continue;
             }
-        }
 
-        // If the command is not a stop-command, start playing the new melody
-        if (cmd->melody) {
-            next_note      = cmd->melody;
-            next_note_time = sys_timepoint_calc(K_NO_WAIT);
-            finished_cb    = cmd->cb;
+            pwm_resumed = true;
+            idle_set_busy(IDLE_SRC_SPEAKER, true);
+            energy_state_begin(ENERGY_PWM_ON);
         }
 
-        // Free the command (it was allocated in speaker_play())
-        k_free(cmd);
+        trace(TRACE_MOD_SPEAKER, TRACE_EVT_SPEAKER_MELODY_START, cmd.melody->note);
+
+        next_note   = cmd.melody;
+        finished_cb = cmd.cb;
+        note_work_fn(NULL);
+    }
+}
+
+static int put_play_cmd(const struct melody_note_t *melody, speaker_finished_cb_t cb) {
+    if (!is_initialized) {
+        return -ENODEV;
+    }
+
+    struct play_cmd_t cmd = {
+        .melody = melody,
+        .cb     = cb,
+    };
+
+    int res = k_msgq_put(&speaker_play_cmd_msgq, &cmd, K_NO_WAIT);
+    if (res) {
+        LOG_ERR("Command queue is full");
+        return -ENOMEM;
     }
+
+    stats_set_queue_depth(STATS_QUEUE_SPEAKER, k_msgq_num_used_get(&speaker_play_cmd_msgq));
+    k_work_submit_to_queue(&workq, &speaker_cmd_work);
+
+    return 0;
 }
 
-K_THREAD_DEFINE(speaker_thread_id, THREAD_STACK_SIZE, speaker_thread_fn, NULL, NULL, NULL, THREAD_PRIORITY, 0, 0);
+/*********************************************************************************************************************
+ * STARTUP HOOKS
+ *********************************************************************************************************************/
+static int init_speaker() {
+    if (!device_is_ready(pwm)) {
+        LOG_ERR("PWM device is not ready");
+        return 0;
+    }
+
+    is_initialized = true;
+    LOG_INF("Speaker module initialized OK; waiting for commands");
+
+    return 0;
+}
+
+SYS_INIT(init_speaker, APPLICATION, 0);
 
 /*********************************************************************************************************************
  * PUBLIC FUNCTIONS
@@ -332,3 +312,36 @@ int speaker_play(enum speaker_melody_t melody, speaker_finished_cb_t cb) {
 int speaker_off() {
     return put_play_cmd(NULL, NULL);
 }
+
+int speaker_tone_now(uint32_t frequency) {
+    __ASSERT(k_current_get() == k_work_queue_thread_get(&workq), "Must be called from the work queue");
+
+    if (!is_initialized) {
+        return -ENODEV;
+    }
+
+    // Stop the melody currently playing, if there is any
+    if (next_note) {
+        stop_melody(true);
+    }
+
+    // Silence the speaker and suspend the PWM peripheral
+    if (frequency == 0) {
+        stop_melody(false);
+        return 0;
+    }
+
+    // The PWM peripheral stays resumed until the speaker is silenced again
+    if (!pwm_resumed) {
+        if (pm_device_runtime_get(pwm) != 0) {
+            LOG_ERR("Failed to resume PWM device");
+            return -EIO;
+        }
+
+        pwm_resumed = true;
+        idle_set_busy(IDLE_SRC_SPEAKER, true);
+        energy_state_begin(ENERGY_PWM_ON);
+    }
+
+    return set_speaker_frequency(frequency) ? 0 : -EIO;
+}
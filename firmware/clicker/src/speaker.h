@@ -37,4 +37,17 @@ int speaker_play(enum speaker_melody_t melody, speaker_finished_cb_t cb);
  */
 int speaker_off();
 
+/**
+ * @brief Play a continuous tone immediately.
+ *
+ * Any melody currently playing is aborted. This is meant for modules that orchestrate the speaker from the shared
+ * work queue (see workq.h) and must only be called from there. The tone plays until this function is called again.
+ *
+ * @param frequency Frequency of the tone in Hz, or 0 to silence the speaker.
+ *
+ * @retval 0 If successful.
+ * @retval <0 Error code if playing the tone failed.
+ */
+int speaker_tone_now(uint32_t frequency);
+
 #endif  // SPEAKER_H
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include "stats.h"
+
+#include <string.h>
+#include <zephyr/kernel.h>
+
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+BUILD_ASSERT(sizeof(struct stats_thread_t) == 24, "Thread statistics layout is part of the GATT snapshot format");
+BUILD_ASSERT(offsetof(struct stats_snapshot_t, threads) % 8 == 0, "Snapshot must not contain padding");
+
+static const char *const counter_names[] = {
+    [STATS_LP5813_WRITES] = "lp5813_writes",
+    [STATS_LP5813_READS]  = "lp5813_reads",
+    [STATS_LP5813_BYTES]  = "lp5813_bytes",
+    [STATS_I2C_ERRORS]    = "i2c_errors",
+    [STATS_PWM_SETS]      = "pwm_sets",
+    [STATS_ADC_READS]     = "adc_reads",
+};
+
+static const char *const queue_names[] = {
+    [STATS_QUEUE_BUTTONS] = "buttons",
+    [STATS_QUEUE_LEDS]    = "leds",
+    [STATS_QUEUE_SPEAKER] = "speaker",
+};
+
+BUILD_ASSERT(ARRAY_SIZE(counter_names) == STATS_NUM_COUNTERS);
+BUILD_ASSERT(ARRAY_SIZE(queue_names) == STATS_NUM_QUEUES);
+
+// Global state
+atomic_t stats_counters[STATS_NUM_COUNTERS];
+
+static atomic_t queue_depth[STATS_NUM_QUEUES];
+static atomic_t queue_max[STATS_NUM_QUEUES];
+
+/*********************************************************************************************************************
+ * PRIVATE FUNCTIONS
+ *********************************************************************************************************************/
+static void add_thread(const struct k_thread *thread, void *user_data) {
+    struct stats_snapshot_t *snapshot = user_data;
+    if (snapshot->num_threads >= STATS_MAX_THREADS) {
+        return;
+    }
+
+    struct stats_thread_t *entry = &snapshot->threads[snapshot->num_threads++];
+    struct k_thread *t           = (struct k_thread *)thread;
+
+    const char *name = k_thread_name_get(t);
+    strncpy(entry->name, name ? name : "?", sizeof(entry->name));
+
+    size_t unused = 0;
+    k_thread_stack_space_get(t, &unused);
+    entry->stack_size   = (uint16_t)t->stack_info.size;
+    entry->stack_unused = (uint16_t)unused;
+
+    k_thread_runtime_stats_t rt;
+    entry->runtime_cycles = (k_thread_runtime_stats_get(t, &rt) == 0) ? rt.execution_cycles : 0;
+}
+
+/*********************************************************************************************************************
+ * SHELL COMMANDS
+ *********************************************************************************************************************/
+#if defined(CONFIG_SHELL)
+
+static int cmd_stats_show(const struct shell *sh, size_t argc, char **argv) {
+    static struct stats_snapshot_t snapshot;
+    stats_get_snapshot(&snapshot);
+
+    // Loads are printed in permille of the uptime
+    uint64_t uptime_cycles = (uint64_t)snapshot.uptime_ms * snapshot.cycles_per_sec / 1000;
+    uint64_t cpu_permille  = uptime_cycles ? snapshot.total_cycles * 1000 / uptime_cycles : 0;
+
+    shell_print(sh, "Uptime: %u ms, CPU load: %u.%u%%", snapshot.uptime_ms, (uint32_t)(cpu_permille / 10),
+                (uint32_t)(cpu_permille % 10));
+
+    shell_print(sh, "\nThreads:");
+    shell_print(sh, "  %-12s %6s %6s %12s %6s", "name", "stack", "used", "cycles", "load");
+    for (int i = 0; i < snapshot.num_threads; i++) {
+        const struct stats_thread_t *t = &snapshot.threads[i];
+        uint32_t used                  = t->stack_size - t->stack_unused;
+        uint64_t load                  = uptime_cycles ? t->runtime_cycles * 1000 / uptime_cycles : 0;
+        shell_print(sh, "  %-12.12s %6u %6u %12llu %3u.%u%%", t->name, t->stack_size, used, t->runtime_cycles,
+                    (uint32_t)(load / 10), (uint32_t)(load % 10));
+    }
+
+    shell_print(sh, "\nQueues:");
+    for (int i = 0; i < STATS_NUM_QUEUES; i++) {
+        shell_print(sh, "  %-12s depth %u, max %u", queue_names[i], snapshot.queue_depth[i], snapshot.queue_max[i]);
+    }
+
+    shell_print(sh, "\nCounters:");
+    for (int i = 0; i < STATS_NUM_COUNTERS; i++) {
+        shell_print(sh, "  %-14s %u", counter_names[i], snapshot.counters[i]);
+    }
+
+    return 0;
+}
+
+static int cmd_stats_reset(const struct shell *sh, size_t argc, char **argv) {
+    stats_reset();
+    shell_print(sh, "Counters and queue maxima reset");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(stats_cmds,
+                               SHELL_CMD(show, NULL, "Show all statistics", cmd_stats_show),
+                               SHELL_CMD(reset, NULL, "Reset counters and queue maxima", cmd_stats_reset),
+                               SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(stats, &stats_cmds, "Performance counters", NULL);
+
+#endif  // CONFIG_SHELL
+
+/*********************************************************************************************************************
+ * PUBLIC FUNCTIONS
+ *********************************************************************************************************************/
+void stats_set_queue_depth(enum stats_queue_t queue, uint32_t depth) {
+    atomic_set(&queue_depth[queue], depth);
+
+    atomic_val_t max = atomic_get(&queue_max[queue]);
+    while ((atomic_val_t)depth > max && !atomic_cas(&queue_max[queue], max, depth)) {
+        max = atomic_get(&queue_max[queue]);
+    }
+}
+
+void stats_get_snapshot(struct stats_snapshot_t *snapshot) {
+    memset(snapshot, 0, sizeof(*snapshot));
+
+    snapshot->uptime_ms      = k_uptime_get_32();
+    snapshot->cycles_per_sec = sys_clock_hw_cycles_per_sec();
+
+    k_thread_runtime_stats_t rt;
+    if (k_thread_runtime_stats_all_get(&rt) == 0) {
+        snapshot->total_cycles = rt.total_cycles;
+    }
+
+    for (int i = 0; i < STATS_NUM_COUNTERS; i++) {
+        snapshot->counters[i] = (uint32_t)atomic_get(&stats_counters[i]);
+    }
+
+    for (int i = 0; i < STATS_NUM_QUEUES; i++) {
+        snapshot->queue_depth[i] = (uint8_t)atomic_get(&queue_depth[i]);
+        snapshot->queue_max[i]   = (uint8_t)atomic_get(&queue_max[i]);
+    }
+
+    k_thread_foreach(add_thread, snapshot);
+}
+
+void stats_reset() {
+    for (int i = 0; i < STATS_NUM_COUNTERS; i++) {
+        atomic_clear(&stats_counters[i]);
+    }
+
+    for (int i = 0; i < STATS_NUM_QUEUES; i++) {
+        atomic_set(&queue_max[i], atomic_get(&queue_depth[i]));
+    }
+}
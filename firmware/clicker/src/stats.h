@@ -0,0 +1,95 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+
+// Operation counters; the numeric values are part of the GATT snapshot format and must not change
+enum stats_counter_t {
+    STATS_LP5813_WRITES = 0,  // Calls to lp5813_write_reg() and lp5813_write_multiple()
+    STATS_LP5813_READS  = 1,  // Calls to lp5813_read_reg()
+    STATS_LP5813_BYTES  = 2,  // Register bytes written to the LP5813
+    STATS_I2C_ERRORS    = 3,  // Failed LP5813 transfers
+    STATS_PWM_SETS      = 4,  // Calls to set_speaker_frequency()
+    STATS_ADC_READS     = 5,  // Calls to read_adc()
+    STATS_NUM_COUNTERS,
+};
+
+// Queue depths; the numeric values are part of the GATT snapshot format and must not change
+enum stats_queue_t {
+    STATS_QUEUE_BUTTONS = 0,  // Button events not yet taken by buttons_get_event()
+    STATS_QUEUE_LEDS    = 1,  // LED commands not yet executed
+    STATS_QUEUE_SPEAKER = 2,  // Speaker commands not yet executed
+    STATS_NUM_QUEUES,
+};
+
+// Maximum number of threads in a snapshot
+#define STATS_MAX_THREADS 10
+
+// Statistics of a single thread in a snapshot
+struct stats_thread_t {
+    char name[12];            // Thread name (truncated, not necessarily null-terminated)
+    uint16_t stack_size;      // Stack size in bytes
+    uint16_t stack_unused;    // Stack space that has never been used in bytes
+    uint64_t runtime_cycles;  // Execution time in hardware cycles
+};
+
+// Snapshot of all statistics (little-endian); this is the value of the GATT characteristic
+struct stats_snapshot_t {
+    uint32_t uptime_ms;
+    uint32_t cycles_per_sec;
+    uint64_t total_cycles;  // Execution time of all threads (i.e. not idle) in hardware cycles
+    uint32_t counters[STATS_NUM_COUNTERS];
+    uint8_t queue_depth[STATS_NUM_QUEUES];
+    uint8_t queue_max[STATS_NUM_QUEUES];  // Highest queue depth since the last reset
+    uint8_t num_threads;
+    uint8_t reserved;
+    struct stats_thread_t threads[STATS_MAX_THREADS];
+};
+
+#if defined(CONFIG_APP_STATS)
+
+#include <zephyr/sys/atomic.h>
+
+extern atomic_t stats_counters[STATS_NUM_COUNTERS];
+
+/**
+ * @brief Adds a value to an operation counter.
+ *
+ * @param counter The counter to increase.
+ * @param value The value to add.
+ */
+static inline void stats_add(enum stats_counter_t counter, uint32_t value) {
+    atomic_add(&stats_counters[counter], value);
+}
+
+/**
+ * @brief Sets the current depth of a queue and updates its maximum.
+ *
+ * @param queue The queue.
+ * @param depth The number of items currently in the queue.
+ */
+void stats_set_queue_depth(enum stats_queue_t queue, uint32_t depth);
+
+/**
+ * @brief Takes a snapshot of all statistics.
+ *
+ * @param snapshot Pointer to the snapshot structure to fill.
+ */
+void stats_get_snapshot(struct stats_snapshot_t *snapshot);
+
+/**
+ * @brief Resets the operation counters and the queue maxima.
+ */
+void stats_reset();
+
+#else
+
+static inline void stats_add(enum stats_counter_t counter, uint32_t value) {
+}
+
+static inline void stats_set_queue_depth(enum stats_queue_t queue, uint32_t depth) {
+}
+
+#endif  // CONFIG_APP_STATS
+
+#endif  // STATS_H
@@ -0,0 +1,340 @@
+#include "timeslot.h"
+#include "energy.h"
+#include "trace.h"
+
+#include <hal/nrf_timer.h>
+#include <mpsl/mpsl_work.h>
+#include <mpsl_timeslot.h>
+#include <nrf_gzll.h>
+#include <nrf_gzll_glue.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+
+LOG_MODULE_REGISTER(app_timeslot);
+
+// Timeslot configuration: short timeslots fit between the events of a BLE connection and are extended as long as a
+// packet is pending. TIMER0 (started by MPSL at the beginning of each timeslot, 1 MHz) ticks once per Gazell timeslot;
+// on each tick we add a packet that came in during the timeslot to the TX FIFO, and check whether the packet is done
+// and whether the end of the timeslot is near. Disabling Gazell takes up to one Gazell timeslot, so winding down
+// starts END_MARGIN_US before the end.
+#define TIMESLOT_LENGTH_US  5000
+#define TIMESLOT_TIMEOUT_US 100000  // A request that cannot be scheduled within this time is blocked or cancelled
+#define MAX_WAIT_US         500000  // A packet that has not had a timeslot for this long fails its try
+#define TICK_US             600     // Gazell's default timeslot period
+#define END_MARGIN_US       (3 * TICK_US)
+#define ADDRESS_PIPES       2  // Pipes with their own base address (pipe 0 uses base address 0, the others base 1)
+
+// State of the timeslot session
+enum state_t {
+    STATE_IDLE,       // No timeslot requested
+    STATE_REQUESTED,  // Waiting for the next timeslot
+    STATE_ACTIVE,     // Inside a timeslot
+};
+
+// Global state (shared between the callers, the MPSL work queue and the timeslot callback)
+static mpsl_timeslot_session_id_t session_id;
+static mpsl_timeslot_request_t request;  // Only filled while no timeslot is requested or active
+static atomic_t state;                   // enum state_t
+static atomic_t has_packet;              // A packet is pending (set by timeslot_send(), cleared by timeslot_tx_done())
+static atomic_t is_packet_urgent;        // The pending packet is sent in high priority timeslots
+static uint32_t request_cycles;          // Hardware cycles when the current timeslot was requested
+static uint32_t packet_pipe;             // Pipe of the pending packet
+static uint32_t packet_len;              // Length of the pending packet
+static uint8_t packet_data[NRF_GZLL_CONST_MAX_PAYLOAD_LENGTH];
+
+// Gazell configuration applied at the start of the next timeslot (Gazell can only be reconfigured while it is
+// disabled). The callers clear the pending flag before changing the data and set it afterwards; the timeslot callback
+// preempts them, so it never sees a partial update.
+static atomic_t is_table_pending;
+static atomic_t pending_addresses;  // Bitmask of the pipes (< ADDRESS_PIPES) with a pending address
+static uint8_t pending_table[NRF_GZLL_CONST_MAX_CHANNEL_TABLE_SIZE];
+static uint32_t pending_table_len;
+static uint8_t pending_address[ADDRESS_PIPES][5];
+
+// Global state (only accessed from the timeslot callback)
+static mpsl_timeslot_signal_return_param_t signal_return;
+static uint32_t end_us;    // End of the current timeslot (including extensions) relative to its start
+static uint32_t tick_us;   // Time of the next tick relative to the start of the timeslot
+static bool is_extending;  // An extension of the current timeslot was requested
+static bool is_ending;     // Gazell is being disabled to end the current timeslot
+static bool is_queued;     // The pending packet is in the Gazell TX FIFO
+
+static void request_work_fn(struct k_work *work);
+
+K_WORK_DEFINE(timeslot_request_work, request_work_fn);
+
+/*********************************************************************************************************************
+ * PRIVATE FUNCTIONS
+ *********************************************************************************************************************/
+static mpsl_timeslot_request_t *get_request() {
+    bool is_urgent = atomic_get(&is_packet_urgent);
+
+    request.request_type               = MPSL_TIMESLOT_REQ_TYPE_EARLIEST;
+    request.params.earliest.hfclk      = MPSL_TIMESLOT_HFCLK_CFG_XTAL_GUARANTEED;
+    request.params.earliest.priority   = is_urgent ? MPSL_TIMESLOT_PRIORITY_HIGH : MPSL_TIMESLOT_PRIORITY_NORMAL;
+    request.params.earliest.length_us  = TIMESLOT_LENGTH_US;
+    request.params.earliest.timeout_us = TIMESLOT_TIMEOUT_US;
+    return &request;
+}
+
+static mpsl_timeslot_signal_return_param_t *request_next() {
+    signal_return.callback_action       = MPSL_TIMESLOT_SIGNAL_ACTION_REQUEST;
+    signal_return.params.request.p_next = get_request();
+    return &signal_return;
+}
+
+static void set_tick(uint32_t time_us) {
+    tick_us = time_us;
+    nrf_timer_cc_set(NRF_TIMER0, NRF_TIMER_CC_CHANNEL0, tick_us);
+}
+
+static bool is_config_pending() {
+    return atomic_get(&is_table_pending) || atomic_get(&pending_addresses);
+}
+
+static void apply_config() {
+    if (atomic_cas(&is_table_pending, true, false)) {
+        nrf_gzll_set_channel_table(pending_table, pending_table_len);
+    }
+
+    for (uint32_t pipe = 0; pipe < ADDRESS_PIPES; pipe++) {
+        if (!atomic_test_and_clear_bit(&pending_addresses, pipe)) {
+            continue;
+        }
+
+        const uint8_t *address = pending_address[pipe];
+        uint32_t base          = sys_get_le32(address);
+        if (pipe == 0) {
+            nrf_gzll_set_base_address_0(base);
+        } else {
+            nrf_gzll_set_base_address_1(base);
+        }
+
+        nrf_gzll_set_address_prefix_byte(pipe, address[4]);
+    }
+}
+
+static void queue_packet() {
+    // The radio is charged from here until Gazell reports the result (which ends the state) or the packet is flushed
+    is_queued = nrf_gzll_add_packet_to_tx_fifo(packet_pipe, packet_data, packet_len);
+    if (is_queued) {
+        energy_state_begin(ENERGY_RADIO_TX);
+    }
+}
+
+static void on_start() {
+    uint32_t wait_us = k_cyc_to_us_floor32(k_cycle_get_32() - request_cycles);
+    trace(TRACE_MOD_RADIO, TRACE_EVT_RADIO_TIMESLOT,
+          MIN(wait_us, INT32_MAX) | ((uint32_t)atomic_get(&is_packet_urgent) << 31));
+
+    atomic_set(&state, STATE_ACTIVE);
+    end_us       = TIMESLOT_LENGTH_US;
+    is_extending = false;
+    is_ending    = false;
+
+    nrf_timer_event_clear(NRF_TIMER0, NRF_TIMER_EVENT_COMPARE0);
+    nrf_timer_int_enable(NRF_TIMER0, NRF_TIMER_INT_COMPARE0_MASK);
+    set_tick(TICK_US);
+
+    // Gazell is still disabled from the end of the previous timeslot; a packet that was interrupted by it is sent again
+    apply_config();
+    nrf_gzll_enable();
+    is_queued = false;
+    if (atomic_get(&has_packet)) {
+        queue_packet();
+    }
+}
+
+static void begin_end() {
+    // Gazell finishes the current transaction before it is disabled
+    is_ending = true;
+    if (nrf_gzll_is_enabled()) {
+        nrf_gzll_disable();
+    }
+}
+
+static mpsl_timeslot_signal_return_param_t *end_timeslot() {
+    nrf_timer_int_disable(NRF_TIMER0, NRF_TIMER_INT_COMPARE0_MASK);
+
+    // The packet is added to the FIFO again in the next timeslot
+    if (is_queued) {
+        nrf_gzll_flush_tx_fifo(packet_pipe);
+        energy_state_end(ENERGY_RADIO_TX);
+        is_queued = false;
+    }
+
+    // A packet may have come in while the timeslot was winding down
+    atomic_set(&state, STATE_IDLE);
+    if (atomic_get(&has_packet) && atomic_cas(&state, STATE_IDLE, STATE_REQUESTED)) {
+        request_cycles = k_cycle_get_32();
+        return request_next();
+    }
+
+    signal_return.callback_action = MPSL_TIMESLOT_SIGNAL_ACTION_END;
+    return &signal_return;
+}
+
+static mpsl_timeslot_signal_return_param_t *on_tick() {
+    nrf_timer_event_clear(NRF_TIMER0, NRF_TIMER_EVENT_COMPARE0);
+    set_tick(tick_us + TICK_US);
+
+    // A changed configuration needs a new timeslot; a packet that came in during this one is added to the FIFO now
+    if (!is_ending && (!atomic_get(&has_packet) || is_config_pending())) {
+        begin_end();
+    } else if (!is_ending && !is_queued) {
+        queue_packet();
+    }
+
+    if (!is_ending && !is_extending && tick_us + END_MARGIN_US >= end_us) {
+        is_extending                          = true;
+        signal_return.callback_action         = MPSL_TIMESLOT_SIGNAL_ACTION_EXTEND;
+        signal_return.params.extend.length_us = TIMESLOT_LENGTH_US;
+        return &signal_return;
+    }
+
+    if (is_ending && !nrf_gzll_is_enabled()) {
+        return end_timeslot();
+    }
+
+    signal_return.callback_action = MPSL_TIMESLOT_SIGNAL_ACTION_NONE;
+    return &signal_return;
+}
+
+static mpsl_timeslot_signal_return_param_t *on_signal(mpsl_timeslot_session_id_t session, uint32_t signal) {
+    signal_return.callback_action = MPSL_TIMESLOT_SIGNAL_ACTION_NONE;
+
+    switch (signal) {
+        case MPSL_TIMESLOT_SIGNAL_START:
+            on_start();
+            break;
+
+        case MPSL_TIMESLOT_SIGNAL_RADIO:
+            // Gazell owns the radio during the timeslot
+            nrf_gzll_radio_irq_handler();
+            break;
+
+        case MPSL_TIMESLOT_SIGNAL_TIMER0:
+            if (nrf_timer_event_check(NRF_TIMER0, NRF_TIMER_EVENT_COMPARE0)) {
+                return on_tick();
+            }
+            break;
+
+        case MPSL_TIMESLOT_SIGNAL_EXTEND_SUCCEEDED:
+            is_extending = false;
+            end_us += TIMESLOT_LENGTH_US;
+            break;
+
+        case MPSL_TIMESLOT_SIGNAL_EXTEND_FAILED:
+            // BLE needs the radio; we continue in the next timeslot
+            begin_end();
+            break;
+
+        case MPSL_TIMESLOT_SIGNAL_BLOCKED:
+        case MPSL_TIMESLOT_SIGNAL_CANCELLED:
+            // The request could not be scheduled in time; try again unless the packet has been dropped in the meantime
+            // (the waiting time includes the failed request)
+            atomic_set(&state, STATE_IDLE);
+            if (!atomic_get(&has_packet)) {
+                break;
+            }
+
+            // BLE may keep the radio for longer than a click can wait (e.g. a long connection event series), so the
+            // try fails like one that was not acked, which lets the radio module retry or give up as usual
+            if (k_cyc_to_us_floor32(k_cycle_get_32() - request_cycles) >= MAX_WAIT_US) {
+                nrf_gzll_device_tx_failed(packet_pipe, (nrf_gzll_device_tx_info_t){.num_tx_attempts = 0});
+                break;
+            }
+
+            if (atomic_cas(&state, STATE_IDLE, STATE_REQUESTED)) {
+                return request_next();
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return &signal_return;
+}
+
+/*********************************************************************************************************************
+ * WORK HANDLERS (on the MPSL work queue, which the MPSL API calls must not be preempted on)
+ *********************************************************************************************************************/
+static void request_work_fn(struct k_work *work) {
+    int res = mpsl_timeslot_request(session_id, get_request());
+    if (res) {
+        LOG_ERR("mpsl_timeslot_request() returned %d", res);
+        atomic_set(&state, STATE_IDLE);
+    }
+}
+
+/*********************************************************************************************************************
+ * PUBLIC FUNCTIONS
+ *********************************************************************************************************************/
+int timeslot_init() {
+    // Like the MPSL work queue, we must not be preempted by other threads while calling into MPSL
+    k_sched_lock();
+    int res = mpsl_timeslot_session_open(on_signal, &session_id);
+    k_sched_unlock();
+
+    if (res) {
+        LOG_ERR("mpsl_timeslot_session_open() returned %d", res);
+        return res;
+    }
+
+    LOG_INF("Timeslot session opened");
+    return 0;
+}
+
+int timeslot_send(uint32_t pipe, const uint8_t *data, uint32_t len, bool is_urgent) {
+    if (atomic_get(&has_packet)) {
+        return -EBUSY;
+    }
+
+    packet_pipe = pipe;
+    packet_len  = MIN(len, sizeof(packet_data));
+    memcpy(packet_data, data, packet_len);
+    atomic_set(&is_packet_urgent, is_urgent);
+    atomic_set(&has_packet, true);
+
+    // If a timeslot is active already, the packet is added to the FIFO on its next tick; if one is requested, the
+    // packet goes out in that one
+    if (atomic_cas(&state, STATE_IDLE, STATE_REQUESTED)) {
+        request_cycles = k_cycle_get_32();
+        mpsl_work_submit(&timeslot_request_work);
+    }
+
+    return 0;
+}
+
+void timeslot_tx_done() {
+    is_queued = false;
+    atomic_set(&has_packet, false);
+}
+
+int timeslot_set_channel_table(const uint8_t *channels, uint32_t num_channels) {
+    if (num_channels == 0 || num_channels > ARRAY_SIZE(pending_table)) {
+        return -EINVAL;
+    }
+
+    atomic_set(&is_table_pending, false);
+    memcpy(pending_table, channels, num_channels);
+    pending_table_len = num_channels;
+    atomic_set(&is_table_pending, true);
+
+    return 0;
+}
+
+int timeslot_set_address(uint32_t pipe, const uint8_t address[5]) {
+    if (pipe >= ADDRESS_PIPES) {
+        return -EINVAL;
+    }
+
+    atomic_clear_bit(&pending_addresses, pipe);
+    memcpy(pending_address[pipe], address, sizeof(pending_address[pipe]));
+    atomic_set_bit(&pending_addresses, pipe);
+
+    return 0;
+}
@@ -0,0 +1,101 @@
+#ifndef TIMESLOT_H
+#define TIMESLOT_H
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(CONFIG_APP_RADIO_TIMESLOTS)
+
+/**
+ * @brief Opens the MPSL timeslot session that Gazell runs in.
+ *
+ * With timeslots, the SoftDevice Controller owns the radio and Gazell only gets it for the duration of a timeslot:
+ * Gazell is enabled at the start of each timeslot and disabled again before it ends, so BLE advertising and
+ * connections keep running while clicks are sent. Timeslots are only requested while a packet is pending.
+ *
+ * @retval 0 If successful.
+ * @retval <0 Error code if the session could not be opened.
+ */
+int timeslot_init();
+
+/**
+ * @brief Sends a packet with Gazell in the next timeslot.
+ *
+ * The packet is copied, a timeslot is requested and the packet is added to the Gazell TX FIFO when the timeslot
+ * starts; if a timeslot is active already, it is added on the next tick of that timeslot (within one Gazell timeslot
+ * of 600 us) instead. If the timeslot ends before the packet was acked, it is added again in the next one. The result
+ * is reported by Gazell's callbacks as usual, which must call timeslot_tx_done(). If no timeslot could be scheduled for
+ * the packet within 500 ms, nrf_gzll_device_tx_failed() is called with no TX attempts (from the MPSL work queue).
+ *
+ * @param pipe The Gazell pipe.
+ * @param data The packet.
+ * @param len The length of the packet in bytes.
+ * @param is_urgent True to request the timeslot with high priority (e.g. for clicks), which preempts BLE activity
+ *                  that can be rescheduled.
+ *
+ * @retval 0 If the packet was accepted.
+ * @retval -EBUSY If another packet is still pending.
+ * @retval <0 Other error code if the timeslot could not be requested.
+ */
+int timeslot_send(uint32_t pipe, const uint8_t *data, uint32_t len, bool is_urgent);
+
+/**
+ * @brief Marks the pending packet as done, so that the timeslot can be handed back.
+ *
+ * Called from Gazell's TX callbacks.
+ */
+void timeslot_tx_done();
+
+/**
+ * @brief Sets the Gazell channel table for the following timeslots.
+ *
+ * Gazell can only be reconfigured while it is disabled, which with timeslots only the timeslot callback knows, so the
+ * table is applied at the start of the next timeslot (an active timeslot is ended early for it). Must be called from
+ * a single thread.
+ *
+ * @param channels The channels.
+ * @param num_channels The number of channels.
+ *
+ * @retval 0 If successful.
+ * @retval -EINVAL If the table is empty or too long for Gazell.
+ */
+int timeslot_set_channel_table(const uint8_t *channels, uint32_t num_channels);
+
+/**
+ * @brief Sets the address of a Gazell pipe for the following timeslots.
+ *
+ * Applied at the start of the next timeslot like timeslot_set_channel_table(). Must be called from a single thread.
+ *
+ * @param pipe The pipe; 0 sets base address 0, 1 sets base address 1 (shared by pipes 1 to 7).
+ * @param address The base address (4 bytes, little-endian) followed by the prefix byte of the pipe.
+ *
+ * @retval 0 If successful.
+ * @retval -EINVAL If the pipe has no base address of its own.
+ */
+int timeslot_set_address(uint32_t pipe, const uint8_t address[5]);
+
+#else
+
+static inline int timeslot_init() {
+    return 0;
+}
+
+static inline int timeslot_send(uint32_t pipe, const uint8_t *data, uint32_t len, bool is_urgent) {
+    return -ENOTSUP;
+}
+
+static inline void timeslot_tx_done() {
+}
+
+static inline int timeslot_set_channel_table(const uint8_t *channels, uint32_t num_channels) {
+    return -ENOTSUP;
+}
+
+static inline int timeslot_set_address(uint32_t pipe, const uint8_t address[5]) {
+    return -ENOTSUP;
+}
+
+#endif  // CONFIG_APP_RADIO_TIMESLOTS
+
+#endif  // TIMESLOT_H
@@ -0,0 +1,67 @@
+#include "trace.h"
+
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+
+#if defined(CONFIG_SOC_FAMILY_NORDIC_NRF)
+#include <helpers/nrfx_ram_ctrl.h>
+#endif
+
+BUILD_ASSERT(sizeof(struct trace_record_t) == 12, "Trace record layout is part of the download format");
+BUILD_ASSERT(sizeof(struct trace_info_t) == 20, "Trace info layout is part of the download format");
+
+// Trace ring; placed in a section that is not cleared on startup
+__noinit struct trace_ring_t trace_ring;
+
+/*********************************************************************************************************************
+ * STARTUP HOOKS
+ *********************************************************************************************************************/
+static int init_trace_ring() {
+    // Keep the records of previous wake cycles unless the ring is corrupt (e.g. after a power-on reset)
+    if (trace_ring.magic != TRACE_MAGIC) {
+        memset(&trace_ring, 0, sizeof(trace_ring));
+        trace_ring.magic = TRACE_MAGIC;
+    }
+
+    trace_ring.boot++;
+
+#if defined(CONFIG_SOC_FAMILY_NORDIC_NRF)
+    // Keep the RAM section containing the trace ring powered in System OFF
+    nrfx_ram_ctrl_retention_enable_set(&trace_ring, sizeof(trace_ring), true);
+#endif
+
+    return 0;
+}
+
+SYS_INIT(init_trace_ring, PRE_KERNEL_1, 0);
+
+/*********************************************************************************************************************
+ * PUBLIC FUNCTIONS
+ *********************************************************************************************************************/
+void trace_get_info(struct trace_info_t *info) {
+    info->magic          = trace_ring.magic;
+    info->boot           = trace_ring.boot;
+    info->head           = (uint32_t)atomic_get(&trace_ring.head);
+    info->cycles_per_sec = sys_clock_hw_cycles_per_sec();
+    info->capacity       = TRACE_CAPACITY;
+    info->record_size    = sizeof(struct trace_record_t);
+}
+
+int trace_read(uint32_t seq, struct trace_record_t *records, int max_records, uint32_t *first_seq) {
+    uint32_t head   = (uint32_t)atomic_get(&trace_ring.head);
+    uint32_t oldest = head > TRACE_CAPACITY ? head - TRACE_CAPACITY : 0;
+
+    // Skip records that have already been overwritten
+    if (seq < oldest) {
+        seq = oldest;
+    }
+
+    int count = 0;
+    while (count < max_records && seq + count < head) {
+        records[count] = trace_ring.records[(seq + count) & (TRACE_CAPACITY - 1)];
+        count++;
+    }
+
+    *first_seq = seq;
+    return count;
+}
@@ -0,0 +1,153 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+// Modules that emit trace events; the numeric values are part of the download format and must not change
+enum trace_module_t {
+    TRACE_MOD_SYSTEM  = 0,
+    TRACE_MOD_BUTTONS = 1,
+    TRACE_MOD_LEDS    = 2,
+    TRACE_MOD_SPEAKER = 3,
+    TRACE_MOD_BATTERY = 4,
+    TRACE_MOD_CONFIG  = 5,
+    TRACE_MOD_BLE     = 6,
+    TRACE_MOD_RADIO   = 7,
+};
+
+// Trace events of all modules; the numeric values are part of the download format and must not change
+enum trace_event_t {
+    // TRACE_MOD_SYSTEM
+    TRACE_EVT_BOOT     = 0,  // arg: 1 if the retained state survived, 0 otherwise
+    TRACE_EVT_POWEROFF = 1,  // arg: 0
+    TRACE_EVT_ERROR    = 2,  // arg: negative error code
+
+    // TRACE_MOD_BUTTONS
+    TRACE_EVT_BUTTON_PRESSED = 0,  // arg: button index
+    TRACE_EVT_BUTTON_EVENT   = 1,  // arg: button index | long press << 8 | preceding short shift presses << 16
+
+    // TRACE_MOD_LEDS
+    TRACE_EVT_LEDS_ENABLED       = 0,  // arg: 0
+    TRACE_EVT_LEDS_DISABLED      = 1,  // arg: 0
+    TRACE_EVT_LEDS_PATTERN_START = 2,  // arg: led | pattern << 8 | repetitions << 16
+
+    // TRACE_MOD_SPEAKER
+    TRACE_EVT_SPEAKER_MELODY_START = 0,  // arg: melody
+    TRACE_EVT_SPEAKER_MELODY_STOP  = 1,  // arg: 1 if aborted, 0 if finished
+
+    // TRACE_MOD_BATTERY
+    TRACE_EVT_BATTERY_SAMPLE = 0,  // arg: raw ADC value
+
+    // TRACE_MOD_CONFIG
+    TRACE_EVT_CONFIG_LOAD = 0,  // arg: 1 if loaded from NVS, 0 if from the retained state
+    TRACE_EVT_CONFIG_SAVE = 1,  // arg: result of the NVS write
+
+    // TRACE_MOD_BLE
+    TRACE_EVT_BLE_CONNECTED    = 0,  // arg: error code
+    TRACE_EVT_BLE_DISCONNECTED = 1,  // arg: HCI reason
+    TRACE_EVT_BLE_CONN_PARAMS  = 2,  // arg: connection interval in us
+
+    // TRACE_MOD_RADIO
+    TRACE_EVT_RADIO_TX_QUEUED     = 0,   // arg: packet counter
+    TRACE_EVT_RADIO_TX_OK         = 1,   // arg: TX attempts | channel switches << 16
+    TRACE_EVT_RADIO_TX_FAILED     = 2,   // arg: TX attempts | channel switches << 16
+    TRACE_EVT_RADIO_FIRST_PACKET  = 3,   // arg: ms since startup | warm start (channel cached) << 31
+    TRACE_EVT_RADIO_PAIRED        = 4,   // arg: error code
+    TRACE_EVT_RADIO_BACKOFF       = 5,   // arg: backoff in receiver cycles before the next try
+    TRACE_EVT_RADIO_TX_POWER      = 6,   // arg: TX power in dBm (signed) | ack RSSI in dBm (signed) << 16
+    TRACE_EVT_RADIO_TIMESLOT      = 7,   // arg: us from the request to the start of the timeslot | high priority << 31
+    TRACE_EVT_RADIO_COMMAND       = 8,   // arg: command ID | error code << 16
+    TRACE_EVT_RADIO_JOURNAL_FLUSH = 9,   // arg: number of records written to flash, or negative error code
+    TRACE_EVT_RADIO_JOURNAL_DROP  = 10,  // arg: 0; the oldest journal sector was dropped to make room
+};
+
+// A single trace record as stored in the ring and downloaded over BLE (little-endian, 12 bytes)
+struct trace_record_t {
+    uint32_t timestamp;  // Hardware cycle counter (k_cycle_get_32()) at the time of the event
+    uint16_t boot;       // Wake cycle in which the event was recorded (lower 16 bits of the boot counter)
+    uint8_t module;      // enum trace_module_t
+    uint8_t event;       // enum trace_event_t
+    uint32_t arg;        // Event-specific argument
+};
+
+// Header of the trace ring as downloaded over BLE (little-endian, 20 bytes)
+struct trace_info_t {
+    uint32_t magic;           // TRACE_MAGIC
+    uint32_t boot;            // Boot counter of the current wake cycle
+    uint32_t head;            // Total number of records written (the newest record is head - 1)
+    uint32_t cycles_per_sec;  // Frequency of the timestamps
+    uint16_t capacity;        // Number of records in the ring
+    uint16_t record_size;     // sizeof(struct trace_record_t)
+};
+
+#define TRACE_MAGIC 0x54524331  // "TRC1"
+
+#if defined(CONFIG_APP_TRACE)
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+
+#define TRACE_CAPACITY BIT(CONFIG_APP_TRACE_RECORDS_LOG2)
+
+// The trace ring; placed in a section that is not cleared on startup and retained in System OFF
+struct trace_ring_t {
+    uint32_t magic;
+    uint32_t boot;
+    atomic_t head;
+    struct trace_record_t records[TRACE_CAPACITY];
+};
+
+extern struct trace_ring_t trace_ring;
+
+/**
+ * @brief Records a trace event.
+ *
+ * This is lock-free and can be called from any context, including ISRs. The newest records overwrite the oldest
+ * ones once the ring is full. A record that is overwritten concurrently with a download may be torn.
+ *
+ * @param module The module emitting the event.
+ * @param event The event.
+ * @param arg Event-specific argument.
+ */
+static inline void trace(enum trace_module_t module, enum trace_event_t event, uint32_t arg) {
+    uint32_t idx                  = (uint32_t)atomic_inc(&trace_ring.head) & (TRACE_CAPACITY - 1);
+    struct trace_record_t *record = &trace_ring.records[idx];
+
+    record->timestamp = k_cycle_get_32();
+    record->boot      = (uint16_t)trace_ring.boot;
+    record->module    = (uint8_t)module;
+    record->event     = (uint8_t)event;
+    record->arg       = arg;
+}
+
+/**
+ * @brief Returns the header of the trace ring.
+ *
+ * @param info Pointer to the header structure to fill.
+ */
+void trace_get_info(struct trace_info_t *info);
+
+/**
+ * @brief Copies trace records out of the ring.
+ *
+ * Records are addressed by their sequence number, i.e. the value of the head when they were written. Records that
+ * have already been overwritten are skipped, so the first copied record may have a higher sequence number than
+ * requested.
+ *
+ * @param seq Sequence number of the first record to copy.
+ * @param records Buffer to copy the records to.
+ * @param max_records Maximum number of records to copy.
+ * @param first_seq Filled with the sequence number of the first copied record.
+ *
+ * @return Number of copied records.
+ */
+int trace_read(uint32_t seq, struct trace_record_t *records, int max_records, uint32_t *first_seq);
+
+#else
+
+static inline void trace(enum trace_module_t module, enum trace_event_t event, uint32_t arg) {
+}
+
+#endif  // CONFIG_APP_TRACE
+
+#endif  // TRACE_H
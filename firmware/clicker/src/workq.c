@@ -0,0 +1,27 @@
+#include "workq.h"
+
+#include <zephyr/init.h>
+
+// Thread configuration; the priority is lower than the buttons thread, so that button presses are never delayed by
+// work items (e.g. I2C transfers to the LED driver)
+#define THREAD_STACK_SIZE 1536
+#define THREAD_PRIORITY   7
+
+// Work queue and its stack
+K_THREAD_STACK_DEFINE(workq_stack, THREAD_STACK_SIZE);
+
+struct k_work_q workq;
+
+/*********************************************************************************************************************
+ * STARTUP HOOKS
+ *********************************************************************************************************************/
+static int start_workq() {
+    const struct k_work_queue_config cfg = {
+        .name = "app_workq",
+    };
+
+    k_work_queue_start(&workq, workq_stack, K_THREAD_STACK_SIZEOF(workq_stack), THREAD_PRIORITY, &cfg);
+    return 0;
+}
+
+SYS_INIT(start_workq, POST_KERNEL, 0);
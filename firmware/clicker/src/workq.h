@@ -0,0 +1,18 @@
+#ifndef WORKQ_H
+#define WORKQ_H
+
+#include <zephyr/kernel.h>
+
+/**
+ * @brief Work queue shared by the LEDs, speaker, feedback, battery, idle, radio and journal modules and the battery
+ * service (the bulk transfer service sends on the system work queue).
+ *
+ * All handlers submitted to this queue run in the same thread, so they must not block for longer than a few
+ * milliseconds: flash writes and erases, BLE notifications that wait for buffers and other blocking calls delay the
+ * feedback and the radio of every other module. The journal and the packet counter write the flash on the flash work
+ * queue instead (see flashq.h). Since the handlers never run concurrently, state that is only
+ * accessed from handlers does not need any locking.
+ */
+extern struct k_work_q workq;
+
+#endif  // WORKQ_H
@@ -0,0 +1,75 @@
+#include "buttons.h"
+#include "config.h"
+#include "leds.h"
+#include "profiling.h"
+#include "sim_board.h"
+#include "speaker.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+
+// Number of measurements per profiling point; the statistics are printed once all tests have run (see teardown())
+#define ITERATIONS 50
+
+// Time for a pattern to be started (the boost converter of the LED driver takes 1 ms to settle)
+#define START_DELAY K_MSEC(20)
+
+static K_SEM_DEFINE(finished_sem, 0, 1);
+
+/*********************************************************************************************************************
+ * HELPERS
+ *********************************************************************************************************************/
+static void on_finished(bool aborted) {
+    k_sem_give(&finished_sem);
+}
+
+/*********************************************************************************************************************
+ * TESTS
+ *********************************************************************************************************************/
+ZTEST(benchmarks, test_start_animation) {
+    // Each pattern aborts the previous one, so every iteration reconfigures the driver from scratch
+    for (int i = 0; i < ITERATIONS; i++) {
+        zassert_ok(leds_play(i % 2 ? LEDS_D1 : LEDS_D2, i % 3 ? LEDS_FLASH : LEDS_BREATHE, LEDS_RGB(i, 255 - i, 128),
+                             -1, NULL));
+        k_sleep(START_DELAY);
+    }
+
+    zassert_ok(leds_off());
+    k_sleep(START_DELAY);
+}
+
+ZTEST(benchmarks, test_set_speaker_frequency) {
+    // Every note, rest and the final silence changes the frequency
+    for (int i = 0; i < ITERATIONS / 10; i++) {
+        zassert_ok(speaker_play(SPEAKER_MELODY_LOW_BATTERY, on_finished));
+        zassert_ok(k_sem_take(&finished_sem, K_SECONDS(5)));
+    }
+}
+
+ZTEST(benchmarks, test_button_scan) {
+    // Only the scan after the press edge is measured; the release is checked on the pressed button only
+    for (int i = 0; i < ITERATIONS; i++) {
+        enum buttons_button_t button = i % BUTTONS_BTN_SHIFT;
+        zassert_ok(sim_board_set_button(button, true));
+        k_msleep(5);
+        zassert_ok(sim_board_set_button(button, false));
+
+        struct buttons_event_t event;
+        zassert_ok(buttons_get_event(&event, K_MSEC(50)));
+        zassert_equal(event.button, button);
+    }
+}
+
+ZTEST(benchmarks, test_config_save) {
+    struct config_t config = {0};
+    for (int i = 0; i < ITERATIONS; i++) {
+        config.gazell_host_id[0] = i;
+        zassert_ok(config_save(&config));
+    }
+}
+
+static void teardown(void *fixture) {
+    profiling_dump();
+}
+
+ZTEST_SUITE(benchmarks, NULL, NULL, NULL, NULL, teardown);
@@ -0,0 +1,146 @@
+#include "buttons.h"
+#include "sim_board.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+
+// Long press thresholds of the buttons module (see buttons.c)
+#define LONG_PRESS_MS           2000
+#define LONG_PRESS_ON_WAKEUP_MS 1500
+
+// Time to wait for an event that is due
+#define EVENT_TIMEOUT K_MSEC(50)
+
+// First event after startup, taken before the tests run (see setup())
+static struct buttons_event_t boot_event;
+static bool has_boot_event;
+
+/*********************************************************************************************************************
+ * HELPERS
+ *********************************************************************************************************************/
+static void press(enum buttons_button_t button, int duration_ms) {
+    zassert_ok(sim_board_set_button(button, true));
+    k_msleep(duration_ms);
+    zassert_ok(sim_board_set_button(button, false));
+    k_msleep(10);
+}
+
+static void assert_event(enum buttons_button_t button, bool is_long_press, int preceding_short_shift_presses) {
+    struct buttons_event_t event;
+    zassert_ok(buttons_get_event(&event, EVENT_TIMEOUT), "No event for button %d", button + 1);
+
+    zassert_equal(event.button, button);
+    zassert_equal(event.is_long_press, is_long_press);
+    zassert_equal(event.preceding_short_shift_presses, preceding_short_shift_presses);
+}
+
+static void assert_no_event() {
+    struct buttons_event_t event;
+    zassert_equal(buttons_get_event(&event, EVENT_TIMEOUT), -ETIMEDOUT, "Unexpected event for button %d",
+                  event.button + 1);
+}
+
+/*********************************************************************************************************************
+ * TESTS
+ *********************************************************************************************************************/
+ZTEST(buttons, test_short_press) {
+    uint32_t press_ms = k_uptime_get_32();
+    press(BUTTONS_BTN_1, 100);
+
+    struct buttons_event_t event;
+    zassert_ok(buttons_get_event(&event, EVENT_TIMEOUT));
+    zassert_equal(event.button, BUTTONS_BTN_1);
+    zassert_false(event.is_long_press);
+    zassert_equal(event.preceding_short_shift_presses, 0);
+
+    // The press time is taken on the press, not on the release that generates the event
+    zassert_within(event.uptime_ms, press_ms, 2, "Press at %u ms reported at %u ms", press_ms, event.uptime_ms);
+
+    assert_no_event();
+}
+
+ZTEST(buttons, test_long_press) {
+    zassert_ok(sim_board_set_button(BUTTONS_BTN_2, true));
+
+    // The event is generated when the threshold expires, while the button is still held
+    struct buttons_event_t event;
+    zassert_equal(buttons_get_event(&event, K_MSEC(LONG_PRESS_MS - 50)), -ETIMEDOUT);
+    zassert_ok(buttons_get_event(&event, K_MSEC(100)));
+    zassert_equal(event.button, BUTTONS_BTN_2);
+    zassert_true(event.is_long_press);
+
+    // Releasing the button afterwards generates no further event
+    k_msleep(500);
+    zassert_ok(sim_board_set_button(BUTTONS_BTN_2, false));
+    assert_no_event();
+}
+
+ZTEST(buttons, test_shift_counting) {
+    press(BUTTONS_BTN_SHIFT, 50);
+    press(BUTTONS_BTN_SHIFT, 50);
+    press(BUTTONS_BTN_3, 50);
+    press(BUTTONS_BTN_3, 50);
+
+    // Each event carries the number of short shift presses right before it
+    assert_event(BUTTONS_BTN_SHIFT, false, 0);
+    assert_event(BUTTONS_BTN_SHIFT, false, 1);
+    assert_event(BUTTONS_BTN_3, false, 2);
+    assert_event(BUTTONS_BTN_3, false, 0);
+}
+
+ZTEST(buttons, test_long_shift_resets_count) {
+    press(BUTTONS_BTN_SHIFT, 50);
+    press(BUTTONS_BTN_SHIFT, LONG_PRESS_MS + 100);
+    press(BUTTONS_BTN_4, 50);
+
+    assert_event(BUTTONS_BTN_SHIFT, false, 0);
+    assert_event(BUTTONS_BTN_SHIFT, true, 1);
+    assert_event(BUTTONS_BTN_4, false, 0);
+}
+
+ZTEST(buttons, test_one_button_at_a_time) {
+    // A second button pressed while the first one is held is ignored
+    zassert_ok(sim_board_set_button(BUTTONS_BTN_1, true));
+    k_msleep(50);
+    press(BUTTONS_BTN_5, 50);
+    zassert_ok(sim_board_set_button(BUTTONS_BTN_1, false));
+    k_msleep(10);
+
+    assert_event(BUTTONS_BTN_1, false, 0);
+    assert_no_event();
+}
+
+ZTEST(buttons, test_wakeup_latch) {
+    if (CONFIG_APP_SIM_WAKEUP_BUTTON == 0) {
+        ztest_test_skip();
+    }
+
+    // The button that woke the device up is reported once it is released, which the simulated board does right away;
+    // its press counts from the start of the clock
+    zassert_true(has_boot_event, "No event for the wake-up button");
+    zassert_equal(boot_event.button, CONFIG_APP_SIM_WAKEUP_BUTTON - 1);
+    zassert_false(boot_event.is_long_press);
+    zassert_equal(boot_event.uptime_ms, 0);
+}
+
+ZTEST(buttons, test_no_wakeup_latch) {
+    if (CONFIG_APP_SIM_WAKEUP_BUTTON != 0) {
+        ztest_test_skip();
+    }
+
+    zassert_false(has_boot_event, "Event for button %d after a power-on reset", boot_event.button + 1);
+}
+
+static void *setup() {
+    has_boot_event = buttons_get_event(&boot_event, K_MSEC(100)) == 0;
+    return NULL;
+}
+
+static void before_each(void *fixture) {
+    // Drop the events that a failed test left behind
+    struct buttons_event_t event;
+    while (buttons_get_event(&event, K_NO_WAIT) == 0) {
+    }
+}
+
+ZTEST_SUITE(buttons, NULL, setup, before_each, NULL, NULL);
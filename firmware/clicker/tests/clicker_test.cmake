@@ -0,0 +1,25 @@
+# Common setup of the clicker test suites: the suites build the application modules they test (never src/main.c)
+# for native_sim with the emulated peripherals of the application (see boards/native_sim.overlay). Include this file
+# before find_package(Zephyr) and use CLICKER_DIR for the paths of the sources.
+
+set(CLICKER_DIR ${CMAKE_CURRENT_LIST_DIR}/..)
+
+set(KCONFIG_ROOT ${CLICKER_DIR}/Kconfig)
+list(APPEND DTS_ROOT ${CLICKER_DIR})
+set(DTC_OVERLAY_FILE ${CLICKER_DIR}/boards/native_sim.overlay)
+list(APPEND EXTRA_CONF_FILE ${CLICKER_DIR}/boards/native_sim.conf)
+
+# Include directories of the application; called after find_package(Zephyr)
+macro(clicker_test_setup)
+    target_include_directories(app PRIVATE
+        ${CLICKER_DIR}/src
+        ${CLICKER_DIR}/sim
+        ${CLICKER_DIR}/../common
+    )
+
+    target_sources(app PRIVATE
+        ${CLICKER_DIR}/sim/lp5813_emul.c
+        ${CLICKER_DIR}/sim/pwm_capture_emul.c
+        ${CLICKER_DIR}/sim/sim_board.c
+    )
+endmacro()
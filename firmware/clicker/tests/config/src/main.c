@@ -0,0 +1,101 @@
+#include "config.h"
+#include "retained.h"
+
+#include <string.h>
+#include <zephyr/ztest.h>
+
+// A configuration as written by the pairing; every byte differs from the default (all zeros)
+static const struct config_t paired_config = {
+    .gazell_secret_key      = {0x01, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+                               0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff},
+    .gazell_pairing_addr    = {0x01, 0x02, 0x03, 0x04, 0x05},
+    .gazell_packet_valid_id = {0x10, 0x20, 0x30},
+    .gazell_system_addr     = {0xa1, 0xa2, 0xa3, 0xa4, 0xa5},
+    .gazell_host_id         = {0xb1, 0xb2, 0xb3, 0xb4, 0xb5},
+};
+
+/*********************************************************************************************************************
+ * HELPERS
+ *********************************************************************************************************************/
+static void forget_retained_copy() {
+    retained.config_valid = false;
+    memset(&retained.config, 0, sizeof(retained.config));
+    retained_update();
+}
+
+/*********************************************************************************************************************
+ * TESTS
+ *********************************************************************************************************************/
+ZTEST(config, test_save_load) {
+    zassert_ok(config_save(&paired_config));
+
+    // The saved configuration is kept in retained RAM as well
+    zassert_true(retained.config_valid);
+    zassert_mem_equal(&retained.config, &paired_config, sizeof(paired_config));
+
+    struct config_t config;
+    zassert_ok(config_load(&config));
+    zassert_mem_equal(&config, &paired_config, sizeof(config));
+}
+
+ZTEST(config, test_load_from_flash) {
+    zassert_ok(config_save(&paired_config));
+
+    // Without the copy in retained RAM (e.g. after a power-on reset), the configuration is read from the flash
+    forget_retained_copy();
+
+    struct config_t config;
+    memset(&config, 0, sizeof(config));
+    zassert_ok(config_load(&config));
+    zassert_mem_equal(&config, &paired_config, sizeof(config));
+
+    zassert_true(retained.config_valid);
+    zassert_mem_equal(&retained.config, &paired_config, sizeof(paired_config));
+}
+
+ZTEST(config, test_overwrite) {
+    struct config_t changed = paired_config;
+    changed.gazell_host_id[0] ^= 0xff;
+
+    zassert_ok(config_save(&paired_config));
+    zassert_ok(config_save(&changed));
+    forget_retained_copy();
+
+    struct config_t config;
+    zassert_ok(config_load(&config));
+    zassert_mem_equal(&config, &changed, sizeof(config));
+}
+
+ZTEST(config, test_verify) {
+    zassert_ok(config_save(&paired_config));
+    zassert_ok(config_verify(&paired_config));
+
+    // The verification reads the flash, so it is not fooled by the copy in retained RAM
+    struct config_t changed = paired_config;
+    changed.gazell_secret_key[15] ^= 0x01;
+    retained.config = changed;
+    retained_update();
+
+    zassert_equal(config_verify(&changed), -EIO);
+}
+
+ZTEST(config, test_radio_counter) {
+    zassert_ok(config_save_radio_counter(1024));
+
+    uint32_t counter = 0;
+    zassert_ok(config_load_radio_counter(&counter));
+    zassert_equal(counter, 1024);
+
+    // The counter is a separate entry, so saving the configuration leaves it alone
+    zassert_ok(config_save(&paired_config));
+    zassert_ok(config_save_radio_counter(2048));
+    zassert_ok(config_load_radio_counter(&counter));
+    zassert_equal(counter, 2048);
+
+    struct config_t config;
+    forget_retained_copy();
+    zassert_ok(config_load(&config));
+    zassert_mem_equal(&config, &paired_config, sizeof(config));
+}
+
+ZTEST_SUITE(config, NULL, NULL, NULL, NULL, NULL);
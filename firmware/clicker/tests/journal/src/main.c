@@ -0,0 +1,271 @@
+#include "flashq.h"
+#include "journal.h"
+#include "retained.h"
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/storage/flash_map.h>
+#include <zephyr/ztest.h>
+
+// Same as in journal.c
+#define JOURNAL_PARTITION_ID FIXED_PARTITION_ID(journal_partition)
+#define MAX_BATCH_GAP_MS     (PACKET_EVENT_MAX_DELTA * PACKET_EVENT_TIME_UNIT_MS)
+
+// Copy of the journal partition (see journal.overlay)
+static uint8_t partition_buf[FIXED_PARTITION_SIZE(journal_partition)];
+
+// Interval between the events added by the tests
+#define EVENT_INTERVAL_MS 100
+
+// Calls of the ready callback of the journal (on the flash work queue)
+static atomic_t num_ready;
+
+// Holds up the flash work queue until unblock_sem is given (see block_flashq())
+static K_SEM_DEFINE(unblock_sem, 0, 1);
+
+static void blocker_work_fn(struct k_work *work) {
+    k_sem_take(&unblock_sem, K_FOREVER);
+}
+
+K_WORK_DEFINE(blocker_work, blocker_work_fn);
+
+/*********************************************************************************************************************
+ * HELPERS
+ *********************************************************************************************************************/
+static void on_ready() {
+    atomic_inc(&num_ready);
+}
+
+static void wait_for_flashq() {
+    k_work_queue_drain(&flashq, false);
+}
+
+static void block_flashq() {
+    k_work_submit_to_queue(&flashq, &blocker_work);
+}
+
+static void unblock_flashq() {
+    k_sem_give(&unblock_sem);
+    wait_for_flashq();
+}
+
+// Adds events for the buttons 1, 2, 3, ... that happened EVENT_INTERVAL_MS apart, the last one right now
+static void add_events(int num_events) {
+    uint32_t now = k_uptime_get_32();
+    for (int i = 0; i < num_events; i++) {
+        struct buttons_event_t event = {
+            .button    = i % BUTTONS_BTN_SHIFT,
+            .uptime_ms = now - (num_events - 1 - i) * EVENT_INTERVAL_MS,
+        };
+
+        zassert_ok(journal_add(&event), "event %d", i);
+    }
+}
+
+static void add_event_at(uint32_t uptime_ms) {
+    struct buttons_event_t event = {.uptime_ms = uptime_ms};
+    zassert_ok(journal_add(&event));
+}
+
+static void get_batch(struct journal_batch_t *batch) {
+    // The shared work queue would retry on the ready callback; the tests wait for the flash work instead
+    wait_for_flashq();
+    zassert_ok(journal_get_batch(batch));
+}
+
+static void ack_batch(const struct journal_batch_t *batch) {
+    journal_ack(batch);
+    wait_for_flashq();
+}
+
+// Delivers the journal batch by batch and returns the number of events; the IDs must follow each other from first_id
+static int deliver_all(uint32_t first_id) {
+    int num_events = 0;
+    struct journal_batch_t batch;
+    for (get_batch(&batch); batch.num_events > 0; get_batch(&batch)) {
+        zassert_equal(batch.first_id, first_id + num_events, "batch after %d events", num_events);
+        num_events += batch.num_events;
+        ack_batch(&batch);
+    }
+
+    // Asking for a batch once everything has been delivered erases the rest of the partition
+    wait_for_flashq();
+    return num_events;
+}
+
+// Adds JOURNAL_FLUSH_SIZE events, lets them be written to flash and returns their records
+static void flush_events(struct journal_record_t *records) {
+    block_flashq();
+    add_events(JOURNAL_FLUSH_SIZE);
+    memcpy(records, retained.journal_staged, JOURNAL_FLUSH_SIZE * sizeof(*records));
+    unblock_flashq();
+}
+
+// Looks for the record anywhere in the journal partition, so the test does not depend on the FCB layout
+static bool is_in_flash(const struct journal_record_t *record) {
+    const struct flash_area *fa;
+    zassert_ok(flash_area_open(JOURNAL_PARTITION_ID, &fa));
+    zassert_ok(flash_area_read(fa, 0, partition_buf, sizeof(partition_buf)));
+    flash_area_close(fa);
+
+    for (size_t offset = 0; offset + sizeof(*record) <= sizeof(partition_buf); offset++) {
+        if (memcmp(&partition_buf[offset], record, sizeof(*record)) == 0) return true;
+    }
+
+    return false;
+}
+
+/*********************************************************************************************************************
+ * TESTS
+ *********************************************************************************************************************/
+ZTEST(journal, test_stage_while_link_down) {
+    uint32_t first_id = retained.journal_next_id;
+    add_events(5);
+    wait_for_flashq();
+
+    // Fewer than JOURNAL_FLUSH_SIZE events stay in retained RAM
+    zassert_true(journal_has_events());
+    zassert_equal(retained.journal_num_staged, 5);
+    zassert_false(retained.journal_in_flash);
+    zassert_equal(atomic_get(&num_ready), 0, "Staging must not touch the flash");
+
+    // The oldest events come first, with their ages relative to the newest one of the batch
+    struct journal_batch_t batch;
+    get_batch(&batch);
+    zassert_equal(batch.first_id, first_id);
+    zassert_equal(batch.num_events, PACKET_MAX_REPLAY_EVENTS);
+    zassert_within(batch.age_ms, EVENT_INTERVAL_MS, PACKET_EVENT_TIME_UNIT_MS);
+    for (int i = 0; i < batch.num_events; i++) {
+        zassert_equal(batch.events[i].button, i, "event %d", i);
+        zassert_equal(batch.events[i].age_ms, (batch.num_events - 1 - i) * EVENT_INTERVAL_MS, "event %d", i);
+    }
+
+    // Acking removes the delivered events from the staging buffer
+    ack_batch(&batch);
+    zassert_equal(retained.journal_num_staged, 5 - PACKET_MAX_REPLAY_EVENTS);
+    zassert_equal(deliver_all(first_id + PACKET_MAX_REPLAY_EVENTS), 5 - PACKET_MAX_REPLAY_EVENTS);
+    zassert_false(journal_has_events());
+}
+
+ZTEST(journal, test_flush) {
+    struct journal_record_t records[JOURNAL_FLUSH_SIZE];
+    flush_events(records);
+
+    // The staged events have been written as one entry on the flash work queue
+    zassert_equal(retained.journal_num_staged, 0);
+    zassert_true(retained.journal_in_flash);
+    zassert_true(atomic_get(&num_ready) > 0);
+    for (int i = 0; i < JOURNAL_FLUSH_SIZE; i++) {
+        zassert_true(is_in_flash(&records[i]), "record %d", i);
+    }
+
+    // They come back from the flash in order
+    zassert_equal(deliver_all(records[0].id), JOURNAL_FLUSH_SIZE);
+    zassert_false(journal_has_events());
+}
+
+ZTEST(journal, test_stage_while_flushing) {
+    uint32_t first_id = retained.journal_next_id;
+
+    // While the flush waits for the flash work queue, the spare slots of the staging buffer take new events
+    block_flashq();
+    add_events(JOURNAL_STAGING_SIZE);
+    zassert_equal(retained.journal_num_staged, JOURNAL_STAGING_SIZE);
+
+    struct buttons_event_t event = {0};
+    zassert_equal(journal_add(&event), -ENOMEM, "The staging buffer must not overflow");
+
+    // Only JOURNAL_FLUSH_SIZE events go into the entry; the others stay staged
+    unblock_flashq();
+    zassert_equal(retained.journal_num_staged, JOURNAL_STAGING_SIZE - JOURNAL_FLUSH_SIZE);
+    zassert_true(retained.journal_in_flash);
+
+    // The events in flash and the staged ones follow each other without gaps or duplicates
+    zassert_equal(deliver_all(first_id), JOURNAL_STAGING_SIZE);
+}
+
+ZTEST(journal, test_batch_split_at_gap) {
+    uint32_t first_id = retained.journal_next_id;
+    uint32_t now      = k_uptime_get_32();
+
+    // The delta times of the packet format cannot express the gap before the last event
+    add_event_at(now - MAX_BATCH_GAP_MS - 200);
+    add_event_at(now - MAX_BATCH_GAP_MS - 100);
+    add_event_at(now);
+
+    struct journal_batch_t batch;
+    get_batch(&batch);
+    zassert_equal(batch.first_id, first_id);
+    zassert_equal(batch.num_events, 2);
+    zassert_equal(batch.events[0].age_ms, 100);
+    ack_batch(&batch);
+
+    get_batch(&batch);
+    zassert_equal(batch.first_id, first_id + 2);
+    zassert_equal(batch.num_events, 1);
+    ack_batch(&batch);
+
+    zassert_equal(deliver_all(first_id + 3), 0);
+}
+
+ZTEST(journal, test_batch_split_at_wake_cycle) {
+    uint32_t first_id = retained.journal_next_id;
+    add_events(2);
+
+    // Uptimes of an earlier wake cycle mean nothing now, so those events go in a batch of their own without ages
+    zassert_ok(journal_init(0, on_ready));
+    add_events(2);
+
+    struct journal_batch_t batch;
+    get_batch(&batch);
+    zassert_equal(batch.first_id, first_id);
+    zassert_equal(batch.num_events, 2);
+    zassert_equal(batch.age_ms, PACKET_AGE_UNKNOWN);
+    zassert_equal(batch.events[0].age_ms, 0);
+    ack_batch(&batch);
+
+    get_batch(&batch);
+    zassert_equal(batch.first_id, first_id + 2);
+    zassert_equal(batch.num_events, 2);
+    zassert_not_equal(batch.age_ms, PACKET_AGE_UNKNOWN);
+    zassert_equal(batch.events[0].age_ms, EVENT_INTERVAL_MS);
+    ack_batch(&batch);
+
+    zassert_equal(deliver_all(first_id + 4), 0);
+}
+
+ZTEST(journal, test_ack_erases_sector) {
+    struct journal_record_t records[JOURNAL_FLUSH_SIZE];
+    flush_events(records);
+
+    // The sector still holds events that have not been delivered
+    struct journal_batch_t batch;
+    get_batch(&batch);
+    ack_batch(&batch);
+    zassert_true(retained.journal_in_flash);
+    zassert_true(is_in_flash(&records[0]));
+
+    // Once the last event of the sector has been acked, the sector is erased on the flash work queue
+    zassert_equal(deliver_all(records[batch.num_events].id), JOURNAL_FLUSH_SIZE - batch.num_events);
+    zassert_false(retained.journal_in_flash);
+    for (int i = 0; i < JOURNAL_FLUSH_SIZE; i++) {
+        zassert_false(is_in_flash(&records[i]), "record %d", i);
+    }
+}
+
+static void *setup() {
+    // Events are added with uptimes up to a few seconds in the past
+    k_sleep(K_SECONDS(MAX_BATCH_GAP_MS / 1000 + 2));
+    zassert_ok(journal_init(0, on_ready));
+    return NULL;
+}
+
+static void before_each(void *fixture) {
+    // Deliver whatever a failed test left behind and start a new wake cycle
+    k_sem_reset(&unblock_sem);
+    deliver_all(retained.journal_replay_id);
+    zassert_ok(journal_init(0, on_ready));
+    atomic_set(&num_ready, 0);
+}
+
+ZTEST_SUITE(journal, NULL, setup, before_each, NULL, NULL);
@@ -0,0 +1,256 @@
+#include "leds.h"
+#include "lp5813_emul.h"
+
+#include <string.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+
+// LP5813 emulator and its EN pin (see boards/native_sim.overlay)
+static const struct emul *lp5813         = EMUL_DT_GET(DT_NODELABEL(lp5813));
+static const struct gpio_dt_spec en_gpio = GPIO_DT_SPEC_GET(DT_NODELABEL(lp5813_en), gpios);
+
+// Indices of the emulator LEDs (channels) that make up the RGB LEDs of the board (A0..A2 and B0..B2, see leds.c)
+static const int d1_channels[] = {4, 5, 6};
+static const int d2_channels[] = {7, 8, 9};
+
+// Bus traffic of starting a pattern while the LED driver is off; the budget is exact, so that additional transfers
+// show up as a test failure (update it together with leds.c if the extra traffic is intended)
+//
+//   enabling the driver:  14 register writes (CHIP_EN, DEV_CONFIG_0..4, DEV_CONFIG_12, CMD_UPDATE, 6 x AUTO_DC) of
+//                         2 bytes each and a read of TSD_CONFIG_STATUS (1 byte written, 1 byte read)
+//   starting the pattern: CMD_STOP, 3 bursts of 10 animation registers (11 bytes each), a burst of the 2 LED_EN
+//                         registers (3 bytes), CMD_UPDATE and CMD_START
+#define PATTERN_START_TRANSFERS     (15 + 7)
+#define PATTERN_START_BYTES_WRITTEN (14 * 2 + 1 + 2 + 3 * 11 + 3 + 2 + 2)
+#define PATTERN_START_BYTES_READ    1
+
+// Time to wait for a pattern to be started (the boost converter of the LED driver takes 1 ms to settle)
+#define START_DELAY K_MSEC(20)
+
+static K_SEM_DEFINE(finished_sem, 0, 1);
+static bool finished_aborted;
+
+// Callbacks of queued commands in the order they were called, as 'A'..'C' for finished and 'a'..'c' for aborted
+static char sequence[8];
+static atomic_t sequence_len;
+
+/*********************************************************************************************************************
+ * HELPERS
+ *********************************************************************************************************************/
+static void on_finished(bool aborted) {
+    finished_aborted = aborted;
+    k_sem_give(&finished_sem);
+}
+
+static void record(char id, bool aborted) {
+    int i = atomic_inc(&sequence_len);
+    if (i < ARRAY_SIZE(sequence) - 1) {
+        sequence[i] = aborted ? id - 'A' + 'a' : id;
+    }
+}
+
+static void on_finished_a(bool aborted) {
+    record('A', aborted);
+}
+
+static void on_finished_b(bool aborted) {
+    record('B', aborted);
+}
+
+static void on_finished_c(bool aborted) {
+    record('C', aborted);
+    on_finished(aborted);
+}
+
+static bool is_led_driver_enabled() {
+    return gpio_emul_output_get(en_gpio.port, en_gpio.pin) == 1;
+}
+
+static void assert_channel_disabled(const int *channels) {
+    for (int i = 0; i < 3; i++) {
+        struct lp5813_emul_anim_t anim;
+        zassert_ok(lp5813_emul_get_anim(lp5813, channels[i], &anim));
+        zassert_false(anim.enabled, "Channel %d is enabled", channels[i]);
+    }
+}
+
+/*********************************************************************************************************************
+ * TESTS
+ *********************************************************************************************************************/
+ZTEST(leds, test_flash_matches_request) {
+    const uint8_t rgb[] = {10, 20, 30};
+    zassert_ok(leds_play(LEDS_D1, LEDS_FLASH, LEDS_RGB(rgb[0], rgb[1], rgb[2]), 3, on_finished));
+    k_sleep(START_DELAY);
+
+    for (int i = 0; i < 3; i++) {
+        struct lp5813_emul_anim_t anim;
+        zassert_ok(lp5813_emul_get_anim(lp5813, d1_channels[i], &anim));
+
+        zassert_true(anim.enabled);
+        zassert_true(anim.running);
+        zassert_equal(anim.num_aeus, 1);
+        zassert_equal(anim.reps, 3);
+        zassert_equal(anim.aeu_reps[0], 1);
+
+        // On for half the period at the full brightness, then off
+        const uint8_t pwm[] = {0, rgb[i], rgb[i], 0, 0};
+        zassert_mem_equal(anim.pwm[0], pwm, sizeof(pwm));
+        zassert_equal(anim.t_ms[0][0], 0);
+        zassert_equal(anim.t_ms[0][1], LEDS_PATTERN_PERIOD_MS / 2);
+        zassert_equal(anim.t_ms[0][2], 0);
+        zassert_equal(anim.t_ms[0][3], LEDS_PATTERN_PERIOD_MS / 2);
+        zassert_equal(anim.duration_ms, 3 * LEDS_PATTERN_PERIOD_MS);
+    }
+
+    assert_channel_disabled(d2_channels);
+
+    zassert_ok(k_sem_take(&finished_sem, K_MSEC(4 * LEDS_PATTERN_PERIOD_MS)));
+    zassert_false(finished_aborted);
+    zassert_false(is_led_driver_enabled(), "LED driver still enabled after the pattern");
+
+    // The LED driver lost its registers when it was disabled
+    assert_channel_disabled(d1_channels);
+}
+
+ZTEST(leds, test_breathe_matches_request) {
+    zassert_ok(leds_play(LEDS_D2, LEDS_BREATHE, LEDS_RGB(0, 100, 0), 2, on_finished));
+    k_sleep(START_DELAY);
+
+    const uint8_t brightness[] = {0, 100, 0};
+    for (int i = 0; i < 3; i++) {
+        struct lp5813_emul_anim_t anim;
+        zassert_ok(lp5813_emul_get_anim(lp5813, d2_channels[i], &anim));
+
+        zassert_true(anim.enabled);
+        zassert_true(anim.running);
+        zassert_equal(anim.reps, 2);
+
+        // Fades in and out over the whole period
+        const uint8_t pwm[] = {0, brightness[i], brightness[i], 0, 0};
+        zassert_mem_equal(anim.pwm[0], pwm, sizeof(pwm));
+        zassert_equal(anim.t_ms[0][0], LEDS_PATTERN_PERIOD_MS / 2);
+        zassert_equal(anim.t_ms[0][1], 0);
+        zassert_equal(anim.t_ms[0][2], LEDS_PATTERN_PERIOD_MS / 2);
+        zassert_equal(anim.t_ms[0][3], 0);
+        zassert_equal(anim.duration_ms, 2 * LEDS_PATTERN_PERIOD_MS);
+    }
+
+    assert_channel_disabled(d1_channels);
+
+    zassert_ok(k_sem_take(&finished_sem, K_MSEC(3 * LEDS_PATTERN_PERIOD_MS)));
+    zassert_false(finished_aborted);
+}
+
+ZTEST(leds, test_solid_until_off) {
+    zassert_ok(leds_play(LEDS_D1, LEDS_SOLID, LEDS_RGB(1, 2, 3), 1, on_finished));
+    k_sleep(START_DELAY);
+
+    for (int i = 0; i < 3; i++) {
+        struct lp5813_emul_anim_t anim;
+        zassert_ok(lp5813_emul_get_anim(lp5813, d1_channels[i], &anim));
+
+        // All PWM steps have the same brightness
+        const uint8_t pwm[] = {i + 1, i + 1, i + 1, i + 1, i + 1};
+        zassert_true(anim.enabled);
+        zassert_mem_equal(anim.pwm[0], pwm, sizeof(pwm));
+    }
+
+    // A solid pattern only finishes when the next one is played
+    zassert_equal(k_sem_take(&finished_sem, K_SECONDS(5)), -EAGAIN);
+    zassert_true(is_led_driver_enabled());
+
+    zassert_ok(leds_off());
+    zassert_ok(k_sem_take(&finished_sem, K_MSEC(100)));
+    zassert_true(finished_aborted);
+    zassert_false(is_led_driver_enabled());
+}
+
+ZTEST(leds, test_pattern_start_traffic) {
+    lp5813_emul_reset_stats(lp5813);
+
+    zassert_ok(leds_play(LEDS_D1, LEDS_FLASH, LEDS_RGB(255, 255, 255), 1, on_finished));
+    k_sleep(START_DELAY);
+
+    struct lp5813_emul_stats_t stats;
+    lp5813_emul_get_stats(lp5813, &stats);
+
+    TC_PRINT("lp5813,pattern_start,%u,%u,%u\n", stats.transfers, stats.bytes_written, stats.bytes_read);
+    zassert_equal(stats.transfers, PATTERN_START_TRANSFERS);
+    zassert_equal(stats.bytes_written, PATTERN_START_BYTES_WRITTEN);
+    zassert_equal(stats.bytes_read, PATTERN_START_BYTES_READ);
+    zassert_equal(stats.cmd_updates, 2);
+    zassert_equal(stats.cmd_starts, 1);
+    zassert_equal(stats.cmd_stops, 1);
+
+    // Finishing the pattern only pulls the EN pin low, the chip sees no traffic
+    lp5813_emul_reset_stats(lp5813);
+    zassert_ok(k_sem_take(&finished_sem, K_MSEC(2 * LEDS_PATTERN_PERIOD_MS)));
+
+    lp5813_emul_get_stats(lp5813, &stats);
+    zassert_equal(stats.transfers, 0);
+}
+
+ZTEST(leds, test_restart_traffic) {
+    // Playing a pattern while another one plays costs the same as starting from scratch, since the driver is disabled
+    // in between
+    zassert_ok(leds_play(LEDS_D1, LEDS_FLASH, LEDS_RGB(255, 0, 0), -1, on_finished));
+    k_sleep(START_DELAY);
+
+    lp5813_emul_reset_stats(lp5813);
+    zassert_ok(leds_play(LEDS_D2, LEDS_FLASH, LEDS_RGB(0, 0, 255), 1, NULL));
+    k_sleep(START_DELAY);
+
+    zassert_ok(k_sem_take(&finished_sem, K_NO_WAIT));
+    zassert_true(finished_aborted);
+
+    struct lp5813_emul_stats_t stats;
+    lp5813_emul_get_stats(lp5813, &stats);
+    zassert_equal(stats.transfers, PATTERN_START_TRANSFERS);
+    zassert_equal(stats.bytes_written, PATTERN_START_BYTES_WRITTEN);
+
+    assert_channel_disabled(d1_channels);
+    zassert_ok(leds_off());
+}
+
+ZTEST(leds, test_command_sequencing) {
+    // Commands queued before the work queue gets to run are executed in order, each one aborting its predecessor
+    k_sched_lock();
+    zassert_ok(leds_play(LEDS_D1, LEDS_FLASH, LEDS_RGB(255, 0, 0), -1, on_finished_a));
+    zassert_ok(leds_play(LEDS_D2, LEDS_SOLID, LEDS_RGB(0, 255, 0), -1, on_finished_b));
+    zassert_ok(leds_play(LEDS_D1, LEDS_FLASH, LEDS_RGB(0, 0, 255), 1, on_finished_c));
+    k_sched_unlock();
+
+    zassert_ok(k_sem_take(&finished_sem, K_MSEC(2 * LEDS_PATTERN_PERIOD_MS)));
+    zassert_false(finished_aborted);
+    zassert_str_equal(sequence, "abC");
+    zassert_false(is_led_driver_enabled());
+}
+
+ZTEST(leds, test_command_queue_full) {
+    // The queue holds four commands; further ones are rejected until the work queue catches up
+    k_sched_lock();
+    for (int i = 0; i < 4; i++) {
+        zassert_ok(leds_play(LEDS_D1, LEDS_FLASH, LEDS_RGB(255, 0, 0), 1, NULL), "Command %d rejected", i);
+    }
+
+    int res = leds_play(LEDS_D1, LEDS_FLASH, LEDS_RGB(255, 0, 0), 1, NULL);
+    k_sched_unlock();
+    zassert_equal(res, -ENOMEM);
+
+    k_sleep(START_DELAY);
+    zassert_ok(leds_play(LEDS_D1, LEDS_FLASH, LEDS_RGB(255, 0, 0), 1, NULL));
+}
+
+static void before_each(void *fixture) {
+    leds_off();
+    k_sleep(START_DELAY);
+    k_sem_reset(&finished_sem);
+    finished_aborted = false;
+    memset(sequence, 0, sizeof(sequence));
+    atomic_set(&sequence_len, 0);
+}
+
+ZTEST_SUITE(leds, NULL, NULL, before_each, NULL, NULL);
@@ -0,0 +1,185 @@
+#include "packet.h"
+
+#include <string.h>
+#include <zephyr/ztest.h>
+
+static const uint8_t key[PACKET_KEY_SIZE] = {0x01, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+                                             0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff};
+
+static const struct packet_header_t header = {
+    .valid_id  = {0x10, 0x20, 0x30},
+    .type      = PACKET_TYPE_CLICK,
+    .device_id = 0x12345678,
+    .counter   = 1024,
+};
+
+/*********************************************************************************************************************
+ * HELPERS
+ *********************************************************************************************************************/
+static struct packet_event_t make_event(uint8_t button, bool is_long_press, uint8_t shift_presses, uint32_t age_ms) {
+    return (struct packet_event_t){
+        .button        = button,
+        .is_long_press = is_long_press,
+        .shift_presses = shift_presses,
+        .age_ms        = age_ms,
+    };
+}
+
+static int round_trip(const struct packet_event_t *events, size_t num_events, struct packet_event_t *decoded) {
+    uint8_t buf[PACKET_MAX_EVENTS * PACKET_EVENT_SIZE];
+    int len = packet_encode_events(events, num_events, buf);
+    zassert_equal(len, num_events * PACKET_EVENT_SIZE);
+
+    return packet_decode_events(buf, len, decoded);
+}
+
+static void *setup() {
+    zassert_ok(packet_set_key(key));
+    return NULL;
+}
+
+/*********************************************************************************************************************
+ * TESTS
+ *********************************************************************************************************************/
+ZTEST(packet, test_events_round_trip) {
+    const struct packet_event_t events[] = {
+        make_event(0, false, 0, 1234),
+        make_event(3, true, 2, 500),
+        make_event(7, false, 7, 30),
+    };
+
+    struct packet_event_t decoded[PACKET_MAX_EVENTS];
+    zassert_equal(round_trip(events, ARRAY_SIZE(events), decoded), ARRAY_SIZE(events));
+
+    // The ages are rounded to PACKET_EVENT_TIME_UNIT_MS; everything else is kept
+    const uint32_t ages_ms[] = {1230, 500, 30};
+    for (int i = 0; i < ARRAY_SIZE(events); i++) {
+        zassert_equal(decoded[i].button, events[i].button, "event %d", i);
+        zassert_equal(decoded[i].is_long_press, events[i].is_long_press, "event %d", i);
+        zassert_equal(decoded[i].shift_presses, events[i].shift_presses, "event %d", i);
+        zassert_equal(decoded[i].age_ms, ages_ms[i], "event %d", i);
+    }
+}
+
+ZTEST(packet, test_events_rounding_does_not_add_up) {
+    // Each delta is taken between rounded ages, so the error of every age stays below half a unit
+    const struct packet_event_t events[] = {
+        make_event(0, false, 0, 44),
+        make_event(1, false, 0, 29),
+        make_event(2, false, 0, 14),
+    };
+
+    struct packet_event_t decoded[PACKET_MAX_EVENTS];
+    zassert_equal(round_trip(events, ARRAY_SIZE(events), decoded), ARRAY_SIZE(events));
+    zassert_equal(decoded[0].age_ms, 40);
+    zassert_equal(decoded[1].age_ms, 30);
+    zassert_equal(decoded[2].age_ms, 10);
+}
+
+ZTEST(packet, test_events_delta_saturates) {
+    // Gaps of more than PACKET_EVENT_MAX_DELTA units are cut to that, which makes the older events look younger
+    const struct packet_event_t events[] = {
+        make_event(0, false, 0, 12000),
+        make_event(1, false, 0, 6000),
+        make_event(2, false, 0, 0),
+    };
+
+    struct packet_event_t decoded[PACKET_MAX_EVENTS];
+    zassert_equal(round_trip(events, ARRAY_SIZE(events), decoded), ARRAY_SIZE(events));
+
+    const uint32_t max_delta_ms = PACKET_EVENT_MAX_DELTA * PACKET_EVENT_TIME_UNIT_MS;
+    zassert_equal(decoded[0].age_ms, 2 * max_delta_ms);
+    zassert_equal(decoded[1].age_ms, max_delta_ms);
+    zassert_equal(decoded[2].age_ms, 0);
+
+    // The age of the newest event is its own delta and saturates as well
+    const struct packet_event_t old = make_event(4, false, 0, 60000);
+    zassert_equal(round_trip(&old, 1, decoded), 1);
+    zassert_equal(decoded[0].age_ms, max_delta_ms);
+}
+
+ZTEST(packet, test_events_shift_presses_saturate) {
+    const struct packet_event_t event = make_event(5, true, PACKET_MAX_SHIFT_PRESSES + 10, 0);
+
+    struct packet_event_t decoded[PACKET_MAX_EVENTS];
+    zassert_equal(round_trip(&event, 1, decoded), 1);
+    zassert_equal(decoded[0].shift_presses, PACKET_MAX_SHIFT_PRESSES);
+    zassert_equal(decoded[0].button, 5);
+    zassert_true(decoded[0].is_long_press);
+}
+
+ZTEST(packet, test_events_count_limits) {
+    struct packet_event_t events[PACKET_MAX_EVENTS + 1];
+    for (int i = 0; i < ARRAY_SIZE(events); i++) {
+        events[i] = make_event(i % 8, false, 0, (ARRAY_SIZE(events) - i) * 100);
+    }
+
+    struct packet_event_t decoded[PACKET_MAX_EVENTS];
+    uint8_t buf[(PACKET_MAX_EVENTS + 1) * PACKET_EVENT_SIZE];
+
+    // No events
+    zassert_equal(round_trip(events, 0, decoded), 0);
+
+    // A full packet
+    zassert_equal(round_trip(&events[1], PACKET_MAX_EVENTS, decoded), PACKET_MAX_EVENTS);
+    for (int i = 0; i < PACKET_MAX_EVENTS; i++) {
+        zassert_equal(decoded[i].button, events[i + 1].button, "event %d", i);
+        zassert_equal(decoded[i].age_ms, events[i + 1].age_ms, "event %d", i);
+    }
+
+    // One event too many, and an encoding of that length or of an odd length
+    zassert_equal(packet_encode_events(events, PACKET_MAX_EVENTS + 1, buf), -EINVAL);
+    zassert_equal(packet_decode_events(buf, sizeof(buf), decoded), -EINVAL);
+    zassert_equal(packet_decode_events(buf, PACKET_EVENT_SIZE + 1, decoded), -EINVAL);
+}
+
+ZTEST(packet, test_seal_open) {
+    const uint8_t body[] = {1, 2, 3, 4, 5, 6, 7, 8};
+    uint8_t buf[PACKET_MAX_SIZE];
+    int len = packet_seal(&header, body, sizeof(body), buf);
+    zassert_equal(len, sizeof(header) + sizeof(body) + PACKET_MIC_SIZE);
+
+    // The header is sent in plain text, the body is not
+    zassert_mem_equal(buf, &header, sizeof(header));
+    zassert_true(memcmp(buf + sizeof(header), body, sizeof(body)) != 0);
+
+    struct packet_header_t opened;
+    uint8_t opened_body[PACKET_MAX_BODY_LEN];
+    zassert_equal(packet_open(buf, len, &opened, opened_body), sizeof(body));
+    zassert_mem_equal(&opened, &header, sizeof(header));
+    zassert_mem_equal(opened_body, body, sizeof(body));
+}
+
+ZTEST(packet, test_open_rejects_tampering) {
+    const uint8_t body[] = {1, 2, 3, 4};
+    uint8_t buf[PACKET_MAX_SIZE];
+    int len = packet_seal(&header, body, sizeof(body), buf);
+    zassert_true(len > 0);
+
+    struct packet_header_t opened;
+    uint8_t opened_body[PACKET_MAX_BODY_LEN];
+
+    // The header is authenticated (e.g. a replayed packet with a new counter) ...
+    buf[offsetof(struct packet_header_t, counter)] ^= 0x01;
+    zassert_equal(packet_open(buf, len, &opened, opened_body), -EBADMSG);
+    buf[offsetof(struct packet_header_t, counter)] ^= 0x01;
+
+    // ... and so is the body
+    buf[sizeof(header)] ^= 0x80;
+    zassert_equal(packet_open(buf, len, &opened, opened_body), -EBADMSG);
+    buf[sizeof(header)] ^= 0x80;
+
+    // Too short to carry a MIC, or too long for Gazell
+    zassert_equal(packet_open(buf, sizeof(header) + PACKET_MIC_SIZE - 1, &opened, opened_body), -EINVAL);
+    zassert_equal(packet_open(buf, PACKET_MAX_SIZE + 1, &opened, opened_body), -EINVAL);
+
+    zassert_equal(packet_open(buf, len, &opened, opened_body), sizeof(body));
+}
+
+ZTEST(packet, test_seal_rejects_long_body) {
+    uint8_t body[PACKET_MAX_BODY_LEN + 1] = {0};
+    uint8_t buf[PACKET_MAX_SIZE];
+    zassert_equal(packet_seal(&header, body, sizeof(body), buf), -EINVAL);
+}
+
+ZTEST_SUITE(packet, NULL, setup, NULL, NULL, NULL);
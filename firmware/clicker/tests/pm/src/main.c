@@ -0,0 +1,194 @@
+#include "battery.h"
+#include "leds.h"
+#include "sim_board.h"
+#include "speaker.h"
+#include "workq.h"
+
+#include <zephyr/device.h>
+#include <zephyr/kernel.h>
+#include <zephyr/pm/device.h>
+#include <zephyr/ztest.h>
+
+// Peripherals that must be suspended whenever the modules are idle (the same as in idle.c)
+enum peripheral_t {
+    PERIPHERAL_I2C,
+    PERIPHERAL_PWM,
+    PERIPHERAL_ADC,
+};
+
+static const struct device *const peripherals[] = {
+    [PERIPHERAL_I2C] = DEVICE_DT_GET(DT_NODELABEL(i2c0)),
+    [PERIPHERAL_PWM] = DEVICE_DT_GET(DT_NODELABEL(pwm0)),
+    [PERIPHERAL_ADC] = DEVICE_DT_GET(DT_IO_CHANNELS_CTLR(DT_PATH(zephyr_user))),
+};
+
+// Time to wait for a pattern or melody to finish
+#define FINISH_TIMEOUT K_SECONDS(10)
+
+// Runtime PM usage of the peripherals by the modules, counted by wrapping the runtime PM functions (see
+// CMakeLists.txt); unlike pm_device_state_get(), this also covers the emulators of Zephyr that have no PM support
+static atomic_t usage[ARRAY_SIZE(peripherals)];
+
+static K_SEM_DEFINE(finished_sem, 0, 1);
+static bool finished_aborted;
+
+// Result of the feedback tone started on the work queue (see tone_work_fn())
+static int tone_res;
+
+int __real_pm_device_runtime_get(const struct device *dev);
+int __real_pm_device_runtime_put(const struct device *dev);
+
+/*********************************************************************************************************************
+ * HELPERS
+ *********************************************************************************************************************/
+static atomic_t *get_usage(const struct device *dev) {
+    for (int i = 0; i < ARRAY_SIZE(peripherals); i++) {
+        if (peripherals[i] == dev) {
+            return &usage[i];
+        }
+    }
+
+    return NULL;
+}
+
+int __wrap_pm_device_runtime_get(const struct device *dev) {
+    int res           = __real_pm_device_runtime_get(dev);
+    atomic_t *counter = get_usage(dev);
+    if (res == 0 && counter) atomic_inc(counter);
+    return res;
+}
+
+int __wrap_pm_device_runtime_put(const struct device *dev) {
+    int res           = __real_pm_device_runtime_put(dev);
+    atomic_t *counter = get_usage(dev);
+    if (res == 0 && counter) atomic_dec(counter);
+    return res;
+}
+
+static void tone_work_fn(struct k_work *work) {
+    // Like a tone step of a feedback script
+    tone_res = speaker_tone_now(1000);
+}
+
+K_WORK_DEFINE(tone_work, tone_work_fn);
+
+static void on_finished(bool aborted) {
+    finished_aborted = aborted;
+    k_sem_give(&finished_sem);
+}
+
+static void assert_suspended(enum peripheral_t peripheral) {
+    const struct device *dev = peripherals[peripheral];
+    zassert_equal(atomic_get(&usage[peripheral]), 0, "%s is still in use while idle", dev->name);
+
+    enum pm_device_state state;
+    int res = pm_device_state_get(dev, &state);
+    if (res == -ENOSYS && peripheral != PERIPHERAL_PWM) {
+        // The I2C and ADC emulators of Zephyr have no PM support, so the usage count is all there is to check; the
+        // PWM emulator of the application does support it
+        return;
+    }
+
+    zassert_ok(res, "Failed to get the PM state of %s", dev->name);
+    zassert_equal(state, PM_DEVICE_STATE_SUSPENDED, "%s is %s while idle", dev->name, pm_device_state_str(state));
+}
+
+static void assert_all_suspended() {
+    for (int i = 0; i < ARRAY_SIZE(peripherals); i++) {
+        assert_suspended(i);
+    }
+}
+
+/*********************************************************************************************************************
+ * TESTS
+ *********************************************************************************************************************/
+ZTEST(pm, test_leds_suspend_i2c_after_pattern) {
+    zassert_ok(leds_play(LEDS_D1, LEDS_FLASH, LEDS_RGB(255, 0, 0), 2, on_finished));
+
+    k_sleep(K_MSEC(100));
+    zassert_equal(atomic_get(&usage[PERIPHERAL_I2C]), 1, "I2C not resumed while the pattern plays");
+
+    zassert_ok(k_sem_take(&finished_sem, FINISH_TIMEOUT));
+    zassert_false(finished_aborted);
+    assert_all_suspended();
+}
+
+ZTEST(pm, test_leds_suspend_i2c_after_abort) {
+    // A solid pattern runs until it is stopped
+    zassert_ok(leds_play(LEDS_D2, LEDS_SOLID, LEDS_RGB(0, 0, 255), 1, on_finished));
+    k_sleep(K_MSEC(100));
+    zassert_equal(atomic_get(&usage[PERIPHERAL_I2C]), 1, "I2C not resumed while the pattern plays");
+
+    zassert_ok(leds_off());
+    zassert_ok(k_sem_take(&finished_sem, FINISH_TIMEOUT));
+    zassert_true(finished_aborted);
+    assert_all_suspended();
+}
+
+ZTEST(pm, test_speaker_suspends_pwm_after_melody) {
+    zassert_ok(speaker_play(SPEAKER_MELODY_SUCCESS, on_finished));
+
+    k_sleep(K_MSEC(10));
+    zassert_equal(atomic_get(&usage[PERIPHERAL_PWM]), 1, "PWM not resumed while the melody plays");
+
+    zassert_ok(k_sem_take(&finished_sem, FINISH_TIMEOUT));
+    zassert_false(finished_aborted);
+    assert_all_suspended();
+}
+
+ZTEST(pm, test_speaker_suspends_pwm_after_abort) {
+    zassert_ok(speaker_play(SPEAKER_MELODY_LOW_BATTERY, on_finished));
+    k_sleep(K_MSEC(10));
+
+    zassert_ok(speaker_off());
+    zassert_ok(k_sem_take(&finished_sem, FINISH_TIMEOUT));
+    zassert_true(finished_aborted);
+    assert_all_suspended();
+}
+
+ZTEST(pm, test_speaker_suspends_pwm_after_melody_over_tone) {
+    tone_res = -EINPROGRESS;
+    k_work_submit_to_queue(&workq, &tone_work);
+    k_sleep(K_MSEC(10));
+    zassert_ok(tone_res);
+    zassert_equal(atomic_get(&usage[PERIPHERAL_PWM]), 1, "PWM not resumed while the tone plays");
+
+    // The melody takes over the PWM from the tone instead of resuming it again
+    zassert_ok(speaker_play(SPEAKER_MELODY_SUCCESS, on_finished));
+    k_sleep(K_MSEC(10));
+    zassert_equal(atomic_get(&usage[PERIPHERAL_PWM]), 1, "PWM resumed twice");
+
+    zassert_ok(k_sem_take(&finished_sem, FINISH_TIMEOUT));
+    zassert_false(finished_aborted);
+    assert_all_suspended();
+}
+
+ZTEST(pm, test_battery_suspends_adc_between_samples) {
+    zassert_ok(sim_board_set_battery_mv(2950));
+
+    // Let the battery module take a few samples (one per second)
+    k_sleep(K_SECONDS(5));
+
+    int mv = battery_get_voltage_mv();
+    zassert_within(mv, 2950, 50, "Unexpected battery voltage %d mV", mv);
+    assert_all_suspended();
+}
+
+ZTEST(pm, test_everything_at_once) {
+    zassert_ok(sim_board_set_battery_mv(3000));
+    zassert_ok(leds_play(LEDS_D1, LEDS_BREATHE, LEDS_RGB(0, 255, 0), 1, NULL));
+    zassert_ok(speaker_play(SPEAKER_MELODY_ERROR, on_finished));
+
+    zassert_ok(k_sem_take(&finished_sem, FINISH_TIMEOUT));
+
+    // The breathe pattern takes longer than the melody
+    k_sleep(K_SECONDS(3));
+    assert_all_suspended();
+}
+
+static void before_each(void *fixture) {
+    k_sem_reset(&finished_sem);
+    finished_aborted = false;
+}
+
+ZTEST_SUITE(pm, NULL, NULL, before_each, NULL, NULL);
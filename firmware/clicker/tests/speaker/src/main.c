@@ -0,0 +1,124 @@
+#include "notes.h"
+#include "pwm_capture_emul.h"
+#include "speaker.h"
+
+#include <stdio.h>
+#include <zephyr/device.h>
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+
+// A note of a melody as it is expected on the speaker
+struct expected_note_t {
+    uint32_t frequency;  // 0 for a rest
+    uint32_t length_ms;
+};
+
+// The low battery melody (see speaker.c)
+static const struct expected_note_t low_battery_melody[] = {
+    {C6, 150}, {0, 100}, {G5, 100}, {A5, 100},  {Bb5, 100}, {0, 100},
+    {Bb5, 100}, {0, 150}, {C5, 300}, {0, 300}, {0, 150},   {C6, 150},
+};
+
+// Tolerance of the note timing; the notes are scheduled on the shared work queue, which is idle during the tests
+#define TIMING_TOLERANCE_MS 5
+
+static const struct device *pwm = DEVICE_DT_GET(DT_NODELABEL(pwm0));
+
+static K_SEM_DEFINE(finished_sem, 0, 1);
+static bool finished_aborted;
+static int64_t finished_ms;
+
+/*********************************************************************************************************************
+ * HELPERS
+ *********************************************************************************************************************/
+static void on_finished(bool aborted) {
+    finished_aborted = aborted;
+    finished_ms      = k_uptime_get();
+    k_sem_give(&finished_sem);
+}
+
+static void assert_frequency(uint32_t frequency, const char *when) {
+    struct pwm_capture_emul_channel_t ch[2];
+    zassert_ok(pwm_capture_emul_get_channel(pwm, 0, &ch[0]));
+    zassert_ok(pwm_capture_emul_get_channel(pwm, 1, &ch[1]));
+
+    // The two channels run out-of-phase at the same frequency; a rest is a 1 Hz period without pulses
+    uint32_t period_ns = PWM_HZ(frequency == 0 ? 1 : frequency);
+    uint32_t pulse_ns  = frequency == 0 ? 0 : period_ns / 2;
+    for (int i = 0; i < ARRAY_SIZE(ch); i++) {
+        zassert_equal(ch[i].period_ns, period_ns, "%s: channel %d has a period of %u ns, expected %u ns", when, i,
+                      ch[i].period_ns, period_ns);
+        zassert_equal(ch[i].pulse_ns, pulse_ns, "%s: channel %d has a pulse of %u ns, expected %u ns", when, i,
+                      ch[i].pulse_ns, pulse_ns);
+    }
+
+    zassert_equal(ch[0].flags & PWM_POLARITY_MASK, PWM_POLARITY_NORMAL);
+    zassert_equal(ch[1].flags & PWM_POLARITY_MASK, PWM_POLARITY_INVERTED);
+}
+
+/*********************************************************************************************************************
+ * TESTS
+ *********************************************************************************************************************/
+ZTEST(speaker, test_note_timing) {
+    int64_t start_ms = k_uptime_get();
+    zassert_ok(speaker_play(SPEAKER_MELODY_LOW_BATTERY, on_finished));
+
+    // Sample the speaker in the middle of each note, relative to the start so that the errors do not add up
+    uint32_t note_start_ms = 0;
+    for (int i = 0; i < ARRAY_SIZE(low_battery_melody); i++) {
+        const struct expected_note_t *note = &low_battery_melody[i];
+        k_sleep(K_TIMEOUT_ABS_MS(start_ms + note_start_ms + note->length_ms / 2));
+
+        char when[32];
+        snprintf(when, sizeof(when), "note %d at %u ms", i, note_start_ms + note->length_ms / 2);
+        assert_frequency(note->frequency, when);
+
+        note_start_ms += note->length_ms;
+    }
+
+    // The callback is called once the last note has ended
+    zassert_ok(k_sem_take(&finished_sem, K_MSEC(note_start_ms)));
+    zassert_false(finished_aborted);
+    zassert_within(finished_ms - start_ms, note_start_ms, TIMING_TOLERANCE_MS, "Finished after %lld ms, expected %u ms",
+                   finished_ms - start_ms, note_start_ms);
+
+    // The speaker is silent afterwards
+    assert_frequency(0, "after the melody");
+}
+
+ZTEST(speaker, test_abort) {
+    zassert_ok(speaker_play(SPEAKER_MELODY_LOW_BATTERY, on_finished));
+    k_msleep(50);
+
+    // Playing another melody aborts the first one and calls its callback right away
+    zassert_ok(speaker_play(SPEAKER_MELODY_SUCCESS, NULL));
+    zassert_ok(k_sem_take(&finished_sem, K_MSEC(10)));
+    zassert_true(finished_aborted);
+
+    zassert_ok(speaker_off());
+    k_msleep(10);
+    assert_frequency(0, "after speaker_off()");
+}
+
+ZTEST(speaker, test_queue_full) {
+    // The commands are executed on the work queue, which must not run in between
+    int res = 0;
+    int n   = 0;
+    k_sched_lock();
+    for (; n < 10 && res == 0; n++) {
+        res = speaker_play(SPEAKER_MELODY_SUCCESS, NULL);
+    }
+    k_sched_unlock();
+
+    zassert_equal(res, -ENOMEM);
+    zassert_equal(n, 5, "Queue accepted %d commands, expected 4", n - 1);
+
+    zassert_ok(speaker_off());
+    k_msleep(10);
+}
+
+static void before_each(void *fixture) {
+    k_sem_reset(&finished_sem);
+}
+
+ZTEST_SUITE(speaker, NULL, NULL, before_each, NULL, NULL);
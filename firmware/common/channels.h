@@ -0,0 +1,21 @@
+#ifndef CHANNELS_H
+#define CHANNELS_H
+
+#include <stdint.h>
+
+// Channel plan shared by the clicker and the receiver
+//
+// Both sides use the same channel table (spread over the band, avoiding the centres of the Wi-Fi channels 1, 6 and
+// 11 where possible). The receiver cycles through all channels that are not blacklisted; the clicker starts on the
+// channel with the best success record and, if the packet is not acked there, moves on to the next one in the table.
+// The clicker reports the outcome of its last transmission per channel to the receiver (see struct packet_click_t),
+// which blacklists channels that fail persistently.
+
+#define CHANNELS_NUM        8     // Number of channels in the table
+#define CHANNELS_MIN_ACTIVE 4     // The receiver never blacklists more than CHANNELS_NUM - CHANNELS_MIN_ACTIVE channels
+#define CHANNELS_NONE       0xff  // Channel index meaning "no channel"
+
+// Radio channels (frequency offset from 2400 MHz)
+static const uint8_t channels_table[CHANNELS_NUM] = {4, 15, 25, 32, 42, 52, 63, 77};
+
+#endif  // CHANNELS_H
@@ -0,0 +1,129 @@
+#include "packet.h"
+
+#include <errno.h>
+#include <psa/crypto.h>
+#include <string.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+
+BUILD_ASSERT(sizeof(struct packet_header_t) == 12, "Packet header layout is part of the radio protocol");
+BUILD_ASSERT(sizeof(struct packet_click_t) <= PACKET_MAX_BODY_LEN, "Click packet body is too large");
+BUILD_ASSERT(sizeof(struct packet_replay_t) <= PACKET_MAX_BODY_LEN, "Replay packet body is too large");
+BUILD_ASSERT(sizeof(struct packet_sync_t) <= PACKET_MAX_BODY_LEN, "Sync packet body is too large");
+
+// AES-CCM with a 4-byte MIC
+#define AEAD_ALG   PSA_ALG_AEAD_WITH_SHORTENED_TAG(PSA_ALG_CCM, PACKET_MIC_SIZE)
+#define NONCE_SIZE 13
+
+// Global state
+static psa_key_id_t key_id = PSA_KEY_ID_NULL;
+
+/*********************************************************************************************************************
+ * PRIVATE FUNCTIONS
+ *********************************************************************************************************************/
+static void make_nonce(const struct packet_header_t *header, uint8_t nonce[NONCE_SIZE]) {
+    memset(nonce, 0, NONCE_SIZE);
+    sys_put_le32(header->device_id, &nonce[0]);
+    sys_put_le32(header->counter, &nonce[4]);
+    nonce[8] = header->type;
+}
+
+static uint32_t to_units(uint32_t ms) {
+    return (ms + PACKET_EVENT_TIME_UNIT_MS / 2) / PACKET_EVENT_TIME_UNIT_MS;
+}
+
+/*********************************************************************************************************************
+ * PUBLIC FUNCTIONS
+ *********************************************************************************************************************/
+int packet_set_key(const uint8_t key[PACKET_KEY_SIZE]) {
+    psa_status_t status = psa_crypto_init();
+    if (status != PSA_SUCCESS) return -EIO;
+
+    if (key_id != PSA_KEY_ID_NULL) {
+        psa_destroy_key(key_id);
+        key_id = PSA_KEY_ID_NULL;
+    }
+
+    // The key stays imported, so sealing a packet only costs the AES-CCM operation itself
+    psa_key_attributes_t attr = PSA_KEY_ATTRIBUTES_INIT;
+    psa_set_key_usage_flags(&attr, PSA_KEY_USAGE_ENCRYPT | PSA_KEY_USAGE_DECRYPT);
+    psa_set_key_algorithm(&attr, AEAD_ALG);
+    psa_set_key_type(&attr, PSA_KEY_TYPE_AES);
+    psa_set_key_bits(&attr, PACKET_KEY_SIZE * 8);
+
+    status = psa_import_key(&attr, key, PACKET_KEY_SIZE, &key_id);
+    return status == PSA_SUCCESS ? 0 : -EIO;
+}
+
+int packet_seal(const struct packet_header_t *header, const void *body, size_t body_len, uint8_t *buf) {
+    if (body_len > PACKET_MAX_BODY_LEN) return -EINVAL;
+    if (key_id == PSA_KEY_ID_NULL) return -EACCES;
+
+    uint8_t nonce[NONCE_SIZE];
+    make_nonce(header, nonce);
+    memcpy(buf, header, sizeof(*header));
+
+    size_t out_len;
+    psa_status_t status = psa_aead_encrypt(key_id, AEAD_ALG, nonce, sizeof(nonce), buf, sizeof(*header), body,
+                                           body_len, buf + sizeof(*header), PACKET_MAX_SIZE - sizeof(*header),
+                                           &out_len);
+    if (status != PSA_SUCCESS) return -EIO;
+
+    return sizeof(*header) + out_len;
+}
+
+int packet_open(const uint8_t *buf, size_t len, struct packet_header_t *header, void *body) {
+    if (len < sizeof(*header) + PACKET_MIC_SIZE || len > PACKET_MAX_SIZE) return -EINVAL;
+    if (key_id == PSA_KEY_ID_NULL) return -EACCES;
+
+    memcpy(header, buf, sizeof(*header));
+
+    uint8_t nonce[NONCE_SIZE];
+    make_nonce(header, nonce);
+
+    size_t body_len;
+    psa_status_t status = psa_aead_decrypt(key_id, AEAD_ALG, nonce, sizeof(nonce), buf, sizeof(*header),
+                                           buf + sizeof(*header), len - sizeof(*header), body, PACKET_MAX_BODY_LEN,
+                                           &body_len);
+    if (status == PSA_ERROR_INVALID_SIGNATURE) return -EBADMSG;
+    if (status != PSA_SUCCESS) return -EIO;
+
+    return body_len;
+}
+
+int packet_encode_events(const struct packet_event_t *events, size_t num_events, uint8_t *buf) {
+    if (num_events > PACKET_MAX_EVENTS) return -EINVAL;
+
+    for (size_t i = 0; i < num_events; i++) {
+        // Deltas are taken between the rounded ages, so that rounding errors do not add up
+        uint32_t age       = to_units(events[i].age_ms);
+        uint32_t next_age  = i + 1 < num_events ? to_units(events[i + 1].age_ms) : 0;
+        uint32_t delta     = MIN(age > next_age ? age - next_age : 0, PACKET_EVENT_MAX_DELTA);
+        uint32_t shift     = MIN(events[i].shift_presses, PACKET_MAX_SHIFT_PRESSES);
+        uint16_t encoded   = (events[i].button & 0x07) | (events[i].is_long_press << 3) | (shift << 4) | (delta << 7);
+        sys_put_le16(encoded, &buf[i * PACKET_EVENT_SIZE]);
+    }
+
+    return num_events * PACKET_EVENT_SIZE;
+}
+
+int packet_decode_events(const uint8_t *buf, size_t len, struct packet_event_t *events) {
+    if (len % PACKET_EVENT_SIZE != 0 || len > PACKET_MAX_EVENTS * PACKET_EVENT_SIZE) return -EINVAL;
+
+    // The ages add up from the newest event backwards
+    int num_events = len / PACKET_EVENT_SIZE;
+    uint32_t age   = 0;
+    for (int i = num_events - 1; i >= 0; i--) {
+        uint16_t encoded = sys_get_le16(&buf[i * PACKET_EVENT_SIZE]);
+        age += encoded >> 7;
+
+        events[i] = (struct packet_event_t){
+            .button        = encoded & 0x07,
+            .is_long_press = (encoded >> 3) & 0x01,
+            .shift_presses = (encoded >> 4) & 0x07,
+            .age_ms        = age * PACKET_EVENT_TIME_UNIT_MS,
+        };
+    }
+
+    return num_events;
+}
@@ -0,0 +1,221 @@
+#ifndef PACKET_H
+#define PACKET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/sys/util_macro.h>
+#include <zephyr/toolchain.h>
+
+// Packet format shared by the clicker and the receiver:
+//
+//   | header (12 bytes, authenticated) | body (encrypted) | MIC (4 bytes) |
+//
+// The body is encrypted and, together with the header, authenticated with AES-CCM. The nonce is built from the
+// device ID, the counter and the packet type, so it is unique as long as every device increments its counter for
+// every packet. The receiver rejects packets whose counter is not higher than the last one of the same device.
+
+#define PACKET_MAX_SIZE     32  // Maximum Gazell payload length
+#define PACKET_KEY_SIZE     16
+#define PACKET_MIC_SIZE     4
+#define PACKET_MAX_BODY_LEN (PACKET_MAX_SIZE - sizeof(struct packet_header_t) - PACKET_MIC_SIZE)
+
+// Button events are bit-packed into 2 bytes each (little-endian):
+//
+//   | bits 0-2: button | bit 3: long press | bits 4-6: shift presses | bits 7-15: delta time |
+//
+// The events of a click packet are ordered from the oldest to the newest. The delta time of an event is the time
+// until the next event, and for the newest one the time until the packet was sealed, in units of
+// PACKET_EVENT_TIME_UNIT_MS; so the receiver can reconstruct when each event happened relative to the arrival of the
+// packet. Shift presses and delta times saturate at their maximum.
+#define PACKET_EVENT_SIZE         2
+#define PACKET_MAX_EVENTS         5  // Fills the body of a click packet
+#define PACKET_MAX_REPLAY_EVENTS  4  // Fills the body of a replay packet
+#define PACKET_MAX_SYNC_EVENTS    3  // Fills the body of a sync packet
+#define PACKET_MAX_SHIFT_PRESSES  7
+#define PACKET_EVENT_TIME_UNIT_MS 10
+#define PACKET_EVENT_MAX_DELTA    511
+
+// Age of replayed events that happened before the clicker was last reset (the clock does not run in System OFF)
+#define PACKET_AGE_UNKNOWN UINT32_MAX
+
+enum packet_type_t {
+    PACKET_TYPE_CLICK         = 1,  // Clicker to receiver: struct packet_click_t
+    PACKET_TYPE_PAIR_REQUEST  = 2,  // Clicker to receiver on the pairing address: no body
+    PACKET_TYPE_PAIR_FETCH    = 3,  // Clicker to receiver on the pairing address: no body; polls for the response
+    PACKET_TYPE_PAIR_RESPONSE = 4,  // Receiver to clicker in an ack payload: struct packet_pair_response_t
+    PACKET_TYPE_SLOT_HINT     = 5,  // Receiver to clicker in an ack payload: struct packet_slot_hint_t (not sealed)
+    PACKET_TYPE_COMMAND       = 6,  // Receiver to clicker in an ack payload: struct packet_command_t
+    PACKET_TYPE_REPLAY        = 7,  // Clicker to receiver: struct packet_replay_t
+    PACKET_TYPE_SYNC          = 8,  // Clicker to receiver: struct packet_sync_t
+};
+
+// Commands the receiver can send to a clicker
+enum packet_command_id_t {
+    PACKET_COMMAND_LEDS    = 1,  // Play an LED pattern: struct packet_command_leds_t
+    PACKET_COMMAND_MELODY  = 2,  // Play a melody: enum speaker_melody_t
+    PACKET_COMMAND_HOST_ID = 3,  // Change the stored host ID: uint8_t host_id[5]
+    PACKET_COMMAND_SLEEP   = 4,  // Enter System OFF right away: no arguments
+};
+
+// Packet header; sent in plain text (little-endian)
+struct packet_header_t {
+    uint8_t valid_id[3];  // Packet validation ID; lets the receiver drop foreign packets without decrypting them
+    uint8_t type;         // enum packet_type_t
+    uint32_t device_id;   // Lower 32 bits of the hardware device ID of the clicker
+    uint32_t counter;     // Monotonic packet counter of the clicker
+} __packed;
+
+// A button event as carried in a click packet
+struct packet_event_t {
+    uint8_t button;         // enum buttons_button_t
+    bool is_long_press;     // True for a long press
+    uint8_t shift_presses;  // Number of preceding short presses of the shift button
+    uint32_t age_ms;        // Time from the event until the packet was sealed (retries are not included)
+};
+
+// The link byte of a click packet holds the channel index (see channels.h) the previous packet was acked on, or
+// PACKET_LINK_NO_CHANNEL, in bits 0-3 and the number of retransmissions of all packets since the previous click packet
+// in bits 4-7. Only the clicker can count them: the Gazell host drops the duplicates of packets whose ack got lost.
+#define PACKET_LINK_CHANNEL_MASK  0x0f
+#define PACKET_LINK_NO_CHANNEL    0x0f
+#define PACKET_LINK_RETRIES_SHIFT 4
+#define PACKET_LINK_MAX_RETRIES   15  // The count saturates
+
+// Body of a PACKET_TYPE_CLICK packet; only the events that are present are sent, so the body is between
+// offsetof(struct packet_click_t, events) + PACKET_EVENT_SIZE and sizeof(struct packet_click_t) bytes long
+struct packet_click_t {
+    uint8_t link;             // Acked channel and retransmissions (see PACKET_LINK_CHANNEL_MASK)
+    uint8_t failed_channels;  // Bitmask of the channel indices tries failed on since the previous click packet
+    uint32_t last_command;    // Counter of the last command that was applied, 0 if none
+    uint8_t events[PACKET_MAX_EVENTS * PACKET_EVENT_SIZE];  // See packet_encode_events()
+} __packed;
+
+// Body of a PACKET_TYPE_REPLAY packet with events from the clicker's journal, i.e. events whose click packets were
+// not acked. Journaled events are numbered consecutively, so the receiver drops the ones it has seen already by their
+// journal ID. The event ages are relative to the newest event of the packet, whose own age is sent separately since
+// journaled events may be much older than the delta times can express. Like click packets, the body is only as long
+// as the events that are present.
+struct packet_replay_t {
+    uint32_t first_id;  // Journal ID of the first (oldest) event; the IDs of the others follow consecutively
+    uint32_t age_ms;    // Time from the newest event until the packet was sealed, or PACKET_AGE_UNKNOWN
+    uint8_t events[PACKET_MAX_REPLAY_EVENTS * PACKET_EVENT_SIZE];  // See packet_encode_events()
+} __packed;
+
+// Body of a PACKET_TYPE_PAIR_RESPONSE packet; its header carries the device ID of the clicker and the counter of the
+// PACKET_TYPE_PAIR_REQUEST packet that is answered, which makes the nonce unique and binds the response to the request
+struct packet_pair_response_t {
+    uint8_t system_addr[5];  // System address of the receiver
+    uint8_t host_id[5];      // Host ID of the receiver
+} __packed;
+
+// Body of a PACKET_TYPE_SYNC packet, which a clicker sends right after a click packet has been acked if the receiver
+// asks for it (see PACKET_SLOT_HINT_TIME_SYNC). The reception of the click packet is an instant both sides know in
+// their own clock: the receiver when it got the packet, the clicker when it got the ack. The sync packet measures the
+// presses against that instant with the clicker's RTC, so the receiver can place them on its own time base with the
+// resolution of the clocks, no matter how long the click packet was delayed by retries and backoffs. Like click
+// packets, the body is only as long as the events that are present.
+struct packet_sync_t {
+    uint32_t counter;                                // Counter of the acked click packet
+    uint32_t press_ages_us[PACKET_MAX_SYNC_EVENTS];  // Time from each press until the ack, for its first events
+} __packed;
+
+// Flags of struct packet_slot_hint_t
+#define PACKET_SLOT_HINT_TIME_SYNC BIT(0)  // Send a sync packet after every click packet
+
+// Ack payload of the data pipe with the number of transmission slots the clickers should spread their packets over.
+// Since the receiver cannot know which clicker gets the next ack, this is a plain broadcast that is neither encrypted
+// nor authenticated; it only affects the timing of transmissions.
+struct packet_slot_hint_t {
+    uint8_t type;       // PACKET_TYPE_SLOT_HINT
+    uint8_t num_slots;  // Number of slots (a power of 2, at least 1)
+    uint8_t flags;      // PACKET_SLOT_HINT_* flags
+} __packed;
+
+// Arguments of PACKET_COMMAND_LEDS
+struct packet_command_leds_t {
+    uint8_t led;      // enum leds_led_t
+    uint8_t pattern;  // enum leds_pattern_t
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+    int8_t reps;      // Number of repetitions, -1 to repeat indefinitely and 0 to switch the LEDs off
+} __packed;
+
+// Body of a PACKET_TYPE_COMMAND packet. Commands are broadcast in the ack payloads of the data pipe (like the slot
+// hints), so the header carries the device ID of the addressed clicker in plain text, and the counter of the last
+// packet of that clicker the receiver had accepted when it sealed the command. Since the clicker's counters are unique,
+// this makes the nonce unique; the clicker only applies commands with a counter higher than the last applied one and
+// confirms them by echoing their counter in the last_command field of its next click.
+struct packet_command_t {
+    uint8_t command;  // enum packet_command_id_t
+    union {
+        struct packet_command_leds_t leds;
+        uint8_t melody;
+        uint8_t host_id[5];
+    };
+} __packed;
+
+/**
+ * @brief Sets the key used to seal and open packets.
+ *
+ * Can be called again to change the key (e.g. after pairing).
+ *
+ * @param key The AES-128 key.
+ *
+ * @retval 0 If successful.
+ * @retval <0 Error code if the key could not be imported.
+ */
+int packet_set_key(const uint8_t key[PACKET_KEY_SIZE]);
+
+/**
+ * @brief Encrypts and authenticates a packet.
+ *
+ * @param header The packet header.
+ * @param body The body to encrypt.
+ * @param body_len Length of the body in bytes (at most PACKET_MAX_BODY_LEN).
+ * @param buf Buffer for the packet (at least PACKET_MAX_SIZE bytes).
+ *
+ * @return Length of the packet in bytes, or a negative error code.
+ */
+int packet_seal(const struct packet_header_t *header, const void *body, size_t body_len, uint8_t *buf);
+
+/**
+ * @brief Authenticates and decrypts a packet.
+ *
+ * The validation ID and the counter are not checked; this is up to the caller.
+ *
+ * @param buf The received packet.
+ * @param len Length of the packet in bytes.
+ * @param header Filled with the packet header.
+ * @param body Buffer for the decrypted body (at least PACKET_MAX_BODY_LEN bytes).
+ *
+ * @return Length of the body in bytes, or a negative error code (-EBADMSG if authentication failed).
+ */
+int packet_open(const uint8_t *buf, size_t len, struct packet_header_t *header, void *body);
+
+/**
+ * @brief Encodes button events for a click packet.
+ *
+ * @param events The events, ordered from the oldest to the newest (i.e. by decreasing age).
+ * @param num_events Number of events (at most PACKET_MAX_EVENTS).
+ * @param buf Buffer for the encoded events (at least num_events * PACKET_EVENT_SIZE bytes).
+ *
+ * @return Length of the encoded events in bytes, or -EINVAL if there are too many events.
+ */
+int packet_encode_events(const struct packet_event_t *events, size_t num_events, uint8_t *buf);
+
+/**
+ * @brief Decodes the button events of a click packet.
+ *
+ * The ages are rounded to multiples of PACKET_EVENT_TIME_UNIT_MS.
+ *
+ * @param buf The encoded events.
+ * @param len Length of the encoded events in bytes.
+ * @param events Buffer for the decoded events (at least PACKET_MAX_EVENTS), ordered from the oldest to the newest.
+ *
+ * @return Number of events, or -EINVAL if the length is invalid.
+ */
+int packet_decode_events(const uint8_t *buf, size_t len, struct packet_event_t *events);
+
+#endif  // PACKET_H
@@ -0,0 +1,304 @@
+#!/usr/bin/env python3
+"""Decodes the binary output of the receiver (see CONFIG_APP_OUTPUT and src/output.h).
+
+Reads the frames from a serial port (e.g. the USB-UART adapter on UARTE1 of the DK, or a pty) or from a file saved
+with --save, checks their CRC and sequence numbers and prints them one per line. With --stats, a summary is printed
+every second instead: frames and bytes per second, frames lost on the link (sequence gaps) or dropped by the receiver
+(ring full), CRC errors, the peak fill level of the receiver's ring with the time it takes to send it, which is the
+worst queueing latency in the period, and the clicker with the highest packet loss according to the telemetry.
+
+When reading from a port, --stats also reports the latency of the click frames from the press to the decoder. The
+clocks of the receiver and the host are not synchronized, so the latency is given relative to the fastest click
+frame since the start; with the synthetic clicks of the native_sim build (see CONFIG_APP_SIM_CLICKERS), whose press
+time is the time the receiver got the click, that is the latency of the receiver's session, output and pty and of
+this script.
+
+Usage:
+    output_decode.py PORT [--baudrate N] [--save capture.bin] [--stats]
+    output_decode.py --file capture.bin [--stats]
+"""
+
+import argparse
+import struct
+import sys
+import time
+from pathlib import Path
+
+PROTOCOL_VERSION = 1
+
+# Layouts of src/output.h
+HEADER_FORMAT = "<BBH"
+STATUS_FORMAT = "<IIIIIHH"
+CLICK_FORMAT = "<IIbBBB"
+EVENT_FORMAT = "<BBBIq"
+SESSION_FORMAT = "<IIBBBHq"
+TELEMETRY_FORMAT = "<IIIIHHH8H8H"
+
+FRAME_STATUS = 0
+FRAME_CLICK = 1
+FRAME_SESSION = 2
+FRAME_TELEMETRY = 3
+
+CLICK_REPLAY = 1 << 0
+EVENT_LONG_PRESS = 1 << 0
+AGE_UNKNOWN = 0xFFFFFFFF
+TIME_UNKNOWN = -(1 << 63)
+SESSION_UPDATES = ["rank", "tally", "lockout", "closed"]
+RANK_NONE = 0xFF
+
+# Histogram bins of the telemetry frames (see struct output_telemetry_t)
+TELEMETRY_BINS = 8
+RSSI_LABELS = [f">{-48 - 8 * i}" for i in range(TELEMETRY_BINS - 1)] + ["<=-96"]
+LATENCY_LABELS = ["<2"] + [f"<{2 << i}" for i in range(1, TELEMETRY_BINS - 1)] + [">=128"]
+
+
+def crc16_ccitt(data, crc=0xFFFF):
+    """CRC-16/CCITT as computed by Zephyr's crc16_ccitt()."""
+    for byte in data:
+        byte ^= crc & 0xFF
+        byte ^= (byte << 4) & 0xFF
+        crc = ((byte << 8) | (crc >> 8)) ^ (byte >> 4) ^ (byte << 3)
+    return crc & 0xFFFF
+
+
+def cobs_decode(data):
+    """Returns the decoded frame, or None if the encoding is invalid."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data) + 1:
+            return None
+        out += data[i + 1 : i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def parse_frame(frame):
+    """Returns (type, seq, fields) or raises ValueError."""
+    header_size = struct.calcsize(HEADER_FORMAT)
+    if len(frame) < header_size + 2:
+        raise ValueError("frame too short")
+
+    (crc,) = struct.unpack_from("<H", frame, len(frame) - 2)
+    if crc16_ccitt(frame[:-2]) != crc:
+        raise ValueError("CRC error")
+
+    version, frame_type, seq = struct.unpack_from(HEADER_FORMAT, frame)
+    if version != PROTOCOL_VERSION:
+        raise ValueError(f"unknown protocol version {version}")
+
+    body = frame[header_size:-2]
+    if frame_type == FRAME_STATUS:
+        keys = ("uptime_ms", "num_frames", "num_dropped", "num_bytes", "baudrate", "ring_size", "ring_peak")
+        return frame_type, seq, dict(zip(keys, struct.unpack_from(STATUS_FORMAT, body)))
+
+    if frame_type == FRAME_CLICK:
+        keys = ("device_id", "counter", "rssi", "flags", "num_events", "num_synced")
+        fields = dict(zip(keys, struct.unpack_from(CLICK_FORMAT, body)))
+        offset = struct.calcsize(CLICK_FORMAT)
+        fields["events"] = [
+            dict(zip(("button", "flags", "shift_presses", "age_ms", "press_time_us"), event))
+            for event in struct.iter_unpack(EVENT_FORMAT, body[offset:])
+        ]
+        return frame_type, seq, fields
+
+    if frame_type == FRAME_SESSION:
+        keys = ("round", "device_id", "type", "button", "rank", "count", "press_time_us")
+        return frame_type, seq, dict(zip(keys, struct.unpack_from(SESSION_FORMAT, body)))
+
+    if frame_type == FRAME_TELEMETRY:
+        keys = ("device_id", "period_ms", "last_seen_ms", "jitter_us", "num_packets", "num_retries", "num_lost")
+        values = struct.unpack_from(TELEMETRY_FORMAT, body)
+        fields = dict(zip(keys, values))
+        fields["rssi_bins"] = list(values[len(keys) : len(keys) + TELEMETRY_BINS])
+        fields["latency_bins"] = list(values[len(keys) + TELEMETRY_BINS :])
+        return frame_type, seq, fields
+
+    return frame_type, seq, {"body": body.hex()}
+
+
+def loss_rate(fields):
+    """Share of the packets of a telemetry frame that never arrived (retries are not counted as packets)."""
+    sent = fields["num_packets"] + fields["num_lost"]
+    return fields["num_lost"] / sent if sent else 0.0
+
+
+def format_bins(labels, bins):
+    return " ".join(f"{label}:{n}" for label, n in zip(labels, bins) if n)
+
+
+def format_frame(frame_type, seq, fields):
+    if frame_type == FRAME_STATUS:
+        return (f"#{seq:<5} status: {fields['num_frames']} frames, {fields['num_dropped']} dropped, "
+                f"{fields['num_bytes']} bytes, ring peak {fields['ring_peak']}/{fields['ring_size']}")
+
+    if frame_type == FRAME_CLICK:
+        kind = "replayed click" if fields["flags"] & CLICK_REPLAY else "click"
+        lines = [f"#{seq:<5} {kind} from {fields['device_id']:08x} (packet {fields['counter']}, {fields['rssi']} dBm)"]
+        for i, event in enumerate(fields["events"]):
+            age = "unknown" if event["age_ms"] == AGE_UNKNOWN else f"{event['age_ms']} ms"
+            time_us = "unknown" if event["press_time_us"] == TIME_UNKNOWN else f"{event['press_time_us']} us"
+            synced = " (synced)" if i < fields["num_synced"] else ""
+            long = ", long" if event["flags"] & EVENT_LONG_PRESS else ""
+            lines.append(f"         button {event['button'] + 1}{long}, shift {event['shift_presses']}, age {age}, "
+                         f"pressed at {time_us}{synced}")
+        return "\n".join(lines)
+
+    if frame_type == FRAME_SESSION:
+        update = SESSION_UPDATES[fields["type"]] if fields["type"] < len(SESSION_UPDATES) else fields["type"]
+        rank = "none" if fields["rank"] == RANK_NONE else fields["rank"] + 1
+        return (f"#{seq:<5} round {fields['round']} {update}: device {fields['device_id']:08x}, "
+                f"button {fields['button'] + 1}, rank {rank}, count {fields['count']}")
+
+    if frame_type == FRAME_TELEMETRY:
+        return (f"#{seq:<5} link of {fields['device_id']:08x} over {fields['period_ms']} ms: "
+                f"{fields['num_packets']} packets, {fields['num_retries']} retries, {fields['num_lost']} lost "
+                f"({loss_rate(fields):.0%}), jitter {fields['jitter_us'] / 1000:.1f} ms, "
+                f"last seen {fields['last_seen_ms']} ms ago; RSSI [{format_bins(RSSI_LABELS, fields['rssi_bins'])}] "
+                f"dBm, latency [{format_bins(LATENCY_LABELS, fields['latency_bins'])}] ms")
+
+    return f"#{seq:<5} type {frame_type}: {fields}"
+
+
+class Stats:
+    def __init__(self):
+        self.frames = 0
+        self.bytes = 0
+        self.lost = 0
+        self.errors = 0
+        self.status = None
+        self.last_dropped = None
+        self.dropped = 0
+        self.links = {}
+        self.delays = []
+        self.min_delay = None
+        self.start = time.monotonic()
+
+    def add_status(self, status):
+        if self.last_dropped is not None:
+            self.dropped += (status["num_dropped"] - self.last_dropped) & 0xFFFFFFFF
+        self.last_dropped = status["num_dropped"]
+        self.status = status
+
+    def add_click(self, click, now):
+        # Press times are receiver uptime in us; replayed clicks are as old as the outage they were journaled in
+        newest = click["events"][-1] if click["events"] else None
+        if click["flags"] & CLICK_REPLAY or newest is None or newest["press_time_us"] == TIME_UNKNOWN:
+            return
+        delay = now - newest["press_time_us"] / 1e6
+        self.min_delay = delay if self.min_delay is None else min(self.min_delay, delay)
+        self.delays.append(delay)
+
+    def add_telemetry(self, telemetry):
+        sent, lost = self.links.get(telemetry["device_id"], (0, 0))
+        sent += telemetry["num_packets"] + telemetry["num_lost"]
+        self.links[telemetry["device_id"]] = (sent, lost + telemetry["num_lost"])
+
+    def report(self):
+        elapsed = max(time.monotonic() - self.start, 1e-3)
+        line = (f"{self.frames / elapsed:8.1f} frames/s {self.bytes / elapsed:9.0f} B/s  missing {self.lost} "
+                f"(dropped by the receiver: {self.dropped}), errors {self.errors}")
+        if self.status and self.status["baudrate"]:
+            # 10 bits per byte on the wire (start and stop bits)
+            latency_ms = self.status["ring_peak"] * 10 * 1000 / self.status["baudrate"]
+            line += f", ring peak {self.status['ring_peak']} B ({latency_ms:.1f} ms)"
+        if self.links:
+            # The clicker with the highest loss in the period is the first one to look at
+            device_id, (sent, lost) = max(self.links.items(), key=lambda item: item[1][1] / max(item[1][0], 1))
+            line += f", worst link {device_id:08x} ({lost}/{sent} lost)"
+        if self.delays:
+            delays = sorted(1000 * (d - self.min_delay) for d in self.delays)
+            p50 = delays[len(delays) // 2]
+            p99 = delays[int(len(delays) * 0.99)]
+            line += f", click latency p50 {p50:.1f} ms, p99 {p99:.1f} ms, max {delays[-1]:.1f} ms"
+        print(line)
+
+        # The drop counter of the receiver and the fastest click carry over
+        last_dropped = self.last_dropped
+        min_delay = self.min_delay
+        self.__init__()
+        self.last_dropped = last_dropped
+        self.min_delay = min_delay
+
+
+def read_chunks(args):
+    if args.file:
+        yield Path(args.file).read_bytes()
+        return
+
+    import serial
+
+    with serial.Serial(args.port, args.baudrate, timeout=0.1) as port:
+        save = open(args.save, "wb") if args.save else None
+        try:
+            while True:
+                # Whatever has arrived, so that the latency does not include waiting for a full buffer
+                chunk = port.read(max(port.in_waiting, 1))
+                if save:
+                    save.write(chunk)
+                yield chunk
+        finally:
+            if save:
+                save.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port", nargs="?", help="serial port of the receiver's output")
+    parser.add_argument("--baudrate", type=int, default=1000000)
+    parser.add_argument("--file", help="decode a saved capture instead of reading from a port")
+    parser.add_argument("--save", help="also save the raw data to this file")
+    parser.add_argument("--stats", action="store_true", help="print a summary every second instead of the frames")
+    args = parser.parse_args()
+    if not args.port and not args.file:
+        parser.error("either a port or --file is required")
+
+    stats = Stats()
+    next_seq = None
+    buffer = b""
+    for chunk in read_chunks(args):
+        buffer += chunk
+        *encoded_frames, buffer = buffer.split(b"\0")
+        for encoded in encoded_frames:
+            if not encoded:
+                continue
+
+            frame = cobs_decode(encoded)
+            try:
+                if frame is None:
+                    raise ValueError("invalid COBS encoding")
+                frame_type, seq, fields = parse_frame(frame)
+            except (ValueError, struct.error) as e:
+                stats.errors += 1
+                if not args.stats:
+                    print(f"Skipping frame: {e}", file=sys.stderr)
+                continue
+
+            # The sequence number also counts frames the receiver dropped
+            if next_seq is not None:
+                stats.lost += (seq - next_seq) & 0xFFFF
+            next_seq = (seq + 1) & 0xFFFF
+            stats.frames += 1
+            stats.bytes += len(encoded) + 1
+            if frame_type == FRAME_STATUS:
+                stats.add_status(fields)
+            elif frame_type == FRAME_CLICK and not args.file:
+                stats.add_click(fields, time.monotonic())
+            elif frame_type == FRAME_TELEMETRY:
+                stats.add_telemetry(fields)
+
+            if not args.stats:
+                print(format_frame(frame_type, seq, fields))
+
+        if args.stats and time.monotonic() - stats.start >= 1:
+            stats.report()
+
+    if args.stats:
+        stats.report()
+
+
+if __name__ == "__main__":
+    main()
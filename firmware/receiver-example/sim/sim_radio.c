@@ -0,0 +1,119 @@
+#include "../src/devices.h"
+#include "../src/radio.h"
+#include "../src/session.h"
+#include "../src/telemetry.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/random/random.h>
+
+LOG_MODULE_REGISTER(app_sim_radio);
+
+// Synthetic clickers: in every round, all of them press one button within SIM_WINDOW_MS (a vote), and their clicks
+// come in at the press times, already synced; the output then sees the bursts of a full classroom
+#define SIM_CLICKERS  CONFIG_APP_SIM_CLICKERS
+#define SIM_ROUND_MS  CONFIG_APP_SIM_ROUND_MS
+#define SIM_WINDOW_MS 200
+#define SIM_FIRST_ID  0x5e000000
+#define SIM_RSSI_MIN  -90
+#define SIM_RSSI_MAX  -40
+
+// Thread configuration
+#define THREAD_STACK_SIZE 1024
+#define THREAD_PRIORITY   5
+
+BUILD_ASSERT(SIM_CLICKERS <= CONFIG_APP_MAX_DEVICES, "The synthetic clickers must fit into the device table");
+
+// Queue for the clicks (from the generator thread to radio_get_click()); sized for a full round, so a main loop that
+// falls behind shows up as a late output rather than as lost clicks
+K_MSGQ_DEFINE(sim_click_msgq, sizeof(struct radio_click_t), SIM_CLICKERS, 8);
+
+// A press of a round (only accessed from the generator thread)
+struct sim_press_t {
+    uint32_t offset_us;  // Time from the start of the round
+    uint8_t clicker;
+};
+
+static struct sim_press_t presses[SIM_CLICKERS];
+static uint32_t counters[SIM_CLICKERS];
+
+/*********************************************************************************************************************
+ * PRIVATE FUNCTIONS
+ *********************************************************************************************************************/
+static void generate_round() {
+    // Insertion sort by press time; rounds are small
+    for (int i = 0; i < SIM_CLICKERS; i++) {
+        struct sim_press_t press = {
+            .offset_us = sys_rand32_get() % (SIM_WINDOW_MS * 1000),
+            .clicker   = i,
+        };
+
+        int j = i;
+        for (; j > 0 && presses[j - 1].offset_us > press.offset_us; j--) {
+            presses[j] = presses[j - 1];
+        }
+        presses[j] = press;
+    }
+}
+
+static void send_click(uint8_t clicker) {
+    struct radio_click_t click = {
+        .device_id  = SIM_FIRST_ID + clicker,
+        .counter    = ++counters[clicker],
+        .rssi       = SIM_RSSI_MIN + (int8_t)(sys_rand32_get() % (SIM_RSSI_MAX - SIM_RSSI_MIN + 1)),
+        .num_events = 1,
+        .num_synced = 1,
+    };
+
+    // The click is received at the press time, so everything after this is the receiver's own latency
+    int64_t rx_us           = k_ticks_to_us_floor64(k_uptime_ticks());
+    click.events[0].button  = sys_rand32_get() % SESSION_NUM_BUTTONS;
+    click.events[0].age_ms  = 0;
+    click.press_times_us[0] = rx_us;
+
+    devices_check_counter(click.device_id, click.counter);
+    telemetry_add_packet(click.device_id, click.counter, click.rssi, rx_us);
+    telemetry_add_latency(click.device_id, rx_us - click.press_times_us[0]);
+    if (k_msgq_put(&sim_click_msgq, &click, K_NO_WAIT) != 0) {
+        LOG_WRN("Click queue full; click from %08x dropped", click.device_id);
+    }
+}
+
+/*********************************************************************************************************************
+ * THREADS
+ *********************************************************************************************************************/
+static void sim_radio_thread_fn() {
+    LOG_INF("Generating clicks of %d clickers every %d ms", SIM_CLICKERS, SIM_ROUND_MS);
+
+    int64_t round_start = k_uptime_get();
+    while (1) {
+        generate_round();
+        for (int i = 0; i < SIM_CLICKERS; i++) {
+            k_sleep(K_TIMEOUT_ABS_US((round_start * 1000) + presses[i].offset_us));
+            send_click(presses[i].clicker);
+        }
+
+        round_start += SIM_ROUND_MS;
+        k_sleep(K_TIMEOUT_ABS_MS(round_start));
+    }
+}
+
+K_THREAD_DEFINE(sim_radio_thread_id, THREAD_STACK_SIZE, sim_radio_thread_fn, NULL, NULL, NULL, THREAD_PRIORITY, 0,
+                SYS_FOREVER_MS);
+
+/*********************************************************************************************************************
+ * PUBLIC FUNCTIONS
+ *********************************************************************************************************************/
+int radio_init() {
+    k_thread_start(sim_radio_thread_id);
+    return 0;
+}
+
+int radio_get_click(struct radio_click_t *click, k_timeout_t timeout) {
+    return k_msgq_get(&sim_click_msgq, click, timeout) == 0 ? 0 : -ETIMEDOUT;
+}
+
+int radio_send_command(uint32_t device_id, const struct packet_command_t *command, size_t len) {
+    // The synthetic clickers never pick up their acks
+    return -ENOENT;
+}
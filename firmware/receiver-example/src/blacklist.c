@@ -0,0 +1,95 @@
+#include "blacklist.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(app_blacklist);
+
+// A channel is only judged once it has this many reports; the counters are halved when they reach four times as many,
+// so old reports fade out
+#define MIN_REPORTS 32
+#define MAX_REPORTS (4 * MIN_REPORTS)
+
+// Reports of a single channel
+struct channel_t {
+    uint16_t ok;
+    uint16_t failed;
+    bool is_blacklisted;
+    int64_t blacklisted_until;  // Uptime in ms
+};
+
+// Global state
+static struct channel_t channels[CHANNELS_NUM];
+
+/*********************************************************************************************************************
+ * PRIVATE FUNCTIONS
+ *********************************************************************************************************************/
+static int num_active() {
+    int n = 0;
+    for (int i = 0; i < CHANNELS_NUM; i++) {
+        n += !channels[i].is_blacklisted;
+    }
+
+    return n;
+}
+
+static void add_report(struct channel_t *channel, bool ok) {
+    if (ok) {
+        channel->ok++;
+    } else {
+        channel->failed++;
+    }
+
+    if (channel->ok + channel->failed >= MAX_REPORTS) {
+        channel->ok /= 2;
+        channel->failed /= 2;
+    }
+}
+
+static bool is_bad(const struct channel_t *channel) {
+    uint32_t total = channel->ok + channel->failed;
+    return total >= MIN_REPORTS && channel->failed * 100 >= total * CONFIG_APP_CHANNEL_BLACKLIST_PERCENT;
+}
+
+/*********************************************************************************************************************
+ * PUBLIC FUNCTIONS
+ *********************************************************************************************************************/
+bool blacklist_report(uint8_t ok_channel, uint8_t failed_channels) {
+    for (int i = 0; i < CHANNELS_NUM; i++) {
+        if (i == ok_channel || (failed_channels & BIT(i))) {
+            add_report(&channels[i], i == ok_channel);
+        }
+    }
+
+    bool changed = false;
+    int64_t now  = k_uptime_get();
+    for (int i = 0; i < CHANNELS_NUM; i++) {
+        struct channel_t *channel = &channels[i];
+
+        // Give blacklisted channels another chance after the timeout, with a clean record
+        if (channel->is_blacklisted && now >= channel->blacklisted_until) {
+            LOG_INF("Channel %u is no longer blacklisted", channels_table[i]);
+            *channel = (struct channel_t){0};
+            changed  = true;
+        } else if (!channel->is_blacklisted && is_bad(channel) && num_active() > CHANNELS_MIN_ACTIVE) {
+            LOG_WRN("Blacklisting channel %u (%u of %u transmissions failed)", channels_table[i], channel->failed,
+                    channel->ok + channel->failed);
+            channel->is_blacklisted    = true;
+            channel->blacklisted_until = now + CONFIG_APP_CHANNEL_BLACKLIST_TIMEOUT_S * MSEC_PER_SEC;
+            changed                    = true;
+        }
+    }
+
+    return changed;
+}
+
+int blacklist_get_table(uint8_t table[CHANNELS_NUM]) {
+    int n = 0;
+    for (int i = 0; i < CHANNELS_NUM; i++) {
+        if (!channels[i].is_blacklisted) {
+            table[n++] = channels_table[i];
+        }
+    }
+
+    return n;
+}
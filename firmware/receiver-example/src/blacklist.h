@@ -0,0 +1,32 @@
+#ifndef BLACKLIST_H
+#define BLACKLIST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "channels.h"
+
+/**
+ * @brief Records the outcome of a clicker's previous transmission per channel.
+ *
+ * Channels on which a large share of the transmissions fail are blacklisted for CONFIG_APP_CHANNEL_BLACKLIST_TIMEOUT_S
+ * seconds; after that, they are given another chance. At least CHANNELS_MIN_ACTIVE channels always stay active.
+ *
+ * @param ok_channel Index of the channel the transmission succeeded on, or CHANNELS_NONE.
+ * @param failed_channels Bitmask of the indices of the channels the transmission failed on.
+ *
+ * @retval true If the set of blacklisted channels changed; the channel table must be updated.
+ * @retval false Otherwise.
+ */
+bool blacklist_report(uint8_t ok_channel, uint8_t failed_channels);
+
+/**
+ * @brief Gets the channel table without the blacklisted channels.
+ *
+ * @param table Filled with the active channels, in the order of channels_table.
+ *
+ * @return Number of active channels.
+ */
+int blacklist_get_table(uint8_t table[CHANNELS_NUM]);
+
+#endif  // BLACKLIST_H
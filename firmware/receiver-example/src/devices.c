@@ -0,0 +1,163 @@
+#include "devices.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <zephyr/kernel.h>
+
+// Index from device IDs to entries of the device table: an open addressing hash table with linear probing that is
+// twice as large as the device table, so a lookup takes about one probe even with all clickers clicking at once.
+// Devices are never removed, so entries need no tombstones.
+#define INDEX_SIZE (2 * CONFIG_APP_MAX_DEVICES)
+
+BUILD_ASSERT(CONFIG_APP_MAX_DEVICES < UINT8_MAX, "Device index entries are 8 bits wide");
+
+// A known clicker
+struct device_t {
+    uint32_t device_id;
+    uint32_t last_counter;     // Counter of the last accepted packet
+    uint32_t next_journal_id;  // Replayed events with lower journal IDs are duplicates
+    int64_t last_seen;         // Uptime of the last accepted packet in ms
+    uint8_t newer;             // Next entry in the list of active clickers + 1, 0 if none (see active_newest)
+    uint8_t older;             // Previous entry in the list of active clickers + 1, 0 if none
+    bool is_active;            // The clicker is in the list of active clickers
+};
+
+// Global state
+static struct device_t devices[CONFIG_APP_MAX_DEVICES];
+static int num_devices;
+static uint8_t device_index[INDEX_SIZE];  // Entry in devices + 1, 0 if free
+
+// The clickers seen within DEVICES_ACTIVE_WINDOW_MS, as a list ordered by last_seen: a clicker moves to the newest end
+// with every accepted packet, and the ones that fall out of the window are dropped from the oldest end, so that the
+// number of active clickers is kept up to date in constant time per packet
+static uint8_t active_newest;  // Entry in devices + 1, 0 if the list is empty
+static uint8_t active_oldest;  // Entry in devices + 1, 0 if the list is empty
+static int num_active;
+
+/*********************************************************************************************************************
+ * PRIVATE FUNCTIONS
+ *********************************************************************************************************************/
+static uint8_t *find_index_entry(uint32_t device_id) {
+    // Device IDs come from the hardware IDs of the clickers, so they are scrambled before use (Fibonacci hashing)
+    uint32_t i = (device_id * 2654435761u) % INDEX_SIZE;
+    while (device_index[i] != 0 && devices[device_index[i] - 1].device_id != device_id) {
+        i = (i + 1) % INDEX_SIZE;
+    }
+
+    return &device_index[i];
+}
+
+static struct device_t *find_device(uint32_t device_id) {
+    uint8_t *entry = find_index_entry(device_id);
+    return *entry ? &devices[*entry - 1] : NULL;
+}
+
+static struct device_t *find_or_add_device(uint32_t device_id, bool *is_new) {
+    uint8_t *entry = find_index_entry(device_id);
+    if (*entry) {
+        *is_new = false;
+        return &devices[*entry - 1];
+    }
+
+    if (num_devices == ARRAY_SIZE(devices)) {
+        return NULL;
+    }
+
+    struct device_t *device = &devices[num_devices++];
+    device->device_id       = device_id;
+    device->next_journal_id = 0;
+    *entry                  = num_devices;
+    *is_new                 = true;
+    return device;
+}
+
+static void unlink_active(struct device_t *device) {
+    uint8_t *newer_link = device->newer ? &devices[device->newer - 1].older : &active_newest;
+    uint8_t *older_link = device->older ? &devices[device->older - 1].newer : &active_oldest;
+    *newer_link         = device->older;
+    *older_link         = device->newer;
+    device->is_active   = false;
+    num_active--;
+}
+
+static void mark_active(struct device_t *device) {
+    if (device->is_active) {
+        unlink_active(device);
+    }
+
+    uint8_t entry = device - devices + 1;
+    device->newer = 0;
+    device->older = active_newest;
+    if (active_newest) {
+        devices[active_newest - 1].newer = entry;
+    } else {
+        active_oldest = entry;
+    }
+
+    active_newest     = entry;
+    device->is_active = true;
+    num_active++;
+}
+
+static void expire_active() {
+    int64_t since = k_uptime_get() - DEVICES_ACTIVE_WINDOW_MS;
+    while (active_oldest && devices[active_oldest - 1].last_seen < since) {
+        unlink_active(&devices[active_oldest - 1]);
+    }
+}
+
+/*********************************************************************************************************************
+ * PUBLIC FUNCTIONS
+ *********************************************************************************************************************/
+int devices_check_counter(uint32_t device_id, uint32_t counter) {
+    bool is_new;
+    struct device_t *device = find_or_add_device(device_id, &is_new);
+    if (device == NULL) {
+        return -ENOMEM;
+    }
+
+    if (!is_new && counter <= device->last_counter) {
+        return -EALREADY;
+    }
+
+    device->last_counter = counter;
+    device->last_seen    = k_uptime_get();
+    mark_active(device);
+    return 0;
+}
+
+int devices_check_journal_ids(uint32_t device_id, uint32_t first_id, int num_events) {
+    struct device_t *device = find_device(device_id);
+    if (device == NULL) {
+        return -ENOENT;
+    }
+
+    // Events are replayed in order, so the duplicates come first
+    int num_seen = 0;
+    if (device->next_journal_id > first_id) {
+        num_seen = MIN(device->next_journal_id - first_id, num_events);
+    }
+
+    device->next_journal_id = MAX(device->next_journal_id, first_id + num_events);
+    return num_seen;
+}
+
+int devices_get_counter(uint32_t device_id, uint32_t *counter) {
+    struct device_t *device = find_device(device_id);
+    if (device == NULL) {
+        return -ENOENT;
+    }
+
+    *counter = device->last_counter;
+    return 0;
+}
+
+int devices_get_index(uint32_t device_id) {
+    uint8_t *entry = find_index_entry(device_id);
+    return *entry ? *entry - 1 : -ENOENT;
+}
+
+int devices_count_active() {
+    expire_active();
+    return num_active;
+}
@@ -0,0 +1,74 @@
+#ifndef DEVICES_H
+#define DEVICES_H
+
+#include <stdint.h>
+
+// Clickers that sent an accepted packet within this time count as active (see devices_count_active())
+#define DEVICES_ACTIVE_WINDOW_MS 60000
+
+/**
+ * @brief Checks the packet counter of a clicker and records it.
+ *
+ * A packet is only accepted if its counter is higher than the one of the last accepted packet of the same clicker,
+ * which rejects replayed and duplicate packets.
+ *
+ * @param device_id The device ID of the clicker.
+ * @param counter The packet counter.
+ *
+ * @retval 0 If the counter is new; it is recorded as the last one of the clicker.
+ * @retval -EALREADY If the counter has been seen before (replay or duplicate).
+ * @retval -ENOMEM If the clicker is unknown and the device table is full.
+ */
+int devices_check_counter(uint32_t device_id, uint32_t counter);
+
+/**
+ * @brief Checks the journal IDs of replayed events of a clicker and records them.
+ *
+ * Clickers replay the events of packets that were not acked from their journal, so events that did arrive are
+ * replayed again. Journal IDs increase with every event, so all events up to the highest ID seen are duplicates.
+ * The clicker must have been recorded with devices_check_counter() before.
+ *
+ * @param device_id The device ID of the clicker.
+ * @param first_id Journal ID of the first event; the IDs of the others follow consecutively.
+ * @param num_events Number of events.
+ *
+ * @return Number of leading events that have been seen before (up to num_events), or -ENOENT if the clicker is
+ *         unknown.
+ */
+int devices_check_journal_ids(uint32_t device_id, uint32_t first_id, int num_events);
+
+/**
+ * @brief Gets the counter of the last accepted packet of a clicker.
+ *
+ * @param device_id The device ID of the clicker.
+ * @param counter Filled with the counter.
+ *
+ * @retval 0 If successful.
+ * @retval -ENOENT If the clicker has not sent an accepted packet yet.
+ */
+int devices_get_counter(uint32_t device_id, uint32_t *counter);
+
+/**
+ * @brief Gets the index of a clicker in the device table.
+ *
+ * Clickers keep their index until the receiver restarts, so other modules can keep per-clicker state in arrays of
+ * CONFIG_APP_MAX_DEVICES entries. The lookup takes constant time.
+ *
+ * @param device_id The device ID of the clicker.
+ *
+ * @return Index of the clicker (less than CONFIG_APP_MAX_DEVICES), or -ENOENT if the clicker has not sent an accepted
+ *         packet yet.
+ */
+int devices_get_index(uint32_t device_id);
+
+/**
+ * @brief Counts the clickers that sent an accepted packet within DEVICES_ACTIVE_WINDOW_MS.
+ *
+ * The count is kept up to date with every accepted packet, so this takes constant time per packet (amortized over the
+ * clickers that fall out of the window).
+ *
+ * @return Number of clickers.
+ */
+int devices_count_active();
+
+#endif  // DEVICES_H
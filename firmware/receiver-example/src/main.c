@@ -1,19 +1,163 @@
+#include <string.h>
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
 
+#if defined(CONFIG_DK_LIBRARY)
 #include <dk_buttons_and_leds.h>
+#endif
+
+#include "output.h"
+#include "radio.h"
+#include "session.h"
+#include "telemetry.h"
 
 LOG_MODULE_REGISTER(app_main);
 
+#if defined(CONFIG_APP_OUTPUT)
+#define STATUS_INTERVAL K_MSEC(CONFIG_APP_OUTPUT_STATUS_INTERVAL_MS)
+#else
+#define STATUS_INTERVAL K_FOREVER
+#endif
+
+#if defined(CONFIG_APP_TELEMETRY)
+#define TELEMETRY_INTERVAL K_MSEC(CONFIG_APP_TELEMETRY_INTERVAL_MS)
+#else
+#define TELEMETRY_INTERVAL K_FOREVER
+#endif
+
+// Device ID of the clicker that clicked last; the buttons of the DK send commands to it
+static atomic_t last_device_id;
+
+#if defined(CONFIG_DK_LIBRARY)
+static void on_button_changed(uint32_t button_state, uint32_t has_changed) {
+    uint32_t pressed   = button_state & has_changed;
+    uint32_t device_id = atomic_get(&last_device_id);
+    if (pressed == 0 || device_id == 0) {
+        return;
+    }
+
+    // Button 1: flash green on D2, button 2: play the error melody, button 3: send our host ID, button 4: sleep
+    // (the values of the clicker's enums are part of the protocol, see packet.h)
+    struct packet_command_t command = {0};
+    size_t len                      = sizeof(command.command);
+    if (pressed & DK_BTN1_MSK) {
+        command.command      = PACKET_COMMAND_LEDS;
+        command.leds.led     = 1;  // LEDS_D2
+        command.leds.pattern = 1;  // LEDS_FLASH
+        command.leds.g       = 255;
+        command.leds.reps    = 3;
+        len += sizeof(command.leds);
+    } else if (pressed & DK_BTN2_MSK) {
+        command.command = PACKET_COMMAND_MELODY;
+        command.melody  = 1;  // SPEAKER_MELODY_ERROR
+        len += sizeof(command.melody);
+    } else if (pressed & DK_BTN3_MSK) {
+        command.command = PACKET_COMMAND_HOST_ID;
+        hex2bin(CONFIG_APP_HOST_ID, strlen(CONFIG_APP_HOST_ID), command.host_id, sizeof(command.host_id));
+        len += sizeof(command.host_id);
+    } else if (pressed & DK_BTN4_MSK) {
+        command.command = PACKET_COMMAND_SLEEP;
+    } else {
+        return;
+    }
+
+    if (radio_send_command(device_id, &command, len) == 0) {
+        LOG_INF("Command %u queued for %08x", command.command, device_id);
+    }
+}
+#endif  // CONFIG_DK_LIBRARY
+
+static void on_session_update(const struct session_update_t *update) {
+    output_write_session(update);
+
+    switch (update->type) {
+        case SESSION_UPDATE_RANK:
+            if (update->rank == SESSION_RANK_NONE) {
+                LOG_INF("Round %u: %08x dropped out of the ranking", update->round, update->device_id);
+            } else {
+                LOG_INF("Round %u: %08x ranked #%u with button %d (pressed at %lld us)", update->round,
+                        update->device_id, update->rank + 1, update->button + 1, update->press_time_us);
+            }
+            break;
+
+        case SESSION_UPDATE_TALLY:
+            LOG_INF("Round %u: button %d has %u answers", update->round, update->button + 1, update->count);
+            break;
+
+        case SESSION_UPDATE_LOCKOUT:
+            LOG_INF("Round %u: %08x is locked out", update->round, update->device_id);
+            break;
+
+        case SESSION_UPDATE_CLOSED:
+            LOG_INF("Round %u closed with %u answers", update->round, update->count);
+            break;
+    }
+}
+
 int main(void) {
+    // Runs before the radio is up, so that no clicks get in the way
+    session_benchmark_run();
+
+    if (radio_init() != 0) {
+        LOG_ERR("Initialization failed.");
+        return 0;
+    }
+
+    if (output_init() != 0) {
+        LOG_WRN("Failed to initialize the output; clicks are only logged");
+    }
+
+#if defined(CONFIG_DK_LIBRARY)
+    if (dk_buttons_init(on_button_changed) != 0) {
+        LOG_WRN("Failed to initialize the buttons; commands are not available");
+    }
+#endif
+
+    // The example runs a single quiz round; an application opens and closes rounds as its host tells it to
+    session_init(on_session_update);
+    session_open_round(SESSION_MODE_QUIZ);
+
     LOG_INF("Starting main loop...");
 
-    int i = 0;
+    // Wait for clicks; the status of the output and the link telemetry are sent in between
+    k_timepoint_t next_status    = sys_timepoint_calc(STATUS_INTERVAL);
+    k_timepoint_t next_telemetry = sys_timepoint_calc(TELEMETRY_INTERVAL);
     while (1) {
-        LOG_INF("Still alive %d", i);
-        ++i;
+        if (sys_timepoint_expired(next_status)) {
+            output_write_status();
+            next_status = sys_timepoint_calc(STATUS_INTERVAL);
+        }
+
+        if (sys_timepoint_expired(next_telemetry)) {
+            telemetry_write_snapshots();
+            next_telemetry = sys_timepoint_calc(TELEMETRY_INTERVAL);
+        }
+
+        k_timepoint_t next_wakeup = sys_timepoint_cmp(next_status, next_telemetry) < 0 ? next_status : next_telemetry;
+
+        struct radio_click_t click;
+        if (radio_get_click(&click, sys_timepoint_timeout(next_wakeup)) == 0) {
+            for (int i = 0; i < click.num_events; i++) {
+                const struct packet_event_t *event = &click.events[i];
+                const char *kind                   = click.is_replay ? "Replayed click" : "Click";
+                if (event->age_ms == PACKET_AGE_UNKNOWN) {
+                    LOG_INF("%s from %08x (packet %u, RSSI %d dBm): button: %d, long: %d, shift: %d, age: unknown",
+                            kind, click.device_id, click.counter, click.rssi, event->button + 1, event->is_long_press,
+                            event->shift_presses);
+                } else {
+                    LOG_INF("%s from %08x (packet %u, RSSI %d dBm): button: %d, long: %d, shift: %d, age: %u ms, "
+                            "pressed at %lld us%s",
+                            kind, click.device_id, click.counter, click.rssi, event->button + 1, event->is_long_press,
+                            event->shift_presses, event->age_ms, click.press_times_us[i],
+                            i < click.num_synced ? " (synced)" : "");
+                }
+            }
 
-        k_sleep(K_SECONDS(1));
+            output_write_click(&click);
+            session_add_click(&click);
+            atomic_set(&last_device_id, click.device_id);
+        }
     }
 
     return 0;
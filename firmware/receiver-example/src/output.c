@@ -0,0 +1,232 @@
+#include "output.h"
+
+#include <string.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/crc.h>
+
+LOG_MODULE_REGISTER(app_output);
+
+// Output ring: a single-producer single-consumer byte ring with free-running indices. The producer side (the threads
+// calling output_write(), serialized by producer_mutex) only writes ring_head, the consumer (the UART, which sends
+// straight from the ring with DMA) only writes ring_tail, so neither ever waits for the other.
+#define RING_SIZE CONFIG_APP_OUTPUT_RING_SIZE
+#define RING_MASK (RING_SIZE - 1)
+
+BUILD_ASSERT(IS_POWER_OF_TWO(RING_SIZE), "The output ring size must be a power of 2");
+BUILD_ASSERT(RING_SIZE <= UINT16_MAX, "The output ring size is reported in 16 bits");
+
+// Largest raw frame and its COBS encoding (one code byte per 254 bytes, plus the zero byte at the end)
+#define MAX_RAW_LEN     (sizeof(struct output_header_t) + OUTPUT_MAX_BODY_LEN + sizeof(uint16_t))
+#define COBS_LEN(len)   ((len) + (len) / 254 + 2)
+#define COBS_MAX_CODE   0xff
+#define CRC_SEED        0xffff
+
+static const struct device *const uart = DEVICE_DT_GET(DT_CHOSEN(app_output_uart));
+
+// Global state (shared between the producers and the UART callback)
+static uint8_t ring[RING_SIZE];
+static atomic_t ring_head;  // Index of the next byte to write (only written by the producers)
+static atomic_t ring_tail;  // Index of the next byte to send (only written by the UART callback)
+static atomic_t tx_busy;    // A transfer is in progress; whoever sets it starts the transfer
+static atomic_t num_bytes;  // Bytes sent since startup
+
+// Global state (protected by producer_mutex)
+static uint16_t next_seq;
+static uint32_t num_frames;
+static uint32_t num_dropped;
+static uint16_t ring_peak;
+
+static K_MUTEX_DEFINE(producer_mutex);
+
+/*********************************************************************************************************************
+ * PRIVATE FUNCTIONS
+ *********************************************************************************************************************/
+static uint32_t cobs_encode(uint32_t at, const uint8_t *data, size_t len) {
+    // Every zero byte is replaced by the distance to the next one, and the frame is terminated by a zero byte
+    uint32_t code_at = at++;
+    uint8_t code     = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] != 0) {
+            ring[at++ & RING_MASK] = data[i];
+            code++;
+        }
+
+        if (data[i] == 0 || code == COBS_MAX_CODE) {
+            ring[code_at & RING_MASK] = code;
+            code_at                   = at++;
+            code                      = 1;
+        }
+    }
+
+    ring[code_at & RING_MASK] = code;
+    ring[at++ & RING_MASK]    = 0;
+    return at;
+}
+
+static void start_tx() {
+    // Whoever gets tx_busy sends everything that is contiguous in the ring; if there is nothing to send, tx_busy is
+    // released, and the check is repeated in case a frame came in right before that
+    while (atomic_cas(&tx_busy, false, true)) {
+        uint32_t tail = atomic_get(&ring_tail);
+        uint32_t len  = atomic_get(&ring_head) - tail;
+        if (len > 0) {
+            len     = MIN(len, RING_SIZE - (tail & RING_MASK));
+            int res = uart_tx(uart, &ring[tail & RING_MASK], len, SYS_FOREVER_US);
+            if (res == 0) {
+                return;
+            }
+
+            // The frames stay in the ring and go out with the next frame
+            LOG_ERR("uart_tx() returned %d", res);
+            atomic_set(&tx_busy, false);
+            return;
+        }
+
+        atomic_set(&tx_busy, false);
+        if (atomic_get(&ring_head) == atomic_get(&ring_tail)) {
+            return;
+        }
+    }
+}
+
+/*********************************************************************************************************************
+ * INTERRUPT HANDLERS
+ *********************************************************************************************************************/
+static void on_uart_event(const struct device *dev, struct uart_event *evt, void *user_data) {
+    switch (evt->type) {
+        case UART_TX_DONE:
+        case UART_TX_ABORTED:
+            atomic_add(&ring_tail, evt->data.tx.len);
+            atomic_add(&num_bytes, evt->data.tx.len);
+            atomic_set(&tx_busy, false);
+            start_tx();
+            break;
+
+        default:
+            break;
+    }
+}
+
+/*********************************************************************************************************************
+ * PUBLIC FUNCTIONS
+ *********************************************************************************************************************/
+int output_init() {
+    if (!device_is_ready(uart)) {
+        LOG_ERR("Output UART not ready");
+        return -ENODEV;
+    }
+
+    int res = uart_callback_set(uart, on_uart_event, NULL);
+    if (res) {
+        LOG_ERR("Failed to set the UART callback: %d", res);
+        return res;
+    }
+
+    LOG_INF("Output initialized OK (%s)", uart->name);
+    return 0;
+}
+
+int output_write(enum output_frame_type_t type, const void *body, size_t len) {
+    if (len > OUTPUT_MAX_BODY_LEN) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&producer_mutex, K_FOREVER);
+
+    uint8_t raw[MAX_RAW_LEN];
+    struct output_header_t header = {
+        .version = OUTPUT_PROTOCOL_VERSION,
+        .type    = type,
+        .seq     = next_seq++,
+    };
+    memcpy(raw, &header, sizeof(header));
+    memcpy(&raw[sizeof(header)], body, len);
+
+    size_t raw_len = sizeof(header) + len;
+    uint16_t crc   = crc16_ccitt(CRC_SEED, raw, raw_len);
+    raw[raw_len++] = crc & 0xff;
+    raw[raw_len++] = crc >> 8;
+
+    // The tail only moves forward in the meantime, so the free space can only grow
+    int res       = 0;
+    uint32_t head = atomic_get(&ring_head);
+    uint32_t used = head - atomic_get(&ring_tail);
+    if (RING_SIZE - used < COBS_LEN(raw_len)) {
+        num_dropped++;
+        res = -ENOBUFS;
+    } else {
+        head = cobs_encode(head, raw, raw_len);
+        atomic_set(&ring_head, head);
+        num_frames++;
+        ring_peak = MAX(ring_peak, used + COBS_LEN(raw_len));
+    }
+
+    k_mutex_unlock(&producer_mutex);
+
+    if (res == 0) {
+        start_tx();
+    }
+
+    return res;
+}
+
+int output_write_click(const struct radio_click_t *click) {
+    uint8_t body[OUTPUT_MAX_BODY_LEN];
+    struct output_click_t *frame = (struct output_click_t *)body;
+    frame->device_id             = click->device_id;
+    frame->counter               = click->counter;
+    frame->rssi                  = click->rssi;
+    frame->flags                 = click->is_replay ? OUTPUT_CLICK_REPLAY : 0;
+    frame->num_events            = click->num_events;
+    frame->num_synced            = click->num_synced;
+
+    struct output_event_t *events = (struct output_event_t *)&body[sizeof(*frame)];
+    for (int i = 0; i < click->num_events; i++) {
+        events[i].button        = click->events[i].button;
+        events[i].flags         = click->events[i].is_long_press ? OUTPUT_EVENT_LONG_PRESS : 0;
+        events[i].shift_presses = click->events[i].shift_presses;
+        events[i].age_ms        = click->events[i].age_ms;
+        events[i].press_time_us = click->press_times_us[i];
+    }
+
+    return output_write(OUTPUT_FRAME_CLICK, body, sizeof(*frame) + click->num_events * sizeof(*events));
+}
+
+int output_write_session(const struct session_update_t *update) {
+    struct output_session_t frame = {
+        .round         = update->round,
+        .device_id     = update->device_id,
+        .type          = update->type,
+        .button        = update->button,
+        .rank          = update->rank,
+        .count         = update->count,
+        .press_time_us = update->press_time_us,
+    };
+
+    return output_write(OUTPUT_FRAME_SESSION, &frame, sizeof(frame));
+}
+
+int output_write_status() {
+    struct uart_config config = {0};
+    uart_config_get(uart, &config);
+
+    k_mutex_lock(&producer_mutex, K_FOREVER);
+
+    struct output_status_t status = {
+        .uptime_ms   = k_uptime_get_32(),
+        .num_frames  = num_frames,
+        .num_dropped = num_dropped,
+        .num_bytes   = atomic_get(&num_bytes),
+        .baudrate    = config.baudrate,
+        .ring_size   = RING_SIZE,
+        .ring_peak   = ring_peak,
+    };
+    ring_peak = 0;
+
+    k_mutex_unlock(&producer_mutex);
+
+    return output_write(OUTPUT_FRAME_STATUS, &status, sizeof(status));
+}
@@ -0,0 +1,183 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/sys/util_macro.h>
+#include <zephyr/toolchain.h>
+
+#include "radio.h"
+#include "session.h"
+
+// Binary output to the host on the UART chosen as app,output-uart. Every frame is COBS encoded and terminated by a
+// zero byte, so the host can pick up at the next zero byte after losing data. Decoded, a frame consists of struct
+// output_header_t, the body of its type and a CRC-16/CCITT (seed 0xffff) over header and body. All fields are little
+// endian. The layout is part of the protocol (see scripts/output_decode.py).
+#define OUTPUT_PROTOCOL_VERSION 1
+#define OUTPUT_MAX_BODY_LEN     128
+
+enum output_frame_type_t {
+    OUTPUT_FRAME_STATUS    = 0,  // struct output_status_t, every CONFIG_APP_OUTPUT_STATUS_INTERVAL_MS
+    OUTPUT_FRAME_CLICK     = 1,  // struct output_click_t, followed by num_events struct output_event_t
+    OUTPUT_FRAME_SESSION   = 2,  // struct output_session_t
+    OUTPUT_FRAME_TELEMETRY = 3,  // struct output_telemetry_t, CONFIG_APP_TELEMETRY_SNAPSHOTS per interval
+};
+
+struct output_header_t {
+    uint8_t version;  // OUTPUT_PROTOCOL_VERSION
+    uint8_t type;     // enum output_frame_type_t
+    uint16_t seq;     // Increments with every frame, including dropped ones; a gap means frames were lost
+} __packed;
+
+// Health of the output itself
+struct output_status_t {
+    uint32_t uptime_ms;
+    uint32_t num_frames;   // Frames queued since startup
+    uint32_t num_dropped;  // Frames dropped since startup because the ring was full
+    uint32_t num_bytes;    // Bytes sent since startup
+    uint32_t baudrate;     // Baudrate of the UART
+    uint16_t ring_size;    // Size of the ring in bytes
+    uint16_t ring_peak;    // Highest fill level of the ring since the last status frame in bytes
+} __packed;
+
+// Flags of struct output_click_t
+#define OUTPUT_CLICK_REPLAY BIT(0)  // The events were replayed from the clicker's journal
+
+// A click (see struct radio_click_t)
+struct output_click_t {
+    uint32_t device_id;
+    uint32_t counter;
+    int8_t rssi;
+    uint8_t flags;  // OUTPUT_CLICK_* flags
+    uint8_t num_events;
+    uint8_t num_synced;
+} __packed;
+
+// Flags of struct output_event_t
+#define OUTPUT_EVENT_LONG_PRESS BIT(0)
+
+struct output_event_t {
+    uint8_t button;  // 0 for button 1
+    uint8_t flags;   // OUTPUT_EVENT_* flags
+    uint8_t shift_presses;
+    uint32_t age_ms;        // PACKET_AGE_UNKNOWN if unknown
+    int64_t press_time_us;  // RADIO_TIME_UNKNOWN if unknown
+} __packed;
+
+// A change of the results of a round (see struct session_update_t)
+struct output_session_t {
+    uint32_t round;
+    uint32_t device_id;
+    uint8_t type;  // enum session_update_type_t
+    uint8_t button;
+    uint8_t rank;
+    uint16_t count;
+    int64_t press_time_us;
+} __packed;
+
+// Histogram bins of struct output_telemetry_t. RSSI bin i counts the packets with an RSSI in (-40 - 8 (i + 1),
+// -40 - 8 i] dBm; latency bin 0 the synced clicks with a latency below 2 ms, bin i the ones in [2 * 2^(i - 1),
+// 2 * 2^i) ms. The first and last bins also count everything above and below.
+#define OUTPUT_TELEMETRY_BINS        8
+#define OUTPUT_TELEMETRY_RSSI_TOP    -40
+#define OUTPUT_TELEMETRY_RSSI_STEP   8
+#define OUTPUT_TELEMETRY_LATENCY_MIN 2  // ms
+
+// Link statistics of a clicker; the counts cover period_ms and saturate at UINT16_MAX
+struct output_telemetry_t {
+    uint32_t device_id;
+    uint32_t period_ms;     // Time since the previous snapshot of the clicker (or since its first packet)
+    uint32_t last_seen_ms;  // Time since the last packet of the clicker
+    uint32_t jitter_us;     // Variation of the latency between synced click packets (RFC 3550 interarrival jitter)
+    uint16_t num_packets;   // Packets accepted
+    uint16_t num_retries;   // Retransmissions reported by the clicker (see PACKET_LINK_RETRIES_SHIFT)
+    uint16_t num_lost;      // Packets that never arrived (gaps in the packet counter)
+    uint16_t rssi_bins[OUTPUT_TELEMETRY_BINS];
+    uint16_t latency_bins[OUTPUT_TELEMETRY_BINS];
+} __packed;
+
+BUILD_ASSERT(sizeof(struct output_click_t) + PACKET_MAX_EVENTS * sizeof(struct output_event_t) <= OUTPUT_MAX_BODY_LEN,
+             "Click frames must fit");
+BUILD_ASSERT(sizeof(struct output_telemetry_t) <= OUTPUT_MAX_BODY_LEN, "Telemetry frames must fit");
+
+#if defined(CONFIG_APP_OUTPUT)
+
+/**
+ * @brief Initializes the output UART.
+ *
+ * @retval 0 If successful.
+ * @retval -ENODEV If the UART is not ready.
+ */
+int output_init();
+
+/**
+ * @brief Queues a frame for the host.
+ *
+ * The frame is encoded right into the output ring, which the UART sends from with DMA as soon as it is idle, so all
+ * frames queued in the meantime go out in one transfer. Never blocks on the UART: if the ring is full, the frame is
+ * dropped and counted. Must not be called from interrupts.
+ *
+ * @param type The type of the frame.
+ * @param body The body of the frame.
+ * @param len Length of the body in bytes (at most OUTPUT_MAX_BODY_LEN).
+ *
+ * @retval 0 If the frame was queued.
+ * @retval -ENOBUFS If the ring is full; the frame was dropped.
+ * @retval -EINVAL If the body is too long.
+ */
+int output_write(enum output_frame_type_t type, const void *body, size_t len);
+
+/**
+ * @brief Queues a click frame (see output_write()).
+ *
+ * @param click The click.
+ *
+ * @retval 0 If the frame was queued.
+ * @retval -ENOBUFS If the ring is full; the frame was dropped.
+ */
+int output_write_click(const struct radio_click_t *click);
+
+/**
+ * @brief Queues a session frame (see output_write()).
+ *
+ * @param update The update of the results.
+ *
+ * @retval 0 If the frame was queued.
+ * @retval -ENOBUFS If the ring is full; the frame was dropped.
+ */
+int output_write_session(const struct session_update_t *update);
+
+/**
+ * @brief Queues a status frame (see output_write()) and starts a new period for the peak fill level of the ring.
+ *
+ * @retval 0 If the frame was queued.
+ * @retval -ENOBUFS If the ring is full; the frame was dropped.
+ */
+int output_write_status();
+
+#else
+
+static inline int output_init() {
+    return 0;
+}
+
+static inline int output_write(enum output_frame_type_t type, const void *body, size_t len) {
+    return -ENOTSUP;
+}
+
+static inline int output_write_click(const struct radio_click_t *click) {
+    return -ENOTSUP;
+}
+
+static inline int output_write_session(const struct session_update_t *update) {
+    return -ENOTSUP;
+}
+
+static inline int output_write_status() {
+    return -ENOTSUP;
+}
+
+#endif  // CONFIG_APP_OUTPUT
+
+#endif  // OUTPUT_H
@@ -0,0 +1,621 @@
+#include "radio.h"
+#include "blacklist.h"
+#include "devices.h"
+#include "telemetry.h"
+
+#include <gzll_glue.h>
+#include <nrf_gzll.h>
+#include <string.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+
+LOG_MODULE_REGISTER(app_radio);
+
+// Gazell configuration; must match the clickers
+#define PAIRING_PIPE 0  // Uses the pairing address as base address 0
+#define DATA_PIPE    1  // Uses the system address (base address 1 and prefix)
+
+#define GAZELL_DISABLE_TIMEOUT K_MSEC(100)
+
+// Click, replay and sync packets carry at least one button event
+#define CLICK_MIN_LEN  (offsetof(struct packet_click_t, events) + PACKET_EVENT_SIZE)
+#define REPLAY_MIN_LEN (offsetof(struct packet_replay_t, events) + PACKET_EVENT_SIZE)
+#define SYNC_MIN_LEN   (offsetof(struct packet_sync_t, press_ages_us) + sizeof(uint32_t))
+
+#if defined(CONFIG_APP_TIME_SYNC)
+#define MAX_PENDING_SYNCS CONFIG_APP_MAX_PENDING_SYNCS
+#define SYNC_TIMEOUT      K_MSEC(CONFIG_APP_TIME_SYNC_TIMEOUT_MS)
+#else
+#define MAX_PENDING_SYNCS 0
+#define SYNC_TIMEOUT      K_NO_WAIT
+#endif
+
+// The clickers spread their packets over a number of slots (channels and delays) that we hint in the acks; it is
+// twice the number of active clickers (see devices_count_active()), rounded up to a power of 2, which keeps the share
+// of clickers that share a slot low (see scripts/burst_sim.py of the clicker)
+#define MIN_NUM_SLOTS 8
+#define MAX_NUM_SLOTS 128
+
+// Commands are broadcast in the ack payloads of the data pipe until the addressed clicker confirms them; the pending
+// commands and the slot hint take turns
+enum command_state_t {
+    COMMAND_FREE,
+    COMMAND_PENDING,
+};
+
+struct command_t {
+    atomic_t state;                 // enum command_state_t; the other fields may only be changed while COMMAND_FREE
+    uint32_t device_id;             // Addressed clicker
+    uint32_t counter;               // Counter the command was sealed with
+    uint8_t data[PACKET_MAX_SIZE];  // Sealed command
+    uint8_t len;                    // Length of the sealed command in bytes
+    struct packet_command_t body;   // Command in plain text, for sealing it again with a newer counter
+    uint8_t body_len;               // Length of the command in plain text in bytes
+    uint8_t command;                // enum packet_command_id_t
+    uint16_t clicks;                // Clicks received from the clicker since the command was queued
+    int64_t queued_at_ms;           // Uptime when the command was queued
+};
+
+// Queue for received packets (from the radio interrupt to radio_get_click())
+#define RX_QUEUE_SIZE 16
+
+struct rx_packet_t {
+    uint8_t data[PACKET_MAX_SIZE];
+    uint8_t len;
+    uint8_t pipe;
+    int8_t rssi;
+    int64_t rx_us;  // Uptime when the packet was received
+};
+
+// A click that waits for the sync packet of its clicker
+struct pending_click_t {
+    bool is_used;
+    int64_t rx_us;  // Uptime when the click packet was received; the clicker measures the press times against it
+    k_timepoint_t deadline;
+    struct radio_click_t click;
+};
+
+K_MSGQ_DEFINE(radio_rx_msgq, sizeof(struct rx_packet_t), RX_QUEUE_SIZE, 4);
+
+// Global state
+static uint8_t packet_valid_id[3];
+static struct packet_pair_response_t pairing_info;
+
+static K_SEM_DEFINE(disabled_sem, 0, 1);
+
+static atomic_t num_slots = ATOMIC_INIT(MIN_NUM_SLOTS);
+
+static struct command_t commands[CONFIG_APP_MAX_PENDING_COMMANDS];
+static K_MUTEX_DEFINE(commands_mutex);  // Serializes the threads changing the commands; the ack payloads only read them
+
+// Global state (only accessed from radio_get_click())
+static struct pending_click_t pending_clicks[MAX_PENDING_SYNCS];
+
+// Global state (only accessed from the radio interrupt)
+static int next_turn;  // Index of the next command to send in an ack payload, ARRAY_SIZE(commands) for the slot hint
+
+/*********************************************************************************************************************
+ * GAZELL CALLBACKS (called from the radio interrupt)
+ *********************************************************************************************************************/
+static void add_ack_payload() {
+    // The payload goes out with the ack of the next packet on the data pipe, whoever sends it
+    if (nrf_gzll_get_tx_fifo_packet_count(DATA_PIPE) != 0) {
+        return;
+    }
+
+    // The pending commands take turns; in every round, the slot hint gets a turn as well
+    for (int i = 0; i <= ARRAY_SIZE(commands); i++) {
+        int turn  = next_turn;
+        next_turn = (next_turn + 1) % (ARRAY_SIZE(commands) + 1);
+        if (turn == ARRAY_SIZE(commands)) {
+            break;
+        }
+
+        struct command_t *command = &commands[turn];
+        if (atomic_get(&command->state) == COMMAND_PENDING) {
+            nrf_gzll_add_packet_to_tx_fifo(DATA_PIPE, command->data, command->len);
+            return;
+        }
+    }
+
+    struct packet_slot_hint_t hint = {
+        .type      = PACKET_TYPE_SLOT_HINT,
+        .num_slots = atomic_get(&num_slots),
+        .flags     = IS_ENABLED(CONFIG_APP_TIME_SYNC) ? PACKET_SLOT_HINT_TIME_SYNC : 0,
+    };
+
+    nrf_gzll_add_packet_to_tx_fifo(DATA_PIPE, (uint8_t *)&hint, sizeof(hint));
+}
+
+void nrf_gzll_host_rx_data_ready(uint32_t pipe, nrf_gzll_host_rx_info_t rx_info) {
+    // Taken first, since the clicker takes the time of the ack right away as well (see process_sync())
+    int64_t rx_us = k_ticks_to_us_floor64(k_uptime_ticks());
+
+    struct rx_packet_t packet;
+    uint32_t len = sizeof(packet.data);
+
+    if (!nrf_gzll_fetch_packet_from_rx_fifo(pipe, packet.data, &len)) {
+        return;
+    }
+
+    packet.len   = len;
+    packet.pipe  = pipe;
+    packet.rssi  = rx_info.rssi;
+    packet.rx_us = rx_us;
+
+    // If the queue is full, the packet is lost; the clicker does not retransmit since it has already been acked
+    k_msgq_put(&radio_rx_msgq, &packet, K_NO_WAIT);
+
+    if (pipe == DATA_PIPE) {
+        add_ack_payload();
+    }
+}
+
+void nrf_gzll_device_tx_success(uint32_t pipe, nrf_gzll_device_tx_info_t tx_info) {
+}
+
+void nrf_gzll_device_tx_failed(uint32_t pipe, nrf_gzll_device_tx_info_t tx_info) {
+}
+
+void nrf_gzll_disabled() {
+    k_sem_give(&disabled_sem);
+}
+
+/*********************************************************************************************************************
+ * PRIVATE FUNCTIONS
+ *********************************************************************************************************************/
+static int parse_hex(const char *hex, uint8_t *buf, size_t len) {
+    if (strlen(hex) != 2 * len || hex2bin(hex, strlen(hex), buf, len) != len) {
+        return -EINVAL;
+    }
+
+    return 0;
+}
+
+static int set_channel_table() {
+    // The channel table can only be changed while Gazell is disabled
+    if (nrf_gzll_is_enabled()) {
+        k_sem_reset(&disabled_sem);
+        nrf_gzll_disable();
+        if (k_sem_take(&disabled_sem, GAZELL_DISABLE_TIMEOUT) != 0) {
+            return -ETIMEDOUT;
+        }
+    }
+
+    uint8_t table[CHANNELS_NUM];
+    int len = blacklist_get_table(table);
+
+    bool ok = nrf_gzll_set_channel_table(table, len);
+    ok      = ok && nrf_gzll_enable();
+
+    return ok ? 0 : -EIO;
+}
+
+static void send_pairing_response(const struct packet_header_t *request) {
+    // The response is bound to the request by its counter; the clicker fetches it with the ack of its next packet
+    struct packet_header_t header = {
+        .type      = PACKET_TYPE_PAIR_RESPONSE,
+        .device_id = request->device_id,
+        .counter   = request->counter,
+    };
+    memcpy(header.valid_id, packet_valid_id, sizeof(header.valid_id));
+
+    uint8_t buf[PACKET_MAX_SIZE];
+    int len = packet_seal(&header, &pairing_info, sizeof(pairing_info), buf);
+    if (len < 0) {
+        LOG_ERR("Failed to seal pairing response: %d", len);
+        return;
+    }
+
+    // Drop the response to a previous request that has not been fetched, so that it cannot block this one
+    nrf_gzll_flush_tx_fifo(PAIRING_PIPE);
+    if (!nrf_gzll_add_packet_to_tx_fifo(PAIRING_PIPE, buf, len)) {
+        LOG_ERR("Failed to queue pairing response: error %d", nrf_gzll_get_error_code());
+        return;
+    }
+
+    LOG_INF("Pairing device %08x", request->device_id);
+}
+
+static int seal_command(struct command_t *command, uint32_t counter) {
+    struct packet_header_t header = {
+        .type      = PACKET_TYPE_COMMAND,
+        .device_id = command->device_id,
+        .counter   = counter,
+    };
+    memcpy(header.valid_id, packet_valid_id, sizeof(header.valid_id));
+
+    int len = packet_seal(&header, &command->body, command->body_len, command->data);
+    if (len < 0) return len;
+
+    command->counter = counter;
+    command->len     = len;
+    return 0;
+}
+
+static void confirm_commands(uint32_t device_id, uint32_t counter, uint32_t last_command) {
+    k_mutex_lock(&commands_mutex, K_FOREVER);
+
+    for (int i = 0; i < ARRAY_SIZE(commands); i++) {
+        struct command_t *command = &commands[i];
+        if (atomic_get(&command->state) != COMMAND_PENDING || command->device_id != device_id) {
+            continue;
+        }
+
+        // The clicker only gets the command with the ack of one of its own packets and confirms it with the next one by
+        // echoing its counter
+        command->clicks++;
+        if (last_command == command->counter) {
+            LOG_INF("Command %u confirmed by %08x after %u clicks and %lld ms", command->command, device_id,
+                    command->clicks, k_uptime_get() - command->queued_at_ms);
+            atomic_set(&command->state, COMMAND_FREE);
+        } else if (last_command > command->counter) {
+            // The clicker has lost its retained state and skipped past the counter (see init_counter() of the
+            // clicker), so it would never apply the command; it gets it again sealed with the counter of this click
+            atomic_set(&command->state, COMMAND_FREE);
+            int res = seal_command(command, counter);
+            if (res) {
+                LOG_WRN("Failed to seal command %u for %08x again: %d", command->command, device_id, res);
+                continue;
+            }
+
+            LOG_INF("Command %u sealed again for %08x", command->command, device_id);
+            atomic_set(&command->state, COMMAND_PENDING);
+        }
+    }
+
+    k_mutex_unlock(&commands_mutex);
+}
+
+static int process_click(const struct packet_header_t *header, const uint8_t *body, size_t len,
+                         struct radio_click_t *click) {
+    // A click packet carries all button events that were queued on the clicker when it was sealed
+    const struct packet_click_t *body_click = (const struct packet_click_t *)body;
+    size_t events_len                       = len - offsetof(struct packet_click_t, events);
+    int num_events                          = packet_decode_events(body_click->events, events_len, click->events);
+    if (num_events < 0) {
+        LOG_WRN("Dropping click packet %u of device %08x with invalid events", header->counter, header->device_id);
+        return num_events;
+    }
+
+    // Clickers report how their previous packet fared on each channel
+    uint8_t ok_channel = body_click->link & PACKET_LINK_CHANNEL_MASK;
+    if (ok_channel == PACKET_LINK_NO_CHANNEL) {
+        ok_channel = CHANNELS_NONE;
+    }
+
+    if (blacklist_report(ok_channel, body_click->failed_channels)) {
+        int res = set_channel_table();
+        if (res) {
+            LOG_ERR("Failed to update the channel table: %d", res);
+        }
+    }
+
+    telemetry_add_retries(header->device_id, body_click->link >> PACKET_LINK_RETRIES_SHIFT);
+
+    confirm_commands(header->device_id, header->counter, body_click->last_command);
+
+    click->is_replay  = false;
+    click->num_events = num_events;
+    return 0;
+}
+
+static int process_replay(const struct packet_header_t *header, const uint8_t *body, size_t len,
+                          struct radio_click_t *click) {
+    const struct packet_replay_t *replay = (const struct packet_replay_t *)body;
+    size_t events_len                    = len - offsetof(struct packet_replay_t, events);
+    int num_events                       = packet_decode_events(replay->events, events_len, click->events);
+    if (num_events < 0) {
+        LOG_WRN("Dropping replay packet %u of device %08x with invalid events", header->counter, header->device_id);
+        return num_events;
+    }
+
+    // Events may be replayed again if the ack of their replay packet got lost
+    int num_seen = devices_check_journal_ids(header->device_id, replay->first_id, num_events);
+    if (num_seen < 0) return num_seen;
+
+    if (num_seen == num_events) {
+        LOG_DBG("Dropping replayed events %u-%u of device %08x (duplicates)", replay->first_id,
+                replay->first_id + num_events - 1, header->device_id);
+        return -EALREADY;
+    }
+
+    // The ages in the packet are relative to the newest event
+    click->is_replay  = true;
+    click->num_events = num_events - num_seen;
+    for (int i = 0; i < click->num_events; i++) {
+        click->events[i] = click->events[num_seen + i];
+        if (replay->age_ms == PACKET_AGE_UNKNOWN) {
+            click->events[i].age_ms = PACKET_AGE_UNKNOWN;
+        } else {
+            click->events[i].age_ms += replay->age_ms;
+        }
+    }
+
+    return 0;
+}
+
+static int process_sync(const struct packet_header_t *header, const uint8_t *body, size_t len,
+                        struct radio_click_t *click) {
+    // The sync packet belongs to the last click packet of the clicker, unless that has been returned already
+    const struct packet_sync_t *sync = (const struct packet_sync_t *)body;
+    struct pending_click_t *pending  = NULL;
+    for (int i = 0; i < ARRAY_SIZE(pending_clicks); i++) {
+        const struct radio_click_t *pending_click = &pending_clicks[i].click;
+        if (pending_clicks[i].is_used && pending_click->device_id == header->device_id &&
+            pending_click->counter == sync->counter) {
+            pending = &pending_clicks[i];
+            break;
+        }
+    }
+
+    if (pending == NULL) {
+        LOG_DBG("Dropping late sync packet for packet %u of device %08x", sync->counter, header->device_id);
+        return -ENOENT;
+    }
+
+    // Both sides took the time when the click packet got through: we on reception, the clicker on the ack
+    size_t num_ages   = (len - offsetof(struct packet_sync_t, press_ages_us)) / sizeof(uint32_t);
+    *click            = pending->click;
+    click->num_synced = MIN(num_ages, click->num_events);
+    for (int i = 0; i < click->num_synced; i++) {
+        click->press_times_us[i] = pending->rx_us - sync->press_ages_us[i];
+    }
+
+    // The latency is taken from the synced press time of the newest event, so unlike its age it includes the retries
+    // and backoff of the click packet; replayed events are as old as the outage they were journaled in and not counted
+    if (click->num_synced == click->num_events) {
+        int64_t press_us = click->press_times_us[click->num_events - 1];
+        telemetry_add_latency(header->device_id, pending->rx_us - press_us);
+    }
+
+    pending->is_used = false;
+    return 0;
+}
+
+static int hold_click(const struct radio_click_t *click, int64_t rx_us) {
+    for (int i = 0; i < ARRAY_SIZE(pending_clicks); i++) {
+        struct pending_click_t *pending = &pending_clicks[i];
+        if (!pending->is_used) {
+            pending->is_used  = true;
+            pending->rx_us    = rx_us;
+            pending->deadline = sys_timepoint_calc(SYNC_TIMEOUT);
+            pending->click    = *click;
+            return 0;
+        }
+    }
+
+    LOG_WRN("Too many clicks waiting for their sync packet; returning click %u of device %08x right away",
+            click->counter, click->device_id);
+    return -ENOMEM;
+}
+
+static int release_expired_click(struct radio_click_t *click, k_timepoint_t *next_deadline) {
+    // Clicks whose sync packet got lost keep the press times derived from their ages
+    *next_deadline = sys_timepoint_calc(K_FOREVER);
+    for (int i = 0; i < ARRAY_SIZE(pending_clicks); i++) {
+        struct pending_click_t *pending = &pending_clicks[i];
+        if (!pending->is_used) {
+            continue;
+        }
+
+        if (sys_timepoint_expired(pending->deadline)) {
+            *click           = pending->click;
+            pending->is_used = false;
+            return 0;
+        }
+
+        if (sys_timepoint_cmp(pending->deadline, *next_deadline) < 0) {
+            *next_deadline = pending->deadline;
+        }
+    }
+
+    return -EAGAIN;
+}
+
+static void set_press_times(struct radio_click_t *click, int64_t rx_us) {
+    // The ages are taken when the clicker seals the packet, and its retries resend the sealed packet: the press times
+    // are off by the rounding to PACKET_EVENT_TIME_UNIT_MS plus the time the packet spent in retries and backoff (up
+    // to hundreds of ms after a few failed tries), which we cannot tell from here. A sync packet refines them.
+    click->num_synced = 0;
+    for (int i = 0; i < click->num_events; i++) {
+        uint32_t age_ms          = click->events[i].age_ms;
+        click->press_times_us[i] = age_ms == PACKET_AGE_UNKNOWN ? RADIO_TIME_UNKNOWN : rx_us - age_ms * 1000LL;
+    }
+}
+
+static int process_packet(const struct rx_packet_t *packet, struct radio_click_t *click) {
+    // Drop foreign packets before spending time on decryption
+    if (packet->len < sizeof(struct packet_header_t) ||
+        memcmp(packet->data, packet_valid_id, sizeof(packet_valid_id)) != 0) {
+        LOG_WRN("Dropping packet with invalid validation ID");
+        return -EINVAL;
+    }
+
+    struct packet_header_t header;
+    uint8_t body[PACKET_MAX_BODY_LEN];
+    int len = packet_open(packet->data, packet->len, &header, body);
+    if (len < 0) {
+        LOG_WRN("Dropping packet that failed authentication (%d)", len);
+        return len;
+    }
+
+    bool is_pairing = header.type == PACKET_TYPE_PAIR_REQUEST || header.type == PACKET_TYPE_PAIR_FETCH;
+    bool is_click   = header.type == PACKET_TYPE_CLICK && len >= CLICK_MIN_LEN;
+    bool is_replay  = header.type == PACKET_TYPE_REPLAY && len >= REPLAY_MIN_LEN;
+    bool is_sync    = header.type == PACKET_TYPE_SYNC && len >= SYNC_MIN_LEN;
+    if (packet->pipe == PAIRING_PIPE ? !is_pairing : !is_click && !is_replay && !is_sync) {
+        LOG_WRN("Dropping packet of unexpected type %d on pipe %d (%d bytes)", header.type, packet->pipe, len);
+        return -EINVAL;
+    }
+
+    int res = devices_check_counter(header.device_id, header.counter);
+    if (res) {
+        LOG_WRN("Dropping packet %u of device %08x (%s)", header.counter, header.device_id,
+                res == -EALREADY ? "replay" : "too many devices");
+        return res;
+    }
+
+    // Only accepted packets count, so replayed ones cannot skew the statistics; the retries are reported by the
+    // clickers (see process_click())
+    telemetry_add_packet(header.device_id, header.counter, packet->rssi, packet->rx_us);
+
+    // Fetch packets only serve to carry the response in their ack payload
+    if (header.type == PACKET_TYPE_PAIR_REQUEST) {
+        send_pairing_response(&header);
+    }
+
+    if (is_pairing) {
+        return -EAGAIN;
+    }
+
+    int active = devices_count_active();
+    atomic_set(&num_slots, CLAMP(2 << LOG2CEIL(active), MIN_NUM_SLOTS, MAX_NUM_SLOTS));
+
+    if (is_sync) {
+        return process_sync(&header, body, len, click);
+    }
+
+    res = is_click ? process_click(&header, body, len, click) : process_replay(&header, body, len, click);
+    if (res) return res;
+
+    click->device_id = header.device_id;
+    click->counter   = header.counter;
+    click->rssi      = packet->rssi;
+    set_press_times(click, packet->rx_us);
+
+    // The clicker sends the sync packet right after the ack
+    if (is_click && IS_ENABLED(CONFIG_APP_TIME_SYNC) && hold_click(click, packet->rx_us) == 0) {
+        return -EINPROGRESS;
+    }
+
+    return 0;
+}
+
+/*********************************************************************************************************************
+ * PUBLIC FUNCTIONS
+ *********************************************************************************************************************/
+int radio_init() {
+    uint8_t key[PACKET_KEY_SIZE];
+    uint8_t *system_addr = pairing_info.system_addr;
+    uint8_t pairing_addr[5];
+
+    bool valid = parse_hex(CONFIG_APP_SECRET_KEY, key, sizeof(key)) == 0;
+    valid      = valid && parse_hex(CONFIG_APP_SYSTEM_ADDR, system_addr, sizeof(pairing_info.system_addr)) == 0;
+    valid      = valid && parse_hex(CONFIG_APP_PAIRING_ADDR, pairing_addr, sizeof(pairing_addr)) == 0;
+    valid      = valid && parse_hex(CONFIG_APP_HOST_ID, pairing_info.host_id, sizeof(pairing_info.host_id)) == 0;
+    valid      = valid && parse_hex(CONFIG_APP_PACKET_VALID_ID, packet_valid_id, sizeof(packet_valid_id)) == 0;
+    if (!valid) {
+        LOG_ERR("Invalid CONFIG_APP_SECRET_KEY, CONFIG_APP_SYSTEM_ADDR, CONFIG_APP_PAIRING_ADDR, CONFIG_APP_HOST_ID "
+                "or CONFIG_APP_PACKET_VALID_ID");
+        return -EINVAL;
+    }
+
+    int res = packet_set_key(key);
+    if (res) {
+        LOG_ERR("Failed to set the packet key: %d", res);
+        return res;
+    }
+
+    // Initialize Gazell; the system and pairing addresses consist of a base address (4 bytes) and the prefix of the
+    // respective pipe
+    if (!gzll_glue_init()) {
+        LOG_ERR("gzll_glue_init() failed");
+        return -EIO;
+    }
+
+    bool ok = nrf_gzll_init(NRF_GZLL_MODE_HOST);
+    ok      = ok && nrf_gzll_set_base_address_0(sys_get_le32(pairing_addr));
+    ok      = ok && nrf_gzll_set_address_prefix_byte(PAIRING_PIPE, pairing_addr[4]);
+    ok      = ok && nrf_gzll_set_base_address_1(sys_get_le32(system_addr));
+    ok      = ok && nrf_gzll_set_address_prefix_byte(DATA_PIPE, system_addr[4]);
+    ok      = ok && set_channel_table() == 0;
+    if (!ok) {
+        LOG_ERR("Failed to initialize Gazell: error %d", nrf_gzll_get_error_code());
+        return -EIO;
+    }
+
+    add_ack_payload();
+
+    LOG_INF("Radio initialized OK; waiting for clicks and pairing requests");
+
+    return 0;
+}
+
+int radio_get_click(struct radio_click_t *click, k_timeout_t timeout) {
+    k_timepoint_t end = sys_timepoint_calc(timeout);
+
+    while (true) {
+        k_timepoint_t next_deadline;
+        if (release_expired_click(click, &next_deadline) == 0) {
+            return 0;
+        }
+
+        // Wake up when a held click expires, even if no packet comes in
+        bool is_sync_first = sys_timepoint_cmp(next_deadline, end) < 0;
+        struct rx_packet_t packet;
+        if (k_msgq_get(&radio_rx_msgq, &packet, sys_timepoint_timeout(is_sync_first ? next_deadline : end)) != 0) {
+            if (is_sync_first) {
+                continue;
+            }
+
+            return -ETIMEDOUT;
+        }
+
+        if (process_packet(&packet, click) == 0) {
+            return 0;
+        }
+    }
+}
+
+int radio_send_command(uint32_t device_id, const struct packet_command_t *command, size_t len) {
+    if (len > sizeof(struct packet_command_t)) {
+        return -EINVAL;
+    }
+
+    // The command is sealed with the counter of the last packet of the clicker, which makes the nonce unique as long
+    // as there is only one command per packet
+    uint32_t counter;
+    int res = devices_get_counter(device_id, &counter);
+    if (res) return res;
+
+    k_mutex_lock(&commands_mutex, K_FOREVER);
+
+    struct command_t *free_slot = NULL;
+    for (int i = 0; i < ARRAY_SIZE(commands); i++) {
+        bool is_pending = atomic_get(&commands[i].state) == COMMAND_PENDING;
+        if (is_pending && commands[i].device_id == device_id) {
+            res = -EBUSY;
+        } else if (!is_pending && free_slot == NULL) {
+            free_slot = &commands[i];
+        }
+    }
+
+    if (res == 0 && free_slot == NULL) {
+        res = -ENOMEM;
+    }
+
+    if (res == 0) {
+        free_slot->device_id = device_id;
+        free_slot->body_len  = len;
+        memcpy(&free_slot->body, command, free_slot->body_len);
+        res = seal_command(free_slot, counter);
+
+        // The ack payloads only pick up the command once it is complete
+        if (res == 0) {
+            free_slot->command      = command->command;
+            free_slot->clicks       = 0;
+            free_slot->queued_at_ms = k_uptime_get();
+            atomic_set(&free_slot->state, COMMAND_PENDING);
+        }
+    }
+
+    k_mutex_unlock(&commands_mutex);
+
+    if (res) {
+        LOG_WRN("Failed to queue command %u for %08x: %d", command->command, device_id, res);
+    }
+
+    return res;
+}
@@ -0,0 +1,71 @@
+#ifndef RADIO_H
+#define RADIO_H
+
+#include <stdint.h>
+#include <zephyr/kernel.h>
+
+#include "packet.h"
+
+// Press time of an event whose age is unknown
+#define RADIO_TIME_UNKNOWN INT64_MIN
+
+// A click received from a clicker
+struct radio_click_t {
+    uint32_t device_id;
+    uint32_t counter;
+    int8_t rssi;     // RSSI of the packet in dBm
+    bool is_replay;  // The events were replayed from the clicker's journal after their click packet was not acked
+    uint8_t num_events;
+    uint8_t num_synced;  // Number of leading events whose press time comes from a sync packet (accurate to ~30 us)
+    struct packet_event_t events[PACKET_MAX_EVENTS];  // Oldest first; ages relative to the reception (may be unknown)
+    int64_t press_times_us[PACKET_MAX_EVENTS];  // Press time of each event in receiver uptime, or RADIO_TIME_UNKNOWN
+};
+
+/**
+ * @brief Initializes Gazell in host mode and starts receiving.
+ *
+ * @retval 0 If successful.
+ * @retval <0 Error code if initialization failed.
+ */
+int radio_init();
+
+/**
+ * @brief Get/wait for the next click.
+ *
+ * Packets that fail validation, authentication or the replay check are dropped (and logged) and not returned.
+ * Pairing requests of clickers (on the pairing address) are answered with the system address and host ID while
+ * waiting.
+ *
+ * With CONFIG_APP_TIME_SYNC, a click packet is held back until the sync packet of its clicker came in (at most
+ * CONFIG_APP_TIME_SYNC_TIMEOUT_MS), so clicks may be returned in a different order than they were received; the press
+ * times are what the clicks should be ranked by.
+ *
+ * @param click Pointer to the click structure to fill.
+ * @param timeout Waiting period to obtain the next click, or one of the special values K_NO_WAIT and K_FOREVER.
+ *
+ * @retval 0 If successful.
+ * @retval -ETIMEDOUT If the timeout expired before a click was received.
+ */
+int radio_get_click(struct radio_click_t *click, k_timeout_t timeout);
+
+/**
+ * @brief Sends a command to a clicker.
+ *
+ * The command is piggybacked on the ack payloads of the data pipe until the clicker confirms it with its next click,
+ * so it is applied once the clicker has clicked (and got an ack with the command); clickers that do not click do not
+ * get it. The delivery time is logged once the clicker has confirmed the command.
+ *
+ * @param device_id The device ID of the clicker.
+ * @param command The command.
+ * @param len Length of the command in bytes, i.e. the command ID and its arguments.
+ *
+ * @retval 0 If the command was queued.
+ * @retval -EINVAL If the command is too long.
+ * @retval -ENOENT If the clicker has not sent a packet since startup.
+ * @retval -EBUSY If the previous command for the clicker has not been confirmed yet.
+ * @retval -ENOMEM If CONFIG_APP_MAX_PENDING_COMMANDS commands are pending.
+ * @retval <0 Other error code if sealing the command failed.
+ */
+int radio_send_command(uint32_t device_id, const struct packet_command_t *command, size_t len);
+
+#endif  // RADIO_H
@@ -0,0 +1,257 @@
+#include "session.h"
+#include "devices.h"
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+
+LOG_MODULE_REGISTER(app_session);
+
+// The ranking holds the first CONFIG_APP_SESSION_MAX_RANKS clickers; inserting a press that arrives out of order
+// shifts the entries behind it, which is bounded by the size of the ranking, and so are the updates for the entries
+// whose rank changed
+#define MAX_RANKS CONFIG_APP_SESSION_MAX_RANKS
+
+BUILD_ASSERT(MAX_RANKS < SESSION_RANK_NONE, "Ranks are reported in 8 bits");
+
+// State of a clicker in a round; only valid if round is the current round, so opening a round does not have to touch
+// the state of all clickers
+struct device_state_t {
+    uint32_t round;
+    bool has_answer;
+    bool is_locked;
+    uint8_t button;          // Button of the answer
+    int64_t answer_time_us;  // Press time of the answer
+};
+
+// An entry of the ranking
+struct rank_t {
+    uint32_t device_id;
+    uint8_t button;
+    int64_t press_time_us;
+};
+
+// Global state (protected by session_mutex)
+static session_handler_t update_handler;
+static uint32_t current_round;
+static enum session_mode_t mode;
+static bool is_open;
+static int64_t open_us;   // Presses from this time on count
+static int64_t close_us;  // Presses from this time on do not count (INT64_MAX while the round is open)
+static uint16_t num_answers;
+static uint16_t tallies[SESSION_NUM_BUTTONS];
+static struct rank_t ranks[MAX_RANKS];
+static uint8_t num_ranks;
+static struct device_state_t device_states[CONFIG_APP_MAX_DEVICES];
+
+static K_MUTEX_DEFINE(session_mutex);
+
+/*********************************************************************************************************************
+ * PRIVATE FUNCTIONS
+ *********************************************************************************************************************/
+static int64_t now_us() {
+    return k_ticks_to_us_floor64(k_uptime_ticks());
+}
+
+static void emit(enum session_update_type_t type, uint32_t device_id, uint8_t button, uint8_t rank, uint16_t count,
+                 int64_t press_time_us) {
+    if (update_handler == NULL) {
+        return;
+    }
+
+    struct session_update_t update = {
+        .type          = type,
+        .round         = current_round,
+        .device_id     = device_id,
+        .button        = button,
+        .rank          = rank,
+        .count         = count,
+        .press_time_us = press_time_us,
+    };
+
+    update_handler(&update);
+}
+
+static struct device_state_t *get_device_state(int index) {
+    struct device_state_t *state = &device_states[index];
+    if (state->round != current_round) {
+        memset(state, 0, sizeof(*state));
+        state->round = current_round;
+    }
+
+    return state;
+}
+
+static void emit_rank(const struct rank_t *entry, uint8_t rank) {
+    emit(SESSION_UPDATE_RANK, entry->device_id, entry->button, rank, 0, entry->press_time_us);
+}
+
+static int remove_rank(uint32_t device_id) {
+    // The entries behind move up; insert_rank() reports them
+    for (int i = 0; i < num_ranks; i++) {
+        if (ranks[i].device_id == device_id) {
+            num_ranks--;
+            memmove(&ranks[i], &ranks[i + 1], (num_ranks - i) * sizeof(ranks[0]));
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static void insert_rank(uint32_t device_id, uint8_t button, int64_t press_time_us, int old_rank) {
+    // Presses at the same time keep the order in which they arrived
+    int rank = num_ranks;
+    while (rank > 0 && ranks[rank - 1].press_time_us > press_time_us) {
+        rank--;
+    }
+
+    if (rank == MAX_RANKS) {
+        return;
+    }
+
+    // A new entry in a full ranking pushes the last one out
+    if (num_ranks == MAX_RANKS) {
+        emit_rank(&ranks[MAX_RANKS - 1], SESSION_RANK_NONE);
+    }
+
+    int num_moved = MIN(num_ranks, MAX_RANKS - 1) - rank;
+    memmove(&ranks[rank + 1], &ranks[rank], num_moved * sizeof(ranks[0]));
+    ranks[rank].device_id     = device_id;
+    ranks[rank].button        = button;
+    ranks[rank].press_time_us = press_time_us;
+    num_ranks                 = MIN(num_ranks + 1, MAX_RANKS);
+
+    // A clicker that moves up from old_rank (see remove_rank()) only changes the ranks up to there; otherwise, all
+    // entries behind the new one moved down
+    int end = old_rank >= 0 ? old_rank + 1 : num_ranks;
+    for (int i = rank; i < end; i++) {
+        emit_rank(&ranks[i], i);
+    }
+}
+
+static void set_answer(struct device_state_t *state, uint32_t device_id, uint8_t button, int64_t press_time_us) {
+    // In a quiz, a new answer is always earlier than the old one, so the clicker can only move up in the ranking
+    int old_rank = -1;
+    if (state->has_answer) {
+        tallies[state->button]--;
+        emit(SESSION_UPDATE_TALLY, device_id, state->button, 0, tallies[state->button], 0);
+        if (mode == SESSION_MODE_QUIZ) {
+            old_rank = remove_rank(device_id);
+        }
+    } else {
+        num_answers++;
+    }
+
+    state->has_answer     = true;
+    state->button         = button;
+    state->answer_time_us = press_time_us;
+
+    tallies[button]++;
+    emit(SESSION_UPDATE_TALLY, device_id, button, 0, tallies[button], 0);
+    if (mode == SESSION_MODE_QUIZ) {
+        insert_rank(device_id, button, press_time_us, old_rank);
+    }
+}
+
+static void add_press(struct device_state_t *state, uint32_t device_id, uint8_t button, int64_t press_time_us) {
+    if (state->is_locked) {
+        emit(SESSION_UPDATE_LOCKOUT, device_id, button, 0, 0, press_time_us);
+        return;
+    }
+
+    // Presses may arrive out of order (e.g. replayed from the journal), so the press times decide: in a quiz, an
+    // earlier press replaces the answer, and in a vote, a later one does
+    if (!state->has_answer) {
+        set_answer(state, device_id, button, press_time_us);
+    } else if (mode == SESSION_MODE_QUIZ && press_time_us < state->answer_time_us) {
+        set_answer(state, device_id, button, press_time_us);
+    } else if (mode == SESSION_MODE_QUIZ) {
+        emit(SESSION_UPDATE_LOCKOUT, device_id, button, 0, 0, press_time_us);
+    } else if (press_time_us > state->answer_time_us && button != state->button) {
+        set_answer(state, device_id, button, press_time_us);
+    } else if (press_time_us > state->answer_time_us) {
+        state->answer_time_us = press_time_us;
+    }
+}
+
+/*********************************************************************************************************************
+ * PUBLIC FUNCTIONS
+ *********************************************************************************************************************/
+void session_init(session_handler_t handler) {
+    k_mutex_lock(&session_mutex, K_FOREVER);
+    update_handler = handler;
+    k_mutex_unlock(&session_mutex);
+}
+
+uint32_t session_open_round(enum session_mode_t new_mode) {
+    k_mutex_lock(&session_mutex, K_FOREVER);
+
+    current_round++;
+    mode        = new_mode;
+    is_open     = true;
+    open_us     = now_us();
+    close_us    = INT64_MAX;
+    num_answers = 0;
+    num_ranks   = 0;
+    memset(tallies, 0, sizeof(tallies));
+    uint32_t new_round = current_round;
+
+    k_mutex_unlock(&session_mutex);
+
+    LOG_INF("Round %u opened (%s)", new_round, new_mode == SESSION_MODE_QUIZ ? "quiz" : "vote");
+    return new_round;
+}
+
+int session_close_round() {
+    k_mutex_lock(&session_mutex, K_FOREVER);
+
+    int res = is_open ? 0 : -EALREADY;
+    if (res == 0) {
+        is_open  = false;
+        close_us = now_us();
+        emit(SESSION_UPDATE_CLOSED, 0, 0, 0, num_answers, 0);
+    }
+
+    k_mutex_unlock(&session_mutex);
+    return res;
+}
+
+int session_lock_device(uint32_t device_id) {
+    int index = devices_get_index(device_id);
+    if (index < 0) return index;
+
+    k_mutex_lock(&session_mutex, K_FOREVER);
+
+    int res = is_open ? 0 : -EALREADY;
+    if (res == 0) {
+        get_device_state(index)->is_locked = true;
+    }
+
+    k_mutex_unlock(&session_mutex);
+    return res;
+}
+
+void session_add_click(const struct radio_click_t *click) {
+    // Before the first round, open_us and close_us are both 0, so all presses are ignored
+    int index = devices_get_index(click->device_id);
+    if (index < 0) {
+        return;
+    }
+
+    k_mutex_lock(&session_mutex, K_FOREVER);
+
+    for (int i = 0; i < click->num_events; i++) {
+        uint8_t button        = click->events[i].button;
+        int64_t press_time_us = click->press_times_us[i];
+        if (button >= SESSION_NUM_BUTTONS || press_time_us == RADIO_TIME_UNKNOWN || press_time_us < open_us ||
+            press_time_us >= close_us) {
+            continue;
+        }
+
+        add_press(get_device_state(index), click->device_id, button, press_time_us);
+    }
+
+    k_mutex_unlock(&session_mutex);
+}
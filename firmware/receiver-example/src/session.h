@@ -0,0 +1,142 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <errno.h>
+#include <stdint.h>
+
+#include "radio.h"
+
+// Buttons that count as answers (buttons 1-5 of the clicker)
+#define SESSION_NUM_BUTTONS 5
+
+// Rank of a clicker that dropped out of the ranking
+#define SESSION_RANK_NONE UINT8_MAX
+
+// How the presses of a clicker count in a round
+enum session_mode_t {
+    SESSION_MODE_QUIZ,  // The first press of a clicker is its answer and is ranked; later presses are locked out
+    SESSION_MODE_VOTE,  // The last press of a clicker is its vote; there is no ranking
+};
+
+enum session_update_type_t {
+    SESSION_UPDATE_RANK,     // The rank of a clicker changed: device_id, button, rank, press_time_us
+    SESSION_UPDATE_TALLY,    // The number of answers for a button changed: button, count
+    SESSION_UPDATE_LOCKOUT,  // A press was ignored since the clicker is locked out: device_id, button, press_time_us
+    SESSION_UPDATE_CLOSED,   // The round was closed: count (number of clickers that answered)
+};
+
+// A change of the results of a round
+struct session_update_t {
+    enum session_update_type_t type;
+    uint32_t round;  // Number of the round (see session_open_round())
+    uint32_t device_id;
+    uint8_t button;  // 0 for button 1
+    uint8_t rank;    // 0 for the first press, SESSION_RANK_NONE if the clicker dropped out of the ranking
+    uint16_t count;
+    int64_t press_time_us;  // Receiver uptime (see struct radio_click_t)
+};
+
+/**
+ * @brief Handler for the updates of the results; called from session_add_click(), session_close_round() and
+ * session_lock_device() and must not call back into the session.
+ */
+typedef void (*session_handler_t)(const struct session_update_t *update);
+
+#if defined(CONFIG_APP_SESSION)
+
+/**
+ * @brief Sets the handler for the updates of the results.
+ *
+ * @param handler The handler.
+ */
+void session_init(session_handler_t handler);
+
+/**
+ * @brief Opens a new round, which closes the current one.
+ *
+ * Only presses from now on count. Takes constant time: the state of the clickers is reset lazily on their first press
+ * in the new round.
+ *
+ * @param mode How the presses count.
+ *
+ * @return Number of the new round (starting at 1).
+ */
+uint32_t session_open_round(enum session_mode_t mode);
+
+/**
+ * @brief Closes the current round.
+ *
+ * Presses after this moment do not count. Clicks that are still on their way (e.g. waiting for their sync packet) are
+ * counted if they were pressed before, so the results may change for a short time after closing.
+ *
+ * @retval 0 If successful.
+ * @retval -EALREADY If no round is open.
+ */
+int session_close_round();
+
+/**
+ * @brief Locks a clicker out of the current round (e.g. after a wrong answer in a quiz); its answer stays.
+ *
+ * @param device_id The device ID of the clicker.
+ *
+ * @retval 0 If successful.
+ * @retval -EALREADY If no round is open.
+ * @retval -ENOENT If the clicker has not sent an accepted packet yet.
+ */
+int session_lock_device(uint32_t device_id);
+
+/**
+ * @brief Adds the presses of a click to the current round and reports the changed results.
+ *
+ * Presses are placed by their press time, not by the order in which they arrive, so clicks that were delayed by
+ * retries or replayed from the journal are ranked correctly. Every clicker whose rank changes gets a
+ * SESSION_UPDATE_RANK update, so the updates keep a copy of the ranking up to date without knowing how it shifts.
+ * Presses with an unknown time, or from outside the round, are ignored. Takes constant time per press (bounded by
+ * CONFIG_APP_SESSION_MAX_RANKS) and does not allocate.
+ *
+ * @param click The click (from radio_get_click()).
+ */
+void session_add_click(const struct radio_click_t *click);
+
+#else
+
+static inline void session_init(session_handler_t handler) {
+}
+
+static inline uint32_t session_open_round(enum session_mode_t mode) {
+    return 0;
+}
+
+static inline int session_close_round() {
+    return -ENOTSUP;
+}
+
+static inline int session_lock_device(uint32_t device_id) {
+    return -ENOTSUP;
+}
+
+static inline void session_add_click(const struct radio_click_t *click) {
+}
+
+#endif  // CONFIG_APP_SESSION
+
+#if defined(CONFIG_APP_SESSION_BENCHMARK)
+
+/**
+ * @brief Measures the throughput of the session with clicks from a synthetic event generator.
+ *
+ * Runs CONFIG_APP_SESSION_BENCHMARK_ROUNDS rounds in which CONFIG_APP_SESSION_BENCHMARK_DEVICES synthetic clickers
+ * press within one millisecond, with their clicks arriving in random order, and logs the time spent in
+ * session_add_click(). The synthetic clickers take entries of the device table, so this is for development builds
+ * only. Replaces the handler of the updates.
+ */
+void session_benchmark_run();
+
+#else
+
+static inline void session_benchmark_run() {
+}
+
+#endif  // CONFIG_APP_SESSION_BENCHMARK
+
+#endif  // SESSION_H
@@ -0,0 +1,111 @@
+#include "devices.h"
+#include "session.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/timing/timing.h>
+
+LOG_MODULE_REGISTER(app_session_bench);
+
+// Synthetic clickers: every fourth one presses twice, which exercises the lockouts (quiz) and vote changes (vote)
+#define BENCH_DEVICES     CONFIG_APP_SESSION_BENCHMARK_DEVICES
+#define BENCH_ROUNDS      CONFIG_APP_SESSION_BENCHMARK_ROUNDS
+#define BENCH_WINDOW_US   1000
+#define BENCH_FIRST_ID    0xbe000000
+#define BENCH_SEED        0x2545f491
+#define DOUBLE_PRESS_RATE 4
+
+BUILD_ASSERT(BENCH_DEVICES <= CONFIG_APP_MAX_DEVICES, "The synthetic clickers must fit into the device table");
+
+// Global state (only accessed from session_benchmark_run())
+static struct radio_click_t clicks[BENCH_DEVICES];
+static uint32_t rng_state;
+static uint32_t num_updates;
+
+/*********************************************************************************************************************
+ * PRIVATE FUNCTIONS
+ *********************************************************************************************************************/
+static uint32_t next_random() {
+    // xorshift32, so that every run sees the same clicks
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static void count_update(const struct session_update_t *update) {
+    num_updates++;
+}
+
+static int generate_round(int64_t start_us) {
+    int num_events = 0;
+    for (int i = 0; i < BENCH_DEVICES; i++) {
+        struct radio_click_t *click = &clicks[i];
+        click->device_id            = BENCH_FIRST_ID + i;
+        click->num_events           = i % DOUBLE_PRESS_RATE == 0 ? 2 : 1;
+        click->num_synced           = click->num_events;
+        for (int j = 0; j < click->num_events; j++) {
+            click->events[j].button  = next_random() % SESSION_NUM_BUTTONS;
+            click->press_times_us[j] = start_us + j * BENCH_WINDOW_US + next_random() % BENCH_WINDOW_US;
+        }
+
+        num_events += click->num_events;
+    }
+
+    // The clicks arrive in random order (Fisher-Yates shuffle)
+    for (int i = BENCH_DEVICES - 1; i > 0; i--) {
+        int j                     = next_random() % (i + 1);
+        struct radio_click_t temp = clicks[i];
+        clicks[i]                 = clicks[j];
+        clicks[j]                 = temp;
+    }
+
+    return num_events;
+}
+
+/*********************************************************************************************************************
+ * PUBLIC FUNCTIONS
+ *********************************************************************************************************************/
+void session_benchmark_run() {
+    for (int i = 0; i < BENCH_DEVICES; i++) {
+        if (devices_check_counter(BENCH_FIRST_ID + i, 1) == -ENOMEM) {
+            LOG_ERR("Device table full; benchmark skipped");
+            return;
+        }
+    }
+
+    timing_init();
+    timing_start();
+    session_init(count_update);
+    rng_state   = BENCH_SEED;
+    num_updates = 0;
+
+    uint64_t total_cycles = 0;
+    uint64_t max_cycles   = 0;
+    uint32_t num_events   = 0;
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        session_open_round(i % 2 ? SESSION_MODE_VOTE : SESSION_MODE_QUIZ);
+        num_events += generate_round(k_ticks_to_us_floor64(k_uptime_ticks()) + BENCH_WINDOW_US);
+
+        for (int j = 0; j < BENCH_DEVICES; j++) {
+            timing_t start = timing_counter_get();
+            session_add_click(&clicks[j]);
+            timing_t end = timing_counter_get();
+
+            uint64_t cycles = timing_cycles_get(&start, &end);
+            total_cycles += cycles;
+            max_cycles = MAX(max_cycles, cycles);
+        }
+
+        session_close_round();
+    }
+
+    timing_stop();
+    session_init(NULL);
+
+    uint64_t total_ns = timing_cycles_to_ns(total_cycles);
+    LOG_INF("Session benchmark: %u events in %u rounds of %u clickers, %u updates", num_events, BENCH_ROUNDS,
+            BENCH_DEVICES, num_updates);
+    LOG_INF("Session benchmark: %llu ns per event, %llu ns max per click, %llu events/s", total_ns / num_events,
+            timing_cycles_to_ns(max_cycles), num_events * 1000000000ULL / MAX(total_ns, 1));
+}
@@ -0,0 +1,174 @@
+#include "telemetry.h"
+#include "devices.h"
+#include "output.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+
+LOG_MODULE_REGISTER(app_telemetry);
+
+// Clickers continue their packet counter at the next block of 1024 after losing their retained state, so larger gaps
+// are taken as a restart of the clicker rather than as lost packets
+#define MAX_LOST_GAP 64
+
+// Latency of a clicker that has not sent a synced click yet
+#define LATENCY_UNKNOWN UINT32_MAX
+
+// Counts of a period (see struct output_telemetry_t)
+struct link_counts_t {
+    uint16_t num_packets;
+    uint16_t num_retries;
+    uint16_t num_lost;
+    uint16_t rssi_bins[OUTPUT_TELEMETRY_BINS];
+    uint16_t latency_bins[OUTPUT_TELEMETRY_BINS];
+};
+
+// Link statistics of a clicker; has the same index as the clicker in the device table (see devices_get_index())
+struct link_t {
+    bool is_used;
+    uint32_t device_id;
+    uint32_t last_counter;     // Counter of the last packet
+    int64_t last_rx_us;        // Uptime when the last packet was received
+    int64_t period_start_us;   // Uptime of the previous snapshot
+    uint32_t last_latency_us;  // Latency of the last synced click packet, or LATENCY_UNKNOWN
+    uint32_t jitter;           // Jitter in us, scaled by 16 (see RFC 3550, A.8)
+    struct link_counts_t counts;  // Counts of the current period
+};
+
+// Global state (only accessed from the thread that calls radio_get_click())
+static struct link_t links[CONFIG_APP_MAX_DEVICES];
+static int next_snapshot;  // Index of the clicker whose snapshot is due next
+
+/*********************************************************************************************************************
+ * PRIVATE FUNCTIONS
+ *********************************************************************************************************************/
+static void count(uint16_t *counter, uint32_t n) {
+    *counter = MIN(*counter + n, UINT16_MAX);
+}
+
+static struct link_t *find_link(uint32_t device_id) {
+    int index = devices_get_index(device_id);
+    if (index < 0) {
+        return NULL;
+    }
+
+    // Indices are never reused, so a free slot belongs to a clicker we have not seen a packet of yet
+    struct link_t *link = &links[index];
+    if (!link->is_used) {
+        memset(link, 0, sizeof(*link));
+        link->is_used         = true;
+        link->device_id       = device_id;
+        link->last_latency_us = LATENCY_UNKNOWN;
+    }
+
+    return link;
+}
+
+static int rssi_bin(int8_t rssi) {
+    return CLAMP((OUTPUT_TELEMETRY_RSSI_TOP - rssi) / OUTPUT_TELEMETRY_RSSI_STEP, 0, OUTPUT_TELEMETRY_BINS - 1);
+}
+
+static int latency_bin(uint32_t latency_us) {
+    uint32_t units = latency_us / (OUTPUT_TELEMETRY_LATENCY_MIN * 1000);
+    return units == 0 ? 0 : MIN(LOG2(units) + 1, OUTPUT_TELEMETRY_BINS - 1);
+}
+
+static int write_snapshot(struct link_t *link, int64_t now_us) {
+    struct output_telemetry_t snapshot = {
+        .device_id    = link->device_id,
+        .period_ms    = (now_us - link->period_start_us) / 1000,
+        .last_seen_ms = (now_us - link->last_rx_us) / 1000,
+        .jitter_us    = link->jitter >> 4,
+        .num_packets  = link->counts.num_packets,
+        .num_retries  = link->counts.num_retries,
+        .num_lost     = link->counts.num_lost,
+    };
+    memcpy(snapshot.rssi_bins, link->counts.rssi_bins, sizeof(snapshot.rssi_bins));
+    memcpy(snapshot.latency_bins, link->counts.latency_bins, sizeof(snapshot.latency_bins));
+
+    int res = output_write(OUTPUT_FRAME_TELEMETRY, &snapshot, sizeof(snapshot));
+    if (res) return res;
+
+    memset(&link->counts, 0, sizeof(link->counts));
+    link->period_start_us = now_us;
+    return 0;
+}
+
+/*********************************************************************************************************************
+ * PUBLIC FUNCTIONS
+ *********************************************************************************************************************/
+void telemetry_add_packet(uint32_t device_id, uint32_t counter, int8_t rssi, int64_t rx_us) {
+    struct link_t *link = find_link(device_id);
+    if (link == NULL) {
+        return;
+    }
+
+    // The first packet starts the first period; accepted counters always increase
+    if (link->last_rx_us == 0) {
+        link->period_start_us = rx_us;
+    } else if (counter - link->last_counter <= MAX_LOST_GAP) {
+        count(&link->counts.num_lost, counter - link->last_counter - 1);
+    }
+
+    link->last_counter = counter;
+    link->last_rx_us   = rx_us;
+    count(&link->counts.num_packets, 1);
+    count(&link->counts.rssi_bins[rssi_bin(rssi)], 1);
+}
+
+void telemetry_add_retries(uint32_t device_id, uint32_t num_retries) {
+    struct link_t *link = find_link(device_id);
+    if (link == NULL) {
+        return;
+    }
+
+    count(&link->counts.num_retries, num_retries);
+}
+
+void telemetry_add_latency(uint32_t device_id, int64_t latency_us) {
+    struct link_t *link = find_link(device_id);
+    if (link == NULL) {
+        return;
+    }
+
+    // Latencies of more than about 71 minutes (e.g. of a clicker whose clock restarted) saturate
+    latency_us = CLAMP(latency_us, 0, LATENCY_UNKNOWN - 1);
+
+    // The press is the send time of the clicker, so the difference of two latencies is the variation of the transit
+    // time, which the jitter smooths over 16 packets
+    if (link->last_latency_us != LATENCY_UNKNOWN) {
+        uint32_t diff_us = llabs(latency_us - link->last_latency_us);
+        link->jitter += diff_us - ((link->jitter + 8) >> 4);
+    }
+
+    link->last_latency_us = latency_us;
+    count(&link->counts.latency_bins[latency_bin(latency_us)], 1);
+}
+
+int telemetry_write_snapshots() {
+    int64_t now_us = k_ticks_to_us_floor64(k_uptime_ticks());
+
+    // At most one pass over the table, so that no clicker is reported twice; the entries of clickers without packets
+    // (e.g. the synthetic ones of the session benchmark) are skipped
+    int n = 0;
+    for (int i = 0; i < ARRAY_SIZE(links) && n < CONFIG_APP_TELEMETRY_SNAPSHOTS; i++) {
+        struct link_t *link = &links[next_snapshot];
+        if (link->is_used) {
+            int res = write_snapshot(link, now_us);
+            if (res) {
+                LOG_DBG("Output ring full; snapshot of %08x postponed", link->device_id);
+                return res;
+            }
+
+            n++;
+        }
+
+        next_snapshot = (next_snapshot + 1) % ARRAY_SIZE(links);
+    }
+
+    return n;
+}
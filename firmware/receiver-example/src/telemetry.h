@@ -0,0 +1,74 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <errno.h>
+#include <stdint.h>
+
+#if defined(CONFIG_APP_TELEMETRY)
+
+/**
+ * @brief Records a packet of a clicker for its link statistics.
+ *
+ * Takes the packets that passed the replay check (see devices_check_counter()), so a gap in the counters means
+ * packets were lost. Takes constant time; packets of clickers that are not in the device table are ignored.
+ *
+ * @param device_id The device ID of the clicker.
+ * @param counter The packet counter.
+ * @param rssi RSSI of the packet in dBm.
+ * @param rx_us Uptime when the packet was received.
+ */
+void telemetry_add_packet(uint32_t device_id, uint32_t counter, int8_t rssi, int64_t rx_us);
+
+/**
+ * @brief Records the retransmissions a clicker reported in a click packet.
+ *
+ * The Gazell host drops the duplicates of packets whose ack got lost before they reach the application, so only the
+ * clicker can count the retransmissions of its packets (see PACKET_LINK_RETRIES_SHIFT). Takes constant time.
+ *
+ * @param device_id The device ID of the clicker.
+ * @param num_retries Retransmissions of all packets since the previous click packet of the clicker.
+ */
+void telemetry_add_retries(uint32_t device_id, uint32_t num_retries);
+
+/**
+ * @brief Records the latency of a click packet, i.e. the time from the press of its newest event to its reception.
+ *
+ * Feeds the latency histogram and the jitter of the clicker. Only synced press times (see CONFIG_APP_TIME_SYNC) are
+ * accurate enough: the ages in the click packet are taken when the clicker seals it and leave out its retries and
+ * backoff. Takes constant time.
+ *
+ * @param device_id The device ID of the clicker.
+ * @param latency_us The reception time minus the synced press time in us.
+ */
+void telemetry_add_latency(uint32_t device_id, int64_t latency_us);
+
+/**
+ * @brief Queues the link statistics of the next CONFIG_APP_TELEMETRY_SNAPSHOTS clickers as telemetry frames.
+ *
+ * The clickers take turns, and the counts of each snapshot cover the time since the previous snapshot of the same
+ * clicker, so every clicker is reported and the output is not flooded with large device tables. Must be called from
+ * the thread that calls radio_get_click().
+ *
+ * @return Number of snapshots queued, or -ENOBUFS if the output ring is full; the clickers that were not reported
+ *         keep their counts for the next call.
+ */
+int telemetry_write_snapshots();
+
+#else
+
+static inline void telemetry_add_packet(uint32_t device_id, uint32_t counter, int8_t rssi, int64_t rx_us) {
+}
+
+static inline void telemetry_add_retries(uint32_t device_id, uint32_t num_retries) {
+}
+
+static inline void telemetry_add_latency(uint32_t device_id, int64_t latency_us) {
+}
+
+static inline int telemetry_write_snapshots() {
+    return -ENOTSUP;
+}
+
+#endif  // CONFIG_APP_TELEMETRY
+
+#endif  // TELEMETRY_H
@@ -0,0 +1,195 @@
+#include "output.h"
+
+#include <string.h>
+#include <zephyr/drivers/serial/uart_emul.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/ztest.h>
+
+// Same as in output.c
+#define CRC_SEED 0xffff
+
+// Largest decoded frame
+#define MAX_FRAME_LEN (sizeof(struct output_header_t) + OUTPUT_MAX_BODY_LEN + sizeof(uint16_t))
+
+static const struct device *const uart = DEVICE_DT_GET(DT_CHOSEN(app_output_uart));
+
+// What the UART sent
+static uint8_t stream[CONFIG_APP_OUTPUT_RING_SIZE * 4];
+static size_t stream_len;
+static size_t stream_pos;
+
+// A decoded frame
+struct frame_t {
+    struct output_header_t header;
+    uint8_t body[OUTPUT_MAX_BODY_LEN];
+    size_t body_len;
+};
+
+/*********************************************************************************************************************
+ * HELPERS
+ *********************************************************************************************************************/
+// Lets the UART send everything that is queued and collects it
+static void read_stream() {
+    stream_len = 0;
+    stream_pos = 0;
+    for (;;) {
+        k_sleep(K_MSEC(10));
+        uint32_t len = uart_emul_get_tx_data(uart, &stream[stream_len], sizeof(stream) - stream_len);
+        if (len == 0) break;
+
+        stream_len += len;
+    }
+}
+
+// Decodes the next frame of the stream and checks its delimiter and CRC
+static void next_frame(struct frame_t *frame) {
+    zassert_true(stream_pos < stream_len, "No more frames");
+
+    // COBS: every code byte gives the distance to the next zero byte of the frame, and a zero byte ends the frame
+    uint8_t raw[MAX_FRAME_LEN];
+    size_t raw_len = 0;
+    while (stream[stream_pos] != 0) {
+        uint8_t code = stream[stream_pos++];
+        zassert_true(stream_pos + code - 1 <= stream_len, "Frame cut off");
+        for (int i = 1; i < code; i++) {
+            zassert_not_equal(stream[stream_pos], 0, "Zero byte inside the frame");
+            zassert_true(raw_len < sizeof(raw), "Frame too long");
+            raw[raw_len++] = stream[stream_pos++];
+        }
+
+        // The last group of the frame adds no zero byte
+        if (code < 0xff && stream[stream_pos] != 0) {
+            zassert_true(raw_len < sizeof(raw), "Frame too long");
+            raw[raw_len++] = 0;
+        }
+    }
+    stream_pos++;
+
+    zassert_true(raw_len >= sizeof(frame->header) + sizeof(uint16_t), "Frame too short");
+    size_t crc_at = raw_len - sizeof(uint16_t);
+    uint16_t crc  = raw[crc_at] | raw[crc_at + 1] << 8;
+    zassert_equal(crc, crc16_ccitt(CRC_SEED, raw, crc_at), "CRC mismatch");
+
+    memcpy(&frame->header, raw, sizeof(frame->header));
+    frame->body_len = crc_at - sizeof(frame->header);
+    memcpy(frame->body, &raw[sizeof(frame->header)], frame->body_len);
+    zassert_equal(frame->header.version, OUTPUT_PROTOCOL_VERSION);
+}
+
+static void check_frame(enum output_frame_type_t type, const void *body, size_t len, struct frame_t *frame) {
+    next_frame(frame);
+    zassert_equal(frame->header.type, type);
+    zassert_equal(frame->body_len, len);
+    zassert_mem_equal(frame->body, body, len);
+}
+
+static uint32_t get_num_dropped() {
+    zassert_ok(output_write_status());
+    read_stream();
+
+    struct frame_t frame;
+    next_frame(&frame);
+    zassert_equal(frame.header.type, OUTPUT_FRAME_STATUS);
+
+    struct output_status_t status;
+    memcpy(&status, frame.body, sizeof(status));
+    return status.num_dropped;
+}
+
+static void *setup() {
+    zassert_ok(output_init());
+    return NULL;
+}
+
+static void before_each(void *fixture) {
+    // Whatever an earlier test left in the ring
+    read_stream();
+}
+
+/*********************************************************************************************************************
+ * TESTS
+ *********************************************************************************************************************/
+ZTEST(output, test_round_trip) {
+    // Zero bytes in all places of the body, including the first and the last
+    const uint8_t body[] = {0x00, 0x01, 0x00, 0x00, 0x02, 0x03, 0xff, 0x00};
+    zassert_ok(output_write(OUTPUT_FRAME_SESSION, body, sizeof(body)));
+    read_stream();
+
+    // Exactly one zero byte, at the end of the frame
+    zassert_equal(memchr(stream, 0, stream_len), &stream[stream_len - 1]);
+
+    struct frame_t frame;
+    check_frame(OUTPUT_FRAME_SESSION, body, sizeof(body), &frame);
+    zassert_equal(stream_pos, stream_len);
+}
+
+ZTEST(output, test_largest_bodies) {
+    uint8_t zeros[OUTPUT_MAX_BODY_LEN] = {0};
+    uint8_t ones[OUTPUT_MAX_BODY_LEN];
+    memset(ones, 0x01, sizeof(ones));
+
+    zassert_ok(output_write(OUTPUT_FRAME_CLICK, zeros, sizeof(zeros)));
+    read_stream();
+    struct frame_t frame;
+    check_frame(OUTPUT_FRAME_CLICK, zeros, sizeof(zeros), &frame);
+
+    zassert_ok(output_write(OUTPUT_FRAME_CLICK, ones, sizeof(ones)));
+    read_stream();
+    check_frame(OUTPUT_FRAME_CLICK, ones, sizeof(ones), &frame);
+
+    zassert_equal(output_write(OUTPUT_FRAME_CLICK, ones, sizeof(ones) + 1), -EINVAL);
+}
+
+ZTEST(output, test_frames_across_ring_end) {
+    // Frames of an odd length, so that they end at every position of the ring in turn
+    uint8_t body[37];
+    for (int i = 0; i < sizeof(body); i++) {
+        body[i] = i % 5 == 0 ? 0 : i;
+    }
+
+    struct frame_t frame;
+    uint16_t seq = 0;
+    for (int n = 0; n < 2 * CONFIG_APP_OUTPUT_RING_SIZE / sizeof(body); n++) {
+        body[0] = n;
+        zassert_ok(output_write(OUTPUT_FRAME_SESSION, body, sizeof(body)), "frame %d", n);
+        read_stream();
+        check_frame(OUTPUT_FRAME_SESSION, body, sizeof(body), &frame);
+
+        // The sequence number increments with every frame
+        if (n > 0) {
+            zassert_equal(frame.header.seq, (uint16_t)(seq + 1), "frame %d", n);
+        }
+        seq = frame.header.seq;
+    }
+}
+
+ZTEST(output, test_ring_full) {
+    uint32_t num_dropped = get_num_dropped();
+
+    // While the UART cannot send, a frame of the largest size only fits once
+    uint8_t body[OUTPUT_MAX_BODY_LEN];
+    memset(body, 0xaa, sizeof(body));
+    k_sched_lock();
+    int first_res  = output_write(OUTPUT_FRAME_CLICK, body, sizeof(body));
+    int second_res = output_write(OUTPUT_FRAME_CLICK, body, sizeof(body));
+    k_sched_unlock();
+    zassert_ok(first_res);
+    zassert_equal(second_res, -ENOBUFS);
+
+    // The frame that fit is sent whole, and the sequence numbers show the gap of the dropped one
+    read_stream();
+    struct frame_t frame;
+    check_frame(OUTPUT_FRAME_CLICK, body, sizeof(body), &frame);
+    zassert_equal(stream_pos, stream_len);
+    uint16_t seq = frame.header.seq;
+
+    zassert_ok(output_write(OUTPUT_FRAME_CLICK, body, sizeof(body)));
+    read_stream();
+    check_frame(OUTPUT_FRAME_CLICK, body, sizeof(body), &frame);
+    zassert_equal(frame.header.seq, (uint16_t)(seq + 2));
+
+    zassert_equal(get_num_dropped(), num_dropped + 1);
+}
+
+ZTEST_SUITE(output, NULL, setup, before_each, NULL, NULL);
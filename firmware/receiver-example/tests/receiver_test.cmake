@@ -0,0 +1,15 @@
+# Common setup of the receiver test suites: the suites build the application modules they test (never src/main.c)
+# for native_sim without Gazell. Include this file before find_package(Zephyr) and use RECEIVER_DIR for the paths of
+# the sources.
+
+set(RECEIVER_DIR ${CMAKE_CURRENT_LIST_DIR}/..)
+
+set(KCONFIG_ROOT ${RECEIVER_DIR}/Kconfig)
+
+# Include directories of the application; called after find_package(Zephyr)
+macro(receiver_test_setup)
+    target_include_directories(app PRIVATE
+        ${RECEIVER_DIR}/src
+        ${RECEIVER_DIR}/../common
+    )
+endmacro()
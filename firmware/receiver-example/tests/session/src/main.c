@@ -0,0 +1,262 @@
+#include "devices.h"
+#include "session.h"
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+
+#define MAX_RANKS CONFIG_APP_SESSION_MAX_RANKS
+
+// The clickers of the tests; all of them are in the device table
+#define FIRST_DEVICE_ID 0x1000
+#define NUM_DEVICES     (MAX_RANKS + 4)
+#define DEVICE(i)       (FIRST_DEVICE_ID + (i))
+
+// Not in the device table
+#define UNKNOWN_DEVICE_ID 0xdead
+
+// Copy of the results, kept up to date from the updates only
+static uint8_t ranks[NUM_DEVICES];
+static uint16_t tallies[SESSION_NUM_BUTTONS];
+static int num_rank_updates;
+static int num_tally_updates;
+static int num_lockouts;
+static int num_closed;
+static uint16_t closed_count;
+
+// Start of the current round
+static int64_t open_us;
+
+/*********************************************************************************************************************
+ * HELPERS
+ *********************************************************************************************************************/
+static void on_update(const struct session_update_t *update) {
+    switch (update->type) {
+        case SESSION_UPDATE_RANK:
+            zassert_true(update->device_id >= DEVICE(0) && update->device_id < DEVICE(NUM_DEVICES));
+            ranks[update->device_id - FIRST_DEVICE_ID] = update->rank;
+            num_rank_updates++;
+            break;
+
+        case SESSION_UPDATE_TALLY:
+            zassert_true(update->button < SESSION_NUM_BUTTONS);
+            tallies[update->button] = update->count;
+            num_tally_updates++;
+            break;
+
+        case SESSION_UPDATE_LOCKOUT:
+            num_lockouts++;
+            break;
+
+        case SESSION_UPDATE_CLOSED:
+            closed_count = update->count;
+            num_closed++;
+            break;
+    }
+}
+
+static void reset_counts() {
+    num_rank_updates  = 0;
+    num_tally_updates = 0;
+    num_lockouts      = 0;
+    num_closed        = 0;
+}
+
+static void open_round(enum session_mode_t mode) {
+    session_open_round(mode);
+    open_us = k_ticks_to_us_floor64(k_uptime_ticks());
+}
+
+// Adds a click with a single press of the button, offset_us after the start of the round
+static void press(int device, uint8_t button, int64_t offset_us) {
+    struct radio_click_t click = {
+        .device_id         = DEVICE(device),
+        .num_events        = 1,
+        .num_synced        = 1,
+        .events[0].button  = button,
+        .press_times_us[0] = open_us + offset_us,
+    };
+
+    session_add_click(&click);
+}
+
+static void *setup() {
+    for (int i = 0; i < NUM_DEVICES; i++) {
+        zassert_ok(devices_check_counter(DEVICE(i), 1));
+    }
+
+    session_init(on_update);
+    return NULL;
+}
+
+static void before_each(void *fixture) {
+    memset(ranks, SESSION_RANK_NONE, sizeof(ranks));
+    memset(tallies, 0, sizeof(tallies));
+    reset_counts();
+}
+
+/*********************************************************************************************************************
+ * TESTS
+ *********************************************************************************************************************/
+ZTEST(session, test_quiz_out_of_order) {
+    open_round(SESSION_MODE_QUIZ);
+
+    press(0, 0, 300);
+    press(1, 1, 100);
+    zassert_equal(ranks[1], 0);
+    zassert_equal(ranks[0], 1);
+
+    // Only the clickers behind the inserted press change their rank
+    reset_counts();
+    press(2, 2, 200);
+    zassert_equal(num_rank_updates, 2);
+    zassert_equal(ranks[1], 0);
+    zassert_equal(ranks[2], 1);
+    zassert_equal(ranks[0], 2);
+
+    // Presses at the same time keep the order in which they arrived
+    press(3, 0, 200);
+    zassert_equal(ranks[2], 1);
+    zassert_equal(ranks[3], 2);
+    zassert_equal(ranks[0], 3);
+}
+
+ZTEST(session, test_quiz_push_out) {
+    open_round(SESSION_MODE_QUIZ);
+    for (int i = 0; i < MAX_RANKS; i++) {
+        press(i, 0, 1000 + i * 10);
+    }
+
+    // An earlier press pushes the last clicker out of the full ranking
+    reset_counts();
+    press(MAX_RANKS, 1, 500);
+    zassert_equal(ranks[MAX_RANKS], 0);
+    for (int i = 0; i < MAX_RANKS - 1; i++) {
+        zassert_equal(ranks[i], i + 1, "clicker %d", i);
+    }
+    zassert_equal(ranks[MAX_RANKS - 1], SESSION_RANK_NONE);
+    zassert_equal(num_rank_updates, MAX_RANKS + 1);
+
+    // A later press does not make it into the ranking, but its answer counts
+    reset_counts();
+    press(MAX_RANKS + 1, 2, 5000);
+    zassert_equal(num_rank_updates, 0);
+    zassert_equal(ranks[MAX_RANKS + 1], SESSION_RANK_NONE);
+    zassert_equal(tallies[2], 1);
+}
+
+ZTEST(session, test_quiz_answer_replaced) {
+    open_round(SESSION_MODE_QUIZ);
+    press(0, 0, 200);
+    press(1, 1, 100);
+    zassert_equal(tallies[0], 1);
+
+    // A replayed press that happened earlier replaces the answer and moves the clicker up
+    press(0, 2, 50);
+    zassert_equal(tallies[0], 0);
+    zassert_equal(tallies[2], 1);
+    zassert_equal(ranks[0], 0);
+    zassert_equal(ranks[1], 1);
+
+    // Later presses are locked out
+    reset_counts();
+    press(0, 3, 300);
+    zassert_equal(num_lockouts, 1);
+    zassert_equal(num_tally_updates, 0);
+    zassert_equal(num_rank_updates, 0);
+    zassert_equal(tallies[3], 0);
+}
+
+ZTEST(session, test_lockout) {
+    open_round(SESSION_MODE_QUIZ);
+    press(0, 0, 100);
+
+    // The answer of a locked clicker stays, but its presses no longer count
+    zassert_ok(session_lock_device(DEVICE(0)));
+    zassert_ok(session_lock_device(DEVICE(1)));
+    reset_counts();
+    press(0, 1, 50);
+    press(1, 1, 200);
+    zassert_equal(num_lockouts, 2);
+    zassert_equal(num_tally_updates, 0);
+    zassert_equal(num_rank_updates, 0);
+    zassert_equal(tallies[0], 1);
+    zassert_equal(ranks[0], 0);
+    zassert_equal(ranks[1], SESSION_RANK_NONE);
+
+    zassert_equal(session_lock_device(UNKNOWN_DEVICE_ID), -ENOENT);
+
+    // The lockout ends with the round
+    open_round(SESSION_MODE_QUIZ);
+    reset_counts();
+    press(1, 1, 100);
+    zassert_equal(num_lockouts, 0);
+    zassert_equal(ranks[1], 0);
+}
+
+ZTEST(session, test_vote_changes) {
+    open_round(SESSION_MODE_VOTE);
+    press(0, 0, 100);
+    press(1, 0, 100);
+    zassert_equal(tallies[0], 2);
+
+    // A later press changes the vote
+    press(0, 1, 200);
+    zassert_equal(tallies[0], 1);
+    zassert_equal(tallies[1], 1);
+
+    // An earlier press that arrives late and a repeated vote change nothing
+    reset_counts();
+    press(0, 2, 150);
+    press(0, 1, 300);
+    zassert_equal(num_tally_updates, 0);
+    zassert_equal(tallies[2], 0);
+
+    // Votes are not ranked
+    zassert_equal(num_rank_updates, 0);
+    zassert_equal(ranks[0], SESSION_RANK_NONE);
+}
+
+ZTEST(session, test_every_rank_change_reported) {
+    open_round(SESSION_MODE_QUIZ);
+
+    // Clicker i pressed after i + 1 ms, but the clicks arrive in a scrambled order (7 is coprime to NUM_DEVICES)
+    BUILD_ASSERT(NUM_DEVICES % 7 != 0);
+    for (int n = 0; n < NUM_DEVICES; n++) {
+        int i = (n * 7) % NUM_DEVICES;
+        press(i, i % SESSION_NUM_BUTTONS, 1000 * (i + 1));
+
+        // After every click, the copy built from the updates must match the ranking of the clicks so far
+        for (int j = 0; j < NUM_DEVICES; j++) {
+            int rank         = 0;
+            bool has_pressed = false;
+            for (int m = 0; m <= n; m++) {
+                int k = (m * 7) % NUM_DEVICES;
+                rank += k < j;
+                has_pressed |= k == j;
+            }
+
+            uint8_t expected = has_pressed && rank < MAX_RANKS ? rank : SESSION_RANK_NONE;
+            zassert_equal(ranks[j], expected, "clicker %d after %d clicks", j, n + 1);
+        }
+    }
+}
+
+ZTEST(session, test_closed_round) {
+    open_round(SESSION_MODE_VOTE);
+    press(0, 0, 100);
+    press(1, 1, 100);
+
+    k_sleep(K_MSEC(10));
+    zassert_ok(session_close_round());
+    zassert_equal(num_closed, 1);
+    zassert_equal(closed_count, 2);
+    zassert_equal(session_close_round(), -EALREADY);
+
+    // A press from before the close still counts, but one after it does not
+    press(2, 2, 5000);
+    press(3, 2, 1000000);
+    zassert_equal(tallies[2], 1);
+}
+
+ZTEST_SUITE(session, NULL, setup, before_each, NULL, NULL);